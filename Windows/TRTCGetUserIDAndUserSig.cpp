@@ -7,14 +7,182 @@
 #include "TRTCGetUserIDAndUserSig.h"
 #include "json.h"
 #include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 
+namespace
+{
+    // ֻ sdkappid  users[i].userId/userTokenֶμǶֱ Json::Value 
+    class UserConfigHandler : public Json::SaxHandler
+    {
+    public:
+        UserConfigHandler(uint32_t& sdkAppId, std::vector<UserInfo>& userInfos)
+            : m_sdkAppId(sdkAppId)
+            , m_userInfos(userInfos)
+            , m_depth(0)
+            , m_key(NONE)
+            , m_inUsers(false)
+            , m_hasSdkAppId(false)
+            , m_hasUsers(false)
+            , m_hasUserId(false)
+            , m_hasUserSig(false)
+        {
+        }
+
+        bool complete() const { return m_hasSdkAppId && m_hasUsers; }
+
+        virtual bool onStartObject()
+        {
+            ++m_depth;
+            if (m_inUsers && m_depth == 3)
+            {
+                m_info = UserInfo();
+                m_hasUserId = m_hasUserSig = false;
+            }
+            return true;
+        }
+        virtual bool onEndObject()
+        {
+            if (m_inUsers && m_depth == 3)
+            {
+                if (!m_hasUserId || !m_hasUserSig)
+                {
+                    return false;
+                }
+                m_userInfos.push_back(m_info);
+            }
+            --m_depth;
+            return true;
+        }
+        virtual bool onStartArray()
+        {
+            if (isRosterItem())
+            {
+                return false;
+            }
+            ++m_depth;
+            if (m_depth == 2 && m_key == USERS)
+            {
+                m_inUsers = m_hasUsers = true;
+            }
+            return true;
+        }
+        virtual bool onEndArray()
+        {
+            if (m_depth == 2)
+            {
+                m_inUsers = false;
+            }
+            --m_depth;
+            return true;
+        }
+        virtual bool onKey(char const* begin, char const* end)
+        {
+            m_key = NONE;
+            if (m_depth == 1)
+            {
+                if (equals(begin, end, "sdkappid")) m_key = SDKAPPID;
+                else if (equals(begin, end, "users")) m_key = USERS;
+            }
+            else if (m_inUsers && m_depth == 3)
+            {
+                if (equals(begin, end, "userId")) m_key = USERID;
+                else if (equals(begin, end, "userToken")) m_key = USERTOKEN;
+            }
+            return true;
+        }
+        virtual bool onNull()
+        {
+            return !isRosterItem();
+        }
+        virtual bool onBool(bool)
+        {
+            return !isRosterItem();
+        }
+        virtual bool onInt(Json::LargestInt value)
+        {
+            return onNumber(static_cast<uint32_t>(value));
+        }
+        virtual bool onUInt(Json::LargestUInt value)
+        {
+            return onNumber(static_cast<uint32_t>(value));
+        }
+        virtual bool onDouble(double value)
+        {
+            return onNumber(static_cast<uint32_t>(value));
+        }
+        virtual bool onString(char const* begin, char const* end)
+        {
+            if (isRosterItem())
+            {
+                return false;
+            }
+            if (m_inUsers && m_depth == 3)
+            {
+                if (m_key == USERID)
+                {
+                    m_info.userId.assign(begin, end);
+                    m_hasUserId = true;
+                }
+                else if (m_key == USERTOKEN)
+                {
+                    m_info.userSig.assign(begin, end);
+                    m_hasUserSig = true;
+                }
+            }
+            return true;
+        }
+    private:
+        enum Key { NONE, SDKAPPID, USERS, USERID, USERTOKEN };
+
+        static bool equals(char const* begin, char const* end, const char* name)
+        {
+            size_t length = strlen(name);
+            return static_cast<size_t>(end - begin) == length && memcmp(begin, name, length) == 0;
+        }
+        // users ԪرǶԭ Json::Reader ʵһΪô
+        bool isRosterItem() const
+        {
+            return m_inUsers && m_depth == 2;
+        }
+        bool onNumber(uint32_t value)
+        {
+            if (isRosterItem())
+            {
+                return false;
+            }
+            if (m_depth == 1 && m_key == SDKAPPID)
+            {
+                m_sdkAppId = value;
+                m_hasSdkAppId = true;
+            }
+            return true;
+        }
+
+        uint32_t& m_sdkAppId;
+        std::vector<UserInfo>& m_userInfos;
+        UserInfo m_info;
+        int m_depth;
+        Key m_key;
+        bool m_inUsers;
+        bool m_hasSdkAppId;
+        bool m_hasUsers;
+        bool m_hasUserId;
+        bool m_hasUserSig;
+    };
+}
+
 TRTCGetUserIDAndUserSig::TRTCGetUserIDAndUserSig()
     : m_sdkAppId(0)
     , m_userInfos()
     , m_http_client(L"User-Agent")
+    , m_login_cgi(L"https://xxx") //ķַ
 {
-
+    m_http_client.setRequestTimeout(15 * 1000);     // ӦʱҪõ¼һֱס
+    m_sig_cache.setFilePath("UserSigCache.json");
 }
 
 TRTCGetUserIDAndUserSig::~TRTCGetUserIDAndUserSig()
@@ -28,118 +196,284 @@ TRTCGetUserIDAndUserSig& TRTCGetUserIDAndUserSig::instance()
     return uniqueInstance;
 }
 
-bool TRTCGetUserIDAndUserSig::loadFromConfig()
+namespace
 {
-    FILE* file = NULL;
-    fopen_s(&file, "Config.json", "rb");
-    if (!file)
-    {
-        return false;
-    }
-
-    std::string data;
-    while (true)
+    bool readConfigFile(std::string& data)
     {
-        char buffer[512] = { 0 };
-        size_t count = ::fread(buffer, 1, 512, file);
-        if (count == 0)
+        FILE* file = NULL;
+        fopen_s(&file, "Config.json", "rb");
+        if (!file)
         {
-            break;
+            return false;
         }
 
-        data.append(buffer, count);
+        while (true)
+        {
+            char buffer[512] = { 0 };
+            size_t count = ::fread(buffer, 1, 512, file);
+            if (count == 0)
+            {
+                break;
+            }
+
+            data.append(buffer, count);
+        }
+        ::fclose(file);
+        return true;
     }
+}
 
-    Json::Reader reader;
-    Json::Value root;
-    if (!reader.parse(data, root))
+bool TRTCGetUserIDAndUserSig::loadFromConfig()
+{
+    std::string data;
+    if (!readConfigFile(data))
     {
         return false;
     }
+    return applyConfig(data);
+}
 
-    if (!root.isMember("sdkappid") || !root.isMember("users"))
+bool TRTCGetUserIDAndUserSig::reloadFromConfig()
+{
+    std::string data;
+    if (!readConfigFile(data))
     {
-        return false;
+        return false;   // ༭ʱļܶݲڣһ֪ͨ
     }
-
-    m_sdkAppId = root["sdkappid"].asUInt();
-
-    Json::Value users = root["users"];
-    for (size_t i = 0; i < users.size(); ++i)
     {
-        Json::Value item = users[i];
-        if (!item.isMember("userId") || !item.isMember("userToken"))
+        std::lock_guard<std::mutex> lock(m_config_mutex);
+        if (data == m_config_data)
         {
             return false;
         }
+    }
+    return applyConfig(data);
+}
 
-        UserInfo info;
-        info.userId = item["userId"].asString();
-        info.userSig = item["userToken"].asString();
+bool TRTCGetUserIDAndUserSig::applyConfig(const std::string& data)
+{
+    // ¼ʽڴռûб޹أļݱ
+    // Ƚֲɹ滻дһļƻеûб
+    uint32_t sdkAppId = 0;
+    std::vector<UserInfo> userInfos;
+    Json::SaxReader reader;
+    UserConfigHandler handler(sdkAppId, userInfos);
+    if (!reader.parse(data.data(), data.data() + data.size(), handler))
+    {
+        return false;
+    }
 
-        m_userInfos.push_back(info);
+    if (!handler.complete())
+    {
+        return false;
     }
 
+    std::lock_guard<std::mutex> lock(m_config_mutex);
+    m_sdkAppId = sdkAppId;
+    m_userInfos.swap(userInfos);
+    m_config_data = data;
     return true;
 }
 
 
 uint32_t TRTCGetUserIDAndUserSig::getConfigSdkAppId() const
 {
+    std::lock_guard<std::mutex> lock(m_config_mutex);
     return m_sdkAppId;
 }
 
 std::vector<UserInfo> TRTCGetUserIDAndUserSig::getConfigUserIdArray() const
 {
+    std::lock_guard<std::mutex> lock(m_config_mutex);
     return m_userInfos;
 }
 
-std::string TRTCGetUserIDAndUserSig::getUserSigFromServer(std::string userId, std::string pwd, int roomId, int sdkAppId)
+namespace
 {
-    std::wstring login_cgi = L"https://xxx"; //ķַ
-    int accountType = 14000;  //Ӧų́ҳȡAccountTypeֵ
-    Json::Value jsonObj;
-    jsonObj["pwd"] = pwd;
-    jsonObj["appid"] = sdkAppId;
-    jsonObj["roomnum"] = roomId;
-    jsonObj["privMap"] = 255;
-    jsonObj["accounttype"] = accountType;
-    jsonObj["identifier"] = userId;
-    Json::FastWriter writer;
-    std::string jsonStr = writer.write(jsonObj);
-    std::vector<std::wstring> headers;
-    headers.push_back(L"Content-Type: application/json; charset=utf-8");
-
-    std::string respData;
-    std::wstring _cgi_url = login_cgi;
-    DWORD ret = m_http_client.http_post(_cgi_url, headers, jsonStr, respData);
-    if (0 != ret || true == respData.empty())
+    std::string makeLoginRequest(const std::string& userId, const std::string& pwd, int roomId, int sdkAppId)
     {
-        //ʧ,硣
+        int accountType = 14000;  //Ӧų́ҳȡAccountTypeֵ
+        Json::Value jsonObj;
+        jsonObj["pwd"] = pwd;
+        jsonObj["appid"] = sdkAppId;
+        jsonObj["roomnum"] = roomId;
+        jsonObj["privMap"] = 255;
+        jsonObj["accounttype"] = accountType;
+        jsonObj["identifier"] = userId;
+        Json::FastWriter writer;
+        return writer.write(jsonObj);
     }
-    std::string _userSig;
+
+    std::string parseUserSig(DWORD ret, const std::string& respData)
     {
-        Json::Reader reader;
-        Json::Value root;
-        if (!reader.parse(respData, root))
+        if (0 != ret || true == respData.empty())
         {
-            //JsonϢ
+            //ʧ,硣
         }
-        if (root.isMember("errorCode"))
+        std::string _userSig;
         {
-            int code = root["errorCode"].asInt();
-            if (code != 0)
+            Json::Reader reader;
+            Json::Value root;
+            if (!reader.parse(respData, root))
             {
-                //¼ز
+                //JsonϢ
             }
-            Json::Value data;
-            if (root.isMember("data"))
+            if (root.isMember("errorCode"))
             {
-                data = root["data"];
-                if (data.isMember("userSig"))
-                    _userSig = data["userSig"].asString();
+                int code = root["errorCode"].asInt();
+                if (code != 0)
+                {
+                    //¼ز
+                }
+                Json::Value data;
+                if (root.isMember("data"))
+                {
+                    data = root["data"];
+                    if (data.isMember("userSig"))
+                        _userSig = data["userSig"].asString();
+                }
             }
         }
+        return _userSig;
     }
-    return _userSig;
+}
+
+std::string TRTCGetUserIDAndUserSig::getUserSigFromServer(std::string userId, std::string pwd, int roomId, int sdkAppId)
+{
+    UserSigKey key = { sdkAppId, userId, roomId };
+    UserSigCache::Fetcher fetcher = makeFetcher(userId, pwd, roomId, sdkAppId);
+    std::string userSig;
+    if (m_sig_cache.lookup(key, pwd, fetcher, userSig))
+    {
+        return userSig;
+    }
+
+    userSig = fetchUserSig(userId, pwd, roomId, sdkAppId);
+    m_sig_cache.store(key, pwd, userSig, fetcher);
+    return userSig;
+}
+
+void TRTCGetUserIDAndUserSig::getUserSigFromServerAsync(std::string userId, std::string pwd, int roomId, int sdkAppId
+    , const std::function<void(const std::string& userSig)>& callback)
+{
+    UserSigKey key = { sdkAppId, userId, roomId };
+    UserSigCache::Fetcher fetcher = makeFetcher(userId, pwd, roomId, sdkAppId);
+    std::string userSig;
+    if (m_sig_cache.lookup(key, pwd, fetcher, userSig))
+    {
+        callback(userSig);
+        return;
+    }
+
+    std::vector<std::wstring> headers;
+    headers.push_back(L"Content-Type: application/json; charset=utf-8");
+
+    m_http_client.http_post_async(m_login_cgi, headers, makeLoginRequest(userId, pwd, roomId, sdkAppId)
+        , [this, key, pwd, fetcher, callback](DWORD ret, std::string& respData)
+    {
+        std::string userSig = parseUserSig(ret, respData);
+        m_sig_cache.store(key, pwd, userSig, fetcher);
+        callback(userSig);
+    });
+}
+
+std::vector<UserSigResult> TRTCGetUserIDAndUserSig::getUserSigsFromServer(const std::vector<UserLogin>& users
+    , int roomId, int sdkAppId, size_t maxParallel)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::vector<UserSigResult> results(users.size());
+    std::vector<std::wstring> headers;
+    headers.push_back(L"Content-Type: application/json; charset=utf-8");
+    if (0 == maxParallel)
+    {
+        maxParallel = 1;
+    }
+
+    // ɵǰ̷߳صֻ̣߳¼黹
+    std::mutex mutex;
+    std::condition_variable released;
+    size_t inflight = 0;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (size_t index = 0; index < users.size(); ++index)
+    {
+        released.wait(lock, [&] { return inflight < maxParallel; });
+        ++inflight;
+        lock.unlock();
+
+        UserSigResult& result = results[index];
+        result.userId = users[index].userId;
+        Clock::time_point start = Clock::now();
+        UserSigKey key = { sdkAppId, users[index].userId, roomId };
+        UserSigCache::Fetcher fetcher = makeFetcher(users[index].userId, users[index].pwd, roomId, sdkAppId);
+        const std::string& pwd = users[index].pwd;
+        if (m_sig_cache.lookup(key, pwd, fetcher, result.userSig))
+        {
+            result.error = ERROR_SUCCESS;
+            result.latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            lock.lock();
+            --inflight;
+            continue;
+        }
+
+        m_http_client.http_post_async(m_login_cgi, headers, makeLoginRequest(users[index].userId, users[index].pwd, roomId, sdkAppId)
+            , [this, &result, &mutex, &released, &inflight, start, key, pwd, fetcher](DWORD ret, std::string& respData)
+        {
+            result.latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            result.error = ret;
+            result.userSig = parseUserSig(ret, respData);
+            m_sig_cache.store(key, pwd, result.userSig, fetcher);
+
+            std::lock_guard<std::mutex> guard(mutex);
+            --inflight;
+            released.notify_all();
+        });
+
+        lock.lock();
+    }
+    released.wait(lock, [&] { return 0 == inflight; });
+    return results;
+}
+
+void TRTCGetUserIDAndUserSig::setServerUrl(const std::wstring& url)
+{
+    m_login_cgi = url;
+}
+
+bool TRTCGetUserIDAndUserSig::setProxy(const std::string& ip, unsigned short port)
+{
+    return m_http_client.setProxy(ip, port);
+}
+
+void TRTCGetUserIDAndUserSig::setUserSigCacheTtl(unsigned int seconds, unsigned int refreshBeforeSeconds)
+{
+    m_sig_cache.setTtl(seconds, refreshBeforeSeconds);
+}
+
+void TRTCGetUserIDAndUserSig::invalidateUserSig(const std::string& userId, int roomId, int sdkAppId)
+{
+    UserSigKey key = { sdkAppId, userId, roomId };
+    m_sig_cache.invalidate(key);
+}
+
+UserSigCache::Stats TRTCGetUserIDAndUserSig::getUserSigCacheStats() const
+{
+    return m_sig_cache.stats();
+}
+
+std::string TRTCGetUserIDAndUserSig::fetchUserSig(const std::string& userId, const std::string& pwd, int roomId, int sdkAppId)
+{
+    std::vector<std::wstring> headers;
+    headers.push_back(L"Content-Type: application/json; charset=utf-8");
+
+    std::string respData;
+    DWORD ret = m_http_client.http_post(m_login_cgi, headers, makeLoginRequest(userId, pwd, roomId, sdkAppId), respData);
+    return parseUserSig(ret, respData);
+}
+
+UserSigCache::Fetcher TRTCGetUserIDAndUserSig::makeFetcher(const std::string& userId, const std::string& pwd, int roomId, int sdkAppId)
+{
+    // ڻĺִ̨߳
+    return [this, userId, pwd, roomId, sdkAppId] { return fetchUserSig(userId, pwd, roomId, sdkAppId); };
 }
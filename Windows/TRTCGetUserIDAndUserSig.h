@@ -5,16 +5,33 @@
 * Function: ڻȡװ TRTCParam  UserSigѶʹ UserSig аȫУ飬 TRTC 
 */
 
+#include <functional>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <stdint.h>
 #include "HttpClient.h"
+#include "UserSigCache.h"
 struct UserInfo
 {
     std::string userId;
     std::string userSig;
 };
 
+struct UserLogin
+{
+    std::string userId;
+    std::string pwd;
+};
+
+struct UserSigResult
+{
+    std::string userId;
+    std::string userSig;    // ʧʱΪ
+    DWORD error;            // http ķֵ
+    double latencyMs;       // ӷյӦ
+};
+
 class TRTCGetUserIDAndUserSig
 {
 protected:
@@ -36,6 +53,13 @@ public:
     *
     */
     bool loadFromConfig();
+
+    /**
+    * Config.json ޸ĺ¶룬̵߳
+    *
+    * ļûб仯ݲʧܣʱԭе sdkappid ûб false
+    */
+    bool reloadFromConfig();
     uint32_t getConfigSdkAppId() const;
     std::vector<UserInfo> getConfigUserIdArray() const;
 
@@ -44,12 +68,53 @@ public:
     * ַʽԽǩ usersig ļ㹤ҵϽУһusersig ǩͿ԰ȫɿ
     *
     * demoе getUserSigFromServer Ϊʾ룬Ҫͨ߼Ҫοhttps://cloud.tencent.com/document/product/647/17275#GetFromServer
+    *
+    * ȡ userSig  (sdkAppId, userId, roomId) 沢̣UserSigCache.jsonЧٴε¼
     */
     //ʾο
     std::string getUserSigFromServer(std::string userId, std::string pwd, int roomId, int sdkAppId);
+
+    /**
+    * ͬ getUserSigFromServeṛ߳ڽ߳ʹ汾
+    *
+    * callback ִ߳Улʱֱڵִ߳Уʧʱ userSig Ϊգ PostMessage ؽ̺߳ٸ½
+    */
+    void getUserSigFromServerAsync(std::string userId, std::string pwd, int roomId, int sdkAppId
+        , const std::function<void(const std::string& userSig)>& callback);
+
+    /**
+    * ȡ userSigһûĳʹãֱȫɣ users һһӦ
+    *
+    * лû maxParallel ͬʱ;ȡӳزָã
+    * maxParallel  HttpClient ÿ host ʱӳŶӣŶʱ latencyMs
+    */
+    std::vector<UserSigResult> getUserSigsFromServer(const std::vector<UserLogin>& users, int roomId, int sdkAppId
+        , size_t maxParallel);
+
+    void setServerUrl(const std::wstring& url);     // ҵ CGI ַ
+
+    /**
+    * ¼ SOCKS5  SDK ýͨõĴͬip Ϊʱֱ
+    *
+    *  false ʾ HttpClient ĺ˲֧ SOCKS5WinHTTP¼󲻾ôϵͳã
+    * ʾû¼޷ҵ
+    */
+    bool setProxy(const std::string& ip, unsigned short port);
+
+    void setUserSigCacheTtl(unsigned int seconds, unsigned int refreshBeforeSeconds);
+    void invalidateUserSig(const std::string& userId, int roomId, int sdkAppId);  // ʾ userSig Чʱ
+    UserSigCache::Stats getUserSigCacheStats() const;
+private:
+    std::string fetchUserSig(const std::string& userId, const std::string& pwd, int roomId, int sdkAppId);
+    UserSigCache::Fetcher makeFetcher(const std::string& userId, const std::string& pwd, int roomId, int sdkAppId);
+    bool applyConfig(const std::string& data);
 private:
+    mutable std::mutex m_config_mutex;  // ļ̻߳¼
     uint32_t m_sdkAppId;
     std::vector<UserInfo> m_userInfos;
+    std::string m_config_data;          // ϴγɹص Config.json 
 private:
     HttpClient m_http_client;
+    std::wstring m_login_cgi;
+    UserSigCache m_sig_cache;   // ̨ˢҪ m_http_client
 };
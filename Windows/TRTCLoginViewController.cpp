@@ -38,6 +38,7 @@ BOOL TRTCLoginViewController::OnInitDialog()
 {
     CDialogEx::OnInitDialog();
     TRTCStorageConfigMgr::GetInstance()->ReadStorageConfig();
+    startConfigWatcher();   //Config.json ʧʱҲҪӣ޺֮
     newFont.CreatePointFont(120, L"΢ź");
     m_userIdCombo.SetFont(&newFont);
     // ô˶Իͼꡣ  ӦóڲǶԻʱܽԶ
@@ -104,6 +105,7 @@ void TRTCLoginViewController::DoDataExchange(CDataExchange* pDX)
 
 void TRTCLoginViewController::OnCancel()
 {
+    m_configWatcher.stop();
     destroyTRTCCloud();
     CDialogEx::OnCancel();
 }
@@ -111,6 +113,8 @@ void TRTCLoginViewController::OnCancel()
 BEGIN_MESSAGE_MAP(TRTCLoginViewController, CDialogEx)
     ON_BN_CLICKED(IDC_ENTER_ROOM, &TRTCLoginViewController::OnBnClickedEnterRoom)
     ON_MESSAGE(WM_CUSTOM_CLOSE_MAINVIEW, OnMsgMainViewClose)
+    ON_MESSAGE(WM_CUSTOM_STORAGE_CONFIG_CHANGED, OnMsgStorageConfigChanged)
+    ON_MESSAGE(WM_CUSTOM_USER_CONFIG_CHANGED, OnMsgUserConfigChanged)
 END_MESSAGE_MAP()
 
 
@@ -145,7 +149,10 @@ void TRTCLoginViewController::joinRoom(int roomId)
     if (userInfos.empty())
     {   
         //Ҳͨ http Эһ̨ȡ userid Ӧ usersig
-        //ʾTRTCGetUserIDAndUserSig::instance().getUserSigFromServer();
+        //ʾTRTCGetUserIDAndUserSig::instance().getUserSigFromServerAsync(userId, pwd, roomId, sdkAppId, callback);
+        //ں̨ɣῨס棻callback ִ߳У PostMessage ؽ̺߳ٽ
+        // SDK  SOCKS5 ʱ¼ҲҪãWinHTTP ֧ SOCKS5 false ʱ¼󲻾Ӧʾû
+        //ʾif (false == TRTCGetUserIDAndUserSig::instance().setProxy(ip, port)) MessageBoxW(L"¼֧ SOCKS5 ϵͳӷ", L"ʾ", MB_OK);
         return;
     }
     int selIndex = m_userIdCombo.GetCurSel();
@@ -199,3 +206,83 @@ LRESULT TRTCLoginViewController::OnMsgMainViewClose(WPARAM wParam, LPARAM lParam
     return LRESULT();
 }
 
+
+/**
+*  Function: ļȼ
+*
+*  صļִ߳У¶ȡͽڸ߳ɣûб仯ԼдINIʱẒ̌߳
+*  б仯ʱ PostMessage ؽֻ̣߳ӰĽ SDK 
+*/
+void TRTCLoginViewController::startConfigWatcher()
+{
+    HWND hWnd = GetSafeHwnd();
+    m_configWatcher.watch(TRTCStorageConfigMgr::GetInstance()->GetConfigFilePath(), [hWnd]() {
+        unsigned int changed = TRTCStorageConfigMgr::GetInstance()->ReloadStorageConfig();
+        if (0 != changed)
+            ::PostMessage(hWnd, WM_CUSTOM_STORAGE_CONFIG_CHANGED, changed, 0);
+    });
+    m_configWatcher.watch(L"Config.json", [hWnd]() {
+        if (TRTCGetUserIDAndUserSig::instance().reloadFromConfig())
+            ::PostMessage(hWnd, WM_CUSTOM_USER_CONFIG_CHANGED, 0, 0);
+    });
+    if (false == m_configWatcher.start())
+    {
+        //Ӱʹãֻ޸ļҪЧ
+        TRACE(traceAppMsg, 0, ": ļʧܣ޸ļҪ\n");
+    }
+}
+
+LRESULT TRTCLoginViewController::OnMsgStorageConfigChanged(WPARAM wParam, LPARAM lParam)
+{
+    //Ѿ´νʱЧѾڷʱֻб仯ļ SDK
+    if (m_pTRTCMainViewController == nullptr)
+        return LRESULT();
+
+    unsigned int changed = static_cast<unsigned int>(wParam);
+    TRTCStorageConfigSnapshot config = TRTCStorageConfigMgr::GetInstance()->GetSnapshot();
+    const unsigned int encoderMask = (1u << Config::SettingVideoBitrate) | (1u << Config::SettingVideoResolution) | (1u << Config::SettingVideoFps);
+    const unsigned int qosMask = (1u << Config::SettingVideoQuality) | (1u << Config::SettingVideoQualityControl);
+    if (changed & encoderMask)
+        getTRTCCloud()->setVideoEncoderParam(config.videoEncParams);
+    if (changed & qosMask)
+        getTRTCCloud()->setNetworkQosParam(config.qosParams);
+    if (changed & (1u << Config::SettingPushSmallVideo))
+    {
+        TRTCVideoEncParam param;
+        param.videoFps = 15;
+        param.videoBitrate = 100;
+        param.videoResolution = TRTCVideoResolution_320_240;
+        getTRTCCloud()->enableSmallVideoStream(config.bPushSmallVideo, param);
+    }
+    if (changed & (1u << Config::SettingPlaySmallVideo))
+    {
+        if (config.bPlaySmallVideo)
+            getTRTCCloud()->setPriorRemoteVideoStreamType(TRTCVideoStreamTypeSmall);
+        else
+            getTRTCCloud()->setPriorRemoteVideoStreamType(TRTCVideoStreamTypeBig);
+    }
+    return LRESULT();
+}
+
+LRESULT TRTCLoginViewController::OnMsgUserConfigChanged(WPARAM wParam, LPARAM lParam)
+{
+    //ûбԭѡеûʱѡ
+    CString selected;
+    int selIndex = m_userIdCombo.GetCurSel();
+    if (selIndex >= 0)
+        m_userIdCombo.GetLBText(selIndex, selected);
+
+    m_userIdCombo.ResetContent();
+    std::vector<UserInfo> userInfos = TRTCGetUserIDAndUserSig::instance().getConfigUserIdArray();
+    int userCnt = userInfos.size();
+    for (int i = 0; i < userCnt; i++)
+    {
+        m_userIdCombo.AddString(UTF82Wide(userInfos[i].userId).c_str());
+    }
+    int index = selected.IsEmpty() ? CB_ERR : m_userIdCombo.FindStringExact(-1, selected);
+    m_userIdCombo.SetCurSel(CB_ERR == index ? 0 : index);
+
+    CWnd *pEnterRoomBtn = GetDlgItem(IDC_ENTER_ROOM);
+    pEnterRoomBtn->EnableWindow(userInfos.empty() ? FALSE : TRUE);
+    return LRESULT();
+}
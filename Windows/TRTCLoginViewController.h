@@ -1,5 +1,6 @@
 #pragma once
 #include "afxwin.h"
+#include "FileWatcher.h"
 
 /*
 * Module:   TRTCLoginViewController
@@ -41,9 +42,14 @@ protected:
 protected:
     afx_msg void OnBnClickedEnterRoom();
     afx_msg LRESULT OnMsgMainViewClose(WPARAM wParam, LPARAM lParam);
+    afx_msg LRESULT OnMsgStorageConfigChanged(WPARAM wParam, LPARAM lParam);
+    afx_msg LRESULT OnMsgUserConfigChanged(WPARAM wParam, LPARAM lParam);
+private:
+    void startConfigWatcher();
 private:
     CFont newFont;
     TRTCMainViewController * m_pTRTCMainViewController = nullptr;
+    FileWatcher m_configWatcher;    //TRTStorageConfig.ini  Config.json ޸ĺԶ¼
 public:
     CComboBox m_userIdCombo;
 };
@@ -316,13 +316,12 @@ void TRTCMainViewController::enterRoom(TRTCParams& params)
     // Ƶֱʡ֡ʡʵȵȣЩ TRTCSettingViewController 
     // ע⣨1Ҫʺܵ͵úܸߵķֱʣֽϴ
     // ע⣨2Ҫó25FPSϵ֡ʣΪӰʹ24FPSһƼ15FPSܽʷ
-    TRTCVideoEncParam& encParams = TRTCStorageConfigMgr::GetInstance()->videoEncParams;
-    TRTCNetworkQosParam qosParams = TRTCStorageConfigMgr::GetInstance()->qosParams;
-    getTRTCCloud()->setVideoEncoderParam(encParams);
-    getTRTCCloud()->setNetworkQosParam(qosParams);
+    TRTCStorageConfigSnapshot config = TRTCStorageConfigMgr::GetInstance()->GetSnapshot();
+    getTRTCCloud()->setVideoEncoderParam(config.videoEncParams);
+    getTRTCCloud()->setNetworkQosParam(config.qosParams);
     
-    bool m_bPushSmallVideo = TRTCStorageConfigMgr::GetInstance()->bPushSmallVideo;
-    bool m_bPlaySmallVideo = TRTCStorageConfigMgr::GetInstance()->bPlaySmallVideo;
+    bool m_bPushSmallVideo = config.bPushSmallVideo;
+    bool m_bPlaySmallVideo = config.bPlaySmallVideo;
 
 
     if (m_bPushSmallVideo)
@@ -178,8 +178,9 @@ BOOL TRTCSettingViewController::OnInitDialog()
 
 void TRTCSettingViewController::OnBnClickedButtonSave()
 {
-    TRTCVideoEncParam& _videoEncParams = TRTCStorageConfigMgr::GetInstance()->videoEncParams;
-    TRTCNetworkQosParam& _qosParams = TRTCStorageConfigMgr::GetInstance()->qosParams;
+    TRTCStorageConfigSnapshot config = TRTCStorageConfigMgr::GetInstance()->GetSnapshot();
+    TRTCVideoEncParam& _videoEncParams = config.videoEncParams;
+    TRTCNetworkQosParam& _qosParams = config.qosParams;
     if (_videoEncParams.videoBitrate != m_videoEncParams.videoBitrate ||
         _videoEncParams.videoFps != m_videoEncParams.videoFps ||
         _videoEncParams.videoResolution != m_videoEncParams.videoResolution)
@@ -192,7 +193,7 @@ void TRTCSettingViewController::OnBnClickedButtonSave()
         getTRTCCloud()->setNetworkQosParam(m_qosParams);
     }
 
-    bool _bPushSmallVideo = TRTCStorageConfigMgr::GetInstance()->bPushSmallVideo;
+    bool _bPushSmallVideo = config.bPushSmallVideo;
     if (_bPushSmallVideo != m_bPushSmallVideo)
     {
         TRTCVideoEncParam param;
@@ -205,7 +206,7 @@ void TRTCSettingViewController::OnBnClickedButtonSave()
         getTRTCCloud()->enableSmallVideoStream(bEnable, param);
     }
 
-    bool _bPlaySmallVideo = TRTCStorageConfigMgr::GetInstance()->bPlaySmallVideo;
+    bool _bPlaySmallVideo = config.bPlaySmallVideo;
     if (_bPlaySmallVideo != m_bPlaySmallVideo)
     {
         if (m_bPlaySmallVideo)
@@ -214,10 +215,11 @@ void TRTCSettingViewController::OnBnClickedButtonSave()
             getTRTCCloud()->setPriorRemoteVideoStreamType(TRTCVideoStreamTypeBig);
     }
 
-    TRTCStorageConfigMgr::GetInstance()->videoEncParams = m_videoEncParams;
-    TRTCStorageConfigMgr::GetInstance()->qosParams = m_qosParams;
-    TRTCStorageConfigMgr::GetInstance()->bPushSmallVideo = m_bPushSmallVideo;
-    TRTCStorageConfigMgr::GetInstance()->bPlaySmallVideo = m_bPlaySmallVideo;
+    config.videoEncParams = m_videoEncParams;
+    config.qosParams = m_qosParams;
+    config.bPushSmallVideo = m_bPushSmallVideo;
+    config.bPlaySmallVideo = m_bPlaySmallVideo;
+    TRTCStorageConfigMgr::GetInstance()->Publish(config);  //ֻڴ棬б仯ʱɺ̨ӳдļ
 
     CWnd *pSaveBtn = GetDlgItem(IDC_BUTTON_SAVE);
     if (pSaveBtn)
@@ -263,10 +265,11 @@ void TRTCSettingViewController::OnCbnSelchangeComboResolution()
 
 void TRTCSettingViewController::InitStorageConfig()
 {
-    m_videoEncParams = TRTCStorageConfigMgr::GetInstance()->videoEncParams;
-    m_qosParams = TRTCStorageConfigMgr::GetInstance()->qosParams;
-    m_bPushSmallVideo = TRTCStorageConfigMgr::GetInstance()->bPushSmallVideo;
-    m_bPlaySmallVideo = TRTCStorageConfigMgr::GetInstance()->bPlaySmallVideo;
+    TRTCStorageConfigSnapshot config = TRTCStorageConfigMgr::GetInstance()->GetSnapshot();
+    m_videoEncParams = config.videoEncParams;
+    m_qosParams = config.qosParams;
+    m_bPushSmallVideo = config.bPushSmallVideo;
+    m_bPlaySmallVideo = config.bPlaySmallVideo;
 }
 
 void TRTCSettingViewController::InitVideoTableConfig()
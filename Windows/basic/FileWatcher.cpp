@@ -0,0 +1,428 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#include <string.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+/**************************************************************************/
+
+namespace
+{
+    // ûĿ¼ʱӵǰĿ¼
+    void splitPath(const std::wstring& path, std::wstring& directory, std::wstring& name)
+    {
+        std::wstring::size_type slash = path.find_last_of(L"\\/");
+        if (std::wstring::npos == slash)
+        {
+            directory = L".";
+            name = path;
+            return;
+        }
+        directory = path.substr(0, 0 == slash ? 1 : slash);
+        name = path.substr(slash + 1);
+    }
+
+#ifndef _WIN32
+    std::string wideToUtf8(const std::wstring& wide)
+    {
+        std::string result;
+        result.reserve(wide.size());
+        for (std::wstring::const_iterator it = wide.begin(); wide.end() != it; ++it)
+        {
+            unsigned long cp = static_cast<unsigned long>(*it);
+            if (cp < 0x80)
+            {
+                result += static_cast<char>(cp);
+            }
+            else if (cp < 0x800)
+            {
+                result += static_cast<char>(0xC0 | (cp >> 6));
+                result += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000)
+            {
+                result += static_cast<char>(0xE0 | (cp >> 12));
+                result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                result += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else
+            {
+                result += static_cast<char>(0xF0 | (cp >> 18));
+                result += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                result += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+        }
+        return result;
+    }
+#endif
+}
+
+FileWatcher::FileWatcher()
+    : m_debounce(0)
+#ifdef _WIN32
+    , m_stopEvent(NULL)
+#else
+    , m_inotify(-1)
+#endif
+{
+#ifndef _WIN32
+    m_stopPipe[0] = -1;
+    m_stopPipe[1] = -1;
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+}
+
+bool FileWatcher::watch(const std::wstring& path, const Callback& onChanged)
+{
+    if (m_thread.joinable() || !onChanged)
+    {
+        return false;
+    }
+
+    File file;
+    std::wstring directoryPath;
+    splitPath(path, directoryPath, file.name);
+    if (file.name.empty())
+    {
+        return false;
+    }
+#ifndef _WIN32
+    file.nativeName = wideToUtf8(file.name);
+#endif
+    file.callback = onChanged;
+    file.pending = false;
+
+    for (std::vector<Directory>::iterator it = m_directories.begin(); m_directories.end() != it; ++it)
+    {
+        if (it->path == directoryPath)
+        {
+            it->files.push_back(file);
+            return true;
+        }
+    }
+
+    Directory directory;
+    directory.path = directoryPath;
+    directory.files.push_back(file);
+#ifdef _WIN32
+    directory.handle = INVALID_HANDLE_VALUE;
+    directory.event = NULL;
+    directory.reading = false;
+#else
+    directory.wd = -1;
+#endif
+    m_directories.push_back(directory);
+    return true;
+}
+
+bool FileWatcher::start(unsigned int debounceMs)
+{
+    if (m_thread.joinable() || m_directories.empty())
+    {
+        return false;
+    }
+    m_debounce = std::chrono::milliseconds(debounceMs);
+
+#ifdef _WIN32
+    // ֹͣ¼ռһȴ
+    if (m_directories.size() >= MAXIMUM_WAIT_OBJECTS)
+    {
+        return false;
+    }
+    m_stopEvent = ::CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (NULL == m_stopEvent)
+    {
+        return false;
+    }
+    for (std::vector<Directory>::iterator it = m_directories.begin(); m_directories.end() != it; ++it)
+    {
+        it->handle = ::CreateFileW(it->path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE
+            , NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+        it->event = ::CreateEventW(NULL, TRUE, FALSE, NULL);
+        it->buffer.resize(16 * 1024 / sizeof(DWORD));
+        if (INVALID_HANDLE_VALUE == it->handle || NULL == it->event || false == issueRead(*it))
+        {
+            close();
+            return false;
+        }
+    }
+#else
+    m_inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0 || 0 != ::pipe2(m_stopPipe, O_CLOEXEC))
+    {
+        close();
+        return false;
+    }
+    for (std::vector<Directory>::iterator it = m_directories.begin(); m_directories.end() != it; ++it)
+    {
+        it->wd = ::inotify_add_watch(m_inotify, wideToUtf8(it->path).c_str()
+            , IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM);
+        if (it->wd < 0)
+        {
+            close();
+            return false;
+        }
+    }
+#endif
+
+    m_thread = std::thread(&FileWatcher::run, this);
+    return true;
+}
+
+void FileWatcher::stop()
+{
+    if (m_thread.joinable())
+    {
+#ifdef _WIN32
+        ::SetEvent(m_stopEvent);
+#else
+        char byte = 0;
+        while (::write(m_stopPipe[1], &byte, 1) < 0 && EINTR == errno)
+        {
+        }
+#endif
+        m_thread.join();
+    }
+    close();
+}
+
+void FileWatcher::changed(File& file)
+{
+    file.pending = true;
+    file.due = Clock::now() + m_debounce;
+}
+
+int FileWatcher::fireDue()
+{
+    bool waiting = false;
+    Clock::duration next = Clock::duration::max();
+    for (std::vector<Directory>::iterator dir = m_directories.begin(); m_directories.end() != dir; ++dir)
+    {
+        for (std::vector<File>::iterator file = dir->files.begin(); dir->files.end() != file; ++file)
+        {
+            if (false == file->pending)
+            {
+                continue;
+            }
+            Clock::time_point now = Clock::now();   // صܱȽÿȡ
+            if (file->due <= now)
+            {
+                file->pending = false;
+                try
+                {
+                    file->callback();
+                }
+                catch (...)
+                {
+                    // ļĵһݲϷʱ׳һ޸
+                }
+            }
+            else
+            {
+                waiting = true;
+                next = (std::min)(next, file->due - now);
+            }
+        }
+    }
+    if (false == waiting)
+    {
+        return -1;
+    }
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(next).count()) + 1;
+}
+
+#ifdef _WIN32
+
+bool FileWatcher::issueRead(Directory& directory)
+{
+    ::ResetEvent(directory.event);
+    memset(&directory.overlapped, 0, sizeof(directory.overlapped));
+    directory.overlapped.hEvent = directory.event;
+    directory.reading = (FALSE != ::ReadDirectoryChangesW(directory.handle, &directory.buffer[0]
+        , static_cast<DWORD>(directory.buffer.size() * sizeof(DWORD)), FALSE
+        , FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE
+        , NULL, &directory.overlapped, NULL));
+    return directory.reading;
+}
+
+void FileWatcher::run()
+{
+    std::vector<HANDLE> handles(1, m_stopEvent);
+    for (std::vector<Directory>::iterator it = m_directories.begin(); m_directories.end() != it; ++it)
+    {
+        handles.push_back(it->event);
+    }
+
+    for (;;)
+    {
+        int wait = fireDue();
+        DWORD result = ::WaitForMultipleObjects(static_cast<DWORD>(handles.size()), &handles[0], FALSE
+            , wait < 0 ? INFINITE : static_cast<DWORD>(wait));
+        if (WAIT_TIMEOUT == result)
+        {
+            continue;
+        }
+        if (result <= WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + handles.size())
+        {
+            break;      // ֹͣ¼ߵȴʧ
+        }
+
+        Directory& directory = m_directories[result - WAIT_OBJECT_0 - 1];
+        DWORD bytes = 0;
+        BOOL ok = ::GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, FALSE);
+        directory.reading = false;
+        if (ok && bytes > 0)
+        {
+            const char* pos = reinterpret_cast<const char*>(&directory.buffer[0]);
+            for (;;)
+            {
+                const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(pos);
+                std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                for (std::vector<File>::iterator file = directory.files.begin(); directory.files.end() != file; ++file)
+                {
+                    if (0 == _wcsicmp(file->name.c_str(), name.c_str()))
+                    {
+                        changed(*file);
+                    }
+                }
+                if (0 == info->NextEntryOffset)
+                {
+                    break;
+                }
+                pos += info->NextEntryOffset;
+            }
+        }
+        else
+        {
+            // ʱ bytes Ϊ 0֪Щļ
+            for (std::vector<File>::iterator file = directory.files.begin(); directory.files.end() != file; ++file)
+            {
+                changed(*file);
+            }
+        }
+        issueRead(directory);   // Ŀ¼ɾʱʧܣ֮յĿ¼֪ͨ
+    }
+}
+
+void FileWatcher::close()
+{
+    for (std::vector<Directory>::iterator it = m_directories.begin(); m_directories.end() != it; ++it)
+    {
+        if (it->reading)
+        {
+            // ȡɣں˲д buffer  overlapped ܹ֮ر
+            DWORD bytes = 0;
+            ::CancelIoEx(it->handle, &it->overlapped);
+            ::GetOverlappedResult(it->handle, &it->overlapped, &bytes, TRUE);
+            it->reading = false;
+        }
+        if (INVALID_HANDLE_VALUE != it->handle)
+        {
+            ::CloseHandle(it->handle);
+            it->handle = INVALID_HANDLE_VALUE;
+        }
+        if (NULL != it->event)
+        {
+            ::CloseHandle(it->event);
+            it->event = NULL;
+        }
+    }
+    if (NULL != m_stopEvent)
+    {
+        ::CloseHandle(m_stopEvent);
+        m_stopEvent = NULL;
+    }
+}
+
+#else
+
+void FileWatcher::run()
+{
+    // inotify_event ű䳤ļ inotify_event 
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    struct pollfd fds[2];
+    fds[0].fd = m_inotify;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_stopPipe[0];
+    fds[1].events = POLLIN;
+
+    for (;;)
+    {
+        int wait = fireDue();
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if (::poll(fds, 2, wait) < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            break;
+        }
+        if (0 != fds[1].revents)
+        {
+            break;
+        }
+
+        for (;;)
+        {
+            ssize_t count = ::read(m_inotify, buffer, sizeof(buffer));
+            if (count <= 0)
+            {
+                break;      // EAGAINѾ
+            }
+            for (const char* pos = buffer; pos < buffer + count; )
+            {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(pos);
+                pos += sizeof(struct inotify_event) + event->len;
+                for (std::vector<Directory>::iterator dir = m_directories.begin(); m_directories.end() != dir; ++dir)
+                {
+                    bool overflow = (0 != (event->mask & IN_Q_OVERFLOW));
+                    if (false == overflow && (dir->wd != event->wd || 0 == event->len))
+                    {
+                        continue;
+                    }
+                    for (std::vector<File>::iterator file = dir->files.begin(); dir->files.end() != file; ++file)
+                    {
+                        if (overflow || 0 == strcmp(file->nativeName.c_str(), event->name))
+                        {
+                            changed(*file);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void FileWatcher::close()
+{
+    for (std::vector<Directory>::iterator it = m_directories.begin(); m_directories.end() != it; ++it)
+    {
+        it->wd = -1;    // ر inotify ʱһƳ
+    }
+    if (m_inotify >= 0)
+    {
+        ::close(m_inotify);
+        m_inotify = -1;
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        if (m_stopPipe[i] >= 0)
+        {
+            ::close(m_stopPipe[i]);
+            m_stopPipe[i] = -1;
+        }
+    }
+}
+
+#endif
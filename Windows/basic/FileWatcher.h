@@ -0,0 +1,84 @@
+#ifndef __FILEWATCHER_H__
+#define __FILEWATCHER_H__
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+/**************************************************************************/
+
+/*
+* ļ޸ģWindows  ReadDirectoryChangesWƽ̨ inotify
+*
+* ӵļڵĿ¼ٰļˣ"дʱļٸ"ı淽ʽ༭ CConfigMgr дģҲյ֪ͨ
+* ͬһļ debounceMs ڵ¼ϲһλصصڼִ߳Уֱ½ļռý߳
+* ص׳쳣ڼ߳ϱ̵std::thread ӳ쳣ֹ̣Ϊ¼ʧܣ֮޸ճ֪ͨ
+* Ŀ¼¼̫ࡢϵͳʱĿ¼бӵļյһλص
+*/
+class FileWatcher
+{
+public:
+    typedef std::function<void()> Callback;
+
+    FileWatcher();
+    ~FileWatcher();
+
+    bool watch(const std::wstring& path, const Callback& onChanged);    //  start() ֮ǰã·ڵǰĿ¼
+    bool start(unsigned int debounceMs = 200);                          // һĿ¼򲻿ʱ false
+    void stop();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct File
+    {
+        std::wstring name;
+        std::string nativeName;     // inotify ϱļ UTF-8
+        Callback callback;
+        bool pending;
+        Clock::time_point due;
+    };
+
+    struct Directory
+    {
+        std::wstring path;
+        std::vector<File> files;
+#ifdef _WIN32
+        HANDLE handle;
+        HANDLE event;
+        OVERLAPPED overlapped;
+        std::vector<DWORD> buffer;  // FILE_NOTIFY_INFORMATION Ҫ DWORD 
+        bool reading;               // һ ReadDirectoryChangesW ;
+#else
+        int wd;
+#endif
+    };
+
+    void run();
+    void changed(File& file);
+    int fireDue();          // ִеڵĻصؾһڻжٺ룬ûдִеĻصʱ -1
+    void close();
+#ifdef _WIN32
+    bool issueRead(Directory& directory);
+#endif
+
+    FileWatcher(const FileWatcher&);
+    void operator=(const FileWatcher&);
+
+private:
+    std::vector<Directory> m_directories;
+    std::thread m_thread;
+    Clock::duration m_debounce;
+#ifdef _WIN32
+    HANDLE m_stopEvent;
+#else
+    int m_inotify;
+    int m_stopPipe[2];
+#endif
+};
+
+#endif /* __FILEWATCHER_H__ */
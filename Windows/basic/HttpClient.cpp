@@ -1,257 +1,1394 @@
 #include "HttpClient.h"
+#include "HttpContentCoding.h"
+#if HTTP_USE_WINHTTP
 #include "Base.h"
+#include <atomic>
+#include <set>
+#else
+#include "HttpEventLoop.h"
+#include "HttpSocketTransport.h"
+#include <errno.h>
+#include <stdio.h>
+#endif
 #include <assert.h>
+#include <limits.h>
+#include <wctype.h>
+#include <algorithm>
+#include <condition_variable>
 #include <memory>
+#include <thread>
 /**************************************************************************/
 
-#define USER_CURL 0
+namespace
+{
+    // headers ǷѾΪ name ͷִСд
+    bool hasHeader(const std::vector<std::wstring>& headers, const wchar_t* name)
+    {
+        size_t const length = ::wcslen(name);
+        for (std::vector<std::wstring>::const_iterator it = headers.begin(); headers.end() != it; ++it)
+        {
+            if (it->size() <= length || L':' != (*it)[length])
+            {
+                continue;
+            }
+            size_t i = 0;
+            while (i < length && ::towlower((*it)[i]) == ::towlower(name[i]))
+            {
+                ++i;
+            }
+            if (length == i)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    double elapsedMs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+}
 
-struct RequestSink
+#if HTTP_USE_WINHTTP
+
+namespace
 {
-    std::string* reqData;
-    size_t sendSize;
-};
-
-struct ResponseSink
+    const DWORD kHttpTimedOut = ERROR_WINHTTP_TIMEOUT;
+    const DWORD kHttpCancelled = ERROR_WINHTTP_OPERATION_CANCELLED;
+
+    class WinHttpHandle
+    {
+    public:
+        explicit WinHttpHandle(HINTERNET handle = NULL) : m_handle(handle) {}
+        ~WinHttpHandle()
+        {
+            if (m_handle)
+            {
+                ::WinHttpCloseHandle(m_handle);
+            }
+        }
+
+        HINTERNET get() const { return m_handle; }
+        HINTERNET release()
+        {
+            HINTERNET handle = m_handle;
+            m_handle = NULL;
+            return handle;
+        }
+
+    private:
+        DISALLOW_COPY_AND_ASSIGN(WinHttpHandle);
+
+        HINTERNET m_handle;
+    };
+
+    // ڳе connect ײ socket ı WinHTTP 
+    class WinHttpConnection : public HttpConnection
+    {
+    public:
+        explicit WinHttpConnection(HINTERNET hConnect) : m_hConnect(hConnect) {}
+
+        HINTERNET handle() const { return m_hConnect.get(); }
+
+        virtual bool isAlive() const { return true; }
+
+    private:
+        WinHttpHandle m_hConnect;
+    };
+
+    BOOL crackUrl(const std::wstring& url, std::wstring& host_name, std::wstring& url_path, URL_COMPONENTS& url_comp)
+    {
+        ::memset(&url_comp, 0, sizeof(url_comp));
+        url_comp.dwStructSize = sizeof(url_comp);
+
+        host_name.resize(url.size());
+        url_path.resize(url.size());
+
+        url_comp.lpszHostName = const_cast<wchar_t*>(host_name.data());
+        url_comp.dwHostNameLength = host_name.size();
+        url_comp.lpszUrlPath = const_cast<wchar_t*>(url_path.data());
+        url_comp.dwUrlPathLength = url_path.size();
+        if (FALSE == ::WinHttpCrackUrl(url.c_str(), static_cast<DWORD>(url.size()), 0, &url_comp))
+        {
+            return FALSE;
+        }
+        host_name.resize(url_comp.dwHostNameLength);
+        return TRUE;
+    }
+
+    //  WinHTTP  Accept-Encoding ѹӦϵͳָ֧ѡʱʧܣδѹշ
+    void enableDecompression(HINTERNET hRequest)
+    {
+#ifdef WINHTTP_OPTION_DECOMPRESSION
+        DWORD flags = WINHTTP_DECOMPRESSION_FLAG_ALL;
+        ::WinHttpSetOption(hRequest, WINHTTP_OPTION_DECOMPRESSION, &flags, sizeof(flags));
+#endif
+    }
+
+    //  HttpClient::setProxy() ָHttpProxyNone ʱûỰϵͳãWinHTTP Լڴϸ
+    DWORD applyProxy(HINTERNET hRequest, const HttpProxy& proxy)
+    {
+        if (HttpProxyNone == proxy.type)
+        {
+            return ERROR_SUCCESS;
+        }
+        if (HttpProxyHttp != proxy.type)
+        {
+            return EcHttpUnsupported;   // WinHTTP ֧ SOCKS 
+        }
+
+        std::wstring host = UTF82Wide(proxy.host);
+        std::wstring server = (std::wstring::npos == host.find(L':') ? host : L"[" + host + L"]") + L":" + std::to_wstring(proxy.port);
+        WINHTTP_PROXY_INFO info;
+        info.dwAccessType = WINHTTP_ACCESS_TYPE_NAMED_PROXY;
+        info.lpszProxy = const_cast<wchar_t*>(server.c_str());
+        info.lpszProxyBypass = NULL;
+        if (FALSE == ::WinHttpSetOption(hRequest, WINHTTP_OPTION_PROXY, &info, sizeof(info)))
+        {
+            return ::GetLastError();
+        }
+
+        if (false == proxy.username.empty())
+        {
+            // յ 407 ʱ WinHTTP ûӦ֤
+            std::wstring username = UTF82Wide(proxy.username);
+            std::wstring password = UTF82Wide(proxy.password);
+            if (FALSE == ::WinHttpSetOption(hRequest, WINHTTP_OPTION_PROXY_USERNAME, const_cast<wchar_t*>(username.c_str()), username.size())
+                || FALSE == ::WinHttpSetOption(hRequest, WINHTTP_OPTION_PROXY_PASSWORD, const_cast<wchar_t*>(password.c_str()), password.size()))
+            {
+                return ::GetLastError();
+            }
+        }
+        return ERROR_SUCCESS;
+    }
+
+    // WinHTTP ֻܰ׶óʱ׶ȡֹʱǰʣʱ WinHTTP Ĭֵ
+    BOOL applyDeadline(HINTERNET hRequest, std::chrono::steady_clock::time_point deadline)
+    {
+        if (std::chrono::steady_clock::time_point::max() == deadline)
+        {
+            return TRUE;
+        }
+        long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0)
+        {
+            ::SetLastError(ERROR_WINHTTP_TIMEOUT);
+            return FALSE;
+        }
+        int timeout = (remaining > INT_MAX ? INT_MAX : static_cast<int>(remaining));
+        return ::WinHttpSetTimeouts(hRequest, timeout, (std::min)(timeout, 60 * 1000), (std::min)(timeout, 30 * 1000), (std::min)(timeout, 30 * 1000));
+    }
+}
+
+/*
+* WinHTTP 첽ģʽĻỰ WinHTTP Ĺ߳ͨ״̬صƽ
+*
+* ÿһص HANDLE_CLOSINGûصִУ֮󼴱ͷ
+*/
+class WinHttpAsyncSession
 {
-    std::string* respData;
-    std::vector<std::string>* respHeaders;
+public:
+    WinHttpAsyncSession() : m_hSession(NULL) {}
+    ~WinHttpAsyncSession();     // ȡδɵ󲢵ȴǻصϣҪڻص
+
+    DWORD open(const std::wstring& user_agent, size_t maxConnectionsPerHost);
+    void setMaxConnectionsPerHost(size_t count);
+    void setTimingListener(const HttpTimingCallback& listener) { m_timingListener = listener; }   // open() ֮ǰ
+    // شʱصsink ΪʱӦսַ callback
+    DWORD submit(const std::wstring& host_name, INTERNET_PORT port, INTERNET_SCHEME scheme, const wchar_t* url_path
+        , const std::wstring& method, const std::vector<std::wstring>& headers, const std::string& body, bool decompress
+        , const HttpProxy& proxy, std::chrono::steady_clock::time_point deadline, HttpBodySink* sink, const HttpCallback& callback);
+
+private:
+    struct Request
+    {
+        WinHttpAsyncSession* session;
+        HINTERNET hConnect;
+        HINTERNET hRequest;
+        std::string body;           // ǰ뱣Ч
+        std::string resp_data;
+        std::unique_ptr<HttpStringSink> buffered;
+        HttpBodySink* sink;         // ÷Ľд resp_data  buffered
+        char buffer[8 * 1024];
+        DWORD statusCode;
+        DWORD error;
+        std::atomic<bool> closing;  // ֻλɹһر
+        HttpCallback callback;
+        HttpTiming timing;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point step;     // ǰ׶εĿʼʱ
+    };
+
+    static void CALLBACK onStatus(HINTERNET hInternet, DWORD_PTR context, DWORD status, LPVOID info, DWORD length);
+    void close(Request* request, DWORD error);
+    void closed(Request* request);
+
+    DISALLOW_COPY_AND_ASSIGN(WinHttpAsyncSession);
+
+private:
+    HINTERNET m_hSession;
+    HttpTimingCallback m_timingListener;
+    std::mutex m_mutex;
+    std::condition_variable m_idle;
+    std::set<Request*> m_requests;
 };
 
-static size_t onRequest(void *ptr, size_t size, size_t nmemb, void *stream)
-{
-    RequestSink* reqSink = reinterpret_cast<RequestSink*>(stream);
-    std::string* reqData = reqSink->reqData;
-
-    size_t sendSize = reqSink->sendSize;
-    size_t actualSize = reqData->size() - sendSize;
-    if (actualSize > 4096)
-    {
-        actualSize = 4096;
-    }
-
-    memcpy_s(ptr, size * nmemb, &((*reqData)[sendSize]), actualSize);
-    reqSink->sendSize += actualSize;
-
-    return actualSize;
-}
-
-static size_t onResponse(void *ptr, size_t size, size_t nmemb, void *stream)
-{
-    ResponseSink* respSink = reinterpret_cast<ResponseSink*>(stream);
-    std::string* respData = respSink->respData;
-
-    respData->append((char*)ptr, size * nmemb);
-
-    return (size * nmemb);
-}
-
-static size_t onHeaderCallback(char *buffer, size_t size, size_t nitems, void *userdata)
-{
-    std::string str(buffer, size * nitems);
-    size_t index = str.rfind('\r');
-
-    std::string header = str.substr(0, index);
-    if (false == header.empty())
-    {
-        ResponseSink* respSink = reinterpret_cast<ResponseSink*>(userdata);
-        respSink->respHeaders->push_back(header.substr(0, index));
-    }
-
-    return (size * nitems);
+WinHttpAsyncSession::~WinHttpAsyncSession()
+{
+    std::vector<HINTERNET> handles;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::set<Request*>::iterator it = m_requests.begin(); m_requests.end() != it; ++it)
+        {
+            if (false == (*it)->closing.exchange(true))
+            {
+                (*it)->error = ERROR_WINHTTP_OPERATION_CANCELLED;
+                handles.push_back((*it)->hRequest);
+            }
+        }
+    }
+    // HANDLE_CLOSING  WinHttpCloseHandle ͬصܳ
+    for (std::vector<HINTERNET>::iterator it = handles.begin(); handles.end() != it; ++it)
+    {
+        ::WinHttpCloseHandle(*it);
+    }
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_requests.empty(); });
+    }
+
+    if (m_hSession)
+    {
+        ::WinHttpSetStatusCallback(m_hSession, NULL, 0, 0);
+        ::WinHttpCloseHandle(m_hSession);
+    }
 }
 
+DWORD WinHttpAsyncSession::open(const std::wstring& user_agent, size_t maxConnectionsPerHost)
+{
+    m_hSession = ::WinHttpOpen(user_agent.c_str()
+        , WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, WINHTTP_FLAG_ASYNC);
+    if (NULL == m_hSession)
+    {
+        return ::GetLastError();
+    }
+
+    // صڻỰϣ֮󴴽Ӻ̳
+    if (WINHTTP_INVALID_STATUS_CALLBACK == ::WinHttpSetStatusCallback(m_hSession, &WinHttpAsyncSession::onStatus
+        , WINHTTP_CALLBACK_FLAG_ALL_COMPLETIONS | WINHTTP_CALLBACK_FLAG_HANDLES, 0))
+    {
+        return ::GetLastError();
+    }
+
+    setMaxConnectionsPerHost(maxConnectionsPerHost);
+    return ERROR_SUCCESS;
+}
+
+void WinHttpAsyncSession::setMaxConnectionsPerHost(size_t count)
+{
+    // 첽Ự WinHTTP Լά޽ WinHTTP ִ
+    DWORD value = (0 == count ? INFINITE : static_cast<DWORD>(count));
+    ::WinHttpSetOption(m_hSession, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &value, sizeof(value));
+    ::WinHttpSetOption(m_hSession, WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER, &value, sizeof(value));
+}
+
+DWORD WinHttpAsyncSession::submit(const std::wstring& host_name, INTERNET_PORT port, INTERNET_SCHEME scheme, const wchar_t* url_path
+    , const std::wstring& method, const std::vector<std::wstring>& headers, const std::string& body, bool decompress
+    , const HttpProxy& proxy, std::chrono::steady_clock::time_point deadline, HttpBodySink* sink, const HttpCallback& callback)
+{
+    std::unique_ptr<Request> request(new Request());
+    request->session = this;
+    request->hConnect = NULL;
+    request->hRequest = NULL;
+    request->body = body;
+    if (NULL == sink)
+    {
+        request->buffered.reset(new HttpStringSink(request->resp_data));
+        sink = request->buffered.get();
+    }
+    request->sink = sink;
+    request->statusCode = 0;
+    request->error = ERROR_SUCCESS;
+    request->closing = false;
+    request->callback = callback;
+    request->timing.host = Wide2UTF8(host_name);
+    request->timing.bytesSent = body.size();
+    request->start = request->step = std::chrono::steady_clock::now();
+
+    // ֮ǰľرʱ HANDLE_CLOSING Ϊ 0ᱻ
+    WinHttpHandle hConnect(::WinHttpConnect(m_hSession, host_name.c_str(), port, 0));
+    if (NULL == hConnect.get())
+    {
+        return ::GetLastError();
+    }
+
+    DWORD flags = (INTERNET_SCHEME_HTTP == scheme ? 0 : WINHTTP_FLAG_SECURE);
+    WinHttpHandle hRequest(::WinHttpOpenRequest(hConnect.get(), method.c_str(), url_path,
+        NULL, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, flags));
+    if (NULL == hRequest.get())
+    {
+        return ::GetLastError();
+    }
+
+    for (std::vector<std::wstring>::const_iterator it = headers.begin(); headers.end() != it; ++it)
+    {
+        ::WinHttpAddRequestHeaders(hRequest.get(), it->c_str(), (ULONG)-1L, WINHTTP_ADDREQ_FLAG_ADD | WINHTTP_ADDREQ_FLAG_COALESCE);
+    }
+    if (decompress)
+    {
+        enableDecompression(hRequest.get());
+    }
+    DWORD proxied = applyProxy(hRequest.get(), proxy);
+    if (ERROR_SUCCESS != proxied)
+    {
+        return proxied;
+    }
+    if (FALSE == applyDeadline(hRequest.get(), deadline))
+    {
+        return ::GetLastError();
+    }
+
+    DWORD_PTR context = reinterpret_cast<DWORD_PTR>(request.get());
+    if (FALSE == ::WinHttpSetOption(hRequest.get(), WINHTTP_OPTION_CONTEXT_VALUE, &context, sizeof(context)))
+    {
+        return ::GetLastError();
+    }
+
+    // ￪ʼ HANDLE_CLOSING ͷ
+    request->hConnect = hConnect.release();
+    request->hRequest = hRequest.release();
+    Request* item = request.release();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.insert(item);
+    }
+
+    void* body_data = (item->body.empty() ? WINHTTP_NO_REQUEST_DATA : const_cast<char*>(item->body.data()));
+    if (FALSE == ::WinHttpSendRequest(item->hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0
+        , body_data, item->body.size(), item->body.size(), context))
+    {
+        close(item, ::GetLastError());
+    }
+    return ERROR_SUCCESS;
+}
+
+void CALLBACK WinHttpAsyncSession::onStatus(HINTERNET hInternet, DWORD_PTR context, DWORD status, LPVOID info, DWORD length)
+{
+    Request* request = reinterpret_cast<Request*>(context);
+    if (NULL == request)
+    {
+        return;     // ỰӾ
+    }
+
+    WinHttpAsyncSession* session = request->session;
+    switch (status)
+    {
+    case WINHTTP_CALLBACK_STATUS_SENDREQUEST_COMPLETE:
+        request->timing.sendMs = elapsedMs(request->step, std::chrono::steady_clock::now());
+        request->step = std::chrono::steady_clock::now();
+        if (FALSE == ::WinHttpReceiveResponse(hInternet, NULL))
+        {
+            session->close(request, ::GetLastError());
+        }
+        break;
+    case WINHTTP_CALLBACK_STATUS_HEADERS_AVAILABLE:
+    {
+        request->timing.ttfbMs = elapsedMs(request->step, std::chrono::steady_clock::now());
+        request->step = std::chrono::steady_clock::now();
+        DWORD size = sizeof(request->statusCode);
+        if (FALSE == ::WinHttpQueryHeaders(hInternet, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER
+            , WINHTTP_HEADER_NAME_BY_INDEX, &request->statusCode, &size, WINHTTP_NO_HEADER_INDEX)
+            || FALSE == ::WinHttpQueryDataAvailable(hInternet, NULL))
+        {
+            session->close(request, ::GetLastError());
+        }
+        break;
+    }
+    case WINHTTP_CALLBACK_STATUS_DATA_AVAILABLE:
+    {
+        DWORD size = *static_cast<DWORD*>(info);
+        if (0 == size)
+        {
+            session->close(request, 200 == request->statusCode ? static_cast<DWORD>(ERROR_SUCCESS) : static_cast<DWORD>(EcHttpCodeError));
+        }
+        else if (FALSE == ::WinHttpReadData(hInternet, request->buffer
+            , size < sizeof(request->buffer) ? size : sizeof(request->buffer), NULL))
+        {
+            session->close(request, ::GetLastError());
+        }
+        break;
+    }
+    case WINHTTP_CALLBACK_STATUS_READ_COMPLETE:
+        request->timing.bytesReceived += length;
+        if (false == request->sink->onData(static_cast<const char*>(info), length))
+        {
+            session->close(request, EcHttpAborted);
+        }
+        else if (FALSE == ::WinHttpQueryDataAvailable(hInternet, NULL))
+        {
+            session->close(request, ::GetLastError());
+        }
+        break;
+    case WINHTTP_CALLBACK_STATUS_REQUEST_ERROR:
+        session->close(request, static_cast<WINHTTP_ASYNC_RESULT*>(info)->dwError);
+        break;
+    case WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING:
+        session->closed(request);
+        break;
+    default:
+        break;
+    }
+}
+
+void WinHttpAsyncSession::close(Request* request, DWORD error)
+{
+    // ر֮ request ʱܱͷţٷ
+    if (false == request->closing.exchange(true))
+    {
+        request->error = error;
+        ::WinHttpCloseHandle(request->hRequest);
+    }
+}
+
+void WinHttpAsyncSession::closed(Request* request)
+{
+    std::unique_ptr<Request> owner(request);
+    ::WinHttpCloseHandle(request->hConnect);
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (request->timing.ttfbMs >= 0)
+    {
+        request->timing.transferMs = elapsedMs(request->step, now);
+    }
+    request->timing.totalMs = elapsedMs(request->start, now);
+    request->timing.error = request->error;
+    if (m_timingListener)
+    {
+        m_timingListener(request->timing);
+    }
+
+    if (ERROR_SUCCESS != request->error && EcHttpCodeError != request->error)
+    {
+        request->resp_data.clear();
+    }
+    request->callback(request->error, request->resp_data);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_requests.erase(request);
+    if (m_requests.empty())
+    {
+        m_idle.notify_all();
+    }
+}
+
+#else
+
+namespace
+{
+    const DWORD kHttpTimedOut = ETIMEDOUT;
+    const DWORD kHttpCancelled = ECANCELED;
+
+    std::string wideToUtf8(const std::wstring& wide)
+    {
+        std::string result;
+        result.reserve(wide.size());
+        for (std::wstring::const_iterator it = wide.begin(); wide.end() != it; ++it)
+        {
+            unsigned long cp = static_cast<unsigned long>(*it);
+            if (cp < 0x80)
+            {
+                result += static_cast<char>(cp);
+            }
+            else if (cp < 0x800)
+            {
+                result += static_cast<char>(0xC0 | (cp >> 6));
+                result += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000)
+            {
+                result += static_cast<char>(0xE0 | (cp >> 12));
+                result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                result += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else
+            {
+                result += static_cast<char>(0xF0 | ((cp >> 18) & 0x07));
+                result += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                result += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+        }
+        return result;
+    }
+
+    //  URL װģdecode Ϊ true ʱ Accept-Encoding
+    DWORD prepareRequest(const std::wstring& url, const std::wstring& method, const std::wstring& user_agent
+        , const std::vector<std::wstring>& headers, const std::string& body, bool tls, bool decode, const HttpProxy& proxy
+        , HttpUrl& target, std::string& data)
+    {
+        if (false == parseHttpUrl(wideToUtf8(url), target))
+        {
+            return EcHttpInvalidUrl;
+        }
+        if ("https" == target.scheme && false == tls)
+        {
+            return EcHttpUnsupported;   // û TLS 
+        }
+
+        std::vector<std::string> lines;
+        for (std::vector<std::wstring>::const_iterator it = headers.begin(); headers.end() != it; ++it)
+        {
+            lines.push_back(wideToUtf8(*it));
+        }
+        if (decode)
+        {
+            lines.push_back(std::string("Accept-Encoding: ") + httpAcceptEncoding());
+        }
+        //  HTTP д URL֤Ϣͷ
+        bool const forward = (HttpProxyNone != proxy.type && false == httpProxyTunnels(proxy, target));
+        std::string authorization = httpProxyAuthorization(proxy);
+        if (forward && false == authorization.empty())
+        {
+            lines.push_back("Proxy-Authorization: " + authorization);
+        }
+        data = formatHttpRequest(wideToUtf8(method), target, wideToUtf8(user_agent), lines, body, forward);
+        return ERROR_SUCCESS;
+    }
+
+    // ĳʱֹʱǰʣʱѾ˽ֹʱʱΪ 0
+    int stepTimeout(int timeoutMs, std::chrono::steady_clock::time_point deadline)
+    {
+        if (std::chrono::steady_clock::time_point::max() == deadline)
+        {
+            return timeoutMs;
+        }
+        long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        return remaining <= 0 ? 0 : (remaining < timeoutMs ? static_cast<int>(remaining) : timeoutMs);
+    }
+
+    // ½ target ӣʱٽhttps  TLS ֣ͬʱд timing жӦĲ
+    DWORD establish(HttpSocketConnection& connection, const HttpUrl& target, const HttpProxy& proxy, HttpTlsProvider* tls
+        , std::chrono::steady_clock::time_point deadline, HttpTiming& timing)
+    {
+        bool const direct = (HttpProxyNone == proxy.type);
+        std::chrono::steady_clock::time_point step = std::chrono::steady_clock::now();
+        DWORD ret = connection.connect(direct ? target.host : proxy.host, direct ? target.port : proxy.port
+            , stepTimeout(kHttpConnectTimeoutMs, deadline));
+        timing.dnsMs = connection.resolveMs();
+        timing.connectMs = elapsedMs(step, std::chrono::steady_clock::now()) - timing.dnsMs;
+        if (ERROR_SUCCESS == ret && httpProxyTunnels(proxy, target))
+        {
+            step = std::chrono::steady_clock::now();
+            ret = connection.tunnel(proxy, target.host, target.port, stepTimeout(kHttpIoTimeoutMs, deadline));
+            timing.proxyMs = elapsedMs(step, std::chrono::steady_clock::now());
+        }
+        if (ERROR_SUCCESS == ret && "https" == target.scheme)
+        {
+            step = std::chrono::steady_clock::now();
+            ret = connection.handshake(*tls, target.host, stepTimeout(kHttpIoTimeoutMs, deadline));
+            timing.tlsMs = elapsedMs(step, std::chrono::steady_clock::now());
+        }
+        return ret;
+    }
+
+    // 󲢶Ӧͬʱд timing з͡ȴͽյĲ
+    DWORD exchange(HttpSocketConnection& connection, const std::string& request
+        , HttpResponseParser& parser, HttpBodySink& sink, std::chrono::steady_clock::time_point deadline, HttpTiming& timing)
+    {
+        std::chrono::steady_clock::time_point step = std::chrono::steady_clock::now();
+        DWORD ret = connection.send(request.data(), request.size(), stepTimeout(kHttpIoTimeoutMs, deadline));
+        if (ERROR_SUCCESS != ret)
+        {
+            return ret;
+        }
+        timing.bytesSent = request.size();
+        timing.sendMs = elapsedMs(step, std::chrono::steady_clock::now());
+        step = std::chrono::steady_clock::now();
+        timing.bytesReceived = 0;
+        timing.ttfbMs = timing.transferMs = -1;
+
+        char buffer[16 * 1024];
+        while (false == parser.complete())
+        {
+            size_t received = 0;
+            ret = connection.receive(buffer, sizeof(buffer), received, stepTimeout(kHttpIoTimeoutMs, deadline));
+            if (ERROR_SUCCESS != ret)
+            {
+                return ret;
+            }
+            if (0 == timing.bytesReceived && received > 0)
+            {
+                timing.ttfbMs = elapsedMs(step, std::chrono::steady_clock::now());
+                step = std::chrono::steady_clock::now();
+            }
+            timing.bytesReceived += received;
+            if (0 == received)
+            {
+                if (parser.finish())
+                {
+                    break;
+                }
+                return parser.started() ? static_cast<DWORD>(EcHttpProtocolError) : static_cast<DWORD>(ECONNRESET);
+            }
+            if (false == parser.feed(buffer, received, sink))
+            {
+                return parser.aborted() ? static_cast<DWORD>(EcHttpAborted) : static_cast<DWORD>(EcHttpProtocolError);
+            }
+        }
+        timing.transferMs = elapsedMs(step, std::chrono::steady_clock::now());
+        return ERROR_SUCCESS;
+    }
+}
+
+#endif
+
+namespace
+{
+    const size_t kLatencySamples = 128;     // Գӳõɹ
+    const size_t kHedgeMinSamples = 20;     // ʱʹ HttpRetryPolicy::hedgeDelayMs
+
+    bool isIdempotent(const std::wstring& method)
+    {
+        return 0 == method.compare(L"GET") || 0 == method.compare(L"PUT");
+    }
+
+    // һӻԺпܳɹĴ
+    bool isRetryable(DWORD error)
+    {
+        switch (error)
+        {
+        case ERROR_SUCCESS:
+        case EcHttpCodeError:
+        case EcHttpInvalidUrl:
+        case EcHttpUnsupported:
+        case EcHttpTlsError:
+        case EcHttpAborted:
+        case EcHttpProxyAuthFailed:
+        case kHttpCancelled:
+#if HTTP_USE_WINHTTP
+        case ERROR_WINHTTP_INVALID_URL:
+        case ERROR_WINHTTP_UNRECOGNIZED_SCHEME:
+        case ERROR_WINHTTP_SECURE_FAILURE:
+#endif
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    // ¼ǷѾ÷ sink ͹ݣ͹ĻҪ rewind() ɹ
+    class TrackingSink : public HttpBodySink
+    {
+    public:
+        explicit TrackingSink(HttpBodySink& sink) : m_sink(sink), m_received(false) {}
+
+        virtual bool onData(const char* data, size_t size)
+        {
+            m_received = true;
+            return m_sink.onData(data, size);
+        }
+        virtual bool rewind()
+        {
+            if (m_received && false == m_sink.rewind())
+            {
+                return false;
+            }
+            m_received = false;
+            return true;
+        }
+
+    private:
+        HttpBodySink& m_sink;
+        bool m_received;
+    };
+}
+
+HttpTiming::HttpTiming()
+    : error(ERROR_SUCCESS)
+    , reused(false)
+    , queueMs(-1)
+    , dnsMs(-1)
+    , connectMs(-1)
+    , proxyMs(-1)
+    , tlsMs(-1)
+    , sendMs(-1)
+    , ttfbMs(-1)
+    , transferMs(-1)
+    , totalMs(-1)
+    , bytesSent(0)
+    , bytesReceived(0)
+{
+
+}
+
+// һ첽гԣԺͶԳ壩״̬callback ֻᱻһ
+struct HttpClient::RetryState
+{
+    RetryState() : maxAttempts(1), failures(0), inflight(0), hedged(false), done(false), timeoutTimer(0), hedgeTimer(0) {}
+
+    std::wstring url;
+    std::wstring method;
+    std::vector<std::wstring> headers;
+    std::string body;
+    Clock::time_point deadline;
+    unsigned int maxAttempts;
+    std::unique_ptr<TrackingSink> sink;     // ʽĽΪʱӦսַ
+
+    std::mutex mutex;
+    HttpCallback callback;
+    unsigned int failures;
+    unsigned int inflight;      // ڽеĳ
+    bool hedged;
+    bool done;
+    HttpTimerQueue::TimerId timeoutTimer;   // ʱʱٳ state
+    HttpTimerQueue::TimerId hedgeTimer;
+};
+
 HttpClient::HttpClient(const std::wstring& user_agent)
 	: m_user_agent(user_agent)
+#if HTTP_USE_WINHTTP
 	, m_hSession(NULL)
-	, m_hConnect(NULL)
-	, m_hRequest(NULL)
-    , m_proxyIP("")
-    , m_proxyPort(1080)
+#else
+	, m_tls(NULL)
+#endif
+    , m_decompress(true)
+    , m_compressMinSize(0)
+    , m_timeoutMs(0)
+    , m_latencyNext(0)
+    , m_random(static_cast<unsigned int>(Clock::now().time_since_epoch().count()))
 {
 
 }
 
 HttpClient::~HttpClient()
 {
+    m_timers.stop();    // ȴеȡصٷµĳ
+    m_async.reset();    // δɵ첽صǵӻỹس
 	http_close();
 }
 
 
-size_t req_reply(void *ptr, size_t size, size_t nmemb, void *stream)
+bool HttpClient::setProxy(const std::string& ip, unsigned short port)
+{
+    HttpProxy proxy;
+#if HTTP_USE_WINHTTP
+    // ӿǰֻ¼Чԭÿʧܣ false õ÷֪û
+    (void)port;
+    setProxy(proxy);
+    return ip.empty();
+#else
+    if (false == ip.empty())
+    {
+        proxy.type = HttpProxySocks5;
+        proxy.host = ip;
+        proxy.port = port;
+    }
+    setProxy(proxy);
+    return true;
+#endif
+}
+
+void HttpClient::setProxy(const HttpProxy& proxy)
+{
+    m_proxy = proxy;
+}
+
+void HttpClient::setMaxConnectionsPerHost(size_t count)
+{
+    m_pool.setMaxConnectionsPerHost(count);
+#if HTTP_USE_WINHTTP
+    std::lock_guard<std::mutex> lock(m_asyncMutex);
+    if (m_async)
+    {
+        m_async->setMaxConnectionsPerHost(count);
+    }
+#endif
+}
+
+void HttpClient::setIdleTimeout(unsigned int ms)
+{
+    m_pool.setIdleTimeout(ms);
+}
+
+HttpConnectionPool::Stats HttpClient::poolStats() const
+{
+    return m_pool.stats();
+}
+
+#if !HTTP_USE_WINHTTP
+void HttpClient::setTlsProvider(HttpTlsProvider* provider)
+{
+    m_tls = provider;
+}
+#endif
+
+void HttpClient::setDecompression(bool enable)
+{
+    m_decompress = enable;
+}
+
+void HttpClient::setRequestCompression(size_t minSize)
+{
+    m_compressMinSize = minSize;
+}
+
+void HttpClient::setRequestTimeout(unsigned int ms)
+{
+    m_timeoutMs = ms;
+}
+
+void HttpClient::setRetryPolicy(const HttpRetryPolicy& policy)
 {
-	std::string *str = (std::string*)stream;
-	(*str).append((char*)ptr, size * nmemb);
-	return (size * nmemb);
+    m_retry = policy;
 }
 
-void HttpClient::setProxy(const std::string& ip, unsigned short port)
+void HttpClient::setTimingListener(const HttpTimingCallback& listener)
 {
-    m_proxyIP = ip;
-    m_proxyPort = port;
+    m_timingListener = listener;
+}
+
+void HttpClient::notifyTiming(const HttpTiming& timing) const
+{
+    if (m_timingListener)
+    {
+        m_timingListener(timing);
+    }
+}
+
+bool HttpClient::compressBody(const std::vector<std::wstring>& headers, const std::string& body
+    , std::vector<std::wstring>& compressedHeaders, std::string& compressed) const
+{
+    // ÷Լ Content-Encoding ʱѾ
+    if (0 == m_compressMinSize || body.size() < m_compressMinSize || hasHeader(headers, L"Content-Encoding"))
+    {
+        return false;
+    }
+    if (false == httpGzip(body, compressed) || compressed.size() >= body.size())
+    {
+        return false;
+    }
+    compressedHeaders = headers;
+    compressedHeaders.push_back(L"Content-Encoding: gzip");
+    return true;
 }
 
 DWORD HttpClient::http_get(const std::wstring& url
 	, const std::vector<std::wstring>& headers, std::string& resp_data)
 {
-	DWORD ret = request(url, L"GET", headers, std::string(), resp_data);
-	http_close();
-	return ret;
-
+	return requestBuffered(url, L"GET", headers, std::string(), resp_data);
 }
 
 DWORD HttpClient::http_post(const std::wstring& url
 	, const std::vector<std::wstring>& headers, const std::string& body, std::string& resp_data)
 {
-
-	DWORD ret = request(url, L"POST", headers, body, resp_data);
-	http_close();
-	return ret;
+	return requestBuffered(url, L"POST", headers, body, resp_data);
 }
 
 DWORD HttpClient::http_put(const std::wstring& url
 	, const std::vector<std::wstring>& headers, const std::string& body, std::string& resp_data)
 {
-	DWORD ret = request(url, L"PUT", headers, body, resp_data);
-	http_close();
+	return requestBuffered(url, L"PUT", headers, body, resp_data);
+}
 
-	return ret;
+DWORD HttpClient::http_get(const std::wstring& url
+    , const std::vector<std::wstring>& headers, HttpBodySink& sink)
+{
+    return request(url, L"GET", headers, std::string(), sink);
+}
+
+DWORD HttpClient::http_post(const std::wstring& url
+    , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink)
+{
+    return request(url, L"POST", headers, body, sink);
+}
+
+DWORD HttpClient::http_put(const std::wstring& url
+    , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink)
+{
+    return request(url, L"PUT", headers, body, sink);
+}
+
+void HttpClient::http_get_async(const std::wstring& url
+    , const std::vector<std::wstring>& headers, const HttpCallback& callback)
+{
+    requestAsync(url, L"GET", headers, std::string(), NULL, callback);
+}
+
+void HttpClient::http_post_async(const std::wstring& url
+    , const std::vector<std::wstring>& headers, const std::string& body, const HttpCallback& callback)
+{
+    requestAsync(url, L"POST", headers, body, NULL, callback);
+}
+
+void HttpClient::http_put_async(const std::wstring& url
+    , const std::vector<std::wstring>& headers, const std::string& body, const HttpCallback& callback)
+{
+    requestAsync(url, L"PUT", headers, body, NULL, callback);
+}
+
+void HttpClient::http_get_async(const std::wstring& url
+    , const std::vector<std::wstring>& headers, HttpBodySink& sink, const HttpSinkCallback& callback)
+{
+    requestAsync(url, L"GET", headers, std::string(), &sink, [callback](DWORD error, std::string&) { callback(error); });
+}
+
+void HttpClient::http_post_async(const std::wstring& url
+    , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink, const HttpSinkCallback& callback)
+{
+    requestAsync(url, L"POST", headers, body, &sink, [callback](DWORD error, std::string&) { callback(error); });
+}
+
+void HttpClient::http_put_async(const std::wstring& url
+    , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink, const HttpSinkCallback& callback)
+{
+    requestAsync(url, L"PUT", headers, body, &sink, [callback](DWORD error, std::string&) { callback(error); });
 }
 
 void HttpClient::http_close()
 {
-    if (m_hRequest)
+    m_pool.clear();
+}
+
+DWORD HttpClient::request(const std::wstring& url, const std::wstring& method
+    , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink)
+{
+    std::vector<std::wstring> gzip_headers;
+    std::string gzip_body;
+    if (compressBody(headers, body, gzip_headers, gzip_body))
     {
-        WinHttpCloseHandle(m_hRequest);
-        m_hRequest = NULL;
+        return request(url, method, gzip_headers, gzip_body, sink);
     }
 
-    if (m_hConnect)
+    Clock::time_point until = deadline();
+    unsigned int attempts = (isIdempotent(method) && m_retry.maxAttempts > 1 ? m_retry.maxAttempts : 1);
+    TrackingSink tracked(sink);
+    for (unsigned int attempt = 1; ; ++attempt)
     {
-        WinHttpCloseHandle(m_hConnect);
-        m_hConnect = NULL;
+        Clock::time_point start = Clock::now();
+        DWORD ret = requestOnce(url, method, headers, body, tracked, until);
+        if (ERROR_SUCCESS == ret)
+        {
+            recordLatency(Clock::now() - start);
+            return ret;
+        }
+        if (attempt >= attempts || false == isRetryable(ret) || false == tracked.rewind())
+        {
+            return ret;
+        }
+
+        // ȲһγԾͻᳬʱĻֱӷһεĴ
+        Clock::time_point resume = Clock::now() + std::chrono::milliseconds(backoff(attempt));
+        if (resume >= until)
+        {
+            return ret;
+        }
+        std::this_thread::sleep_until(resume);
     }
+}
 
-    if (m_hSession)
+DWORD HttpClient::requestBuffered(const std::wstring& url, const std::wstring& method
+    , const std::vector<std::wstring>& headers, const std::string& body, std::string& resp_data)
+{
+    if (0 == m_retry.hedgeDelayMs || false == isIdempotent(method))
     {
-        WinHttpCloseHandle(m_hSession);
-        m_hSession = NULL;
+        HttpStringSink sink(resp_data);
+        return request(url, method, headers, body, sink);
     }
+
+    // ԳҪͬʱ󣬽첽ӿڣ
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    DWORD ret = ERROR_SUCCESS;
+    requestAsync(url, method, headers, body, NULL, [&](DWORD error, std::string& data)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        resp_data.append(data);
+        ret = error;
+        done = true;
+        finished.notify_all();  // ֪ͨغ÷ջʱʧЧ
+    });
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return done; });
+    return ret;
 }
 
-DWORD HttpClient::request(const std::wstring& url, const std::wstring& method
-	, const std::vector<std::wstring>& headers, const std::string& body, std::string& resp_data)
+void HttpClient::requestAsync(const std::wstring& url, const std::wstring& method
+    , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink* sink, const HttpCallback& callback)
 {
-	assert(NULL == m_hSession && NULL == m_hConnect && NULL == m_hRequest);
+    std::vector<std::wstring> gzip_headers;
+    std::string gzip_body;
+    if (compressBody(headers, body, gzip_headers, gzip_body))
+    {
+        requestAsync(url, method, gzip_headers, gzip_body, sink, callback);
+        return;
+    }
 
-	std::wstring host_name;
-	std::wstring url_path;
-	URL_COMPONENTS url_comp = { 0 };
-	url_comp.dwStructSize = sizeof(url_comp);
+    bool idempotent = isIdempotent(method);
+    bool retry = (idempotent && m_retry.maxAttempts > 1);
+    // Գͬʱ sink дʽ󲻶Գ
+    bool hedge = (idempotent && 0 != m_retry.hedgeDelayMs && NULL == sink);
+    if (false == retry && false == hedge && (0 == m_timeoutMs || sink))
+    {
+        requestOnceAsync(url, method, headers, body, sink, deadline(), callback);
+        return;
+    }
+
+    std::shared_ptr<RetryState> state(new RetryState());
+    state->url = url;
+    state->method = method;
+    state->headers = headers;
+    state->body = body;
+    state->deadline = deadline();
+    state->maxAttempts = (retry ? m_retry.maxAttempts : 1);
+    state->callback = callback;
+    if (sink)
+    {
+        state->sink.reset(new TrackingSink(*sink));
+    }
 
-	host_name.resize(url.size());
-	url_path.resize(url.size());
+    // ʽڳԻд sink ʱǰصʱֻÿγԵĽֹʱ˱ǰļ鱣֤
+    if (0 != m_timeoutMs && NULL == sink)
+    {
+        // ֻܱ֤γԲʱʱ˱ܵȴﱣ֤
+        HttpTimerQueue::TimerId timer = m_timers.schedule(m_timeoutMs, [this, state](bool cancelled)
+        {
+            std::string empty;
+            complete(state, cancelled ? kHttpCancelled : kHttpTimedOut, empty);
+        });
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->timeoutTimer = timer;
+    }
+    if (hedge)
+    {
+        HttpTimerQueue::TimerId timer = m_timers.schedule(hedgeDelay(), [this, state](bool cancelled)
+        {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                // ˱ܵȴʱԳ壬ȴںȻᷢһ
+                if (cancelled || state->done || state->hedged || 0 == state->inflight)
+                {
+                    return;
+                }
+                state->hedged = true;
+            }
+            launch(state);
+        });
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->hedgeTimer = timer;
+    }
+    launch(state);
+}
+
+void HttpClient::launch(const std::shared_ptr<RetryState>& state)
+{
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->done)
+        {
+            return;
+        }
+        ++state->inflight;
+    }
+
+    Clock::time_point start = Clock::now();
+    requestOnceAsync(state->url, state->method, state->headers, state->body, state->sink.get(), state->deadline
+        , [this, state, start](DWORD error, std::string& resp_data) { attemptDone(state, start, error, resp_data); });
+}
+
+void HttpClient::attemptDone(const std::shared_ptr<RetryState>& state, Clock::time_point start, DWORD error, std::string& resp_data)
+{
+    unsigned int delay = 0;
+    bool retry = false;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        --state->inflight;
+        if (state->done)
+        {
+            return;     // Գһݣʱ p95 ̧
+        }
+        if (isRetryable(error))
+        {
+            if (state->inflight > 0)
+            {
+                return; // һڽУĽΪ׼
+            }
+            // ʽѾҪջزط
+            if (++state->failures < state->maxAttempts && (!state->sink || state->sink->rewind()))
+            {
+                delay = backoff(state->failures);
+                retry = (Clock::now() + std::chrono::milliseconds(delay) < state->deadline);
+            }
+        }
+    }
+
+    if (false == retry)
+    {
+        if (ERROR_SUCCESS == error)
+        {
+            recordLatency(Clock::now() - start);
+        }
+        complete(state, error, resp_data);
+        return;
+    }
+    m_timers.schedule(delay, [this, state](bool cancelled)
+    {
+        if (cancelled)
+        {
+            std::string empty;
+            complete(state, kHttpCancelled, empty);
+            return;
+        }
+        launch(state);
+    });
+}
+
+void HttpClient::complete(const std::shared_ptr<RetryState>& state, DWORD error, std::string& resp_data)
+{
+    HttpCallback callback;
+    HttpTimerQueue::TimerId timeoutTimer = 0;
+    HttpTimerQueue::TimerId hedgeTimer = 0;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->done)
+        {
+            return;
+        }
+        state->done = true;
+        callback.swap(state->callback);
+        std::swap(timeoutTimer, state->timeoutTimer);
+        std::swap(hedgeTimer, state->hedgeTimer);
+    }
+    // ûڵĶʱҪںŷſ state塢ͷͻص
+    m_timers.cancel(timeoutTimer);
+    m_timers.cancel(hedgeTimer);
+    callback(error, resp_data);
+}
 
-	url_comp.lpszHostName = const_cast<wchar_t*>(host_name.data());
-	url_comp.dwHostNameLength = host_name.size();
-	url_comp.lpszUrlPath = const_cast<wchar_t*>(url_path.data());
-	url_comp.dwUrlPathLength = url_path.size();
-	if (FALSE == ::WinHttpCrackUrl(url.c_str(), static_cast<DWORD>(url.size()), 0, &url_comp))
+HttpClient::Clock::time_point HttpClient::deadline() const
+{
+    return 0 == m_timeoutMs ? Clock::time_point::max() : Clock::now() + std::chrono::milliseconds(m_timeoutMs);
+}
+
+unsigned int HttpClient::backoff(unsigned int retry)
+{
+    unsigned long long delay = m_retry.initialBackoffMs;
+    for (unsigned int i = 1; i < retry && delay < m_retry.maxBackoffMs; ++i)
+    {
+        delay *= 2;
+    }
+    if (delay > m_retry.maxBackoffMs)
+    {
+        delay = m_retry.maxBackoffMs;
+    }
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return static_cast<unsigned int>(delay / 2 + m_random() % (delay - delay / 2 + 1));
+}
+
+unsigned int HttpClient::hedgeDelay()
+{
+    std::vector<unsigned int> samples;
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        if (m_latencies.size() < kHedgeMinSamples)
+        {
+            return m_retry.hedgeDelayMs;
+        }
+        samples = m_latencies;
+    }
+    std::vector<unsigned int>::iterator p95 = samples.begin() + samples.size() * 95 / 100;
+    std::nth_element(samples.begin(), p95, samples.end());
+    return *p95 > 0 ? *p95 : 1;
+}
+
+void HttpClient::recordLatency(Clock::duration latency)
+{
+    unsigned int ms = static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::milliseconds>(latency).count());
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    if (m_latencies.size() < kLatencySamples)
+    {
+        m_latencies.push_back(ms);
+        return;
+    }
+    m_latencies[m_latencyNext] = ms;
+    m_latencyNext = (m_latencyNext + 1) % kLatencySamples;
+}
+
+#if HTTP_USE_WINHTTP
+
+HINTERNET HttpClient::session()
+{
+    std::lock_guard<std::mutex> lock(m_sessionMutex);
+    if (NULL == m_hSession)
+    {
+        m_hSession = ::WinHttpOpen(m_user_agent.c_str()
+            , WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+    }
+    return m_hSession;
+}
+
+DWORD HttpClient::requestOnce(const std::wstring& url, const std::wstring& method
+	, const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink, Clock::time_point deadline)
+{
+	std::wstring host_name;
+	std::wstring url_path;
+	URL_COMPONENTS url_comp;
+	if (FALSE == crackUrl(url, host_name, url_path, url_comp))
 	{
 		return ::GetLastError();
 	}
 
-	m_hSession = ::WinHttpOpen(m_user_agent.c_str()
-		, WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
-	if (NULL == m_hSession)
+	HINTERNET hSession = session();
+	if (NULL == hSession)
 	{
 		return ::GetLastError();
 	}
 
-	m_hConnect = ::WinHttpConnect(m_hSession, host_name.c_str(), url_comp.nPort, 0);
-	if (NULL == m_hConnect)
+	HttpEndpoint endpoint;
+	endpoint.scheme = (INTERNET_SCHEME_HTTP == url_comp.nScheme ? "http" : "https");
+	endpoint.host = Wide2UTF8(host_name);
+	endpoint.port = url_comp.nPort;
+
+	HttpTiming timing;
+	timing.host = endpoint.host;
+	Clock::time_point start = Clock::now();
+	std::unique_ptr<HttpConnection> connection;
+	DWORD ret = kHttpTimedOut;
+	if (m_pool.acquireUntil(endpoint, deadline, connection))
 	{
-		return ::GetLastError();
+		timing.queueMs = elapsedMs(start, Clock::now());
+		ret = ERROR_SUCCESS;
+		if (!connection)
+		{
+			HINTERNET hConnect = ::WinHttpConnect(hSession, host_name.c_str(), url_comp.nPort, 0);
+			if (NULL == hConnect)
+			{
+				ret = ::GetLastError();
+			}
+			else
+			{
+				connection.reset(new WinHttpConnection(hConnect));
+			}
+		}
+		if (ERROR_SUCCESS == ret)
+		{
+			HINTERNET hConnect = static_cast<WinHttpConnection*>(connection.get())->handle();
+			ret = sendRequest(hConnect, url_comp.nScheme, url_path.c_str(), method, headers, body, sink, deadline, timing);
+		}
+		m_pool.release(endpoint, std::move(connection), true);
 	}
 
-	DWORD flags = (INTERNET_SCHEME_HTTP == url_comp.nScheme ? 0 : WINHTTP_FLAG_SECURE);
-	m_hRequest = ::WinHttpOpenRequest(m_hConnect, method.c_str(), url_path.c_str(),
-		NULL, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, flags);
-	if (NULL == m_hRequest)
+	timing.error = ret;
+	timing.totalMs = elapsedMs(start, Clock::now());
+	notifyTiming(timing);
+	return ret;
+}
+
+DWORD HttpClient::sendRequest(HINTERNET hConnect, INTERNET_SCHEME scheme, const wchar_t* url_path, const std::wstring& method
+	, const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink, Clock::time_point deadline
+	, HttpTiming& timing)
+{
+	DWORD flags = (INTERNET_SCHEME_HTTP == scheme ? 0 : WINHTTP_FLAG_SECURE);
+	WinHttpHandle request(::WinHttpOpenRequest(hConnect, method.c_str(), url_path,
+		NULL, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, flags));
+	HINTERNET hRequest = request.get();
+	if (NULL == hRequest)
 	{
 		return ::GetLastError();
 	}
 
 	for (std::vector<std::wstring>::const_iterator it = headers.begin(); headers.end() != it; ++it)
 	{
-		::WinHttpAddRequestHeaders(m_hRequest, it->c_str(), (ULONG)-1L, WINHTTP_ADDREQ_FLAG_ADD | WINHTTP_ADDREQ_FLAG_COALESCE);
+		::WinHttpAddRequestHeaders(hRequest, it->c_str(), (ULONG)-1L, WINHTTP_ADDREQ_FLAG_ADD | WINHTTP_ADDREQ_FLAG_COALESCE);
+	}
+	if (m_decompress && false == hasHeader(headers, L"Accept-Encoding"))
+	{
+		enableDecompression(hRequest);
+	}
+	DWORD proxied = applyProxy(hRequest, m_proxy);
+	if (ERROR_SUCCESS != proxied)
+	{
+		return proxied;
+	}
+	if (FALSE == applyDeadline(hRequest, deadline))
+	{
+		return ::GetLastError();
 	}
 
+	// ỰӾǸõģGetLastError() ֮ǰĵµģԷֵΪ׼
+	// ͬģʽ WinHttpSendRequest ʱѾ DNSӡTLS ֺͷ
+	Clock::time_point step = Clock::now();
+	BOOL sent = FALSE;
 	if (0 == method.compare(L"GET"))
 	{
-		::WinHttpSendRequest(m_hRequest, WINHTTP_NO_ADDITIONAL_HEADERS,
+		sent = ::WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS,
 			0, WINHTTP_NO_REQUEST_DATA, 0,
 			0, 0);
 	}
 	else if (0 == method.compare(L"POST"))
 	{
 		const void* body_data = reinterpret_cast<const void*>(body.c_str());
-		::WinHttpSendRequest(m_hRequest, WINHTTP_NO_ADDITIONAL_HEADERS,
+		sent = ::WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS,
 			0, const_cast<void*>(body_data), body.size(),
 			body.size(), 0);
 	}
 	else if (0 == method.compare(L"PUT"))
 	{
 		const void* body_data = reinterpret_cast<const void*>(body.c_str());
-		::WinHttpSendRequest(m_hRequest, WINHTTP_NO_ADDITIONAL_HEADERS,
+		sent = ::WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS,
 			0, const_cast<void*>(body_data), body.size(),
 			body.size(), 0);
 	}
 
-	if (ERROR_SUCCESS != ::GetLastError())
+	if (FALSE == sent)
 	{
 		return ::GetLastError();
 	}
+	timing.bytesSent = body.size();
+	timing.sendMs = elapsedMs(step, Clock::now());
 
-	if (FALSE == ::WinHttpReceiveResponse(m_hRequest, NULL))
+	step = Clock::now();
+	if (FALSE == ::WinHttpReceiveResponse(hRequest, NULL))
 	{
 		return ::GetLastError();
 	}
+	timing.ttfbMs = elapsedMs(step, Clock::now());
 
 	WCHAR status_code[16] = { 0 };
 	DWORD buffer_length = _countof(status_code);
-	if (FALSE == ::WinHttpQueryHeaders(m_hRequest, WINHTTP_QUERY_STATUS_CODE
+	if (FALSE == ::WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE
 		, WINHTTP_HEADER_NAME_BY_INDEX, status_code, &buffer_length
 		, WINHTTP_NO_HEADER_INDEX))
 	{
 		return ::GetLastError();
 	}
 
-	DWORD size = 0;
-	while (TRUE == ::WinHttpQueryDataAvailable(m_hRequest, &size))
+	// ͬģʽ WinHttpReadData ȵΪֹ 0 ֽڱʾӦ
+	step = Clock::now();
+	char buffer[16 * 1024];
+	for (;;)
 	{
-		if (0 == size)
+		DWORD lpdwNumberOfBytesRead = 0;
+		if (FALSE == ::WinHttpReadData(hRequest, buffer, sizeof(buffer), &lpdwNumberOfBytesRead))
 		{
-			break;
+			return ::GetLastError();
 		}
-
-		std::unique_ptr<char[]> buffer(new char[size]);
-		if (NULL == buffer.get())
+		if (0 == lpdwNumberOfBytesRead)
 		{
 			break;
 		}
-
-		DWORD lpdwNumberOfBytesRead = 0;
-		if (TRUE == ::WinHttpReadData(m_hRequest, buffer.get(), size, &lpdwNumberOfBytesRead))
+		timing.bytesReceived += lpdwNumberOfBytesRead;
+		if (false == sink.onData(buffer, static_cast<size_t>(lpdwNumberOfBytesRead)))
 		{
-			resp_data.append(buffer.get(), static_cast<size_t>(lpdwNumberOfBytesRead));
-		}
-		else
-		{
-			return ::GetLastError();
+			return EcHttpAborted;
 		}
 	}
 
+	timing.transferMs = elapsedMs(step, Clock::now());
+
 	const WCHAR ok_status_code[] = { L'2', L'0', L'0', L'\0' };
 	if (0 != ::_wcsicmp(ok_status_code, status_code))
 	{
@@ -260,3 +1397,152 @@ DWORD HttpClient::request(const std::wstring& url, const std::wstring& method
 
 	return ERROR_SUCCESS;
 }
+
+void HttpClient::requestOnceAsync(const std::wstring& url, const std::wstring& method
+	, const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink* sink, Clock::time_point deadline
+	, const HttpCallback& callback)
+{
+	std::wstring host_name;
+	std::wstring url_path;
+	URL_COMPONENTS url_comp;
+	DWORD ret = ERROR_SUCCESS;
+	if (FALSE == crackUrl(url, host_name, url_path, url_comp))
+	{
+		ret = ::GetLastError();
+	}
+
+	WinHttpAsyncSession* session = NULL;
+	if (ERROR_SUCCESS == ret)
+	{
+		std::lock_guard<std::mutex> lock(m_asyncMutex);
+		if (!m_async)
+		{
+			std::unique_ptr<WinHttpAsyncSession> created(new WinHttpAsyncSession());
+			created->setTimingListener([this](const HttpTiming& timing) { notifyTiming(timing); });
+			ret = created->open(m_user_agent, m_pool.maxConnectionsPerHost());
+			if (ERROR_SUCCESS == ret)
+			{
+				m_async = std::move(created);
+			}
+		}
+		session = m_async.get();
+	}
+
+	if (ERROR_SUCCESS == ret)
+	{
+		ret = session->submit(host_name, url_comp.nPort, url_comp.nScheme, url_path.c_str(), method, headers, body
+			, m_decompress && false == hasHeader(headers, L"Accept-Encoding"), m_proxy, deadline, sink, callback);
+	}
+	if (ERROR_SUCCESS != ret)
+	{
+		std::string empty;
+		callback(ret, empty);   // ûܷڵֱ߳ӻص
+	}
+}
+
+#else
+
+DWORD HttpClient::requestOnce(const std::wstring& url, const std::wstring& method
+    , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink, Clock::time_point deadline)
+{
+    HttpUrl target;
+    std::string data;
+    bool decode = (m_decompress && '\0' != *httpAcceptEncoding() && false == hasHeader(headers, L"Accept-Encoding"));
+    DWORD prepared = prepareRequest(url, method, m_user_agent, headers, body, NULL != m_tls, decode, m_proxy, target, data);
+    if (ERROR_SUCCESS != prepared)
+    {
+        return prepared;
+    }
+
+    HttpEndpoint endpoint;
+    endpoint.scheme = target.scheme;
+    endpoint.host = target.host;
+    endpoint.port = target.port;
+    endpoint.proxy = httpProxyKey(m_proxy);
+
+    HttpTiming timing;
+    timing.host = target.host;
+    Clock::time_point start = Clock::now();
+    DWORD ret = ERROR_SUCCESS;
+    for (int attempt = 0; ; ++attempt)
+    {
+        Clock::time_point step = Clock::now();
+        std::unique_ptr<HttpConnection> pooled;
+        if (false == m_pool.acquireUntil(endpoint, deadline, pooled))
+        {
+            ret = kHttpTimedOut;
+            break;
+        }
+        timing.queueMs = elapsedMs(step, Clock::now());
+        bool reused = static_cast<bool>(pooled);
+        timing.reused = reused;
+        std::unique_ptr<HttpSocketConnection> connection(static_cast<HttpSocketConnection*>(pooled.release()));
+
+        ret = ERROR_SUCCESS;
+        if (!connection)
+        {
+            connection.reset(new HttpSocketConnection());
+            ret = establish(*connection, target, m_proxy, m_tls, deadline, timing);
+        }
+
+        HttpResponseParser parser(decode);
+        if (ERROR_SUCCESS == ret)
+        {
+            ret = exchange(*connection, data, parser, sink, deadline, timing);
+        }
+        m_pool.release(endpoint, std::move(connection), ERROR_SUCCESS == ret && parser.keepAlive());
+
+        // ӿڼ֮űԶ˹رգûյκӦʱһط
+        if (ERROR_SUCCESS != ret && reused && false == parser.started() && 0 == attempt)
+        {
+            continue;
+        }
+        if (ERROR_SUCCESS == ret && 200 != parser.statusCode())
+        {
+            ret = httpStatusError(parser.statusCode(), m_proxy, target);
+        }
+        break;
+    }
+
+    timing.error = ret;
+    timing.totalMs = elapsedMs(start, Clock::now());
+    notifyTiming(timing);
+    return ret;
+}
+
+void HttpClient::requestOnceAsync(const std::wstring& url, const std::wstring& method
+    , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink* sink, Clock::time_point deadline
+    , const HttpCallback& callback)
+{
+    HttpUrl target;
+    std::string data;
+    bool decode = (m_decompress && '\0' != *httpAcceptEncoding() && false == hasHeader(headers, L"Accept-Encoding"));
+    DWORD ret = prepareRequest(url, method, m_user_agent, headers, body, NULL != m_tls, decode, m_proxy, target, data);
+
+    HttpEventLoop* loop = NULL;
+    if (ERROR_SUCCESS == ret)
+    {
+        std::lock_guard<std::mutex> lock(m_asyncMutex);
+        if (!m_async)
+        {
+            std::unique_ptr<HttpEventLoop> created(new HttpEventLoop(m_pool));
+            created->setTimingListener([this](const HttpTiming& timing) { notifyTiming(timing); });
+            ret = created->start();
+            if (ERROR_SUCCESS == ret)
+            {
+                m_async = std::move(created);
+            }
+        }
+        loop = m_async.get();
+    }
+
+    if (ERROR_SUCCESS != ret)
+    {
+        std::string empty;
+        callback(ret, empty);   // ûܷڵֱ߳ӻص
+        return;
+    }
+    loop->submit(target, data, m_proxy, "https" == target.scheme ? m_tls : NULL, decode, deadline, sink, callback);
+}
+
+#endif
@@ -2,24 +2,228 @@
 #define __HTTPCLIENT_H__
 
 
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
 #include <string>
 #include <vector>
+#ifdef _WIN32
 #include <windows.h>
 #include <winhttp.h>
+#else
+typedef unsigned long DWORD;
+#define ERROR_SUCCESS 0
+#endif
+#include "HttpConnectionPool.h"
+#include "HttpTimerQueue.h"
 /**************************************************************************/
 
+// 1 ʹ WinHTTP0 ʹ HttpSocketTransport е socket ʵ֣POSIX
+#ifndef HTTP_USE_WINHTTP
+#ifdef _WIN32
+#define HTTP_USE_WINHTTP 1
+#else
+#define HTTP_USE_WINHTTP 0
+#endif
+#endif
+
+// 1  zlib֧ gzip/deflate Ӧѹsocket ˣѹûи zlibWindows ĬϹر
+#ifndef HTTP_USE_ZLIB
+#ifdef _WIN32
+#define HTTP_USE_ZLIB 0
+#else
+#define HTTP_USE_ZLIB 1
+#endif
+#endif
+
+// 1  brotli ⣬socket ֧ br Ӧѹ
+#ifndef HTTP_USE_BROTLI
+#define HTTP_USE_BROTLI 0
+#endif
+
 enum HttpErrorCode
 {
-    EcHttpCodeError = 1
+    EcHttpCodeError = 1,
+    // ȡֵλ bit 29ӦԶ룩ϵͳͻ
+    EcHttpInvalidUrl = 0x20000001,
+    EcHttpProtocolError = 0x20000002,
+    EcHttpUnsupported = 0x20000003,
+    EcHttpTlsError = 0x20000004,
+    EcHttpAborted = 0x20000005,     // HttpBodySink ֹ
+    EcHttpProxyError = 0x20000006,  // ܾ󣬻Ӧʽ
+    EcHttpProxyAuthFailed = 0x20000007,
+};
+
+enum HttpProxyType
+{
+    HttpProxyNone,      // ֱWinHTTP ʹϵͳã
+    HttpProxySocks5,
+    HttpProxyHttp,
+};
+
+/*
+* ãSOCKS5 û֤ RFC 1929HTTP ʹ Basic ֤ûΪʱ֤
+*
+* socket ˣSOCKS5 ɴĿHTTP  https  CONNECT http ֱӽת
+* ͬӳأͬһϸ
+* WinHTTP ֻ֧ HTTP  SOCKS5 ʱ󷵻 EcHttpUnsupported
+* ɵ setProxy(ip, port) ڸú²Ч falseվϵͳɵ÷ʾ
+*/
+struct HttpProxy
+{
+    HttpProxy() : type(HttpProxyNone), port(0) {}
+
+    HttpProxyType type;
+    std::string host;
+    unsigned short port;
+    std::string username;
+    std::string password;
+};
+
+/*
+* Ӧһͷֿ齻 onData()HttpClient ù̶СĻȡڴ
+*
+* ֱдļ߽ Json::IncrementalReader ձ߽data ڵ÷غʧЧ
+*  200 ӦͬʱѾյ˲
+*/
+class HttpBodySink
+{
+public:
+    virtual ~HttpBodySink() {}
+
+    //  false ֹ󷵻 EcHttpAborted
+    virtual bool onData(const char* data, size_t size) = 0;
+    // ǰѾݣ false ʾյݵ
+    virtual bool rewind() { return false; }
+};
+
+// Ӧ׷ӵ std::stringַ汾 http_get/http_post/http_put ʹ
+class HttpStringSink : public HttpBodySink
+{
+public:
+    explicit HttpStringSink(std::string& data) : m_data(data), m_start(data.size()) {}
+
+    virtual bool onData(const char* data, size_t size)
+    {
+        m_data.append(data, size);
+        return true;
+    }
+    virtual bool rewind()
+    {
+        m_data.resize(m_start);
+        return true;
+    }
+
+private:
+    std::string& m_data;
+    size_t m_start;     // ǰеݣʱ
+};
+
+// 첽ɻصerror ȡֵͬӿڵķֵͬ
+typedef std::function<void(DWORD error, std::string& resp_data)> HttpCallback;
+// ʽ첽ɻصӦѾȫ HttpBodySink
+typedef std::function<void(DWORD error)> HttpSinkCallback;
+
+/*
+* γԣÿԡÿݶԳһΣĺʱֽ⣬λ룻ûоߺ˲ⲻĽ׶Ϊ -1
+*
+* socket ˣdns/connect/tls ֻ½ʱֵ
+* WinHTTP ޷ DNSTCP Ӻ TLS ֣Ƕ sendMsreused  false
+* ֻֽͽѹӦ
+*/
+struct HttpTiming
+{
+    HttpTiming();
+
+    std::string host;
+    DWORD error;            // ķֵͬ
+    bool reused;            // ʹӳе
+    double queueMs;         // ȴ
+    double dnsMs;
+    double connectMs;       // TCP ӣ DNSʱΪ
+    double proxyMs;         // ֽSOCKS5  CONNECT
+    double tlsMs;
+    double sendMs;          // 
+    double ttfbMs;          // յһӦֽ
+    double transferMs;      // һӦֽڵӦ
+    double totalMs;
+    unsigned long long bytesSent;       // 
+    unsigned long long bytesReceived;   // ӦģӦͷѹǰ
 };
 
+// ڷ̻߳ I/O ߳ϵãҪʱHttpTimingStats::record ֱΪ
+typedef std::function<void(const HttpTiming& timing)> HttpTimingCallback;
+
+/*
+* ʧԳĬ϶ֻݵȵ GET/PUT ЧPOST ֻһ
+*
+* ֻԴĴʧܡʱӱáӦȣ 200 ӦURL TLS 
+*  HttpBodySink ֹȡֱӷ
+*  n ǰȴ min(maxBackoffMs, initialBackoffMs * 2^(n-1))  50%~100%ͬʱԣ
+* ȴʱ setRequestTimeout() Ľֹʱ䣬ʣʱ䲻ʱ
+*/
+struct HttpRetryPolicy
+{
+    HttpRetryPolicy() : maxAttempts(1), initialBackoffMs(100), maxBackoffMs(2000), hedgeDelayMs(0) {}
+
+    unsigned int maxAttempts;       // һڵೢԴ
+    unsigned int initialBackoffMs;
+    unsigned int maxBackoffMs;
+    /**
+    *  0 ʱԳ壺󷢳󳬹ʱδɣٷһͬȳɹһЧ
+    * ɹĺʱ۵ 20 󣬸ɹʱ p95 Ϊȴʱ
+    * ַֻ汾ͬӿں첽ӿڣҪ첽صеͬӿ
+    */
+    unsigned int hedgeDelayMs;
+};
+
+#if HTTP_USE_WINHTTP
+class WinHttpAsyncSession;
+#else
+class HttpEventLoop;
+class HttpTlsProvider;
+#endif
+
 class HttpClient
 {
 public:
     explicit HttpClient(const std::wstring& user_agent);
     ~HttpClient();
 
-    void setProxy(const std::string& ip, unsigned short port);
+    // ʹ SOCKS5  SDK ýͨĴ֤ͬip Ϊʱֱ
+    // WinHTTP ֧ SOCKSúǰһԴãϵͳ falseҪʱ HttpProxyHttp
+    bool setProxy(const std::string& ip, unsigned short port);
+    // ڷǰ
+    void setProxy(const HttpProxy& proxy);
+
+    // ӳأӱڳУͬһ host ĺֱӸ
+    void setMaxConnectionsPerHost(size_t count);    // ͬһ host ͬʱõޣ0 ʾ
+    void setIdleTimeout(unsigned int ms);           // гʱӲٸ
+    HttpConnectionPool::Stats poolStats() const;
+
+#if !HTTP_USE_WINHTTP
+    // socket ˵ https ֧֣ʱ https 󷵻 EcHttpUnsupportedתȨ
+    void setTlsProvider(HttpTlsProvider* provider);
+#endif
+
+    /**
+    * ӦѹĬϿ Accept-EncodingѹӦձ߽ѹٽ÷
+    * WinHTTP  WinHTTP ѹgzip/deflateҪ Windows 8.1 ϣ÷Լ Accept-Encoding ʱԭӦ
+    */
+    void setDecompression(bool enable);
+    // С minSize ֽڵѹ gzip ͣ0 ʾѹĬϣҪ֧֣ HTTP_USE_ZLIB Ϊ 1
+    void setRequestCompression(size_t minSize);
+
+    /**
+    * ÿӷɵʱޣŶӵӡԼȴʱ䣬0 ʾƣĬϣ
+    * ʱ ETIMEDOUTWinHTTP Ϊ ERROR_WINHTTP_TIMEOUT
+    * WinHTTP ˰ʣʱø׶εĳʱͬܺʱԳ
+    */
+    void setRequestTimeout(unsigned int ms);
+    void setRetryPolicy(const HttpRetryPolicy& policy);
+    // ÿγԽصʱֽ⣻ڷǰ
+    void setTimingListener(const HttpTimingCallback& listener);
 
     DWORD http_get(const std::wstring& url
         , const std::vector<std::wstring>& headers, std::string& resp_data);
@@ -27,18 +231,107 @@ public:
         , const std::vector<std::wstring>& headers, const std::string& body, std::string& resp_data);
 	DWORD http_put(const std::wstring& url
 		, const std::vector<std::wstring>& headers, const std::string& body, std::string& resp_data);
-	void  http_close();
+
+    // ʽӦ壬ֵڴӦС޹
+    DWORD http_get(const std::wstring& url
+        , const std::vector<std::wstring>& headers, HttpBodySink& sink);
+    DWORD http_post(const std::wstring& url
+        , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink);
+    DWORD http_put(const std::wstring& url
+        , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink);
+	void  http_close();     // رճеĿ
+
+    /**
+    * 첽أ̣߳ͬʱ
+    *
+    * ɺ I/O ߳ϵ callbackWinHTTP Ḷ́߳ HttpEventLoop ̣߳
+    * ̷߳ڻص PostMessage ؽ߳ٴ
+    * HttpClient ʱδɵȡص
+    */
+    void http_get_async(const std::wstring& url
+        , const std::vector<std::wstring>& headers, const HttpCallback& callback);
+    void http_post_async(const std::wstring& url
+        , const std::vector<std::wstring>& headers, const std::string& body, const HttpCallback& callback);
+    void http_put_async(const std::wstring& url
+        , const std::vector<std::wstring>& headers, const std::string& body, const HttpCallback& callback);
+
+    /**
+    * ʽ첽Ӧ I/O ߳Ϸֿ齻 sinkڴܳӦ
+    *
+    * sink 뱣Чֱ callback أԳ壬ֻ sink ֧ rewind()߻ûյݣʱԣ
+    * setRequestTimeout() ĽֹʱÿγԼִ
+    */
+    void http_get_async(const std::wstring& url
+        , const std::vector<std::wstring>& headers, HttpBodySink& sink, const HttpSinkCallback& callback);
+    void http_post_async(const std::wstring& url
+        , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink, const HttpSinkCallback& callback);
+    void http_put_async(const std::wstring& url
+        , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink, const HttpSinkCallback& callback);
 private:
+    typedef std::chrono::steady_clock Clock;
+    struct RetryState;
+
     DWORD request(const std::wstring& url, const std::wstring& method
+        , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink);
+    // ַ汾ͬӿڣԳʱ첽ӿڷ
+    DWORD requestBuffered(const std::wstring& url, const std::wstring& method
         , const std::vector<std::wstring>& headers, const std::string& body, std::string& resp_data);
+    // sink ΪʱӦսַ callbackֱӽ sinkcallback յ resp_data Ϊ
+    void requestAsync(const std::wstring& url, const std::wstring& method
+        , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink* sink, const HttpCallback& callback);
+    void launch(const std::shared_ptr<RetryState>& state);
+    void attemptDone(const std::shared_ptr<RetryState>& state, Clock::time_point start, DWORD error, std::string& resp_data);
+    void complete(const std::shared_ptr<RetryState>& state, DWORD error, std::string& resp_data);
+    Clock::time_point deadline() const;
+    unsigned int backoff(unsigned int retry);
+    unsigned int hedgeDelay();
+    void recordLatency(Clock::duration latency);
+    // ɸʵ֣deadline Ϊ Clock::time_point::max() ʱʱ
+    DWORD requestOnce(const std::wstring& url, const std::wstring& method
+        , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink, Clock::time_point deadline);
+    void requestOnceAsync(const std::wstring& url, const std::wstring& method
+        , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink* sink, Clock::time_point deadline
+        , const HttpCallback& callback);
+    // Ҫѹʱ truecompressed  compressedHeaders׷ Content-Encodingԭͷ
+    bool compressBody(const std::vector<std::wstring>& headers, const std::string& body
+        , std::vector<std::wstring>& compressedHeaders, std::string& compressed) const;
+    void notifyTiming(const HttpTiming& timing) const;
+#if HTTP_USE_WINHTTP
+    HINTERNET session();
+    DWORD sendRequest(HINTERNET hConnect, INTERNET_SCHEME scheme, const wchar_t* url_path, const std::wstring& method
+        , const std::vector<std::wstring>& headers, const std::string& body, HttpBodySink& sink, Clock::time_point deadline
+        , HttpTiming& timing);
+#endif
 private:
     std::wstring m_user_agent;
-    HINTERNET m_hSession;
-    HINTERNET m_hConnect;
-    HINTERNET m_hRequest;
+#if HTTP_USE_WINHTTP
+    HINTERNET m_hSession;   // ڱִ򿪣WinHTTP ڻỰڸ socket
+    std::mutex m_sessionMutex;
+#endif
+    HttpConnectionPool m_pool;
+    // ״η첽ʱ m_pool ֮ӳ
+#if HTTP_USE_WINHTTP
+    std::unique_ptr<WinHttpAsyncSession> m_async;
+#else
+    std::unique_ptr<HttpEventLoop> m_async;
+    HttpTlsProvider* m_tls;
+#endif
+    std::mutex m_asyncMutex;
+
+    HttpProxy m_proxy;
+    bool m_decompress;
+    size_t m_compressMinSize;
 
-    std::string m_proxyIP;
-    unsigned short m_proxyPort;
+    unsigned int m_timeoutMs;
+    HttpRetryPolicy m_retry;
+    HttpTimingCallback m_timingListener;
+    // ɹĺʱ룩λ壬ڼԳӳ٣õҲ m_statsMutex 
+    std::vector<unsigned int> m_latencies;
+    size_t m_latencyNext;
+    std::minstd_rand m_random;
+    std::mutex m_statsMutex;
+    // ˱ܺͶԳĶʱʱ m_async ֹͣδڵȡص
+    HttpTimerQueue m_timers;
 };
 
 #endif /* __HTTPCLIENT_H__ */
@@ -0,0 +1,235 @@
+#include "HttpConnectionPool.h"
+/**************************************************************************/
+
+bool HttpEndpoint::operator<(const HttpEndpoint& other) const
+{
+    if (port != other.port)
+    {
+        return port < other.port;
+    }
+    if (scheme != other.scheme)
+    {
+        return scheme < other.scheme;
+    }
+    if (host != other.host)
+    {
+        return host < other.host;
+    }
+    return proxy < other.proxy;
+}
+
+HttpConnectionPool::HttpConnectionPool()
+    : m_maxPerHost(6)
+    , m_idleTimeout(std::chrono::seconds(60))
+{
+    m_stats.acquired = 0;
+    m_stats.reused = 0;
+}
+
+HttpConnectionPool::~HttpConnectionPool()
+{
+    clear();
+}
+
+void HttpConnectionPool::setMaxConnectionsPerHost(size_t count)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxPerHost = count;
+    m_released.notify_all();
+}
+
+void HttpConnectionPool::setIdleTimeout(unsigned int ms)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idleTimeout = std::chrono::milliseconds(ms);
+}
+
+size_t HttpConnectionPool::maxConnectionsPerHost() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maxPerHost;
+}
+
+void HttpConnectionPool::setReleaseListener(const std::function<void()>& listener)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_releaseListener = listener;
+}
+
+std::unique_ptr<HttpConnection> HttpConnectionPool::acquire(const HttpEndpoint& endpoint)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        Host& host = m_hosts[endpoint];
+        m_released.wait(lock, [&] { return 0 == m_maxPerHost || host.active < m_maxPerHost; });
+        reserve(host);
+    }
+    return takeIdle(endpoint);
+}
+
+bool HttpConnectionPool::acquireUntil(const HttpEndpoint& endpoint, std::chrono::steady_clock::time_point deadline
+    , std::unique_ptr<HttpConnection>& connection)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        Host& host = m_hosts[endpoint];
+        auto available = [&] { return 0 == m_maxPerHost || host.active < m_maxPerHost; };
+        if (Clock::time_point::max() == deadline)
+        {
+            m_released.wait(lock, available);      // time_point::max() 
+        }
+        else if (false == m_released.wait_until(lock, deadline, available))
+        {
+            return false;
+        }
+        reserve(host);
+    }
+    connection = takeIdle(endpoint);
+    return true;
+}
+
+bool HttpConnectionPool::tryAcquire(const HttpEndpoint& endpoint, std::unique_ptr<HttpConnection>& connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Host& host = m_hosts[endpoint];
+        if (0 != m_maxPerHost && host.active >= m_maxPerHost)
+        {
+            return false;
+        }
+        reserve(host);
+    }
+    connection = takeIdle(endpoint);
+    return true;
+}
+
+void HttpConnectionPool::release(const HttpEndpoint& endpoint, std::unique_ptr<HttpConnection> connection, bool keepAlive)
+{
+    std::unique_ptr<HttpConnection> closed;     // 
+    std::list<IdleConnection> expired;
+    std::function<void()> listener;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Clock::time_point now = Clock::now();
+        Host& host = m_hosts[endpoint];
+        if (host.active > 0)
+        {
+            --host.active;
+        }
+        if (connection && keepAlive)
+        {
+            IdleConnection idle = { connection.release(), now };
+            host.idle.push_front(idle);
+        }
+        else
+        {
+            closed = std::move(connection);
+        }
+        evictExpired(now, expired);
+        listener = m_releaseListener;
+    }
+    destroy(expired);
+    m_released.notify_all();
+    if (listener)
+    {
+        listener();
+    }
+}
+
+void HttpConnectionPool::clear()
+{
+    std::list<IdleConnection> idle;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::map<HttpEndpoint, Host>::iterator it = m_hosts.begin(); m_hosts.end() != it; ++it)
+        {
+            idle.splice(idle.end(), it->second.idle);
+        }
+    }
+    destroy(idle);
+}
+
+size_t HttpConnectionPool::idleCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t count = 0;
+    for (std::map<HttpEndpoint, Host>::const_iterator it = m_hosts.begin(); m_hosts.end() != it; ++it)
+    {
+        count += it->second.idle.size();
+    }
+    return count;
+}
+
+HttpConnectionPool::Stats HttpConnectionPool::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void HttpConnectionPool::reserve(Host& host)
+{
+    ++host.active;
+    ++m_stats.acquired;
+}
+
+std::unique_ptr<HttpConnection> HttpConnectionPool::takeIdle(const HttpEndpoint& endpoint)
+{
+    // isAlive() Ҫ socketرӿҪ TLS close_notify
+    for (;;)
+    {
+        std::list<IdleConnection> expired;
+        std::unique_ptr<HttpConnection> connection;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            evictExpired(Clock::now(), expired);
+            Host& host = m_hosts[endpoint];
+            if (false == host.idle.empty())
+            {
+                connection.reset(host.idle.front().connection);
+                host.idle.pop_front();
+            }
+        }
+        destroy(expired);
+        if (!connection)
+        {
+            return connection;
+        }
+        if (connection->isAlive())
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_stats.reused;
+            return connection;
+        }
+    }   // Զѹرյȡһ
+}
+
+void HttpConnectionPool::evictExpired(Clock::time_point now, std::list<IdleConnection>& expired)
+{
+    //  host 飺ٷʵ host ĿҲҪʱر
+    for (std::map<HttpEndpoint, Host>::iterator it = m_hosts.begin(); m_hosts.end() != it; ++it)
+    {
+        std::list<IdleConnection>& idle = it->second.idle;
+        // ԽԽ
+        std::list<IdleConnection>::iterator first = idle.end();
+        while (idle.begin() != first)
+        {
+            std::list<IdleConnection>::iterator previous = first;
+            --previous;
+            if (now - previous->since < m_idleTimeout)
+            {
+                break;
+            }
+            first = previous;
+        }
+        expired.splice(expired.end(), idle, first, idle.end());
+    }
+}
+
+void HttpConnectionPool::destroy(std::list<IdleConnection>& connections)
+{
+    for (std::list<IdleConnection>::iterator it = connections.begin(); connections.end() != it; ++it)
+    {
+        delete it->connection;
+    }
+    connections.clear();
+}
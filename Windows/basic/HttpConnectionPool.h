@@ -0,0 +1,106 @@
+#ifndef __HTTPCONNECTIONPOOL_H__
+#define __HTTPCONNECTIONPOOL_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+/**************************************************************************/
+
+struct HttpEndpoint
+{
+    std::string scheme;     // "http"  "https"
+    std::string host;
+    unsigned short port;
+    std::string proxy;      // ʱֲͬӣֱΪ
+
+    bool operator<(const HttpEndpoint& other) const;
+};
+
+// ɸõӣWinHTTP  connect  keep-alive  socket
+class HttpConnection
+{
+public:
+    virtual ~HttpConnection() {}
+
+    // ڼԶ˿Ѿرӣȡǰ
+    virtual bool isAlive() const = 0;
+};
+
+/*
+*  scheme/host/port ӣÿ host ͬʱõ
+*
+* acquire() ռһȡһӣû򷵻ؿգɵ÷½
+*  release() 黹ܸõڳ
+*
+* 첽˲ acquire() ϣ tryAcquire()ͨ setReleaseListener() ֪ճ
+*/
+class HttpConnectionPool
+{
+public:
+    struct Stats
+    {
+        unsigned long long acquired;   // acquire() 
+        unsigned long long reused;     // ȡӵĴ
+    };
+
+    HttpConnectionPool();
+    ~HttpConnectionPool();
+
+    void setMaxConnectionsPerHost(size_t count);    // 0 ʾƣĬ 6
+    void setIdleTimeout(unsigned int ms);           // Ĭ 60 룻ÿ acquire/release ʱر host ĳʱ
+    size_t maxConnectionsPerHost() const;
+    // ÿ release() ֮ڵ߳ϣ⣩
+    void setReleaseListener(const std::function<void()>& listener);
+
+    std::unique_ptr<HttpConnection> acquire(const HttpEndpoint& endpoint);
+    // ȵ deadline ûʱ falseɹʱ connection Ϊӻ
+    bool acquireUntil(const HttpEndpoint& endpoint, std::chrono::steady_clock::time_point deadline
+        , std::unique_ptr<HttpConnection>& connection);
+    // ȴʱ falseɹʱ connection Ϊӻ
+    bool tryAcquire(const HttpEndpoint& endpoint, std::unique_ptr<HttpConnection>& connection);
+    void release(const HttpEndpoint& endpoint, std::unique_ptr<HttpConnection> connection, bool keepAlive);
+
+    void clear();       // رп
+    size_t idleCount() const;
+    Stats stats() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct IdleConnection
+    {
+        HttpConnection* connection;
+        Clock::time_point since;
+    };
+
+    struct Host
+    {
+        Host() : active(0) {}
+        std::list<IdleConnection> idle;     // 黹ǰ
+        size_t active;
+    };
+
+    void reserve(Host& host);                                           // ռ÷ m_mutex
+    std::unique_ptr<HttpConnection> takeIdle(const HttpEndpoint& endpoint);     // ÷ m_mutex
+    void evictExpired(Clock::time_point now, std::list<IdleConnection>& expired);   // ժ host ĳʱӣ÷ m_mutex
+    static void destroy(std::list<IdleConnection>& connections);        // ر
+
+    HttpConnectionPool(const HttpConnectionPool&);
+    void operator=(const HttpConnectionPool&);
+
+private:
+    std::map<HttpEndpoint, Host> m_hosts;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_released;
+    std::function<void()> m_releaseListener;
+    size_t m_maxPerHost;
+    Clock::duration m_idleTimeout;
+    Stats m_stats;
+};
+
+#endif /* __HTTPCONNECTIONPOOL_H__ */
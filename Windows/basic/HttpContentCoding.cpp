@@ -0,0 +1,259 @@
+#include "HttpContentCoding.h"
+#include <ctype.h>
+#include <string.h>
+#if HTTP_USE_ZLIB
+#include <zlib.h>
+#endif
+#if HTTP_USE_BROTLI
+#include <brotli/decode.h>
+#endif
+/**************************************************************************/
+
+namespace
+{
+#if HTTP_USE_ZLIB || HTTP_USE_BROTLI
+    const size_t kDecodeBufferSize = 16 * 1024;
+
+    bool equalsNoCase(const std::string& value, const char* name)
+    {
+        size_t const length = ::strlen(name);
+        if (value.size() != length)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < length; ++i)
+        {
+            if (::tolower(static_cast<unsigned char>(value[i])) != name[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+#endif
+
+#if HTTP_USE_ZLIB
+    // gzip  deflatedeflate 淶 zlib ʽеķ˷ deflate ׿ⲻʱ
+    class ZlibDecoder : public HttpContentDecoder
+    {
+    public:
+        explicit ZlibDecoder(bool gzip)
+            : m_gzip(gzip)
+            , m_raw(false)
+            , m_started(false)
+            , m_ended(false)
+            , m_output(false)
+        {
+            ::memset(&m_stream, 0, sizeof(m_stream));
+            m_ready = (Z_OK == ::inflateInit2(&m_stream, gzip ? 15 + 16 : 15));
+        }
+
+        ~ZlibDecoder()
+        {
+            if (m_ready)
+            {
+                ::inflateEnd(&m_stream);
+            }
+        }
+
+        virtual DWORD decode(const char* data, size_t size, HttpBodySink& sink)
+        {
+            if (false == m_ready)
+            {
+                return EcHttpProtocolError;
+            }
+            // ֻеһݿİ deflate ؽ
+            bool const first = (false == m_started);
+            m_started = m_started || size > 0;
+            m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            m_stream.avail_in = static_cast<uInt>(size);
+            while (m_stream.avail_in > 0)
+            {
+                if (m_ended)
+                {
+                    // gzip ԱβӣʽӦ
+                    if (false == m_gzip || Z_OK != ::inflateReset(&m_stream))
+                    {
+                        return EcHttpProtocolError;
+                    }
+                    m_ended = false;
+                }
+
+                Bytef buffer[kDecodeBufferSize];
+                m_stream.next_out = buffer;
+                m_stream.avail_out = sizeof(buffer);
+                int ret = ::inflate(&m_stream, Z_NO_FLUSH);
+                if (Z_DATA_ERROR == ret && first && false == m_gzip && false == m_raw && false == m_output)
+                {
+                    if (Z_OK != ::inflateReset2(&m_stream, -15))
+                    {
+                        return EcHttpProtocolError;
+                    }
+                    m_raw = true;
+                    m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+                    m_stream.avail_in = static_cast<uInt>(size);
+                    continue;
+                }
+                if (Z_OK != ret && Z_STREAM_END != ret && Z_BUF_ERROR != ret)
+                {
+                    return EcHttpProtocolError;
+                }
+                m_ended = (Z_STREAM_END == ret);
+
+                size_t const produced = sizeof(buffer) - m_stream.avail_out;
+                if (produced > 0)
+                {
+                    m_output = true;
+                    if (false == sink.onData(reinterpret_cast<const char*>(buffer), produced))
+                    {
+                        return EcHttpAborted;
+                    }
+                }
+                else if (Z_BUF_ERROR == ret)
+                {
+                    break;
+                }
+            }
+            return ERROR_SUCCESS;
+        }
+
+        virtual bool finish()
+        {
+            return m_ended || false == m_started;
+        }
+
+    private:
+        z_stream m_stream;
+        bool m_ready;
+        bool m_gzip;
+        bool m_raw;
+        bool m_started;
+        bool m_ended;       // ǰgzip Աѽ
+        bool m_output;
+    };
+#endif
+
+#if HTTP_USE_BROTLI
+    class BrotliDecoder : public HttpContentDecoder
+    {
+    public:
+        BrotliDecoder()
+            : m_state(::BrotliDecoderCreateInstance(NULL, NULL, NULL))
+            , m_started(false)
+        {
+
+        }
+
+        ~BrotliDecoder()
+        {
+            if (m_state)
+            {
+                ::BrotliDecoderDestroyInstance(m_state);
+            }
+        }
+
+        virtual DWORD decode(const char* data, size_t size, HttpBodySink& sink)
+        {
+            if (NULL == m_state)
+            {
+                return EcHttpProtocolError;
+            }
+            m_started = m_started || size > 0;
+            const uint8_t* next_in = reinterpret_cast<const uint8_t*>(data);
+            size_t avail_in = size;
+            for (;;)
+            {
+                uint8_t buffer[kDecodeBufferSize];
+                uint8_t* next_out = buffer;
+                size_t avail_out = sizeof(buffer);
+                BrotliDecoderResult ret = ::BrotliDecoderDecompressStream(m_state, &avail_in, &next_in, &avail_out, &next_out, NULL);
+                if (BROTLI_DECODER_RESULT_ERROR == ret
+                    || (BROTLI_DECODER_RESULT_SUCCESS == ret && avail_in > 0))
+                {
+                    return EcHttpProtocolError;
+                }
+
+                size_t const produced = sizeof(buffer) - avail_out;
+                if (produced > 0 && false == sink.onData(reinterpret_cast<const char*>(buffer), produced))
+                {
+                    return EcHttpAborted;
+                }
+                if (BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT != ret)
+                {
+                    return ERROR_SUCCESS;
+                }
+            }
+        }
+
+        virtual bool finish()
+        {
+            return false == m_started || ::BrotliDecoderIsFinished(m_state);
+        }
+
+    private:
+        BrotliDecoderState* m_state;
+        bool m_started;
+    };
+#endif
+}
+
+const char* httpAcceptEncoding()
+{
+#if HTTP_USE_ZLIB && HTTP_USE_BROTLI
+    return "gzip, deflate, br";
+#elif HTTP_USE_ZLIB
+    return "gzip, deflate";
+#elif HTTP_USE_BROTLI
+    return "br";
+#else
+    return "";
+#endif
+}
+
+HttpContentDecoder* createHttpContentDecoder(const std::string& encoding)
+{
+#if HTTP_USE_ZLIB
+    if (equalsNoCase(encoding, "gzip") || equalsNoCase(encoding, "x-gzip"))
+    {
+        return new ZlibDecoder(true);
+    }
+    if (equalsNoCase(encoding, "deflate"))
+    {
+        return new ZlibDecoder(false);
+    }
+#endif
+#if HTTP_USE_BROTLI
+    if (equalsNoCase(encoding, "br"))
+    {
+        return new BrotliDecoder();
+    }
+#endif
+    (void)encoding;
+    return NULL;
+}
+
+bool httpGzip(const std::string& data, std::string& compressed)
+{
+#if HTTP_USE_ZLIB
+    z_stream stream;
+    ::memset(&stream, 0, sizeof(stream));
+    if (Z_OK != ::deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY))
+    {
+        return false;
+    }
+
+    compressed.resize(::deflateBound(&stream, static_cast<uLong>(data.size())));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+    stream.avail_out = static_cast<uInt>(compressed.size());
+    int ret = ::deflate(&stream, Z_FINISH);
+    compressed.resize(stream.total_out);
+    ::deflateEnd(&stream);
+    return Z_STREAM_END == ret;
+#else
+    (void)data;
+    (void)compressed;
+    return false;
+#endif
+}
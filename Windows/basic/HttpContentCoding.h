@@ -0,0 +1,33 @@
+#ifndef __HTTPCONTENTCODING_H__
+#define __HTTPCONTENTCODING_H__
+
+#include "HttpClient.h"
+#include <string>
+/**************************************************************************/
+
+/*
+* HTTP ݱ루Content-Encodinggzip/deflate  zlibHTTP_USE_ZLIBbr  brotli ⣨HTTP_USE_BROTLI
+*
+* WinHTTP ˵Ӧѹ WinHTTP ɣĽֻ socket ʹãѹ˹
+*/
+
+// ʽѹݿзֺδ룬ѹù̶СĻֿ齻 sink
+class HttpContentDecoder
+{
+public:
+    virtual ~HttpContentDecoder() {}
+
+    // 𻵷 EcHttpProtocolErrorsink ֹ EcHttpAborted
+    virtual DWORD decode(const char* data, size_t size, HttpBodySink& sink) = 0;
+    // Ӧѹʱ falseûյκݣ HEAD204Ϊ
+    virtual bool finish() = 0;
+};
+
+// ܽı룬 Accept-Encoding ȡֵһֶ֧ʱΪմ
+const char* httpAcceptEncoding();
+//  Content-Encoding ȡֵֵ֧ı뷵 NULL
+HttpContentDecoder* createHttpContentDecoder(const std::string& encoding);
+// ѹ gzipû zlib ѹʧʱ false
+bool httpGzip(const std::string& data, std::string& compressed);
+
+#endif /* __HTTPCONTENTCODING_H__ */
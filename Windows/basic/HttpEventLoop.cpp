@@ -0,0 +1,724 @@
+#include "HttpEventLoop.h"
+#include <algorithm>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+/**************************************************************************/
+
+namespace
+{
+    double elapsedMs(std::chrono::steady_clock::time_point from)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+    }
+}
+
+struct HttpEventLoop::Request
+{
+    enum State
+    {
+        Waiting,        //  m_waiting Ŷӣû
+        Resolving,      //  m_resolving Уȴ߳̽
+        Connecting,
+        Tunneling,      // 
+        Handshaking,
+        Sending,
+        Receiving,
+    };
+
+    Request() : tls(NULL), decode(false), sent(0), state(Waiting), reused(false), retried(false), lookup(0), watchedFd(-1), watchedEvents(0), hasTimer(false), sink(NULL) {}
+
+    HttpUrl url;
+    HttpEndpoint endpoint;
+    HttpProxy proxy;
+    HttpTlsProvider* tls;
+    bool decode;        // ѹӦ
+    std::string data;
+    size_t sent;
+    Clock::time_point deadline;
+    HttpCallback callback;
+
+    std::unique_ptr<HttpSocketConnection> connection;
+    State state;
+    bool reused;        // ȡӳ
+    bool retried;
+    unsigned long long lookup;
+    int watchedFd;      // עᵽ epoll  fd
+    unsigned int watchedEvents;
+    bool hasTimer;
+    std::multimap<Clock::time_point, Request*>::iterator timer;
+
+    HttpResponseParser parser;
+    std::string body;
+    std::unique_ptr<HttpStringSink> buffered;
+    HttpBodySink* sink;     // ÷Ľд body  buffered
+
+    HttpTiming timing;
+    Clock::time_point start;    // ύʱ
+    Clock::time_point step;     // ǰ׶εĿʼʱ
+};
+
+HttpEventLoop::HttpEventLoop(HttpConnectionPool& pool)
+    : m_pool(pool)
+    , m_epoll(-1)
+    , m_wakeup(-1)
+    , m_stop(false)
+    , m_nextLookup(0)
+    , m_buffer(16 * 1024)
+{
+
+}
+
+HttpEventLoop::~HttpEventLoop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    if (m_thread.joinable())
+    {
+        wake();
+        m_thread.join();
+    }
+    if (m_resolver.joinable())
+    {
+        // ڽе getaddrinfo ޷жϣֻܵ
+        m_resolveCondition.notify_all();
+        m_resolver.join();
+    }
+    m_pool.setReleaseListener(std::function<void()>());
+    cancelAll();
+
+    if (m_wakeup >= 0)
+    {
+        ::close(m_wakeup);
+    }
+    if (m_epoll >= 0)
+    {
+        ::close(m_epoll);
+    }
+}
+
+DWORD HttpEventLoop::start()
+{
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0)
+    {
+        return errno;
+    }
+    m_wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeup < 0)
+    {
+        return errno;
+    }
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (0 != ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &event))
+    {
+        return errno;
+    }
+
+    // ̹ͬ߱߳黹ŶӵܿԿʼ
+    m_pool.setReleaseListener([this] { wake(); });
+    m_thread = std::thread(&HttpEventLoop::run, this);
+    m_resolver = std::thread(&HttpEventLoop::runResolver, this);
+    return ERROR_SUCCESS;
+}
+
+void HttpEventLoop::setTimingListener(const HttpTimingCallback& listener)
+{
+    m_timingListener = listener;
+}
+
+void HttpEventLoop::submit(const HttpUrl& url, const std::string& request, const HttpProxy& proxy, HttpTlsProvider* tls, bool decode
+    , std::chrono::steady_clock::time_point deadline, HttpBodySink* sink, const HttpCallback& callback)
+{
+    std::unique_ptr<Request> item(new Request());
+    item->url = url;
+    item->endpoint.scheme = url.scheme;
+    item->endpoint.host = url.host;
+    item->endpoint.port = url.port;
+    item->endpoint.proxy = httpProxyKey(proxy);
+    item->proxy = proxy;
+    item->tls = tls;
+    item->decode = decode;
+    item->parser = HttpResponseParser(decode);
+    item->data = request;
+    item->deadline = deadline;
+    item->callback = callback;
+    if (NULL == sink)
+    {
+        item->buffered.reset(new HttpStringSink(item->body));
+        sink = item->buffered.get();
+    }
+    item->sink = sink;
+    item->timing.host = url.host;
+    item->start = Clock::now();
+
+    bool notify = false;    // зǿʱ I/O ߳Ѿѹظ
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (false == m_stop)
+        {
+            notify = m_submitted.empty();
+            m_submitted.push_back(item.release());
+        }
+    }
+    if (item)
+    {
+        std::string empty;
+        callback(ECANCELED, empty);
+        return;
+    }
+    if (notify)
+    {
+        wake();
+    }
+}
+
+void HttpEventLoop::run()
+{
+    epoll_event events[64];
+    for (;;)
+    {
+        int count = ::epoll_wait(m_epoll, events, 64, nextTimeout());
+        for (int i = 0; i < count; ++i)
+        {
+            Request* request = static_cast<Request*>(events[i].data.ptr);
+            if (NULL == request)
+            {
+                uint64_t value = 0;
+                ssize_t ignored = ::read(m_wakeup, &value, sizeof(value));
+                (void)ignored;
+            }
+            else if (Request::Connecting == request->state)
+            {
+                watch(request, 0);
+                connected(request, request->connection->finishConnect());
+            }
+            else if (Request::Tunneling == request->state)
+            {
+                tunnel(request);
+            }
+            else if (Request::Handshaking == request->state)
+            {
+                handshake(request);
+            }
+            else
+            {
+                advance(request);
+            }
+        }
+
+        std::vector<Request*> submitted;
+        std::vector<Lookup> lookups;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stop)
+            {
+                break;
+            }
+            submitted.swap(m_submitted);
+            lookups.swap(m_resolved);
+        }
+        for (std::vector<Request*>::iterator it = submitted.begin(); submitted.end() != it; ++it)
+        {
+            m_waiting[(*it)->endpoint].push_back(*it);
+            if (Clock::time_point::max() != (*it)->deadline)
+            {
+                (*it)->timer = m_timers.insert(std::make_pair((*it)->deadline, *it));
+                (*it)->hasTimer = true;
+            }
+        }
+
+        resolved(lookups);
+        expire();
+        dispatch();
+    }
+}
+
+void HttpEventLoop::runResolver()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        while (false == m_stop && m_lookups.empty())
+        {
+            m_resolveCondition.wait(lock);
+        }
+        if (m_stop)
+        {
+            break;
+        }
+        Lookup lookup = m_lookups.front();
+        m_lookups.pop_front();
+
+        lock.unlock();
+        lookup.error = HttpSocketConnection::resolve(lookup.host, lookup.port, lookup.addresses);
+        lock.lock();
+
+        bool notify = m_resolved.empty();
+        m_resolved.push_back(lookup);
+        if (notify)
+        {
+            wake();
+        }
+    }
+}
+
+void HttpEventLoop::resolved(std::vector<Lookup>& lookups)
+{
+    for (std::vector<Lookup>::iterator it = lookups.begin(); lookups.end() != it; ++it)
+    {
+        std::map<unsigned long long, Request*>::iterator found = m_resolving.find(it->id);
+        if (m_resolving.end() == found)
+        {
+            continue;   // Ѿʱȡ
+        }
+        Request* request = found->second;
+        m_resolving.erase(found);
+
+        // ʱ I/O ̵߳ӽǼ㣬ڸ߳Ŷӵʱ
+        request->state = Request::Connecting;
+        DWORD error = request->connection->startConnect(it->addresses, elapsedMs(request->step));
+        connected(request, ERROR_SUCCESS == it->error ? error : it->error);
+    }
+}
+
+void HttpEventLoop::wake()
+{
+    uint64_t value = 1;
+    ssize_t ignored = ::write(m_wakeup, &value, sizeof(value));
+    (void)ignored;
+}
+
+void HttpEventLoop::dispatch()
+{
+    std::map<HttpEndpoint, std::deque<Request*> >::iterator it = m_waiting.begin();
+    while (m_waiting.end() != it)
+    {
+        std::deque<Request*>& queue = it->second;
+        std::unique_ptr<HttpConnection> pooled;
+        while (false == queue.empty() && m_pool.tryAcquire(it->first, pooled))
+        {
+            Request* request = queue.front();
+            queue.pop_front();
+            begin(request, std::move(pooled));
+        }
+        if (queue.empty())
+        {
+            m_waiting.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void HttpEventLoop::begin(Request* request, std::unique_ptr<HttpConnection> pooled)
+{
+    m_active.insert(request);
+    request->timing.queueMs = elapsedMs(request->start);
+    if (!pooled)
+    {
+        connect(request);
+        return;
+    }
+
+    request->connection.reset(static_cast<HttpSocketConnection*>(pooled.release()));
+    request->reused = true;
+    request->timing.reused = true;
+    request->step = Clock::now();
+    request->state = Request::Sending;
+    touch(request, std::chrono::milliseconds(kHttpIoTimeoutMs));
+    advance(request);
+}
+
+void HttpEventLoop::connect(Request* request)
+{
+    watch(request, 0);
+    request->connection.reset(new HttpSocketConnection());
+    request->reused = false;
+    request->timing.reused = false;
+    request->step = Clock::now();
+    request->state = Request::Resolving;
+
+    bool const direct = (HttpProxyNone == request->proxy.type);
+    Lookup lookup;
+    lookup.id = ++m_nextLookup;
+    lookup.host = (direct ? request->url.host : request->proxy.host);
+    lookup.port = (direct ? request->url.port : request->proxy.port);
+    lookup.error = ERROR_SUCCESS;
+    request->lookup = lookup.id;
+    m_resolving[lookup.id] = request;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lookups.push_back(lookup);
+    }
+    m_resolveCondition.notify_one();
+    touch(request, std::chrono::milliseconds(kHttpConnectTimeoutMs));
+}
+
+void HttpEventLoop::connected(Request* request, DWORD error)
+{
+    if (EINPROGRESS == error)
+    {
+        watch(request, EPOLLOUT);
+        touch(request, std::chrono::milliseconds(kHttpConnectTimeoutMs));
+        return;
+    }
+    // ʧʱҲ¼ǽӳ
+    request->timing.dnsMs = request->connection->resolveMs();
+    request->timing.connectMs = elapsedMs(request->step) - request->timing.dnsMs;
+    request->step = Clock::now();
+    if (ERROR_SUCCESS == error && httpProxyTunnels(request->proxy, request->url))
+    {
+        error = request->connection->startTunnel(request->proxy, request->url.host, request->url.port);
+        if (ERROR_SUCCESS == error)
+        {
+            request->state = Request::Tunneling;
+            touch(request, std::chrono::milliseconds(kHttpIoTimeoutMs));
+            tunnel(request);
+            return;
+        }
+    }
+    if (ERROR_SUCCESS != error)
+    {
+        finish(request, error);
+        return;
+    }
+    established(request);
+}
+
+void HttpEventLoop::tunnel(Request* request)
+{
+    DWORD error = request->connection->tryTunnel();
+    if (EAGAIN == error)
+    {
+        watch(request, request->connection->wantEvents());
+        return;
+    }
+    request->timing.proxyMs = elapsedMs(request->step);
+    if (ERROR_SUCCESS != error)
+    {
+        finish(request, error);
+        return;
+    }
+    established(request);
+}
+
+void HttpEventLoop::established(Request* request)
+{
+    // Ŀӣѽhttps  TLS 
+    request->step = Clock::now();
+    if (request->tls)
+    {
+        DWORD error = request->connection->startTls(*request->tls, request->url.host);
+        if (ERROR_SUCCESS != error)
+        {
+            finish(request, error);
+            return;
+        }
+        request->state = Request::Handshaking;
+        touch(request, std::chrono::milliseconds(kHttpIoTimeoutMs));
+        handshake(request);
+        return;
+    }
+
+    request->state = Request::Sending;
+    touch(request, std::chrono::milliseconds(kHttpIoTimeoutMs));
+    advance(request);
+}
+
+void HttpEventLoop::handshake(Request* request)
+{
+    DWORD error = request->connection->tryHandshake();
+    if (EAGAIN == error)
+    {
+        watch(request, request->connection->wantEvents());
+        return;
+    }
+    request->timing.tlsMs = elapsedMs(request->step);
+    if (ERROR_SUCCESS != error)
+    {
+        finish(request, error);
+        return;
+    }
+
+    request->step = Clock::now();
+    request->state = Request::Sending;
+    touch(request, std::chrono::milliseconds(kHttpIoTimeoutMs));
+    advance(request);
+}
+
+void HttpEventLoop::advance(Request* request)
+{
+    for (;;)
+    {
+        if (Request::Sending == request->state)
+        {
+            if (request->data.size() == request->sent)
+            {
+                request->timing.sendMs = elapsedMs(request->step);
+                request->timing.bytesSent = request->sent;
+                request->timing.bytesReceived = 0;
+                request->step = Clock::now();
+                request->state = Request::Receiving;
+                continue;
+            }
+
+            size_t sent = 0;
+            DWORD error = request->connection->trySend(request->data.data() + request->sent
+                , request->data.size() - request->sent, sent);
+            if (EAGAIN == error)
+            {
+                watch(request, request->connection->wantEvents());
+                return;
+            }
+            if (ERROR_SUCCESS != error)
+            {
+                fail(request, error);
+                return;
+            }
+            request->sent += sent;
+            touch(request, std::chrono::milliseconds(kHttpIoTimeoutMs));
+            continue;
+        }
+
+        size_t received = 0;
+        DWORD error = request->connection->tryReceive(&m_buffer[0], m_buffer.size(), received);
+        if (EAGAIN == error)
+        {
+            watch(request, request->connection->wantEvents());
+            return;
+        }
+        if (ERROR_SUCCESS != error)
+        {
+            fail(request, error);
+            return;
+        }
+        touch(request, std::chrono::milliseconds(kHttpIoTimeoutMs));
+        if (0 == request->timing.bytesReceived && received > 0)
+        {
+            request->timing.ttfbMs = elapsedMs(request->step);
+            request->step = Clock::now();
+        }
+        request->timing.bytesReceived += received;
+
+        if (0 == received)
+        {
+            if (request->parser.finish())
+            {
+                finish(request, ERROR_SUCCESS);
+            }
+            else
+            {
+                fail(request, request->parser.started() ? static_cast<DWORD>(EcHttpProtocolError) : static_cast<DWORD>(ECONNRESET));
+            }
+            return;
+        }
+        if (false == request->parser.feed(&m_buffer[0], received, *request->sink))
+        {
+            finish(request, request->parser.aborted() ? static_cast<DWORD>(EcHttpAborted) : static_cast<DWORD>(EcHttpProtocolError));
+            return;
+        }
+        if (request->parser.complete())
+        {
+            finish(request, ERROR_SUCCESS);
+            return;
+        }
+    }
+}
+
+void HttpEventLoop::fail(Request* request, DWORD error)
+{
+    // õӿڿڼ䱻Զ˹رգûյκӦʱһطһ
+    if (request->reused && false == request->retried && false == request->parser.started() && ETIMEDOUT != error)
+    {
+        request->retried = true;
+        request->sent = 0;
+        request->body.clear();
+        request->parser = HttpResponseParser(request->decode);
+        connect(request);
+        return;
+    }
+    finish(request, error);
+}
+
+void HttpEventLoop::finish(Request* request, DWORD error)
+{
+    std::unique_ptr<Request> owner(request);
+    watch(request, 0);
+    if (Request::Resolving == request->state)
+    {
+        m_resolving.erase(request->lookup);
+    }
+    if (request->hasTimer)
+    {
+        m_timers.erase(request->timer);
+        request->hasTimer = false;
+    }
+    m_active.erase(request);
+
+    bool keepAlive = (ERROR_SUCCESS == error && request->parser.keepAlive());
+    m_pool.release(request->endpoint, std::move(request->connection), keepAlive);
+
+    if (ERROR_SUCCESS != error)
+    {
+        request->body.clear();
+    }
+    else if (200 != request->parser.statusCode())
+    {
+        error = httpStatusError(request->parser.statusCode(), request->proxy, request->url);
+    }
+    if (request->parser.complete())
+    {
+        request->timing.transferMs = elapsedMs(request->step);
+    }
+    report(request, error);
+    request->callback(error, request->body);
+}
+
+void HttpEventLoop::drop(Request* request, DWORD error)
+{
+    // Ŷӵûռӳ
+    std::unique_ptr<Request> owner(request);
+    std::map<HttpEndpoint, std::deque<Request*> >::iterator it = m_waiting.find(request->endpoint);
+    if (m_waiting.end() != it)
+    {
+        it->second.erase(std::remove(it->second.begin(), it->second.end(), request), it->second.end());
+        if (it->second.empty())
+        {
+            m_waiting.erase(it);
+        }
+    }
+    report(request, error);
+    std::string empty;
+    request->callback(error, empty);
+}
+
+void HttpEventLoop::report(Request* request, DWORD error)
+{
+    if (m_timingListener)
+    {
+        request->timing.error = error;
+        request->timing.totalMs = elapsedMs(request->start);
+        m_timingListener(request->timing);
+    }
+}
+
+void HttpEventLoop::watch(Request* request, unsigned int events)
+{
+    // POLLIN/POLLOUT  EPOLLIN/EPOLLOUT ȡֵͬwantEvents() ֱӴ
+    static_assert(POLLIN == EPOLLIN && POLLOUT == EPOLLOUT, "poll and epoll event bits differ");
+    // fd رǰעevents Ϊ 0Ӹͬһ fd ʱ
+    int fd = (request->connection ? request->connection->fd() : -1);
+    if (0 == events || fd < 0)
+    {
+        if (request->watchedFd >= 0)
+        {
+            ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, request->watchedFd, NULL);
+            request->watchedFd = -1;
+        }
+        return;
+    }
+    if (fd == request->watchedFd && events == request->watchedEvents)
+    {
+        return;
+    }
+
+    epoll_event event;
+    event.events = events;
+    event.data.ptr = request;
+    ::epoll_ctl(m_epoll, fd == request->watchedFd ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event);
+    request->watchedFd = fd;
+    request->watchedEvents = events;
+}
+
+void HttpEventLoop::touch(Request* request, Clock::duration timeout)
+{
+    if (request->hasTimer)
+    {
+        m_timers.erase(request->timer);
+    }
+    Clock::time_point at = Clock::now() + timeout;
+    request->timer = m_timers.insert(std::make_pair(at < request->deadline ? at : request->deadline, request));
+    request->hasTimer = true;
+}
+
+int HttpEventLoop::nextTimeout() const
+{
+    if (m_timers.empty())
+    {
+        return -1;
+    }
+    Clock::duration remaining = m_timers.begin()->first - Clock::now();
+    if (remaining <= Clock::duration::zero())
+    {
+        return 0;
+    }
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count() + 1;
+    return ms > INT_MAX ? INT_MAX : static_cast<int>(ms);
+}
+
+void HttpEventLoop::expire()
+{
+    Clock::time_point now = Clock::now();
+    while (false == m_timers.empty() && m_timers.begin()->first <= now)
+    {
+        Request* request = m_timers.begin()->second;
+        m_timers.erase(m_timers.begin());
+        request->hasTimer = false;
+
+        if (request->deadline <= now)
+        {
+            // ڣٻַ߻
+            if (Request::Waiting == request->state)
+            {
+                drop(request, ETIMEDOUT);
+            }
+            else
+            {
+                finish(request, ETIMEDOUT);
+            }
+        }
+        else if (Request::Connecting == request->state)
+        {
+            watch(request, 0);
+            connected(request, request->connection->abandonConnect(ETIMEDOUT));
+        }
+        else
+        {
+            fail(request, ETIMEDOUT);
+        }
+    }
+}
+
+void HttpEventLoop::cancelAll()
+{
+    while (false == m_active.empty())
+    {
+        finish(*m_active.begin(), ECANCELED);
+    }
+
+    std::vector<Request*> pending;
+    pending.swap(m_submitted);
+    for (std::map<HttpEndpoint, std::deque<Request*> >::iterator it = m_waiting.begin(); m_waiting.end() != it; ++it)
+    {
+        pending.insert(pending.end(), it->second.begin(), it->second.end());
+    }
+    m_waiting.clear();
+
+    for (std::vector<Request*>::iterator it = pending.begin(); pending.end() != it; ++it)
+    {
+        std::unique_ptr<Request> request(*it);
+        std::string empty;
+        request->callback(ECANCELED, empty);
+    }
+}
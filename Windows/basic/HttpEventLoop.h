@@ -0,0 +1,101 @@
+#ifndef __HTTPEVENTLOOP_H__
+#define __HTTPEVENTLOOP_H__
+
+#include "HttpSocketTransport.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+/**************************************************************************/
+
+/*
+* HttpClient 첽ӿڵ POSIX ˣһ I/O ߳ epoll ;
+*
+* ȡ HttpClient ӳأͬÿ host Լ¼ѭŶӣ
+* ռ̡߳ص I/O ִ߳УҪڻصʱ
+*
+* getaddrinfo ûз汾DNS һ̣߳ٽ I/O ̣߳ĽῨס
+*/
+class HttpEventLoop
+{
+public:
+    explicit HttpEventLoop(HttpConnectionPool& pool);
+    ~HttpEventLoop();   // δɵڵ߳ ECANCELED ص
+
+    DWORD start();
+    void setTimingListener(const HttpTimingCallback& listener);     // start() ֮ǰ
+    // request Ϊģ formatHttpRequestproxy ͲΪ HttpProxyNone ʱ½Ӿ
+    // tls Ϊʱ½ TLS ֣decode Ϊ true ʱ Accept-Encoding Content-Encoding ѹӦ壻
+    //  deadline δɣŶӣʱ ETIMEDOUT صtime_point::max() ʾʱ
+    // sink ΪʱӦսַ callback I/O ߳ϱձ߽ sinkcallback յ resp_data Ϊ
+    void submit(const HttpUrl& url, const std::string& request, const HttpProxy& proxy, HttpTlsProvider* tls, bool decode
+        , std::chrono::steady_clock::time_point deadline, HttpBodySink* sink, const HttpCallback& callback);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    struct Request;
+
+    struct Lookup
+    {
+        unsigned long long id;      // Ӧ m_resolving ļڽڼʱҲֱӶ
+        std::string host;
+        unsigned short port;
+        DWORD error;
+        std::vector<HttpSocketConnection::Address> addresses;
+    };
+
+    void run();
+    void runResolver();
+    void resolved(std::vector<Lookup>& lookups);
+    void wake();
+    void dispatch();
+    void begin(Request* request, std::unique_ptr<HttpConnection> pooled);
+    void connect(Request* request);
+    void connected(Request* request, DWORD error);
+    void tunnel(Request* request);
+    void established(Request* request);
+    void handshake(Request* request);
+    void advance(Request* request);
+    void fail(Request* request, DWORD error);
+    void finish(Request* request, DWORD error);
+    void drop(Request* request, DWORD error);
+    void report(Request* request, DWORD error);
+    void watch(Request* request, unsigned int events);
+    void touch(Request* request, Clock::duration timeout);
+    int nextTimeout() const;
+    void expire();
+    void cancelAll();
+
+    HttpEventLoop(const HttpEventLoop&);
+    void operator=(const HttpEventLoop&);
+
+private:
+    HttpConnectionPool& m_pool;
+    HttpTimingCallback m_timingListener;
+    int m_epoll;
+    int m_wakeup;       // eventfd
+    std::thread m_thread;
+    std::thread m_resolver;
+    bool m_stop;        //  m_mutex 
+
+    std::mutex m_mutex;
+    std::condition_variable m_resolveCondition;
+    std::vector<Request*> m_submitted;  // ߳ύδ I/O ߳ȡߵ
+    std::deque<Lookup> m_lookups;       // ȴ
+    std::vector<Lookup> m_resolved;     // ѽδ I/O ߳ȡ
+
+    // ½ I/O ߳Ϸ
+    std::map<HttpEndpoint, std::deque<Request*> > m_waiting;    // ȴ
+    std::set<Request*> m_active;
+    std::multimap<Clock::time_point, Request*> m_timers;
+    std::map<unsigned long long, Request*> m_resolving;
+    unsigned long long m_nextLookup;
+    std::vector<char> m_buffer;
+};
+
+#endif /* __HTTPEVENTLOOP_H__ */
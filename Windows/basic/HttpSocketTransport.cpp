@@ -0,0 +1,1151 @@
+#include "HttpSocketTransport.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <chrono>
+/**************************************************************************/
+
+namespace
+{
+    const size_t kProxyReplyMaxSize = 16 * 1024;    // CONNECT Ӧͷĳ
+
+    std::string base64Encode(const std::string& data)
+    {
+        static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string result;
+        result.reserve((data.size() + 2) / 3 * 4);
+        for (size_t i = 0; i < data.size(); i += 3)
+        {
+            unsigned long value = static_cast<unsigned char>(data[i]) << 16;
+            if (i + 1 < data.size())
+            {
+                value |= static_cast<unsigned char>(data[i + 1]) << 8;
+            }
+            if (i + 2 < data.size())
+            {
+                value |= static_cast<unsigned char>(data[i + 2]);
+            }
+            result += kAlphabet[(value >> 18) & 0x3F];
+            result += kAlphabet[(value >> 12) & 0x3F];
+            result += (i + 1 < data.size() ? kAlphabet[(value >> 6) & 0x3F] : '=');
+            result += (i + 2 < data.size() ? kAlphabet[value & 0x3F] : '=');
+        }
+        return result;
+    }
+
+    // host:portIPv6 ַӷ
+    std::string formatAuthority(const std::string& host, unsigned short port)
+    {
+        char suffix[8] = { 0 };
+        ::snprintf(suffix, sizeof(suffix), ":%u", static_cast<unsigned int>(port));
+        return (std::string::npos == host.find(':') ? host : "[" + host + "]") + suffix;
+    }
+}
+
+/*
+* ֣ӵķ socket 
+*
+* ÿֻȡǰӦֽڣCONNECT ӦȿȡΪֹĿ
+*/
+class HttpProxyTunnel
+{
+public:
+    HttpProxyTunnel(const HttpProxy& proxy, const std::string& host, unsigned short port);
+
+    //  ERROR_SUCCESSʱ޷ʱ EAGAINҪȴ¼ wantEvents
+    DWORD advance(int fd, short& wantEvents);
+
+private:
+    enum Step
+    {
+        StepSocksMethod,    // SOCKS5 ѡ֤ʽ
+        StepSocksAuth,      // û֤
+        StepSocksConnect,   // SOCKS5 CONNECT Ӧ
+        StepHttpConnect,    // HTTP CONNECT Ӧ
+        StepDone,
+    };
+
+    DWORD receive(int fd, short& wantEvents);
+    DWORD onReply();
+    DWORD onHttpReply();
+    void request(Step step, const std::string& data, size_t expected);
+    std::string socksConnect() const;
+
+    HttpProxyTunnel(const HttpProxyTunnel&);
+    void operator=(const HttpProxyTunnel&);
+
+private:
+    HttpProxy m_proxy;
+    std::string m_host;
+    unsigned short m_port;
+    Step m_step;
+    std::string m_out;      // ͵
+    size_t m_sent;
+    std::string m_in;       // ǰӦյĲ
+    size_t m_expected;      // ǰӦĳȣHTTP ӦΪֹΪ 0
+};
+
+HttpProxyTunnel::HttpProxyTunnel(const HttpProxy& proxy, const std::string& host, unsigned short port)
+    : m_proxy(proxy)
+    , m_host(host)
+    , m_port(port)
+    , m_step(StepDone)
+    , m_sent(0)
+    , m_expected(0)
+{
+    if (HttpProxySocks5 == proxy.type)
+    {
+        // 汾 5ṩ֤ʽ֤û
+        request(StepSocksMethod, proxy.username.empty() ? std::string("\x05\x01\x00", 3) : std::string("\x05\x02\x00\x02", 4), 2);
+        return;
+    }
+
+    std::string authority = formatAuthority(host, port);
+    std::string data = "CONNECT " + authority + " HTTP/1.1\r\n";
+    data += "Host: " + authority + "\r\n";
+    std::string authorization = httpProxyAuthorization(proxy);
+    if (false == authorization.empty())
+    {
+        data += "Proxy-Authorization: " + authorization + "\r\n";
+    }
+    data += "\r\n";
+    request(StepHttpConnect, data, 0);
+}
+
+DWORD HttpProxyTunnel::advance(int fd, short& wantEvents)
+{
+    wantEvents = 0;
+    while (StepDone != m_step)
+    {
+        if (m_sent < m_out.size())
+        {
+            ssize_t count = ::send(fd, m_out.data() + m_sent, m_out.size() - m_sent, MSG_NOSIGNAL);
+            if (count < 0)
+            {
+                if (EINTR == errno)
+                {
+                    continue;
+                }
+                if (EAGAIN == errno || EWOULDBLOCK == errno)
+                {
+                    wantEvents = POLLOUT;
+                    return EAGAIN;
+                }
+                return errno;
+            }
+            m_sent += static_cast<size_t>(count);
+            continue;
+        }
+
+        DWORD error = receive(fd, wantEvents);
+        if (ERROR_SUCCESS != error)
+        {
+            return error;
+        }
+        bool const complete = (0 == m_expected
+            ? m_in.size() >= 4 && 0 == m_in.compare(m_in.size() - 4, 4, "\r\n\r\n")
+            : m_in.size() == m_expected);
+        if (complete)
+        {
+            error = onReply();
+            if (ERROR_SUCCESS != error)
+            {
+                return error;
+            }
+        }
+    }
+    return ERROR_SUCCESS;
+}
+
+DWORD HttpProxyTunnel::receive(int fd, short& wantEvents)
+{
+    char buffer[1024];
+    size_t size = sizeof(buffer);
+    int flags = 0;
+    if (0 != m_expected)
+    {
+        size = m_expected - m_in.size();
+    }
+    else
+    {
+        flags = MSG_PEEK;   // ֪Ӧͷȿһ
+    }
+
+    ssize_t count = 0;
+    for (;;)
+    {
+        count = ::recv(fd, buffer, size, flags);
+        if (count > 0)
+        {
+            break;
+        }
+        if (0 == count)
+        {
+            return ECONNRESET;  // Ӧǰر
+        }
+        if (EINTR != errno)
+        {
+            if (EAGAIN == errno || EWOULDBLOCK == errno)
+            {
+                wantEvents = POLLIN;
+                return EAGAIN;
+            }
+            return errno;
+        }
+    }
+    if (0 != m_expected)
+    {
+        m_in.append(buffer, static_cast<size_t>(count));
+        return ERROR_SUCCESS;
+    }
+
+    // ֻȡߵΪֹĲ֣ʣµ
+    size_t const previous = m_in.size();
+    m_in.append(buffer, static_cast<size_t>(count));
+    size_t const end = m_in.find("\r\n\r\n", previous < 3 ? 0 : previous - 3);
+    if (std::string::npos != end)
+    {
+        m_in.resize(end + 4);
+    }
+    else if (m_in.size() > kProxyReplyMaxSize)
+    {
+        return EcHttpProxyError;
+    }
+    size_t const consumed = m_in.size() - previous;
+    if (::recv(fd, buffer, consumed, 0) != static_cast<ssize_t>(consumed))
+    {
+        return EcHttpProxyError;
+    }
+    return ERROR_SUCCESS;
+}
+
+DWORD HttpProxyTunnel::onReply()
+{
+    const unsigned char* reply = reinterpret_cast<const unsigned char*>(m_in.data());
+    switch (m_step)
+    {
+    case StepSocksMethod:
+        if (0x05 != reply[0])
+        {
+            return EcHttpProxyError;
+        }
+        if (0x00 == reply[1])
+        {
+            request(StepSocksConnect, socksConnect(), 5);
+            return ERROR_SUCCESS;
+        }
+        if (0x02 == reply[1] && false == m_proxy.username.empty())
+        {
+            // RFC 1929汾 1ûһֽڵĳ
+            std::string data(1, '\x01');
+            data += static_cast<char>(m_proxy.username.size());
+            data += m_proxy.username;
+            data += static_cast<char>(m_proxy.password.size());
+            data += m_proxy.password;
+            request(StepSocksAuth, data, 2);
+            return ERROR_SUCCESS;
+        }
+        return 0xFF == reply[1] ? static_cast<DWORD>(EcHttpProxyAuthFailed) : static_cast<DWORD>(EcHttpProxyError);
+
+    case StepSocksAuth:
+        if (0x00 != reply[1])
+        {
+            return EcHttpProxyAuthFailed;
+        }
+        request(StepSocksConnect, socksConnect(), 5);
+        return ERROR_SUCCESS;
+
+    case StepSocksConnect:
+        if (0x05 != reply[0])
+        {
+            return EcHttpProxyError;
+        }
+        switch (reply[1])
+        {
+        case 0x00:
+            break;
+        // Ŀֱ꣬ʱĴһ£߼ж
+        case 0x03:
+            return ENETUNREACH;
+        case 0x04:
+            return EHOSTUNREACH;
+        case 0x05:
+            return ECONNREFUSED;
+        case 0x06:
+            return ETIMEDOUT;
+        default:
+            return EcHttpProxyError;
+        }
+        if (5 == m_in.size())
+        {
+            // Ӧа󶨵ַĳȡڵַͣǰ 5 ֽ֪Ӧĳ
+            switch (reply[3])
+            {
+            case 0x01:
+                m_expected = 4 + 4 + 2;
+                break;
+            case 0x03:
+                m_expected = 4 + 1 + reply[4] + 2;
+                break;
+            case 0x04:
+                m_expected = 4 + 16 + 2;
+                break;
+            default:
+                return EcHttpProxyError;
+            }
+            if (m_in.size() < m_expected)
+            {
+                return ERROR_SUCCESS;
+            }
+        }
+        m_step = StepDone;
+        return ERROR_SUCCESS;
+
+    case StepHttpConnect:
+        return onHttpReply();
+
+    default:
+        return EcHttpProxyError;
+    }
+}
+
+DWORD HttpProxyTunnel::onHttpReply()
+{
+    // ֻ״̬УHTTP/1.x 2xx ʾѽ
+    unsigned int major = 0;
+    unsigned int minor = 0;
+    unsigned int status = 0;
+    if (3 != ::sscanf(m_in.c_str(), "HTTP/%u.%u %u", &major, &minor, &status))
+    {
+        return EcHttpProxyError;
+    }
+    if (407 == status)
+    {
+        return EcHttpProxyAuthFailed;
+    }
+    if (status < 200 || status >= 300)
+    {
+        return EcHttpProxyError;
+    }
+    m_step = StepDone;
+    return ERROR_SUCCESS;
+}
+
+void HttpProxyTunnel::request(Step step, const std::string& data, size_t expected)
+{
+    m_step = step;
+    m_out = data;
+    m_sent = 0;
+    m_in.clear();
+    m_expected = expected;
+}
+
+std::string HttpProxyTunnel::socksConnect() const
+{
+    // 汾 5CONNECT Ŀʱز DNS
+    std::string data("\x05\x01\x00", 3);
+    unsigned char address[16];
+    if (1 == ::inet_pton(AF_INET, m_host.c_str(), address))
+    {
+        data += '\x01';
+        data.append(reinterpret_cast<const char*>(address), 4);
+    }
+    else if (1 == ::inet_pton(AF_INET6, m_host.c_str(), address))
+    {
+        data += '\x04';
+        data.append(reinterpret_cast<const char*>(address), 16);
+    }
+    else
+    {
+        data += '\x03';
+        data += static_cast<char>(m_host.size());
+        data += m_host;
+    }
+    data += static_cast<char>(m_port >> 8);
+    data += static_cast<char>(m_port & 0xFF);
+    return data;
+}
+
+bool parseHttpUrl(const std::string& url, HttpUrl& result)
+{
+    size_t pos = url.find("://");
+    if (std::string::npos == pos)
+    {
+        return false;
+    }
+    result.scheme = url.substr(0, pos);
+    for (size_t i = 0; i < result.scheme.size(); ++i)
+    {
+        result.scheme[i] = static_cast<char>(::tolower(static_cast<unsigned char>(result.scheme[i])));
+    }
+    if ("http" == result.scheme)
+    {
+        result.port = 80;
+    }
+    else if ("https" == result.scheme)
+    {
+        result.port = 443;
+    }
+    else
+    {
+        return false;
+    }
+
+    pos += 3;
+    size_t const authorityEnd = url.find_first_of("/?#", pos);
+    std::string authority = url.substr(pos, std::string::npos == authorityEnd ? std::string::npos : authorityEnd - pos);
+    size_t const at = authority.rfind('@');    // ֧ URL еû룬
+    if (std::string::npos != at)
+    {
+        authority.erase(0, at + 1);
+    }
+
+    std::string port;
+    if (false == authority.empty() && '[' == authority[0])
+    {
+        size_t const close = authority.find(']');
+        if (std::string::npos == close)
+        {
+            return false;
+        }
+        result.host = authority.substr(1, close - 1);
+        if (close + 1 < authority.size())
+        {
+            if (':' != authority[close + 1])
+            {
+                return false;
+            }
+            port = authority.substr(close + 2);
+        }
+    }
+    else
+    {
+        size_t const colon = authority.find(':');
+        result.host = authority.substr(0, colon);
+        if (std::string::npos != colon)
+        {
+            port = authority.substr(colon + 1);
+        }
+    }
+    if (result.host.empty())
+    {
+        return false;
+    }
+    if (false == port.empty())
+    {
+        char* end = NULL;
+        unsigned long value = ::strtoul(port.c_str(), &end, 10);
+        if ('\0' != *end || 0 == value || value > 65535)
+        {
+            return false;
+        }
+        result.port = static_cast<unsigned short>(value);
+    }
+
+    result.path = std::string::npos == authorityEnd ? "/" : url.substr(authorityEnd);
+    result.path.erase(std::min(result.path.find('#'), result.path.size()));
+    if (result.path.empty() || '/' != result.path[0])
+    {
+        result.path.insert(0, "/");
+    }
+    return true;
+}
+
+std::string formatHttpRequest(const std::string& method, const HttpUrl& url, const std::string& userAgent
+    , const std::vector<std::string>& headers, const std::string& body, bool absoluteUri)
+{
+    std::string host = (std::string::npos == url.host.find(':') ? url.host : "[" + url.host + "]");
+    if (("http" == url.scheme && 80 != url.port) || ("https" == url.scheme && 443 != url.port))
+    {
+        char port[8] = { 0 };
+        ::snprintf(port, sizeof(port), ":%u", static_cast<unsigned int>(url.port));
+        host += port;
+    }
+
+    std::string data = method + " " + (absoluteUri ? url.scheme + "://" + host : std::string()) + url.path + " HTTP/1.1\r\n";
+    data += "Host: " + host + "\r\n";
+    data += "User-Agent: " + userAgent + "\r\n";
+    if ("GET" != method)
+    {
+        char length[32] = { 0 };
+        ::snprintf(length, sizeof(length), "Content-Length: %lu\r\n", static_cast<unsigned long>(body.size()));
+        data += length;
+    }
+    for (std::vector<std::string>::const_iterator it = headers.begin(); headers.end() != it; ++it)
+    {
+        size_t const end = it->find_last_not_of("\r\n");
+        if (std::string::npos != end)
+        {
+            data.append(*it, 0, end + 1);
+            data += "\r\n";
+        }
+    }
+    data += "\r\n";
+    data += body;
+    return data;
+}
+
+bool httpProxyTunnels(const HttpProxy& proxy, const HttpUrl& url)
+{
+    return HttpProxySocks5 == proxy.type || (HttpProxyHttp == proxy.type && "https" == url.scheme);
+}
+
+std::string httpProxyAuthorization(const HttpProxy& proxy)
+{
+    if (proxy.username.empty())
+    {
+        return std::string();
+    }
+    return "Basic " + base64Encode(proxy.username + ":" + proxy.password);
+}
+
+std::string httpProxyKey(const HttpProxy& proxy)
+{
+    if (HttpProxyNone == proxy.type)
+    {
+        return std::string();
+    }
+    return (HttpProxySocks5 == proxy.type ? "socks5://" : "http://") + proxy.username + "@" + formatAuthority(proxy.host, proxy.port);
+}
+
+DWORD httpStatusError(unsigned int statusCode, const HttpProxy& proxy, const HttpUrl& url)
+{
+    if (407 == statusCode && HttpProxyHttp == proxy.type && false == httpProxyTunnels(proxy, url))
+    {
+        return EcHttpProxyAuthFailed;
+    }
+    return EcHttpCodeError;
+}
+
+HttpSocketConnection::HttpSocketConnection()
+    : m_fd(-1)
+    , m_wantEvents(0)
+    , m_resolveMs(-1)
+{
+
+}
+
+HttpSocketConnection::~HttpSocketConnection()
+{
+    m_tls.reset();      // TLS ỰܻҪ socket Ϸ close_notify
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+}
+
+DWORD HttpSocketConnection::connect(const std::string& host, unsigned short port, int timeoutMs)
+{
+    DWORD error = startConnect(host, port);
+    while (EINPROGRESS == error)
+    {
+        error = wait(POLLOUT, timeoutMs);
+        error = (ERROR_SUCCESS == error ? finishConnect() : abandonConnect(error));
+    }
+    return error;
+}
+
+DWORD HttpSocketConnection::tunnel(const HttpProxy& proxy, const std::string& host, unsigned short port, int timeoutMs)
+{
+    DWORD error = startTunnel(proxy, host, port);
+    while (ERROR_SUCCESS == error)
+    {
+        error = tryTunnel();
+        if (EAGAIN != error)
+        {
+            break;
+        }
+        error = wait(m_wantEvents, timeoutMs);
+    }
+    return error;
+}
+
+DWORD HttpSocketConnection::handshake(HttpTlsProvider& provider, const std::string& host, int timeoutMs)
+{
+    DWORD error = startTls(provider, host);
+    while (ERROR_SUCCESS == error)
+    {
+        error = tryHandshake();
+        if (EAGAIN != error)
+        {
+            break;
+        }
+        error = wait(m_wantEvents, timeoutMs);
+    }
+    return error;
+}
+
+DWORD HttpSocketConnection::send(const char* data, size_t size, int timeoutMs)
+{
+    while (size > 0)
+    {
+        size_t sent = 0;
+        DWORD error = trySend(data, size, sent);
+        if (EAGAIN == error)
+        {
+            error = wait(m_wantEvents, timeoutMs);
+        }
+        if (ERROR_SUCCESS != error)
+        {
+            return error;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return ERROR_SUCCESS;
+}
+
+DWORD HttpSocketConnection::receive(char* buffer, size_t size, size_t& received, int timeoutMs)
+{
+    for (;;)
+    {
+        DWORD error = tryReceive(buffer, size, received);
+        if (EAGAIN != error)
+        {
+            return error;
+        }
+        error = wait(m_wantEvents, timeoutMs);
+        if (ERROR_SUCCESS != error)
+        {
+            return error;
+        }
+    }
+}
+
+DWORD HttpSocketConnection::startConnect(const std::string& host, unsigned short port)
+{
+    std::vector<Address> addresses;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    DWORD error = resolve(host, port, addresses);
+    double resolveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (ERROR_SUCCESS != error)
+    {
+        m_resolveMs = resolveMs;
+        return error;
+    }
+    return startConnect(addresses, resolveMs);
+}
+
+DWORD HttpSocketConnection::startConnect(std::vector<Address>& addresses, double resolveMs)
+{
+    m_resolveMs = resolveMs;
+    m_addresses.swap(addresses);
+    std::reverse(m_addresses.begin(), m_addresses.end());   // βȡֽ˳
+    return connectNext(EHOSTUNREACH);
+}
+
+DWORD HttpSocketConnection::resolve(const std::string& host, unsigned short port, std::vector<Address>& addresses)
+{
+    addrinfo hints;
+    ::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[8] = { 0 };
+    ::snprintf(service, sizeof(service), "%u", static_cast<unsigned int>(port));
+
+    addrinfo* result = NULL;
+    int ret = ::getaddrinfo(host.c_str(), service, &hints, &result);
+    if (0 != ret)
+    {
+        return EAI_SYSTEM == ret ? errno : EHOSTUNREACH;
+    }
+
+    addresses.clear();
+    for (addrinfo* address = result; NULL != address; address = address->ai_next)
+    {
+        Address item;
+        ::memcpy(&item.addr, address->ai_addr, address->ai_addrlen);
+        item.length = address->ai_addrlen;
+        addresses.push_back(item);
+    }
+    ::freeaddrinfo(result);
+    return ERROR_SUCCESS;
+}
+
+DWORD HttpSocketConnection::finishConnect()
+{
+    int soError = 0;
+    socklen_t length = sizeof(soError);
+    if (0 != ::getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &soError, &length))
+    {
+        soError = errno;
+    }
+    if (0 == soError)
+    {
+        m_addresses.clear();
+        return ERROR_SUCCESS;
+    }
+    return connectNext(soError);
+}
+
+DWORD HttpSocketConnection::abandonConnect(DWORD error)
+{
+    return connectNext(error);
+}
+
+DWORD HttpSocketConnection::startTunnel(const HttpProxy& proxy, const std::string& host, unsigned short port)
+{
+    // SOCKS5 û붼ֻһֽڵĳ
+    if (HttpProxySocks5 == proxy.type && (host.size() > 255 || proxy.username.size() > 255 || proxy.password.size() > 255))
+    {
+        return EcHttpProxyError;
+    }
+    m_tunnel.reset(new HttpProxyTunnel(proxy, host, port));
+    return ERROR_SUCCESS;
+}
+
+DWORD HttpSocketConnection::tryTunnel()
+{
+    DWORD error = m_tunnel->advance(m_fd, m_wantEvents);
+    if (EAGAIN != error)
+    {
+        m_tunnel.reset();
+    }
+    return error;
+}
+
+DWORD HttpSocketConnection::startTls(HttpTlsProvider& provider, const std::string& host)
+{
+    m_tls.reset(provider.createChannel(m_fd, host));
+    return m_tls ? static_cast<DWORD>(ERROR_SUCCESS) : static_cast<DWORD>(EcHttpTlsError);
+}
+
+DWORD HttpSocketConnection::tryHandshake()
+{
+    DWORD error = m_tls->handshake();
+    m_wantEvents = (EAGAIN == error ? m_tls->wantEvents() : 0);
+    return error;
+}
+
+DWORD HttpSocketConnection::trySend(const char* data, size_t size, size_t& sent)
+{
+    if (m_tls)
+    {
+        DWORD error = m_tls->send(data, size, sent);
+        m_wantEvents = (EAGAIN == error ? m_tls->wantEvents() : 0);
+        return error;
+    }
+
+    m_wantEvents = POLLOUT;
+    for (;;)
+    {
+        ssize_t count = ::send(m_fd, data, size, MSG_NOSIGNAL);
+        if (count >= 0)
+        {
+            sent = static_cast<size_t>(count);
+            return ERROR_SUCCESS;
+        }
+        if (EINTR != errno)
+        {
+            return EWOULDBLOCK == errno ? static_cast<DWORD>(EAGAIN) : static_cast<DWORD>(errno);
+        }
+    }
+}
+
+DWORD HttpSocketConnection::tryReceive(char* buffer, size_t size, size_t& received)
+{
+    if (m_tls)
+    {
+        DWORD error = m_tls->receive(buffer, size, received);
+        m_wantEvents = (EAGAIN == error ? m_tls->wantEvents() : 0);
+        return error;
+    }
+
+    m_wantEvents = POLLIN;
+    for (;;)
+    {
+        ssize_t count = ::recv(m_fd, buffer, size, 0);
+        if (count >= 0)
+        {
+            received = static_cast<size_t>(count);
+            return ERROR_SUCCESS;
+        }
+        if (EINTR != errno)
+        {
+            return EWOULDBLOCK == errno ? static_cast<DWORD>(EAGAIN) : static_cast<DWORD>(errno);
+        }
+    }
+}
+
+bool HttpSocketConnection::isAlive() const
+{
+    // ϲӦݣɶζŶԶѹرգ˶ݣ
+    pollfd item = { m_fd, POLLIN, 0 };
+    if (m_fd < 0 || 0 != ::poll(&item, 1, 0))
+    {
+        if (m_fd < 0 || !m_tls)
+        {
+            return false;
+        }
+        // TLS 1.3 ֮ᲹỰƱݵȼ¼ TLS ûӦݲ
+        char byte = 0;
+        size_t received = 0;
+        return EAGAIN == m_tls->receive(&byte, 1, received);
+    }
+    return true;
+}
+
+DWORD HttpSocketConnection::connectNext(DWORD error)
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    while (false == m_addresses.empty())
+    {
+        Address address = m_addresses.back();
+        m_addresses.pop_back();
+        m_fd = ::socket(address.addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (m_fd < 0)
+        {
+            error = errno;
+            continue;
+        }
+        int one = 1;
+        ::setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if (0 == ::connect(m_fd, reinterpret_cast<const sockaddr*>(&address.addr), address.length))
+        {
+            m_addresses.clear();
+            return ERROR_SUCCESS;
+        }
+        error = errno;
+        if (EINPROGRESS == error)
+        {
+            return error;
+        }
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    return error;
+}
+
+DWORD HttpSocketConnection::wait(short events, int timeoutMs)
+{
+    pollfd item = { m_fd, events, 0 };
+    for (;;)
+    {
+        int ret = ::poll(&item, 1, timeoutMs);
+        if (ret > 0)
+        {
+            return ERROR_SUCCESS;
+        }
+        if (0 == ret)
+        {
+            return ETIMEDOUT;
+        }
+        if (EINTR != errno)
+        {
+            return errno;
+        }
+    }
+}
+
+HttpResponseParser::HttpResponseParser(bool decode)
+    : m_state(StateStatusLine)
+    , m_statusCode(0)
+    , m_http11(false)
+    , m_keepAlive(false)
+    , m_started(false)
+    , m_aborted(false)
+    , m_untilClose(false)
+    , m_remaining(0)
+    , m_decode(decode)
+{
+
+}
+
+bool HttpResponseParser::feed(const char* data, size_t size, HttpBodySink& sink)
+{
+    const char* const end = data + size;
+    m_started = m_started || size > 0;
+    while (data != end)
+    {
+        if (StateBody == m_state || StateChunkData == m_state)
+        {
+            size_t count = static_cast<size_t>(end - data);
+            if (false == m_untilClose && count > m_remaining)
+            {
+                count = static_cast<size_t>(m_remaining);
+            }
+            if (false == deliver(data, count, sink))
+            {
+                return false;
+            }
+            data += count;
+            if (false == m_untilClose)
+            {
+                m_remaining -= count;
+                if (0 == m_remaining)
+                {
+                    if (StateChunkData == m_state)
+                    {
+                        m_state = StateChunkEnd;
+                    }
+                    else if (false == endBody())
+                    {
+                        return false;
+                    }
+                }
+            }
+            continue;
+        }
+        if (StateDone == m_state)
+        {
+            // keep-alive ϲӦö
+            m_keepAlive = false;
+            return true;
+        }
+
+        const char* const newline = static_cast<const char*>(::memchr(data, '\n', end - data));
+        if (NULL == newline)
+        {
+            m_line.append(data, end);
+            if (m_line.size() > 64 * 1024)
+            {
+                return false;
+            }
+            return true;
+        }
+        m_line.append(data, newline);
+        data = newline + 1;
+        if (false == m_line.empty() && '\r' == m_line[m_line.size() - 1])
+        {
+            m_line.erase(m_line.size() - 1);
+        }
+
+        bool ok = true;
+        if (StateStatusLine == m_state)
+        {
+            ok = parseStatusLine(m_line);
+        }
+        else if (StateChunkSize == m_state)
+        {
+            ok = parseChunkSize(m_line);
+        }
+        else if (StateChunkEnd == m_state)
+        {
+            ok = m_line.empty();
+            m_state = StateChunkSize;
+        }
+        else if (StateTrailers == m_state)
+        {
+            if (m_line.empty())
+            {
+                ok = endBody();
+            }
+        }
+        else if (m_line.empty())
+        {
+            ok = endHeaders();
+        }
+        else
+        {
+            ok = parseHeader(m_line);
+        }
+        m_line.clear();
+        if (false == ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HttpResponseParser::finish()
+{
+    if (StateBody == m_state && m_untilClose)
+    {
+        m_keepAlive = false;
+        return endBody();
+    }
+    return StateDone == m_state;
+}
+
+bool HttpResponseParser::deliver(const char* data, size_t size, HttpBodySink& sink)
+{
+    DWORD error = ERROR_SUCCESS;
+    if (m_decoder)
+    {
+        error = m_decoder->decode(data, size, sink);
+    }
+    else if (false == sink.onData(data, size))
+    {
+        error = EcHttpAborted;
+    }
+    m_aborted = (EcHttpAborted == error);
+    return ERROR_SUCCESS == error;
+}
+
+bool HttpResponseParser::endBody()
+{
+    // ѹضʱӦҲܸ
+    if (m_decoder && false == m_decoder->finish())
+    {
+        return false;
+    }
+    m_state = StateDone;
+    return true;
+}
+
+bool HttpResponseParser::parseStatusLine(const std::string& line)
+{
+    // HTTP/1.1 200 OK
+    if (line.size() < 12 || 0 != line.compare(0, 7, "HTTP/1.") || ' ' != line[8])
+    {
+        return false;
+    }
+    m_http11 = '1' == line[7];
+    m_statusCode = 0;
+    for (size_t i = 9; i < 12; ++i)
+    {
+        if (line[i] < '0' || line[i] > '9')
+        {
+            return false;
+        }
+        m_statusCode = m_statusCode * 10 + (line[i] - '0');
+    }
+    m_keepAlive = m_http11;
+    m_headers.clear();
+    m_state = StateHeaders;
+    return true;
+}
+
+bool HttpResponseParser::parseHeader(const std::string& line)
+{
+    size_t const colon = line.find(':');
+    if (std::string::npos == colon || 0 == colon)
+    {
+        return false;
+    }
+    size_t first = line.find_first_not_of(" \t", colon + 1);
+    size_t last = line.find_last_not_of(" \t");
+    std::string value = std::string::npos == first ? std::string() : line.substr(first, last + 1 - first);
+    m_headers.push_back(std::make_pair(line.substr(0, colon), value));
+    return true;
+}
+
+bool HttpResponseParser::endHeaders()
+{
+    if (m_statusCode >= 100 && m_statusCode < 200)
+    {
+        // 100 Continue ʱӦ滹ʽӦ
+        m_state = StateStatusLine;
+        return true;
+    }
+
+    bool hasLength = false;
+    bool chunked = false;
+    m_remaining = 0;
+    m_decoder.reset();
+    for (size_t i = 0; i < m_headers.size(); ++i)
+    {
+        const std::string& name = m_headers[i].first;
+        const std::string& value = m_headers[i].second;
+        if (0 == ::strcasecmp(name.c_str(), "Content-Length"))
+        {
+            char* end = NULL;
+            errno = 0;
+            unsigned long long length = ::strtoull(value.c_str(), &end, 10);
+            if (value.empty() || '\0' != *end || ERANGE == errno || (hasLength && length != m_remaining))
+            {
+                return false;
+            }
+            hasLength = true;
+            m_remaining = length;
+        }
+        else if (0 == ::strcasecmp(name.c_str(), "Transfer-Encoding"))
+        {
+            // ֻ chunked Ϊһ룬루gzip ȣûӦ
+            std::string coding = value.substr(value.rfind(',') + 1);
+            size_t const first = coding.find_first_not_of(" \t");
+            if (std::string::npos == first || 0 != ::strcasecmp(coding.c_str() + first, "chunked"))
+            {
+                return false;
+            }
+            chunked = true;
+        }
+        else if (0 == ::strcasecmp(name.c_str(), "Content-Encoding") && m_decode
+            && false == value.empty() && 0 != ::strcasecmp(value.c_str(), "identity"))
+        {
+            m_decoder.reset(createHttpContentDecoder(value));
+            if (!m_decoder)
+            {
+                return false;
+            }
+        }
+        else if (0 == ::strcasecmp(name.c_str(), "Connection"))
+        {
+            if (0 == ::strcasecmp(value.c_str(), "close"))
+            {
+                m_keepAlive = false;
+            }
+            else if (0 == ::strcasecmp(value.c_str(), "keep-alive"))
+            {
+                m_keepAlive = true;
+            }
+        }
+    }
+
+    if (204 == m_statusCode || 304 == m_statusCode)
+    {
+        m_state = StateDone;
+    }
+    else if (chunked)
+    {
+        // ͬʱʱ Transfer-Encoding Ϊ׼
+        m_remaining = 0;
+        m_state = StateChunkSize;
+    }
+    else if (hasLength && 0 == m_remaining)
+    {
+        m_state = StateDone;
+    }
+    else if (hasLength)
+    {
+        m_state = StateBody;
+    }
+    else
+    {
+        m_untilClose = true;
+        m_keepAlive = false;
+        m_state = StateBody;
+    }
+    return true;
+}
+
+bool HttpResponseParser::parseChunkSize(const std::string& line)
+{
+    // 1a3f;ext=value
+    std::string size = line.substr(0, line.find(';'));
+    size.erase(std::min(size.find_last_not_of(" \t") + 1, size.size()));
+    if (size.empty() || size.size() > 15)
+    {
+        return false;
+    }
+    m_remaining = 0;
+    for (size_t i = 0; i < size.size(); ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(size[i]);
+        if (0 == ::isxdigit(c))
+        {
+            return false;
+        }
+        m_remaining = (m_remaining << 4) | static_cast<unsigned long long>(::isdigit(c) ? c - '0' : ::tolower(c) - 'a' + 10);
+    }
+    m_state = (0 == m_remaining ? StateTrailers : StateChunkData);
+    return true;
+}
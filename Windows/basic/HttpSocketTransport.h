@@ -0,0 +1,189 @@
+#ifndef __HTTPSOCKETTRANSPORT_H__
+#define __HTTPSOCKETTRANSPORT_H__
+
+#include "HttpClient.h"
+#include "HttpContentCoding.h"
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+/**************************************************************************/
+
+/*
+* HttpClient  socket ˣHTTP_USE_WINHTTP Ϊ 0 ʱʹã֧ POSIX ƽ̨
+*
+* ʱ errno HttpErrorCode еȡֵ
+*/
+
+const int kHttpConnectTimeoutMs = 10 * 1000;    // ÿַӳʱ
+const int kHttpIoTimeoutMs = 30 * 1000;         // շʱνչ֮
+
+struct HttpUrl
+{
+    std::string scheme;
+    std::string host;       // IPv6 ַ
+    unsigned short port;
+    std::string path;       // ѯΪ "/"
+};
+
+/*
+* TLS ӣ˲κ TLS ⣬Ҫ https ʱʹ÷ OpenSSL ʵ֣ͨ HttpClient::setTlsProvider() 
+*
+* HttpTlsChannel ӵķ socket ϣ HttpSocketConnection  try* ӿͬ
+* ʱ޷ʱ EAGAIN wantEvents() Ҫȴ¼POLLIN  POLLOUT
+* ЭʱҪȴд
+*/
+class HttpTlsChannel
+{
+public:
+    virtual ~HttpTlsChannel() {}
+
+    virtual DWORD handshake() = 0;
+    virtual DWORD send(const char* data, size_t size, size_t& sent) = 0;
+    // received Ϊ 0 ʾԶѹر
+    virtual DWORD receive(char* buffer, size_t size, size_t& received) = 0;
+    virtual short wantEvents() const = 0;
+};
+
+class HttpTlsProvider
+{
+public:
+    virtual ~HttpTlsProvider() {}
+
+    // host  SNI ֤У飬ʧܷ NULLͬ I/O ̻߳Ტ
+    virtual HttpTlsChannel* createChannel(int fd, const std::string& host) = 0;
+};
+
+bool parseHttpUrl(const std::string& url, HttpUrl& result);
+// װģ GET  Content-Lengthheaders ÿΪһУβ
+// absoluteUri Ϊ true ʱʹ URL HTTP תʱʹ
+std::string formatHttpRequest(const std::string& method, const HttpUrl& url, const std::string& userAgent
+    , const std::vector<std::string>& headers, const std::string& body, bool absoluteUri = false);
+
+//  url ʱǷȽSOCKS5 ҪHTTP ֻ https Ҫhttp ֱӽת
+bool httpProxyTunnels(const HttpProxy& proxy, const HttpUrl& url);
+// HTTP  Proxy-Authorization ȡֵBasic ֤ûûʱΪ
+std::string httpProxyAuthorization(const HttpProxy& proxy);
+// ӳִıʶHttpEndpoint::proxyֱΪ
+std::string httpProxyKey(const HttpProxy& proxy);
+//  200 ӦӦĴ룺 HTTP תʱ 407 ǴҪ֤
+DWORD httpStatusError(unsigned int statusCode, const HttpProxy& proxy, const HttpUrl& url);
+
+class HttpProxyTunnel;
+
+class HttpSocketConnection : public HttpConnection
+{
+public:
+    struct Address
+    {
+        sockaddr_storage addr;
+        socklen_t length;
+    };
+
+    HttpSocketConnection();
+    ~HttpSocketConnection();
+
+    DWORD connect(const std::string& host, unsigned short port, int timeoutMs);
+    // ӵʱ host:port ֮շ TLSڽ
+    DWORD tunnel(const HttpProxy& proxy, const std::string& host, unsigned short port, int timeoutMs);
+    DWORD handshake(HttpTlsProvider& provider, const std::string& host, int timeoutMs);
+    DWORD send(const char* data, size_t size, int timeoutMs);
+    // received Ϊ 0 ʾԶѹر
+    DWORD receive(char* buffer, size_t size, size_t& received, int timeoutMs);
+
+    // ӿڣ¼ѭʹã EINPROGRESS ʱ fd() д finishConnect()
+    // ʧʱỻһַ·fd() ֮ı
+    DWORD startConnect(const std::string& host, unsigned short port);
+    // ͬϣַѾ resolve() ã¼ѭڸ߳ϽresolveMs Ϊĺʱ
+    DWORD startConnect(std::vector<Address>& addresses, double resolveMs);
+    DWORD finishConnect();
+    DWORD abandonConnect(DWORD error);      // ǰַʱһַ
+    // ӵʼ֮󷴸 tryTunnel() ֱٷ EAGAIN
+    DWORD startTunnel(const HttpProxy& proxy, const std::string& host, unsigned short port);
+    DWORD tryTunnel();
+    // ӽʼ TLS ֣֮շ TLS
+    DWORD startTls(HttpTlsProvider& provider, const std::string& host);
+    // ɼʱ EAGAINҪȴ¼ wantEvents()
+    DWORD tryHandshake();
+    DWORD trySend(const char* data, size_t size, size_t& sent);
+    DWORD tryReceive(char* buffer, size_t size, size_t& received);
+
+    int fd() const { return m_fd; }
+    short wantEvents() const { return m_wantEvents; }
+    double resolveMs() const { return m_resolveMs; }    // startConnect()  DNS ĺʱ
+    virtual bool isAlive() const;
+
+    //  DNS ߳ϵãַ˳ addresses
+    static DWORD resolve(const std::string& host, unsigned short port, std::vector<Address>& addresses);
+
+private:
+    DWORD connectNext(DWORD error);
+    DWORD wait(short events, int timeoutMs);
+
+    HttpSocketConnection(const HttpSocketConnection&);
+    void operator=(const HttpSocketConnection&);
+
+private:
+    int m_fd;
+    std::vector<Address> m_addresses;   // δԵĵַ
+    std::unique_ptr<HttpProxyTunnel> m_tunnel;   // ֻڼ
+    std::unique_ptr<HttpTlsChannel> m_tls;
+    short m_wantEvents;
+    double m_resolveMs;
+};
+
+//  HTTP/1.x Ӧݿзֺδ
+class HttpResponseParser
+{
+public:
+    // decode Ϊ true ʱ Content-Encoding ѹӦ壨 Accept-Encodingֵ֧ıΪʽ
+    explicit HttpResponseParser(bool decode = false);
+
+    //  [data, data + size)Ӧ彻 sinkʽ sink ֹʱ false
+    bool feed(const char* data, size_t size, HttpBodySink& sink);
+    // Զ˹رӣԹرΪӦ嵽
+    bool finish();
+
+    bool started() const { return m_started; }
+    bool aborted() const { return m_aborted; }
+    bool complete() const { return StateDone == m_state; }
+    unsigned int statusCode() const { return m_statusCode; }
+    // ӦͬһϷһ
+    bool keepAlive() const { return complete() && m_keepAlive; }
+    const std::vector<std::pair<std::string, std::string> >& headers() const { return m_headers; }
+
+private:
+    enum State
+    {
+        StateStatusLine,
+        StateHeaders,
+        StateBody,
+        StateChunkSize,             // ֿ鴫䣺鳤
+        StateChunkData,
+        StateChunkEnd,              // ݺ CRLF
+        StateTrailers,              // һ֮βֶ
+        StateDone,
+    };
+
+    bool parseStatusLine(const std::string& line);
+    bool parseHeader(const std::string& line);
+    bool endHeaders();
+    bool parseChunkSize(const std::string& line);
+    bool deliver(const char* data, size_t size, HttpBodySink& sink);
+    bool endBody();
+
+private:
+    State m_state;
+    std::string m_line;             // δһ
+    std::vector<std::pair<std::string, std::string> > m_headers;
+    unsigned int m_statusCode;
+    bool m_http11;
+    bool m_keepAlive;
+    bool m_started;
+    bool m_aborted;
+    bool m_untilClose;              // û Content-LengthӹرΪֹ
+    unsigned long long m_remaining; // Ӧ壨ǰ飩ʣֽ
+    bool m_decode;
+    std::unique_ptr<HttpContentDecoder> m_decoder;  // Ӧ Content-Encoding ʱ
+};
+
+#endif /* __HTTPSOCKETTRANSPORT_H__ */
@@ -0,0 +1,106 @@
+#include "HttpTimerQueue.h"
+#include <vector>
+/**************************************************************************/
+
+HttpTimerQueue::HttpTimerQueue()
+    : m_nextId(0)
+    , m_stopped(false)
+{
+
+}
+
+HttpTimerQueue::~HttpTimerQueue()
+{
+    stop();
+}
+
+HttpTimerQueue::TimerId HttpTimerQueue::schedule(unsigned int delayMs, const Task& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (false == m_stopped)
+        {
+            if (false == m_thread.joinable())
+            {
+                m_thread = std::thread(&HttpTimerQueue::run, this);
+            }
+            TimerId id = ++m_nextId;
+            m_ids[id] = m_tasks.insert(std::make_pair(Clock::now() + std::chrono::milliseconds(delayMs), std::make_pair(id, task)));
+            m_changed.notify_all();
+            return id;
+        }
+    }
+    task(true);
+    return 0;
+}
+
+void HttpTimerQueue::cancel(TimerId id)
+{
+    Task task;  // 񲶻Ķ
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<TimerId, TaskMap::iterator>::iterator it = m_ids.find(id);
+        if (m_ids.end() == it)
+        {
+            return;
+        }
+        task.swap(it->second->second.second);
+        m_tasks.erase(it->second);
+        m_ids.erase(it);
+    }
+}
+
+void HttpTimerQueue::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_changed.notify_all();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    std::vector<Task> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (TaskMap::iterator it = m_tasks.begin(); m_tasks.end() != it; ++it)
+        {
+            pending.push_back(it->second.second);
+        }
+        m_tasks.clear();
+        m_ids.clear();
+    }
+    for (std::vector<Task>::iterator it = pending.begin(); pending.end() != it; ++it)
+    {
+        (*it)(true);
+    }
+}
+
+void HttpTimerQueue::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (false == m_stopped)
+    {
+        if (m_tasks.empty())
+        {
+            m_changed.wait(lock);
+            continue;
+        }
+        Clock::time_point next = m_tasks.begin()->first;   // ȴڼܱ cancel() ɾ map еļ
+        if (Clock::now() < next)
+        {
+            m_changed.wait_until(lock, next);
+            continue;
+        }
+
+        Task task;
+        task.swap(m_tasks.begin()->second.second);
+        m_ids.erase(m_tasks.begin()->second.first);
+        m_tasks.erase(m_tasks.begin());
+        lock.unlock();
+        task(false);
+        lock.lock();
+    }
+}
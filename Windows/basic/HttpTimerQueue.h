@@ -0,0 +1,53 @@
+#ifndef __HTTPTIMERQUEUE_H__
+#define __HTTPTIMERQUEUE_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+/**************************************************************************/
+
+/*
+* ̶߳ʱHttpClient 첽˱ܺͶԳӳٵں󷢳һ
+*
+* ڶʱִ߳УҪ߳ڵһ schedule() ʱŴ
+* stop() ֮δڵ֮ύ񶼻 cancelled Ϊ true ڵִ߳
+* cancel() ִУ񲶻Ķ֮ͷ
+*/
+class HttpTimerQueue
+{
+public:
+    typedef std::function<void(bool cancelled)> Task;
+    typedef unsigned long long TimerId;    // 0 ʾû
+
+    HttpTimerQueue();
+    ~HttpTimerQueue();
+
+    // ֵ cancel() ʹãѾ stop() ʱִУ 0
+    TimerId schedule(unsigned int delayMs, const Task& task);
+    // ѾִлִʱʲôҲ
+    void cancel(TimerId id);
+    void stop();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::multimap<Clock::time_point, std::pair<TimerId, Task> > TaskMap;
+
+    void run();
+
+    HttpTimerQueue(const HttpTimerQueue&);
+    void operator=(const HttpTimerQueue&);
+
+private:
+    TaskMap m_tasks;
+    std::map<TimerId, TaskMap::iterator> m_ids;
+    TimerId m_nextId;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::thread m_thread;
+    bool m_stopped;
+};
+
+#endif /* __HTTPTIMERQUEUE_H__ */
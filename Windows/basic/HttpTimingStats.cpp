@@ -0,0 +1,141 @@
+#include "HttpTimingStats.h"
+#include "json.h"
+#include <string.h>
+/**************************************************************************/
+
+namespace
+{
+    // һͰûϽ
+    const double kBucketBounds[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000 };
+
+    const char* const kPhaseNames[] = { "queue", "dns", "connect", "proxy", "tls", "send", "ttfb", "transfer", "total" };
+}
+
+HttpTimingStats::HttpTimingStats()
+{
+    reset();
+}
+
+void HttpTimingStats::record(const HttpTiming& timing)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_requests;
+    if (ERROR_SUCCESS != timing.error)
+    {
+        ++m_errors;
+    }
+    if (timing.reused)
+    {
+        ++m_reused;
+    }
+    m_bytesSent += timing.bytesSent;
+    m_bytesReceived += timing.bytesReceived;
+
+    add(PhaseQueue, timing.queueMs);
+    add(PhaseDns, timing.dnsMs);
+    add(PhaseConnect, timing.connectMs);
+    add(PhaseProxy, timing.proxyMs);
+    add(PhaseTls, timing.tlsMs);
+    add(PhaseSend, timing.sendMs);
+    add(PhaseTtfb, timing.ttfbMs);
+    add(PhaseTransfer, timing.transferMs);
+    add(PhaseTotal, timing.totalMs);
+}
+
+void HttpTimingStats::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ::memset(m_phases, 0, sizeof(m_phases));
+    m_requests = 0;
+    m_errors = 0;
+    m_reused = 0;
+    m_bytesSent = 0;
+    m_bytesReceived = 0;
+}
+
+std::string HttpTimingStats::exportJson() const
+{
+    Json::Value root;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    root["requests"] = static_cast<Json::UInt64>(m_requests);
+    root["errors"] = static_cast<Json::UInt64>(m_errors);
+    root["reused"] = static_cast<Json::UInt64>(m_reused);
+    root["bytesSent"] = static_cast<Json::UInt64>(m_bytesSent);
+    root["bytesReceived"] = static_cast<Json::UInt64>(m_bytesReceived);
+
+    Json::Value& phases = root["phases"];
+    for (int i = 0; i < PhaseCount; ++i)
+    {
+        const Histogram& histogram = m_phases[i];
+        Json::Value& phase = phases[kPhaseNames[i]];
+        phase["count"] = static_cast<Json::UInt64>(histogram.count);
+        phase["sumMs"] = histogram.sum;
+        phase["p50Ms"] = percentile(histogram, 0.50);
+        phase["p95Ms"] = percentile(histogram, 0.95);
+        phase["p99Ms"] = percentile(histogram, 0.99);
+
+        Json::Value buckets(Json::arrayValue);
+        unsigned long long cumulative = 0;
+        for (int j = 0; j < kBucketCount; ++j)
+        {
+            cumulative += histogram.buckets[j];
+            Json::Value bucket;
+            if (j < kBucketCount - 1)
+            {
+                bucket["le"] = kBucketBounds[j];
+            }
+            else
+            {
+                bucket["le"] = "+Inf";
+            }
+            bucket["count"] = static_cast<Json::UInt64>(cumulative);
+            buckets.append(bucket);
+        }
+        phase["buckets"] = buckets;
+    }
+
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
+void HttpTimingStats::add(Phase phase, double ms)
+{
+    if (ms < 0)
+    {
+        return;     // ûоý׶
+    }
+    int bucket = 0;
+    while (bucket < kBucketCount - 1 && ms > kBucketBounds[bucket])
+    {
+        ++bucket;
+    }
+    Histogram& histogram = m_phases[phase];
+    ++histogram.buckets[bucket];
+    ++histogram.count;
+    histogram.sum += ms;
+}
+
+double HttpTimingStats::percentile(const Histogram& histogram, double fraction)
+{
+    if (0 == histogram.count)
+    {
+        return 0;
+    }
+    unsigned long long rank = static_cast<unsigned long long>(fraction * histogram.count + 0.5);
+    if (0 == rank)
+    {
+        rank = 1;
+    }
+    unsigned long long cumulative = 0;
+    for (int i = 0; i < kBucketCount - 1; ++i)
+    {
+        cumulative += histogram.buckets[i];
+        if (cumulative >= rank)
+        {
+            return kBucketBounds[i];
+        }
+    }
+    // һͰʱûϽãԾֵһϽнϴһ
+    double mean = histogram.sum / histogram.count;
+    return mean > kBucketBounds[kBucketCount - 2] ? mean : kBucketBounds[kBucketCount - 2];
+}
@@ -0,0 +1,70 @@
+#ifndef __HTTPTIMINGSTATS_H__
+#define __HTTPTIMINGSTATS_H__
+
+#include "HttpClient.h"
+#include <mutex>
+#include <string>
+/**************************************************************************/
+
+/*
+*  HttpTimingÿ׶һ̶Ͱֱͼֽ
+*
+* ÷client.setTimingListener(std::bind(&HttpTimingStats::record, &stats, std::placeholders::_1))
+* ͰϽΪ 125102050 ... 10000 ms Լ +InfٷλͰϽ
+*/
+class HttpTimingStats
+{
+public:
+    HttpTimingStats();
+
+    void record(const HttpTiming& timing);
+    void reset();
+
+    /**
+    * Ϊ JSON
+    * {"requests":n,"errors":n,"reused":n,"bytesSent":n,"bytesReceived":n,
+    *  "phases":{"dns":{"count":n,"sumMs":x,"p50Ms":x,"p95Ms":x,"p99Ms":x,"buckets":[{"le":1,"count":n},...,{"le":"+Inf","count":n}]},...}}
+    * buckets е count Ϊۼֵ
+    */
+    std::string exportJson() const;
+
+private:
+    enum Phase
+    {
+        PhaseQueue,
+        PhaseDns,
+        PhaseConnect,
+        PhaseProxy,
+        PhaseTls,
+        PhaseSend,
+        PhaseTtfb,
+        PhaseTransfer,
+        PhaseTotal,
+        PhaseCount,
+    };
+    static const int kBucketCount = 14;     //  +Inf
+
+    struct Histogram
+    {
+        unsigned long long buckets[kBucketCount];
+        unsigned long long count;
+        double sum;
+    };
+
+    void add(Phase phase, double ms);
+    static double percentile(const Histogram& histogram, double fraction);
+
+    HttpTimingStats(const HttpTimingStats&);
+    void operator=(const HttpTimingStats&);
+
+private:
+    mutable std::mutex m_mutex;
+    Histogram m_phases[PhaseCount];
+    unsigned long long m_requests;
+    unsigned long long m_errors;
+    unsigned long long m_reused;
+    unsigned long long m_bytesSent;
+    unsigned long long m_bytesReceived;
+};
+
+#endif /* __HTTPTIMINGSTATS_H__ */
@@ -1,30 +1,175 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cerrno>
+#include <climits>
 #include <cstdlib>
+#include <cstring>
 #include <vector>
 #include <mutex>
 #include "StorageConfigMgr.h"
 #include "Base.h"
 
 //#define INIDEBUG
-//INIļ洢ṹ
-class ININode
+namespace
 {
-public:
-    ININode(std::wstring root, std::wstring key, std::wstring value)
+    bool IsIniSpace(char ch)
     {
-        this->root = root;
-        this->key = key;
-        this->value = value;
+        return ' ' == ch || '\t' == ch || '\r' == ch;
     }
-    std::wstring root;
-    std::wstring key;
-    std::wstring value;
-};
-//////////////////////////////////////////////////////////////////////////ININode
+
+    //ȥ [begin, end) ˵Ŀհ
+    void TrimRange(const char*& begin, const char*& end)
+    {
+        while (begin != end && IsIniSpace(*begin))
+            ++begin;
+        while (begin != end && IsIniSpace(*(end - 1)))
+            --end;
+    }
+
+    //UTF-8 תΪַд out out е ASCII ʱֽչϵͳת
+    void AssignUTF8(std::wstring& out, const char* begin, const char* end)
+    {
+        const char* itr = begin;
+        while (itr != end && 0 == (*itr & 0x80))
+            ++itr;
+        if (itr == end)
+        {
+            out.assign(begin, end);
+            return;
+        }
+
+        int nWide = ::MultiByteToWideChar(CP_UTF8, 0, begin, static_cast<int>(end - begin), NULL, 0);
+        out.resize(nWide);
+        if (nWide > 0)
+            ::MultiByteToWideChar(CP_UTF8, 0, begin, static_cast<int>(end - begin), &out[0], nWide);
+    }
+
+    //Ⱥ֮Ĳ֣˳ɶԵȥԭհס;  #
+    //δʱհ֮ ;  # ʼעֵ͡ԸһͬŽ
+    void ParseIniValue(const char*& begin, const char*& end)
+    {
+        const char* first = begin;
+        while (first != end && IsIniSpace(*first))
+            ++first;
+        if (first != end && ('"' == *first || '\'' == *first))
+        {
+            const char* close = end;
+            while (close - 1 > first && *(close - 1) != *first)
+                --close;
+            if (close - 1 > first)
+            {
+                begin = first + 1;
+                end = close - 1;
+                return;
+            }
+        }   //ûԵʱֵͨ
+
+        for (const char* itr = begin; itr != end; ++itr)
+        {
+            if ((';' == *itr || '#' == *itr) && itr != begin && IsIniSpace(*(itr - 1)))
+            {
+                end = itr;
+                break;
+            }
+        }
+        TrimRange(begin, end);
+    }
+
+    //ֵпհסſͷߺлᱻע͵ʱдʱԭԭ
+    std::string QuoteIniValue(const std::string& value)
+    {
+        bool quote = !value.empty() && (IsIniSpace(value[0]) || IsIniSpace(value[value.size() - 1])
+            || '"' == value[0] || '\'' == value[0]);
+        for (std::string::size_type i = 1; !quote && i < value.size(); ++i)
+        {
+            quote = (';' == value[i] || '#' == value[i]) && IsIniSpace(value[i - 1]);
+        }
+        return quote ? "\"" + value + "\"" : value;
+    }
+
+    //һζļļڻȡʧʱ falseļõմ
+    bool ReadIniFile(const std::wstring& path, std::string& buffer)
+    {
+        buffer.clear();
+        std::ifstream in_conf_file(path.c_str(), std::ios::in | std::ios::binary);
+        if (!in_conf_file) return false;
+        in_conf_file.seekg(0, std::ios::end);
+        std::streamoff file_size = in_conf_file.tellg();
+        in_conf_file.seekg(0, std::ios::beg);
+        if (file_size <= 0) return true;
+        buffer.resize(static_cast<std::string::size_type>(file_size));
+        if (!in_conf_file.read(&buffer[0], file_size))
+        {
+            buffer.clear();
+            return false;
+        }
+        return true;
+    }
+
+    //ڻнֱֵӲڵĽ
+    void ParseIni(const std::string& buffer, std::map<std::wstring, SubNode>& sections)
+    {
+        const char* pos = buffer.data();
+        const char* const file_end = pos + buffer.size();
+        if (file_end - pos >= 3 && 0 == memcmp(pos, "\xEF\xBB\xBF", 3))
+            pos += 3;   //UTF-8 BOM
+
+        std::map<std::wstring, SubNode>::iterator section = sections.end();    //һ֮ǰļֵ
+        std::wstring str_root;
+        std::wstring str_key;
+        std::wstring str_value;
+        while (pos < file_end)
+        {
+            const char* begin = pos;
+            const char* end = static_cast<const char*>(memchr(pos, '\n', file_end - pos));
+            if (NULL == end)
+                end = file_end;
+            pos = (end == file_end ? file_end : end + 1);
+
+            TrimRange(begin, end);
+            if (begin == end || ';' == *begin || '#' == *begin)
+                continue;   //кע
+
+            if ('[' == *begin)
+            {
+                const char* close = static_cast<const char*>(memchr(begin, ']', end - begin));
+                if (NULL == close)
+                    continue;
+                const char* name_begin = begin + 1;
+                const char* name_end = close;
+                TrimRange(name_begin, name_end);
+                AssignUTF8(str_root, name_begin, name_end);
+                //ͬĽںϲһ
+                section = str_root.empty() ? sections.end() : sections.insert(std::make_pair(str_root, SubNode())).first;
+                continue;
+            }
+
+            const char* equal = static_cast<const char*>(memchr(begin, '=', end - begin));
+            if (NULL == equal || sections.end() == section)
+                continue;
+            const char* key_end = equal;
+            TrimRange(begin, key_end);
+            if (begin == key_end)
+                continue;
+            const char* value_begin = equal + 1;
+            ParseIniValue(value_begin, end);
+            AssignUTF8(str_key, begin, key_end);
+            AssignUTF8(str_value, value_begin, end);
+            //ظļԵһγֵΪ׼
+            section->second.sub_node.insert(std::make_pair(str_key, str_value));
+#ifdef INIDEBUG
+            std::wcout << L"[" << str_root << L"] " << str_key << L"=" << str_value << std::endl;
+#endif	//INIDEBUG
+        }
+    }
+
+    const std::chrono::milliseconds kIniWriteDelay(500);   //һ޸֮ȴôдأ޸ĺϲһд
+}
 
 CConfigMgr::CConfigMgr()
+    : _bDirty(false)
+    , _bStop(false)
 {
     wchar_t szCurrentDirectory[MAX_PATH] = { 0 };
     DWORD dwCurDirPathLen;
@@ -40,7 +185,14 @@ CConfigMgr::CConfigMgr()
 
 CConfigMgr::~CConfigMgr()
 {
-    WriteINI();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _bStop = true;
+    }
+    _changed.notify_all();
+    if (_writeThread.joinable())
+        _writeThread.join();
+    Flush();
 }
 
 //************************************************************************
@@ -70,67 +222,9 @@ std::string &TrimString(std::string &str)
 //************************************************************************
 int CConfigMgr::InitReadINI()
 {
-    std::ifstream in_conf_file(_IncFilePath.c_str());
-    if (!in_conf_file) return 0;
-    std::string str_line = "";
-    std::string str_root = "";
-    std::vector<ININode> vec_ini;
-    while (getline(in_conf_file, str_line))
-    {
-        std::string::size_type left_pos = 0;
-        std::string::size_type right_pos = 0;
-        std::string::size_type equal_div_pos = 0;
-        std::string str_key = "";
-        std::string str_value = "";
-        if ((str_line.npos != (left_pos = str_line.find("["))) && (str_line.npos != (right_pos = str_line.find("]"))))
-        {
-            //cout << str_line.substr(left_pos+1, right_pos-1) << endl;
-            str_root = str_line.substr(left_pos + 1, right_pos - 1);
-        }
-
-        if (str_line.npos != (equal_div_pos = str_line.find("=")))
-        {
-            str_key = str_line.substr(0, equal_div_pos);
-            str_value = str_line.substr(equal_div_pos + 1, str_line.size() - 1);
-            //str_key = TrimString(str_key);
-            //str_value = TrimString(str_value);
-            //cout << str_key << "=" << str_value << endl;
-        }
-
-        if ((!str_root.empty()) && (!str_key.empty()) && (!str_value.empty()))
-        {
-            ININode ini_node(UTF82Wide(str_root), UTF82Wide(str_key), UTF82Wide(str_value));
-            vec_ini.push_back(ini_node);
-            //cout << vec_ini.size() << endl;
-        }
-    }
-    in_conf_file.close();
-    in_conf_file.clear();
-
-    //vector convert to map
-    std::map<std::wstring, std::wstring> map_tmp;
-    for (std::vector<ININode>::iterator itr = vec_ini.begin(); itr != vec_ini.end(); ++itr)
-    {
-        map_tmp.insert(std::pair<std::wstring, std::wstring>(itr->root, L""));
-    }	//ȡڵ
-    for (std::map<std::wstring, std::wstring>::iterator itr = map_tmp.begin(); itr != map_tmp.end(); ++itr)
-    {
-#ifdef INIDEBUG
-        cout << "ڵ㣺 " << itr->first << endl;
-#endif	//INIDEBUG
-        SubNode sn;
-        for (std::vector<ININode>::iterator sub_itr = vec_ini.begin(); sub_itr != vec_ini.end(); ++sub_itr)
-        {
-            if (sub_itr->root == itr->first)
-            {
-#ifdef INIDEBUG
-                cout << "ֵԣ " << sub_itr->key << "=" << sub_itr->value << endl;
-#endif	//INIDEBUG
-                sn.InsertElement(sub_itr->key, sub_itr->value);
-            }
-        }
-        map_ini.insert(std::pair<std::wstring, SubNode>(itr->first, sn));
-    }
+    if (false == ReadIniFile(_IncFilePath, _fileContent))
+        return 0;
+    ParseIni(_fileContent, map_ini);
     return 1;
 }
 
@@ -146,6 +240,7 @@ int CConfigMgr::InitReadINI()
 //************************************************************************
 std::wstring CConfigMgr::GetValue(std::wstring root, std::wstring key)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
     std::map<std::wstring, SubNode>::iterator itr = map_ini.find(root);
     if (map_ini.end() == itr)
         return L"";
@@ -165,32 +260,122 @@ std::wstring CConfigMgr::GetValue(std::wstring root, std::wstring key)
 // Ȩ:    	public 
 // :		2017/01/05
 //   :		
-// ˵:    XMLϢļ
-// : 	string path	INIļı·
-//   ֵ:   	int
+// ˵:    δ޸ʱINIдļдͬĿ¼µʱļ滻ԭļ
+//              дһԭļ÷ _writeMutex
+//   ֵ:   	int     1 ɹд룬-1 ʧܣ޸ıԺԣ
 //************************************************************************
 int CConfigMgr::WriteINI()
 {
-    //...ļ򿪣ϢرļȲ
-    std::wofstream out_conf_file(_IncFilePath.c_str());
-    if (!out_conf_file)
-        return -1;
-    //cout << map_ini.size() << endl;
-    for (std::map<std::wstring, SubNode>::iterator itr = map_ini.begin(); itr != map_ini.end(); ++itr)
+    std::string content;
     {
-        //cout << itr->first << endl;
-        out_conf_file << "[" << Wide2UTF8(itr->first).c_str() << "]" << std::endl;
-        for (std::map<std::wstring, std::wstring>::iterator sub_itr = itr->second.sub_node.begin(); sub_itr != itr->second.sub_node.end(); ++sub_itr)
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (false == _bDirty)
+            return 1;
+        for (std::map<std::wstring, SubNode>::iterator itr = map_ini.begin(); itr != map_ini.end(); ++itr)
         {
-            //cout << sub_itr->first << "=" << sub_itr->second << endl;
-            out_conf_file << Wide2UTF8(sub_itr->first).c_str() << "=" << Wide2UTF8(sub_itr->second).c_str() << std::endl;
+            content += "[";
+            content += Wide2UTF8(itr->first);
+            content += "]\r\n";
+            for (std::map<std::wstring, std::wstring>::iterator sub_itr = itr->second.sub_node.begin(); sub_itr != itr->second.sub_node.end(); ++sub_itr)
+            {
+                content += Wide2UTF8(sub_itr->first);
+                content += "=";
+                content += QuoteIniValue(Wide2UTF8(sub_itr->second));
+                content += "\r\n";
+            }
         }
+        _bDirty = false;
+    }   //ļддڼ޸Ļٴα
+
+    std::wstring tmpPath = _IncFilePath + L".tmp";
+    HANDLE hFile = ::CreateFileW(tmpPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    bool bWritten = false;
+    if (INVALID_HANDLE_VALUE != hFile)
+    {
+        DWORD dwWritten = 0;
+        bWritten = ::WriteFile(hFile, content.data(), static_cast<DWORD>(content.size()), &dwWritten, NULL)
+            && dwWritten == content.size()
+            && ::FlushFileBuffers(hFile);
+        ::CloseHandle(hFile);
     }
-    out_conf_file.close();
-    out_conf_file.clear();
+    if (bWritten)
+        bWritten = (FALSE != ::MoveFileExW(tmpPath.c_str(), _IncFilePath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH));
+    if (false == bWritten)
+    {
+        ::DeleteFileW(tmpPath.c_str());
+        std::lock_guard<std::mutex> lock(_mutex);
+        _bDirty = true;
+        _lastChange = std::chrono::steady_clock::now();
+        _changed.notify_all();      //д߳̿Ѿڵһ޸ģԺ
+        return -1;
+    }
+    _fileContent.swap(content);     //ļᱨд룬Reload ʱֱͬ
     return 1;
 }
 
+int CConfigMgr::Flush()
+{
+    std::lock_guard<std::mutex> writeLock(_writeMutex);
+    return WriteINI();
+}
+
+//************************************************************************
+// :    	Reload
+// Ȩ:    	public 
+// ˵:    ļⲿ޸ĺ¶롣ݺϴζдͬʱ
+//              ػûдص޸ʱԱΪ׼ԺдػḲⲿ޸
+//   ֵ:   	int     1 ѻݣ0 ûб仯δ
+//************************************************************************
+int CConfigMgr::Reload()
+{
+    std::lock_guard<std::mutex> writeLock(_writeMutex);
+    std::string content;
+    if (false == ReadIniFile(_IncFilePath, content) || content == _fileContent)
+        return 0;   //滻жݲʱһ֪ͨ
+
+    std::map<std::wstring, SubNode> sections;
+    ParseIni(content, sections);    //ֻڽʱȴ
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_bDirty)
+        return 0;
+    map_ini.swap(sections);
+    _fileContent.swap(content);
+    return 1;
+}
+
+std::wstring CConfigMgr::GetFilePath() const
+{
+    return _IncFilePath;
+}
+
+int CConfigMgr::GetSize()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return map_ini.size();
+}
+
+void CConfigMgr::WriteThread()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (false == _bStop)
+    {
+        if (false == _bDirty)
+        {
+            _changed.wait(lock);
+            continue;
+        }
+        std::chrono::steady_clock::time_point due = _lastChange + kIniWriteDelay;
+        if (std::chrono::steady_clock::now() < due)
+        {
+            _changed.wait_until(lock, due);
+            continue;
+        }
+        lock.unlock();
+        Flush();
+        lock.lock();
+    }
+}
+
 //************************************************************************
 // :    	SetValue
 // Ȩ:    	public 
@@ -200,13 +385,17 @@ int CConfigMgr::WriteINI()
 // : 	string root		ĸڵ
 // : 	string key		ļ
 // : 	string value	ֵ
-//   ֵ:   	std::vector<ININode>::size_type	
+//   ֵ:   	bool
 //************************************************************************
 bool CConfigMgr::SetValue(std::wstring root, std::wstring key, std::wstring value)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
     std::map<std::wstring, SubNode>::iterator itr = map_ini.find(root);	//
     if (map_ini.end() != itr)
     {
+        std::map<std::wstring, std::wstring>::iterator sub_itr = itr->second.sub_node.find(key);
+        if (itr->second.sub_node.end() != sub_itr && sub_itr->second == value)
+            return true;    //ֵûб仯Ҫд
         itr->second.sub_node[key] = value;
     }	//ڵѾˣֵ
     else
@@ -216,6 +405,14 @@ bool CConfigMgr::SetValue(std::wstring root, std::wstring key, std::wstring valu
         map_ini.insert(std::pair<std::wstring, SubNode>(root, sn));
     }	//ڵ㲻ڣֵ
 
+    _lastChange = std::chrono::steady_clock::now();
+    if (false == _bDirty)
+    {
+        _bDirty = true;
+        if (false == _writeThread.joinable())
+            _writeThread = std::thread(&CConfigMgr::WriteThread, this);
+        _changed.notify_all();
+    }   //Ѿʱд߳ڵȴᰴµ޸ʱ¼
     return true;
 }
 
@@ -241,28 +438,96 @@ void CConfigMgr::Travel()
     }
 }
 
+////////////////////////////////////////////////////////////////////////// CSettingRegistry
+namespace
+{
+    struct SettingDescriptor
+    {
+        const wchar_t* key;     //INIеļ INI_ROOT_KEY 
+        int defaultValue;
+        int minValue;           //INIгΧֵĬֵ
+        int maxValue;
+    };
+
+    //±꼴 Config::SettingKey
+    const SettingDescriptor s_settingTable[] =
+    {
+        { INI_KEY_VIDEO_BITRATE, 500, 1, INT_MAX },
+        { INI_KEY_VIDEO_RESOLUTION, TRTCVideoResolution_640_360, 1, INT_MAX },
+        { INI_KEY_VIDEO_FPS, 15, 1, INT_MAX },
+        { INI_KEY_VIDEO_QUALITY, TRTCVideoQosPreferenceClear, TRTCVideoQosPreferenceSmooth, TRTCVideoQosPreferenceClear },
+        { INI_KEY_VIDEO_QUALITY_CONTROL, TRTCQosControlModeServer, TRTCQosControlModeClient, TRTCQosControlModeServer },
+        { INI_KEY_SET_PUSH_SMALLVIDEO, 0, 0, 1 },
+        { INI_KEY_SET_PLAY_SMALLVIDEO, 0, 0, 1 },
+    };
+    static_assert(sizeof(s_settingTable) / sizeof(s_settingTable[0]) == Config::SettingKeyCount, "s_settingTable must match Config::SettingKey");
+}
+
+CSettingRegistry::CSettingRegistry()
+{
+    for (int i = 0; i < Config::SettingKeyCount; ++i)
+    {
+        m_values[i] = s_settingTable[i].defaultValue;
+        m_changed[i] = false;
+    }
+}
+
+void CSettingRegistry::SetInt(Config::SettingKey key, int value)
+{
+    if (m_values[key] == value)
+        return;
+    m_values[key] = value;
+    m_changed[key] = true;
+}
+
+void CSettingRegistry::Load(CConfigMgr& config)
+{
+    for (int i = 0; i < Config::SettingKeyCount; ++i)
+    {
+        const SettingDescriptor& desc = s_settingTable[i];
+        std::wstring strValue = config.GetValue(INI_ROOT_KEY, desc.key);
+        const wchar_t* begin = strValue.c_str();
+        wchar_t* end = NULL;
+        errno = 0;
+        long value = wcstol(begin, &end, 10);
+        if (end == begin || L'\0' != *end || 0 != errno || value < desc.minValue || value > desc.maxValue)
+        {
+            m_values[i] = desc.defaultValue;
+            m_changed[i] = true;
+        }
+        else
+        {
+            m_values[i] = static_cast<int>(value);
+            m_changed[i] = false;
+        }
+    }
+}
+
+void CSettingRegistry::Save(CConfigMgr& config)
+{
+    for (int i = 0; i < Config::SettingKeyCount; ++i)
+    {
+        if (false == m_changed[i])
+            continue;
+        config.SetValue(INI_ROOT_KEY, s_settingTable[i].key, format(L"%d", m_values[i]));
+        m_changed[i] = false;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////// TRTCStorageConfig
-static std::shared_ptr<TRTCStorageConfigMgr> s_pInstance;
-static std::mutex engine_mex;
 std::shared_ptr<TRTCStorageConfigMgr> TRTCStorageConfigMgr::GetInstance()
 {
-    if (s_pInstance == NULL) {
-        engine_mex.lock();
-        if (s_pInstance == NULL)
-        {
-            s_pInstance = std::make_shared<TRTCStorageConfigMgr>();
-        }
-        engine_mex.unlock();
-    }
+    //ֲ̬ĳʼ̰߳ȫģSDK ص߳Ҳ
+    static std::shared_ptr<TRTCStorageConfigMgr> s_pInstance = std::make_shared<TRTCStorageConfigMgr>();
     return s_pInstance;
 }
 
 TRTCStorageConfigMgr::TRTCStorageConfigMgr()
+    : m_sequence(0)
 {
     m_pConfigMgr = new CConfigMgr;
-    videoEncParams.videoResolution = TRTCVideoResolution_640_360;
-    videoEncParams.videoBitrate = 500;
-    videoEncParams.videoFps = 15;
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    PublishLocked();
 }
 
 TRTCStorageConfigMgr::~TRTCStorageConfigMgr()
@@ -278,54 +543,104 @@ TRTCStorageConfigMgr::~TRTCStorageConfigMgr()
 
 void TRTCStorageConfigMgr::ReadStorageConfig()
 {
-    if (m_pConfigMgr == false || m_pConfigMgr->GetSize() == 0)
+    if (nullptr == m_pConfigMgr)
         return;
-    //Ƶ
-    std::wstring strParam;
-    strParam = m_pConfigMgr->GetValue(INI_ROOT_KEY, INI_KEY_VIDEO_BITRATE);
-    videoEncParams.videoBitrate = _wtoi(strParam.c_str());
-
-    strParam = m_pConfigMgr->GetValue(INI_ROOT_KEY, INI_KEY_VIDEO_RESOLUTION);
-    videoEncParams.videoResolution = (TRTCVideoResolution)_wtoi(strParam.c_str());
-
-    strParam = m_pConfigMgr->GetValue(INI_ROOT_KEY, INI_KEY_VIDEO_FPS);
-    videoEncParams.videoFps = _wtoi(strParam.c_str());
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_settings.Load(*m_pConfigMgr);
+    m_settings.SetEnum(Config::SettingVideoQualityControl, TRTCQosControlModeServer);  //ģʽ̶ƶ˿ƣINI
+    PublishLocked();
+}
 
-    strParam = m_pConfigMgr->GetValue(INI_ROOT_KEY, INI_KEY_VIDEO_QUALITY);
-    qosParams.preference = (TRTCVideoQosPreference)_wtoi(strParam.c_str());
+unsigned int TRTCStorageConfigMgr::ReloadStorageConfig()
+{
+    if (nullptr == m_pConfigMgr)
+        return 0;
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (0 == m_pConfigMgr->Reload())
+        return 0;
 
-    //strParam = m_pConfigMgr->GetValue(INI_ROOT_KEY, INI_KEY_VIDEO_QUALITY_CONTROL);
-    qosParams.controlMode = TRTCQosControlModeServer;
+    int before[Config::SettingKeyCount];
+    for (int i = 0; i < Config::SettingKeyCount; ++i)
+        before[i] = m_settings.GetInt(static_cast<Config::SettingKey>(i));
+    m_settings.Load(*m_pConfigMgr);
+    m_settings.SetEnum(Config::SettingVideoQualityControl, TRTCQosControlModeServer);
 
-    strParam = m_pConfigMgr->GetValue(INI_ROOT_KEY, INI_KEY_SET_PUSH_SMALLVIDEO);
-    bPushSmallVideo = _wtoi(strParam.c_str());
+    unsigned int changed = 0;
+    for (int i = 0; i < Config::SettingKeyCount; ++i)
+    {
+        if (before[i] != m_settings.GetInt(static_cast<Config::SettingKey>(i)))
+            changed |= 1u << i;
+    }
+    if (0 != changed)
+        PublishLocked();
+    return changed;
+}
 
-    strParam = m_pConfigMgr->GetValue(INI_ROOT_KEY, INI_KEY_SET_PLAY_SMALLVIDEO);
-    bPlaySmallVideo = _wtoi(strParam.c_str());
+std::wstring TRTCStorageConfigMgr::GetConfigFilePath() const
+{
+    return m_pConfigMgr ? m_pConfigMgr->GetFilePath() : std::wstring();
 }
 
 void TRTCStorageConfigMgr::WriteStorageConfig()
 {
-    //Ƶ
-    std::wstring strFormat;
-    strFormat = format(L"%d", videoEncParams.videoBitrate);
-    m_pConfigMgr->SetValue(INI_ROOT_KEY, INI_KEY_VIDEO_BITRATE, strFormat.c_str());
-
-    strFormat = format(L"%d", videoEncParams.videoResolution);
-    m_pConfigMgr->SetValue(INI_ROOT_KEY, INI_KEY_VIDEO_RESOLUTION, strFormat.c_str());
-
-    strFormat = format(L"%d", videoEncParams.videoFps);
-    m_pConfigMgr->SetValue(INI_ROOT_KEY, INI_KEY_VIDEO_FPS, strFormat.c_str());
+    //Ƶãûб仯д
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (m_pConfigMgr)
+        m_settings.Save(*m_pConfigMgr);
+}
 
-    strFormat = format(L"%d", qosParams.preference);
-    m_pConfigMgr->SetValue(INI_ROOT_KEY, INI_KEY_VIDEO_QUALITY, strFormat.c_str());
+TRTCStorageConfigSnapshot TRTCStorageConfigMgr::GetSnapshot() const
+{
+    //˳ˣǰζͬһżţ˵мûзֵͬһ汾
+    int values[Config::SettingKeyCount];
+    unsigned int sequence = 0;
+    for (;;)
+    {
+        sequence = m_sequence.load(std::memory_order_acquire);
+        if (0 == (sequence & 1))
+        {
+            for (int i = 0; i < Config::SettingKeyCount; ++i)
+                values[i] = m_published[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence == m_sequence.load(std::memory_order_relaxed))
+                break;
+        }
+        std::this_thread::yield();     //дڷֻǼԭдܿ
+    }
 
-    strFormat = format(L"%d", qosParams.controlMode);
-    m_pConfigMgr->SetValue(INI_ROOT_KEY, INI_KEY_VIDEO_QUALITY_CONTROL, strFormat.c_str());
+    TRTCStorageConfigSnapshot config;
+    config.videoEncParams.videoBitrate = values[Config::SettingVideoBitrate];
+    config.videoEncParams.videoResolution = static_cast<TRTCVideoResolution>(values[Config::SettingVideoResolution]);
+    config.videoEncParams.videoFps = values[Config::SettingVideoFps];
+    config.qosParams.preference = static_cast<TRTCVideoQosPreference>(values[Config::SettingVideoQuality]);
+    config.qosParams.controlMode = static_cast<TRTCQosControlMode>(values[Config::SettingVideoQualityControl]);
+    config.bPushSmallVideo = (0 != values[Config::SettingPushSmallVideo]);
+    config.bPlaySmallVideo = (0 != values[Config::SettingPlaySmallVideo]);
+    return config;
+}
 
-    strFormat = format(L"%d", bPushSmallVideo);
-    m_pConfigMgr->SetValue(INI_ROOT_KEY, INI_KEY_SET_PUSH_SMALLVIDEO, strFormat.c_str());
+void TRTCStorageConfigMgr::Publish(const TRTCStorageConfigSnapshot& config)
+{
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_settings.SetInt(Config::SettingVideoBitrate, static_cast<int>(config.videoEncParams.videoBitrate));
+    m_settings.SetEnum(Config::SettingVideoResolution, config.videoEncParams.videoResolution);
+    m_settings.SetInt(Config::SettingVideoFps, static_cast<int>(config.videoEncParams.videoFps));
+    m_settings.SetEnum(Config::SettingVideoQuality, config.qosParams.preference);
+    m_settings.SetEnum(Config::SettingVideoQualityControl, config.qosParams.controlMode);
+    m_settings.SetBool(Config::SettingPushSmallVideo, config.bPushSmallVideo);
+    m_settings.SetBool(Config::SettingPlaySmallVideo, config.bPlaySmallVideo);
+    PublishLocked();
+    if (m_pConfigMgr)
+        m_settings.Save(*m_pConfigMgr);
+}
 
-    strFormat = format(L"%d", bPlaySmallVideo);
-    m_pConfigMgr->SetValue(INI_ROOT_KEY, INI_KEY_SET_PLAY_SMALLVIDEO, strFormat.c_str());
+void TRTCStorageConfigMgr::PublishLocked()
+{
+    //˳дˣȱдֵٱż
+    unsigned int sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < Config::SettingKeyCount; ++i)
+        m_published[i].store(m_settings.GetInt(static_cast<Config::SettingKey>(i)), std::memory_order_relaxed);
+    m_sequence.store(sequence + 2, std::memory_order_release);
 }
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include "TRTCCloudDef.h"
 //ֵԽṹ
 namespace Config {
@@ -13,6 +18,19 @@ namespace Config {
     #define INI_KEY_VIDEO_QUALITY_CONTROL L"INI_KEY_VIDEO_QUALITY_CONTROL"
     #define INI_KEY_SET_PUSH_SMALLVIDEO L"INI_KEY_SET_PUSH_SMALLVIDEO"
     #define INI_KEY_SET_PLAY_SMALLVIDEO L"INI_KEY_SET_PLAY_SMALLVIDEO"
+
+    //ͻ±꣬ StorageConfigMgr.cpp  s_settingTable ˳һ
+    enum SettingKey
+    {
+        SettingVideoBitrate = 0,
+        SettingVideoResolution,
+        SettingVideoFps,
+        SettingVideoQuality,
+        SettingVideoQualityControl,
+        SettingPushSmallVideo,
+        SettingPlaySmallVideo,
+        SettingKeyCount
+    };
 };
 
 class SubNode
@@ -26,6 +44,7 @@ public:
 };
 
 //INIļ
+//SetValue ֻڴ沢̨࣬߳һ޸ 500ms ϲдأʱδдص޸ͬд
 class CConfigMgr
 {
 public:
@@ -34,15 +53,60 @@ public:
 public:
     std::wstring GetValue(std::wstring root, std::wstring key);			    //ɸͼȡֵ
     bool SetValue(std::wstring root, std::wstring key, std::wstring value);	//øͼȡֵ
-    int GetSize() { return map_ini.size(); }
+    int GetSize();
+    int Flush();                        //дδ޸ģû޸ʱдļ
+    int Reload();                       //ļⲿ޸ĺ¶룬 1 ʾб仯
+    std::wstring GetFilePath() const;
 private:
     int WriteINI();			//дINIļ
     void Clear() { map_ini.clear(); }	//
     void Travel();						//ӡINIļ
     int InitReadINI();
+    void WriteThread();                 //ӳٺϲд
+    CConfigMgr(const CConfigMgr&);
+    CConfigMgr& operator=(const CConfigMgr&);
 private:
     std::map<std::wstring, SubNode> map_ini;		//INIļݵĴ洢
     std::wstring _IncFilePath;                      //ļ·
+    std::string _fileContent;                       //ϴζдļݣ _writeMutex 
+    std::mutex _mutex;                              // map_ini д״̬
+    std::mutex _writeMutex;                         //лļд룬ݸ
+    std::condition_variable _changed;
+    std::thread _writeThread;
+    bool _bDirty;                                   //޸Ļûдļ
+    bool _bStop;
+    std::chrono::steady_clock::time_point _lastChange;
+};
+
+//ͻñ Config::SettingKey ±ֱӴȡ intbool ö٣ȡַڴ棻
+//ֻ Load/Save ʱź CConfigMgr еַת
+class CSettingRegistry
+{
+public:
+    CSettingRegistry();     //ȡĬֵ
+public:
+    int GetInt(Config::SettingKey key) const { return m_values[key]; }
+    bool GetBool(Config::SettingKey key) const { return 0 != m_values[key]; }
+    template <typename T> T GetEnum(Config::SettingKey key) const { return static_cast<T>(m_values[key]); }
+    void SetInt(Config::SettingKey key, int value);
+    void SetBool(Config::SettingKey key, bool value) { SetInt(key, value ? 1 : 0); }
+    template <typename T> void SetEnum(Config::SettingKey key, T value) { SetInt(key, static_cast<int>(value)); }
+
+    void Load(CConfigMgr& config);          //INIеֵȱʧ򲻺ϷĬֵ´ Save ʱд
+    void Save(CConfigMgr& config);          //ֻѸĹд CConfigMgr
+private:
+    int m_values[Config::SettingKeyCount];
+    bool m_changed[Config::SettingKeyCount];    //INIеݲһ£Ҫд
+};
+
+//־ûõһ汾ֵأõ֮󲻻ٱ߳޸
+struct TRTCStorageConfigSnapshot
+{
+    // Ƶ
+    TRTCVideoEncParam videoEncParams;
+    TRTCNetworkQosParam qosParams;
+    bool bPushSmallVideo = false; //˫־
+    bool bPlaySmallVideo = false; //ĬƵ־
 };
 
 /*
@@ -52,6 +116,11 @@ private:
 *
 *    1. TRTCSettingViewControllerõĲҪ־ûء
 *
+*    2. GetSnapshot ̣߳ SDK ص̣߳ãĳһ Publish ݣ
+*       Publish ֮ûУ°汾Զԭӿɼ
+*
+*    3. INIⲿ޸ʱļ̵߳ ReloadStorageConfigֻݱ˲½ͷ
+*
 */
 class TRTCStorageConfigMgr
 {
@@ -61,14 +130,21 @@ public:
     ~TRTCStorageConfigMgr();
     void ReadStorageConfig();    //ʼSDKlocalϢ
     void WriteStorageConfig();
+    unsigned int ReloadStorageConfig();     //INIⲿ޸ĺ¶벢ֵĵ i λʾ Config::SettingKey i б仯
+    std::wstring GetConfigFilePath() const;
+
+    TRTCStorageConfigSnapshot GetSnapshot() const;
+    void Publish(const TRTCStorageConfigSnapshot& config);  //°汾б仯ӳдINI
+private:
+    void PublishLocked();        // m_settings ߣ÷ m_writeMutex
+    TRTCStorageConfigMgr(const TRTCStorageConfigMgr&);
+    TRTCStorageConfigMgr& operator=(const TRTCStorageConfigMgr&);
 
-public: //trtc 
-    // Ƶ
-    TRTCVideoEncParam videoEncParams;
-    TRTCNetworkQosParam qosParams;
-    bool bPushSmallVideo = false; //˫־
-    bool bPlaySmallVideo = false; //ĬƵ־
 private:
     CConfigMgr* m_pConfigMgr;
+    CSettingRegistry m_settings;                                //дߵĹ
+    std::mutex m_writeMutex;
+    std::atomic<unsigned int> m_sequence;                       //˳ʾڷ
+    std::atomic<int> m_published[Config::SettingKeyCount];      //߿ֵ Config::SettingKey ±
 };
 
@@ -0,0 +1,432 @@
+#include "UserSigCache.h"
+#include "json.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <wincrypt.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+/**************************************************************************/
+
+namespace
+{
+    // 64 λ FNV-1a sdkAppId  userIdͬڲͬûժҪͬ
+    std::string hashPassword(const UserSigKey& key, const std::string& pwd)
+    {
+        std::string input = std::to_string(key.sdkAppId) + '\n' + key.userId + '\n' + pwd;
+        unsigned long long hash = 14695981039346656037ULL;
+        for (std::string::const_iterator it = input.begin(); input.end() != it; ++it)
+        {
+            hash ^= static_cast<unsigned char>(*it);
+            hash *= 1099511628211ULL;
+        }
+        char text[17];
+        ::snprintf(text, sizeof(text), "%016llx", hash);
+        return text;
+    }
+
+    // Windows  DPAPI ܲת base64ƽ̨ԭ
+    bool sealSecret(const std::string& plain, std::string& sealed)
+    {
+#ifdef _WIN32
+        DATA_BLOB input = { static_cast<DWORD>(plain.size()), reinterpret_cast<BYTE*>(const_cast<char*>(plain.data())) };
+        DATA_BLOB output = { 0, NULL };
+        if (FALSE == ::CryptProtectData(&input, L"UserSigCache", NULL, NULL, NULL, CRYPTPROTECT_UI_FORBIDDEN, &output))
+        {
+            return false;
+        }
+        DWORD flags = CRYPT_STRING_BASE64 | CRYPT_STRING_NOCRLF;
+        DWORD size = 0;
+        bool sealedOk = (FALSE != ::CryptBinaryToStringA(output.pbData, output.cbData, flags, NULL, &size));
+        if (sealedOk)
+        {
+            sealed.resize(size);    // β '\0'
+            sealedOk = (FALSE != ::CryptBinaryToStringA(output.pbData, output.cbData, flags, &sealed[0], &size));
+            sealed.resize(size);
+        }
+        ::LocalFree(output.pbData);
+        return sealedOk;
+#else
+        sealed = plain;
+        return true;
+#endif
+    }
+
+    bool unsealSecret(const std::string& sealed, std::string& plain)
+    {
+#ifdef _WIN32
+        DWORD size = 0;
+        if (sealed.empty() || FALSE == ::CryptStringToBinaryA(sealed.c_str(), static_cast<DWORD>(sealed.size()), CRYPT_STRING_BASE64, NULL, &size, NULL, NULL))
+        {
+            return false;
+        }
+        std::vector<BYTE> blob(size + 1);
+        if (FALSE == ::CryptStringToBinaryA(sealed.c_str(), static_cast<DWORD>(sealed.size()), CRYPT_STRING_BASE64, &blob[0], &size, NULL, NULL))
+        {
+            return false;
+        }
+        DATA_BLOB input = { size, &blob[0] };
+        DATA_BLOB output = { 0, NULL };
+        if (FALSE == ::CryptUnprotectData(&input, NULL, NULL, NULL, NULL, CRYPTPROTECT_UI_FORBIDDEN, &output))
+        {
+            return false;
+        }
+        plain.assign(reinterpret_cast<const char*>(output.pbData), output.cbData);
+        ::SecureZeroMemory(output.pbData, output.cbData);
+        ::LocalFree(output.pbData);
+        return true;
+#else
+        plain = sealed;
+        return true;
+#endif
+    }
+}
+
+bool UserSigKey::operator<(const UserSigKey& other) const
+{
+    if (sdkAppId != other.sdkAppId)
+    {
+        return sdkAppId < other.sdkAppId;
+    }
+    if (roomId != other.roomId)
+    {
+        return roomId < other.roomId;
+    }
+    return userId < other.userId;
+}
+
+UserSigCache::UserSigCache()
+    : m_stop(false)
+    , m_ttl(std::chrono::hours(24))
+    , m_refreshBefore(std::chrono::hours(1))
+    , m_dirty(false)
+{
+    m_stats.hits = 0;
+    m_stats.misses = 0;
+    m_stats.refreshed = 0;
+    m_stats.refreshFailed = 0;
+}
+
+UserSigCache::~UserSigCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_changed.notify_all();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    if (m_dirty)
+    {
+        save();
+    }
+}
+
+void UserSigCache::setTtl(unsigned int seconds, unsigned int refreshBeforeSeconds)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ttl = std::chrono::seconds(seconds);
+    m_refreshBefore = std::chrono::seconds(refreshBeforeSeconds < seconds ? refreshBeforeSeconds : seconds);
+}
+
+void UserSigCache::setFilePath(const std::string& path)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_filePath = path;
+    }
+    load();
+}
+
+bool UserSigCache::lookup(const UserSigKey& key, const std::string& pwd, const Fetcher& refresh, std::string& userSig)
+{
+    std::string pwdHash = hashPassword(key, pwd);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<UserSigKey, Entry>::iterator it = m_entries.find(key);
+    if (m_entries.end() == it || it->second.expires <= Clock::now() || pwdHash != it->second.pwdHash)
+    {
+        ++m_stats.misses;
+        return false;
+    }
+
+    ++m_stats.hits;
+    // Ŀ±ΪҪˢʱѺ̨߳
+    Entry& entry = it->second;
+    bool wake = (false == entry.used);
+    entry.used = true;
+    if (!entry.refresh && refresh)
+    {
+        entry.refresh = refresh;
+        wake = true;
+    }
+    if (wake && entry.refresh)
+    {
+        changedLocked();
+    }
+    userSig = entry.userSig;
+    return true;
+}
+
+void UserSigCache::store(const UserSigKey& key, const std::string& pwd, const std::string& userSig, const Fetcher& refresh)
+{
+    if (userSig.empty())
+    {
+        return;
+    }
+    std::string pwdHash = hashPassword(key, pwd);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry& entry = m_entries[key];
+    entry.userSig = userSig;
+    entry.pwdHash = pwdHash;
+    entry.expires = Clock::now() + m_ttl;
+    entry.refreshAt = entry.expires - m_refreshBefore;
+    entry.refresh = refresh;
+    entry.used = true;
+    m_dirty = true;
+    changedLocked();
+}
+
+void UserSigCache::invalidate(const UserSigKey& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (0 != m_entries.erase(key))
+    {
+        m_dirty = true;
+        changedLocked();
+    }
+}
+
+UserSigCache::Stats UserSigCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void UserSigCache::changedLocked()
+{
+    if (false == m_thread.joinable())
+    {
+        m_thread = std::thread(&UserSigCache::run, this);
+    }
+    m_changed.notify_all();
+}
+
+void UserSigCache::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (false == m_stop)
+    {
+        if (m_dirty)
+        {
+            m_dirty = false;
+            lock.unlock();
+            save();
+            lock.lock();
+            continue;
+        }
+
+        Clock::time_point now = Clock::now();
+        evictExpiredLocked(now);
+
+        std::map<UserSigKey, Entry>::iterator next = m_entries.end();
+        for (std::map<UserSigKey, Entry>::iterator it = m_entries.begin(); m_entries.end() != it; ++it)
+        {
+            if (it->second.refresh && it->second.used && (m_entries.end() == next || it->second.refreshAt < next->second.refreshAt))
+            {
+                next = it;
+            }
+        }
+        if (m_entries.end() == next)
+        {
+            m_changed.wait(lock);
+            continue;
+        }
+        if (now < next->second.refreshAt)
+        {
+            m_changed.wait_until(lock, next->second.refreshAt);
+            continue;
+        }
+
+        // ȡڼ䲻Ŀܱ store/invalidate ĵ²
+        UserSigKey key = next->first;
+        Fetcher refresh = next->second.refresh;
+        lock.unlock();
+        std::string userSig = refresh();
+        lock.lock();
+
+        now = Clock::now();
+        std::map<UserSigKey, Entry>::iterator it = m_entries.find(key);
+        if (m_entries.end() == it)
+        {
+            continue;
+        }
+        Entry& entry = it->second;
+        if (userSig.empty())
+        {
+            ++m_stats.refreshFailed;
+            // ǰԼ
+            entry.refreshAt = now + (std::max)(m_refreshBefore / 4, Clock::duration(std::chrono::seconds(1)));
+            continue;
+        }
+
+        ++m_stats.refreshed;
+        entry.userSig = userSig;
+        entry.expires = now + m_ttl;
+        entry.refreshAt = entry.expires - m_refreshBefore;
+        entry.used = false;
+        m_dirty = true;
+    }
+}
+
+void UserSigCache::evictExpiredLocked(Clock::time_point now)
+{
+    std::map<UserSigKey, Entry>::iterator it = m_entries.begin();
+    while (m_entries.end() != it)
+    {
+        if (it->second.expires <= now)
+        {
+            m_entries.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void UserSigCache::load()
+{
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        path = m_filePath;
+    }
+    if (path.empty())
+    {
+        return;
+    }
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file)
+    {
+        return;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    Json::Reader reader;
+    Json::Value root;
+    if (!reader.parse(data, root) || !root.isMember("entries") || !root["entries"].isArray())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Clock::time_point now = Clock::now();
+    const Json::Value& entries = root["entries"];
+    for (Json::ArrayIndex i = 0; i < entries.size(); ++i)
+    {
+        const Json::Value& item = entries[i];
+        UserSigKey key;
+        key.sdkAppId = item["sdkAppId"].asInt();
+        key.userId = item["userId"].asString();
+        key.roomId = item["roomId"].asInt();
+
+        // ɰ汾д userSig ûժҪټأ´дʱǵ
+        std::string secret;
+        if (false == unsealSecret(item["secret"].asString(), secret))
+        {
+            continue;
+        }
+        size_t separator = secret.find('\n');
+        if (std::string::npos == separator)
+        {
+            continue;
+        }
+
+        Entry entry;
+        entry.pwdHash = secret.substr(0, separator);
+        entry.userSig = secret.substr(separator + 1);
+        entry.expires = Clock::from_time_t(static_cast<time_t>(item["expires"].asInt64()));
+        entry.refreshAt = entry.expires - m_refreshBefore;
+        entry.used = false;
+        if (entry.userSig.empty() || entry.expires <= now || m_entries.end() != m_entries.find(key))
+        {
+            continue;
+        }
+        m_entries[key] = entry;
+    }
+}
+
+void UserSigCache::save()
+{
+    std::string path;
+    Json::Value entries(Json::arrayValue);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        path = m_filePath;
+        if (path.empty())
+        {
+            return;
+        }
+        for (std::map<UserSigKey, Entry>::const_iterator it = m_entries.begin(); m_entries.end() != it; ++it)
+        {
+            std::string secret;
+            if (false == sealSecret(it->second.pwdHash + '\n' + it->second.userSig, secret))
+            {
+                continue;
+            }
+            Json::Value item;
+            item["sdkAppId"] = it->first.sdkAppId;
+            item["userId"] = it->first.userId;
+            item["roomId"] = it->first.roomId;
+            item["secret"] = secret;
+            item["expires"] = static_cast<Json::Int64>(Clock::to_time_t(it->second.expires));
+            entries.append(item);
+        }
+    }
+
+    Json::Value root;
+    root["entries"] = entries;
+    Json::FastWriter writer;
+    std::string data = writer.write(root);
+
+    // дʱļ滻дһ˳Ҳ½ضϵĻļ
+    std::string tmpPath = path + ".tmp";
+    bool written = false;
+#ifndef _WIN32
+    // ĵ userSig ֻ߶ȡ 0600 ofstream ضļʱȨ
+    ::remove(tmpPath.c_str());
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+    {
+        return;
+    }
+    ::close(fd);
+#endif
+    {
+        std::ofstream file(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+        file.flush();
+        written = file.good();
+    }
+    if (written)
+    {
+#ifdef _WIN32
+        written = (FALSE != ::MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH));
+#else
+        written = (0 == ::rename(tmpPath.c_str(), path.c_str()));
+#endif
+    }
+    if (false == written)
+    {
+        ::remove(tmpPath.c_str());
+    }
+}
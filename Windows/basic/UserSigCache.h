@@ -0,0 +1,92 @@
+#ifndef __USERSIGCACHE_H__
+#define __USERSIGCACHE_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+/**************************************************************************/
+
+struct UserSigKey
+{
+    int sdkAppId;
+    std::string userId;
+    int roomId;
+
+    bool operator<(const UserSigKey& other) const;
+};
+
+/*
+* ҵȡ UserSigͬʱд뱾ļԿ
+*
+* Ŀ TTL ǰɺ̨߳õǼǵ Fetcher »ȡϴλȡ֮ûٱȡĿˢ£ں
+* Fetcher ֻڴУпܴ룩ļصĿҪһ lookup() Ǽ Fetcher Żˢ
+*
+* ĿժҪһ lookup() Уɵ÷»ȡ store() ǣժҪֻڱȽϣܴ롣
+* ʱ userSig ժҪ Windows Ͼ DPAPICryptProtectDataܣֻͬһ Windows ûܽ⿪
+* ƽ̨д룬ļȨΪ߿ɶд
+*/
+class UserSigCache
+{
+public:
+    typedef std::function<std::string()> Fetcher;  // »ȡ userSigʧܷؿ
+
+    struct Stats
+    {
+        unsigned long long hits;
+        unsigned long long misses;
+        unsigned long long refreshed;       // ̨ˢ³ɹ
+        unsigned long long refreshFailed;
+    };
+
+    UserSigCache();
+    ~UserSigCache();
+
+    void setTtl(unsigned int seconds, unsigned int refreshBeforeSeconds);  // Ĭ 24 Сʱǰ 1 Сʱʼˢ
+    void setFilePath(const std::string& path);      // δڵĿ֮ıɺ̨̺߳ϲдأձʾ
+
+    // ʱ truepwd  store() ʱͬĿû Fetcher ʱǼ refresh
+    bool lookup(const UserSigKey& key, const std::string& pwd, const Fetcher& refresh, std::string& userSig);
+    void store(const UserSigKey& key, const std::string& pwd, const std::string& userSig, const Fetcher& refresh);
+    void invalidate(const UserSigKey& key);     // ˾ܾ˻ userSig ʱ
+    Stats stats() const;
+
+private:
+    typedef std::chrono::system_clock Clock;    // ʱҪ̣ steady_clock
+
+    struct Entry
+    {
+        std::string userSig;
+        std::string pwdHash;
+        Clock::time_point expires;
+        Clock::time_point refreshAt;
+        Fetcher refresh;
+        bool used;          // ϴλȡ֮Ƿ񱻶ȡ
+    };
+
+    void run();
+    void changedLocked();
+    void load();
+    void save();
+    void evictExpiredLocked(Clock::time_point now);
+
+    UserSigCache(const UserSigCache&);
+    void operator=(const UserSigCache&);
+
+private:
+    std::map<UserSigKey, Entry> m_entries;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::thread m_thread;
+    bool m_stop;
+    Clock::duration m_ttl;
+    Clock::duration m_refreshBefore;
+    std::string m_filePath;
+    bool m_dirty;               // бûдļ
+    Stats m_stats;
+};
+
+#endif /* __USERSIGCACHE_H__ */
@@ -143,6 +143,39 @@ license you like.
 #define JSON_USE_EXCEPTION 1
 #endif
 
+// If non-zero, string scanning in the readers and writers uses SSE2/AVX2 or
+// NEON when the compiler targets them. Define to 0 to force the portable
+// byte-at-a-time loops. The output is the same either way.
+#ifndef JSON_USE_SIMD
+#define JSON_USE_SIMD 1
+#endif
+
+// If non-zero, doubles are written with the shortest digits that read back
+// to the same value (instead of snprintf "%.17g") and read with a built-in
+// parser when the conversion is exact. Define to 0 for the C library paths,
+// which also restores the previous 17 digit output.
+#ifndef JSON_USE_FAST_NUMBERS
+#define JSON_USE_FAST_NUMBERS 1
+#endif
+
+// If non-zero, object members and array elements are kept in a sorted array
+// (Json::FlatMap) instead of a std::map: fewer allocations and faster
+// lookups, but inserting into an object or array invalidates references to
+// its other members, and so do iterators.
+#ifndef JSON_USE_FLAT_MAP
+#define JSON_USE_FLAT_MAP 0
+#endif
+
+// If non-zero, Json::BatchProcessor is available. It needs the C++11 thread
+// support library, so the default follows the language level.
+#ifndef JSON_USE_THREADS
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define JSON_USE_THREADS 1
+#else
+#define JSON_USE_THREADS 0
+#endif
+#endif
+
 /// If defined, indicates that the source file is amalgated
 /// to prevent private header inclusion.
 /// Remarks: it is automatically defined in the generated amalgated header.
@@ -454,8 +487,13 @@ public:
 #include <string>
 #include <vector>
 #include <exception>
+#include <new>
+#include <utility>
 
-#ifndef JSON_USE_CPPTL_SMALLMAP
+#if JSON_USE_FLAT_MAP
+#include <algorithm>
+#include <cstring>
+#elif !defined(JSON_USE_CPPTL_SMALLMAP)
 #include <map>
 #else
 #include <cpptl/smallmap.h>
@@ -582,6 +620,339 @@ private:
   const char* c_str_;
 };
 
+/** \brief Bump-pointer allocator backing a document parsed in zero-copy mode.
+ *
+ * Memory is carved out of large blocks and is only returned to the system when
+ * the Arena is cleared or destroyed; deallocation of a single chunk is a no-op.
+ * A CharReader created with the "zeroCopy" setting owns one Arena and places
+ * the whole tree of the last parsed document (containers, member nodes and
+ * string payloads) in it.
+ *
+ * \sa CharReaderBuilder
+ */
+class JSON_API Arena {
+public:
+  explicit Arena(size_t blockSize = 16 * 1024);
+  ~Arena();
+
+  /// Return \c size bytes suitably aligned for any Value member.
+  /// \throw RuntimeError if the system allocator fails.
+  void* allocate(size_t size);
+
+  /// Release every block but the first one, which is kept for reuse.
+  void clear();
+
+  /// Number of bytes handed out since construction or the last clear().
+  size_t bytesUsed() const { return used_; }
+
+private:
+  Arena(Arena const&);           // no impl
+  void operator=(Arena const&);  // no impl
+
+  struct Block {
+    Block* next_;
+    size_t size_;
+  };
+
+  void addBlock(size_t minSize);
+
+  Block* blocks_;
+  char* current_;
+  char* limit_;
+  size_t blockSize_;
+  size_t used_;
+};
+
+/** \brief STL allocator that draws from an Arena, or from the heap if none.
+ *
+ * A default-constructed allocator uses operator new, so containers of ordinary
+ * Values are unaffected. Copies of a container never inherit the arena.
+ */
+template <typename T> class ArenaAllocator {
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template <typename U> struct rebind { typedef ArenaAllocator<U> other; };
+
+  ArenaAllocator() : arena_(0) {}
+  explicit ArenaAllocator(Arena* arena) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+  pointer allocate(size_type n, const void* = 0) {
+    if (arena_)
+      return static_cast<pointer>(arena_->allocate(n * sizeof(T)));
+    return static_cast<pointer>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(pointer p, size_type) {
+    if (!arena_)
+      ::operator delete(p);
+  }
+
+  pointer address(reference x) const { return &x; }
+  const_pointer address(const_reference x) const { return &x; }
+  size_type max_size() const { return size_type(-1) / sizeof(T); }
+  void construct(pointer p, const T& val) { new (static_cast<void*>(p)) T(val); }
+  void destroy(pointer p) { p->~T(); }
+#if JSON_HAS_RVALUE_REFERENCES
+  template <typename U, typename... Args> void construct(U* p, Args&&... args) {
+    new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+  template <typename U> void destroy(U* p) { p->~U(); }
+#endif
+
+  ArenaAllocator select_on_container_copy_construction() const {
+    return ArenaAllocator();
+  }
+
+  Arena* arena() const { return arena_; }
+
+  template <typename U> bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+  template <typename U> bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena();
+  }
+
+private:
+  Arena* arena_;
+};
+
+#if JSON_USE_FLAT_MAP
+/** \brief Sorted-array map used for object members and array elements when
+ * JSON_USE_FLAT_MAP is non-zero.
+ *
+ * Elements are kept ordered by key in one contiguous block, so a lookup is a
+ * binary search over adjacent memory and iteration order is the same as with
+ * std::map. Up to InlineCapacity elements live inside the map itself; larger
+ * maps take one block from Allocator and grow it geometrically. Copies use a
+ * default-constructed Allocator.
+ *
+ * Unlike std::map, insertion and erasure invalidate iterators and references
+ * to elements. Elements are moved around with memmove, so Key and T must not
+ * hold pointers into themselves (true of Value and its keys).
+ */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          size_t InlineCapacity>
+class FlatMap {
+public:
+  typedef Key key_type;
+  typedef T mapped_type;
+  typedef std::pair<const Key, T> value_type;
+  typedef Compare key_compare;
+  typedef Allocator allocator_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef value_type* iterator;
+  typedef value_type const* const_iterator;
+
+  FlatMap()
+      : data_(inlineData()), size_(0), capacity_(InlineCapacity), compare_(),
+        allocator_() {}
+  FlatMap(Compare const& compare, Allocator const& allocator)
+      : data_(inlineData()), size_(0), capacity_(InlineCapacity),
+        compare_(compare), allocator_(allocator) {}
+  template <typename InputIterator>
+  FlatMap(InputIterator first, InputIterator last)
+      : data_(inlineData()), size_(0), capacity_(InlineCapacity), compare_(),
+        allocator_() {
+    for (; first != last; ++first)
+      insert(end(), *first);
+  }
+  FlatMap(FlatMap const& other)
+      : data_(inlineData()), size_(0), capacity_(InlineCapacity),
+        compare_(other.compare_), allocator_() {
+    assign(other);
+  }
+  FlatMap& operator=(FlatMap const& other) {
+    if (this != &other) {
+      clear();
+      assign(other);
+    }
+    return *this;
+  }
+  ~FlatMap() {
+    clear();
+    if (data_ != inlineData())
+      allocator_.deallocate(data_, capacity_);
+  }
+
+  iterator begin() { return data_; }
+  iterator end() { return data_ + size_; }
+  const_iterator begin() const { return data_; }
+  const_iterator end() const { return data_ + size_; }
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+  allocator_type get_allocator() const { return allocator_; }
+
+  void clear() {
+    while (size_ != 0)
+      data_[--size_].~value_type();
+  }
+  void reserve(size_type capacity) {
+    if (capacity > capacity_)
+      relocate(capacity);
+  }
+
+  iterator lower_bound(key_type const& key) {
+    return const_cast<iterator>(
+        static_cast<FlatMap const*>(this)->lower_bound(key));
+  }
+  const_iterator lower_bound(key_type const& key) const {
+    const_iterator first = data_;
+    size_type count = size_;
+    while (count != 0) {
+      size_type const step = count / 2;
+      const_iterator const middle = first + step;
+      if (compare_(middle->first, key)) {
+        first = middle + 1;
+        count -= step + 1;
+      } else {
+        count = step;
+      }
+    }
+    return first;
+  }
+  iterator find(key_type const& key) {
+    iterator it = lower_bound(key);
+    return (it != end() && !compare_(key, it->first)) ? it : end();
+  }
+  const_iterator find(key_type const& key) const {
+    const_iterator it = lower_bound(key);
+    return (it != end() && !compare_(key, it->first)) ? it : end();
+  }
+  size_type count(key_type const& key) const { return find(key) != end(); }
+
+  mapped_type& operator[](key_type const& key) {
+    iterator it = lower_bound(key);
+    if (it == end() || compare_(key, it->first))
+      it = insert(it, value_type(key, mapped_type()));
+    return it->second;
+  }
+
+  /// Inserts 'value' unless its key is present, and returns the element with
+  /// that key. 'hint' makes in-order insertion constant time.
+  iterator insert(const_iterator hint, value_type const& value) {
+    iterator position = findPosition(hint, value.first);
+    if (position != end() && !compare_(value.first, position->first))
+      return position;
+    Slot slot;
+    size_type const index = static_cast<size_type>(position - data_);
+    reserve(size_ + 1);
+    new (static_cast<void*>(&slot)) value_type(value);
+    return place(index, slot);
+  }
+#if JSON_HAS_RVALUE_REFERENCES
+  template <typename K, typename V>
+  iterator emplace_hint(const_iterator hint, K&& key, V&& value) {
+    iterator position = findPosition(hint, key);
+    if (position != end() && !compare_(key, position->first))
+      return position;
+    Slot slot;
+    size_type const index = static_cast<size_type>(position - data_);
+    reserve(size_ + 1);
+    new (static_cast<void*>(&slot))
+        value_type(std::forward<K>(key), std::forward<V>(value));
+    return place(index, slot);
+  }
+#endif
+
+  void erase(iterator position) {
+    position->~value_type();
+    memmove(static_cast<void*>(position), position + 1,
+            static_cast<size_t>(end() - position - 1) * sizeof(value_type));
+    --size_;
+  }
+  size_type erase(key_type const& key) {
+    iterator it = find(key);
+    if (it == end())
+      return 0;
+    erase(it);
+    return 1;
+  }
+
+private:
+  // Raw, suitably aligned storage for one element.
+  union Slot {
+    char bytes_[sizeof(value_type)];
+    double double_;
+    LargestUInt integer_;
+    void* pointer_;
+  };
+
+  value_type* inlineData() {
+    return reinterpret_cast<value_type*>(inline_);
+  }
+
+  iterator findPosition(const_iterator hint, key_type const& key) {
+    if ((hint == end() || compare_(key, hint->first)) &&
+        (hint == begin() || compare_((hint - 1)->first, key)))
+      return const_cast<iterator>(hint);
+    return lower_bound(key);
+  }
+
+  // Moves the element built in 'slot' to data_[index]. Never throws.
+  // \pre size_ < capacity_
+  iterator place(size_type index, Slot& slot) {
+    value_type* position = data_ + index;
+    memmove(static_cast<void*>(position + 1), position,
+            (size_ - index) * sizeof(value_type));
+    memcpy(static_cast<void*>(position), &slot, sizeof(value_type));
+    ++size_;
+    return position;
+  }
+
+  void relocate(size_type capacity) {
+    size_type newCapacity = capacity_ * 2;
+    if (newCapacity < capacity)
+      newCapacity = capacity;
+    value_type* newData = allocator_.allocate(newCapacity);
+    memcpy(static_cast<void*>(newData), data_, size_ * sizeof(value_type));
+    if (data_ != inlineData())
+      allocator_.deallocate(data_, capacity_);
+    data_ = newData;
+    capacity_ = newCapacity;
+  }
+
+  void assign(FlatMap const& other) {
+    reserve(other.size_);
+    for (const_iterator it = other.begin(); it != other.end(); ++it) {
+      new (static_cast<void*>(data_ + size_)) value_type(*it);
+      ++size_;
+    }
+  }
+
+  value_type* data_;
+  size_type size_;
+  size_type capacity_;
+  Compare compare_;
+  Allocator allocator_;
+  Slot inline_[InlineCapacity];
+};
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          size_t InlineCapacity>
+bool operator==(
+    FlatMap<Key, T, Compare, Allocator, InlineCapacity> const& x,
+    FlatMap<Key, T, Compare, Allocator, InlineCapacity> const& y) {
+  return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          size_t InlineCapacity>
+bool operator<(
+    FlatMap<Key, T, Compare, Allocator, InlineCapacity> const& x,
+    FlatMap<Key, T, Compare, Allocator, InlineCapacity> const& y) {
+  return std::lexicographical_compare(x.begin(), x.end(), y.begin(), y.end());
+}
+#endif // if JSON_USE_FLAT_MAP
+
 /** \brief Represents a <a HREF="http://www.json.org">JSON</a> value.
  *
  * This class is a discriminated union wrapper that can represents a:
@@ -618,6 +989,7 @@ private:
  */
 class JSON_API Value {
   friend class ValueIteratorBase;
+  friend class OurReader;
 public:
   typedef std::vector<JSONCPP_STRING> Members;
   typedef ValueIterator iterator;
@@ -700,11 +1072,17 @@ private:
   };
 
 public:
-#ifndef JSON_USE_CPPTL_SMALLMAP
-  typedef std::map<CZString, Value> ObjectValues;
+#if JSON_USE_FLAT_MAP
+  typedef FlatMap<CZString, Value, std::less<CZString>,
+                  ArenaAllocator<std::pair<const CZString, Value> >, 4>
+      ObjectValues;
+#elif !defined(JSON_USE_CPPTL_SMALLMAP)
+  typedef std::map<CZString, Value, std::less<CZString>,
+                   ArenaAllocator<std::pair<const CZString, Value> > >
+      ObjectValues;
 #else
   typedef CppTL::SmallMap<CZString, Value> ObjectValues;
-#endif // ifndef JSON_USE_CPPTL_SMALLMAP
+#endif // if JSON_USE_FLAT_MAP
 #endif // ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
 
 public:
@@ -1027,6 +1405,12 @@ private:
   Value& resolveReference(const char* key);
   Value& resolveReference(const char* key, const char* end);
 
+  // Zero-copy parse support (used by OurReader). The payload is placed in
+  // 'arena' and is never freed individually; 'key' is borrowed, not copied.
+  void initArenaContainer(ValueType type, Arena* arena);
+  void initArenaString(const char* begin, const char* end, Arena* arena);
+  Value& resolveBorrowedReference(const char* key, const char* end);
+
   struct CommentInfo {
     CommentInfo();
     ~CommentInfo();
@@ -1056,6 +1440,7 @@ private:
   ValueType type_ : 8;
   unsigned int allocated_ : 1; // Notes: if declared as bool, bitfield is useless.
                                // If not allocated_, string_ must be null-terminated.
+  unsigned int arena_ : 1;     // string_ or map_ lives in an Arena: not owned.
   CommentInfo* comments_;
 
   // [start, limit) byte offsets in the source JSON text from which this Value
@@ -1127,6 +1512,46 @@ private:
   Args args_;
 };
 
+/** \brief A compiled <a HREF="https://tools.ietf.org/html/rfc6901">JSON
+ * Pointer</a>, such as "/data/userSig", to resolve against many documents.
+ *
+ * The pointer is parsed once: "~1" and "~0" are unescaped, and array indexes
+ * are converted, at construction. Resolving it is then one lookup per
+ * reference token, with no string parsing or allocation.
+ *
+ * Usage:
+ * \code
+ * static Json::Pointer const userSigPointer("/data/userSig");
+ * Json::Value const* userSig = userSigPointer.find(response);
+ * if (userSig && userSig->isString()) ...
+ * \endcode
+ */
+class JSON_API Pointer {
+public:
+  /// \throw LogicError if \c pointer is neither empty nor starts with '/',
+  ///        or has a '~' not followed by '0' or '1'.
+  explicit Pointer(const JSONCPP_STRING& pointer);
+
+  /// The referenced value, or NULL if there is none.
+  const Value* find(const Value& root) const;
+  /// The referenced value, or Value::null if there is none.
+  const Value& resolve(const Value& root) const;
+  Value resolve(const Value& root, const Value& defaultValue) const;
+  /// Creates the referenced value if needed, as Path::make() does; "-"
+  /// appends to an array.
+  Value& make(Value& root) const;
+
+private:
+  struct Token {
+    JSONCPP_STRING key_;
+    ArrayIndex index_;
+    bool isIndex_; // key_ is an array index without leading zeroes
+  };
+  typedef std::vector<Token> Tokens;
+
+  Tokens tokens_;
+};
+
 /** \brief base class for Value iterators.
  *
  */
@@ -1652,6 +2077,16 @@ public:
     - `"allowSpecialFloats": false or true`
       - If true, special float values (NaNs and infinities) are allowed 
         and their values are lossfree restorable.
+    - `"zeroCopy": false or true`
+      - If true, the document tree is placed in an Arena owned by the
+        CharReader instead of one heap block per member and string, and
+        member names without escapes point straight into the input buffer.
+        The parsed root is only valid until the next parse() with the same
+        CharReader, or until the CharReader or the input buffer is destroyed,
+        whichever comes first. Copying a Value detaches it completely.
+    - `"format": "json" or "cbor"`
+      - "cbor" reads the input as CBOR (RFC 7049) instead of JSON text.
+        Only stackLimit, failIfExtra and rejectDupKeys apply to it.
 
     You can examine 'settings_` yourself
     to see the defaults. You can also write and read them just like any
@@ -1723,6 +2158,355 @@ bool JSON_API parseFromStream(
 */
 JSON_API JSONCPP_ISTREAM& operator>>(JSONCPP_ISTREAM&, Value&);
 
+/** \brief Receives the events of a SaxReader.
+ *
+ * Every callback returns \c true to continue parsing, or \c false to stop;
+ * SaxReader::parse() then returns \c false with an "Aborted by handler" error.
+ * The default implementations ignore the event.
+ *
+ * Character ranges passed to onKey() and onString() are only valid during the
+ * call: they point either into the parsed document or into a scratch buffer
+ * that the reader reuses for the next escaped string.
+ */
+class JSON_API SaxHandler {
+public:
+  virtual ~SaxHandler();
+
+  virtual bool onStartObject();
+  virtual bool onEndObject();
+  virtual bool onStartArray();
+  virtual bool onEndArray();
+  /// Name of the next object member. [begin, end) may contain embedded zeroes.
+  virtual bool onKey(char const* begin, char const* end);
+  virtual bool onNull();
+  virtual bool onBool(bool value);
+  /// An integer that is negative or at most Value::maxInt (as intValue).
+  virtual bool onInt(LargestInt value);
+  /// A larger integer that fits in LargestUInt (as uintValue).
+  virtual bool onUInt(LargestUInt value);
+  /// Any other number (as realValue).
+  virtual bool onDouble(double value);
+  virtual bool onString(char const* begin, char const* end);
+};
+
+/** \brief Push-style (SAX) <a HREF="http://www.json.org">JSON</a> reader.
+ *
+ * Walks a document and reports it to a SaxHandler without ever building a
+ * Value tree, so memory use is bounded by the nesting depth, not the size
+ * of the document. Numbers are classified the same way as by Reader.
+ *
+ * Usage:
+ * \code
+ * struct CountUsers : Json::SaxHandler {
+ *   int count;
+ *   CountUsers() : count(0) {}
+ *   bool onKey(char const* b, char const* e) JSONCPP_OVERRIDE {
+ *     if (JSONCPP_STRING(b, e) == "userId") ++count;
+ *     return true;
+ *   }
+ * };
+ * CountUsers handler;
+ * Json::SaxReader reader;
+ * bool ok = reader.parse(doc.data(), doc.data() + doc.size(), handler);
+ * \endcode
+ */
+class JSON_API SaxReader {
+public:
+  SaxReader();
+  /// Honours allowComments_, strictRoot_, allowDroppedNullPlaceholders_ and
+  /// allowNumericKeys_ (numeric names are reported through onKey()).
+  SaxReader(const Features& features);
+
+  /** \brief Parse [beginDoc, endDoc) and report it to \c handler.
+   * \return \c true if the whole document was valid and the handler never
+   *         asked to stop. Events already delivered are not rolled back.
+   */
+  bool parse(const char* beginDoc, const char* endDoc, SaxHandler& handler);
+
+  /// Nesting depth above which parse() fails. Defaults to 1000.
+  void setStackLimit(size_t limit) { stackLimit_ = limit; }
+
+  /// Empty if the last parse() succeeded.
+  JSONCPP_STRING getFormattedErrorMessages() const;
+
+  /// Byte offset of the last error in the parsed document, or -1.
+  ptrdiff_t getErrorOffset() const { return errorOffset_; }
+
+private:
+  typedef const char* Location;
+
+  bool readValue(SaxHandler& handler);
+  bool readKey(SaxHandler& handler);
+  bool readString(Location& begin, Location& end);
+  bool readNumber(SaxHandler& handler);
+  bool skipSpacesAndComments();
+  bool match(const char* pattern, int patternLength);
+  bool fail(const char* message, Location where);
+
+  std::vector<char> containers_;  // '{' or '[' for every open container
+  JSONCPP_STRING scratch_;
+  JSONCPP_STRING error_;
+  Location begin_;
+  Location end_;
+  Location current_;
+  ptrdiff_t errorOffset_;
+  size_t stackLimit_;
+  Features features_;
+};
+
+/** \brief Resumable push-style reader for documents that arrive in pieces.
+ *
+ * Accepts the same grammar as SaxReader and reports the same events, but the
+ * document may be split into chunks at arbitrary byte boundaries. Every call
+ * to feed() reports all the events it can and keeps the unfinished token (a
+ * string, number or literal cut by the chunk boundary) for the next call, so
+ * parsing overlaps with receiving and the whole document is never buffered.
+ *
+ * Usage:
+ * \code
+ * Json::Value root;
+ * Json::ValueBuilder builder(root);
+ * Json::IncrementalReader reader(builder);
+ * while (size_t n = receive(buffer, sizeof(buffer))) {
+ *   if (!reader.feed(buffer, buffer + n))
+ *     break;
+ * }
+ * bool ok = reader.finish();
+ * \endcode
+ */
+class JSON_API IncrementalReader {
+public:
+  explicit IncrementalReader(SaxHandler& handler);
+  /// Same features as SaxReader.
+  IncrementalReader(SaxHandler& handler, const Features& features);
+
+  /** \brief Parse the next chunk [beginChunk, endChunk) of the document.
+   * The chunk does not have to outlive the call.
+   * \return \c false once an error has been found; further calls do nothing.
+   */
+  bool feed(const char* beginChunk, const char* endChunk);
+
+  /** \brief Signal the end of the document.
+   * \return \c true if a complete root value was read without error. Anything
+   *         after the root value is ignored, as by Reader.
+   */
+  bool finish();
+
+  /// Forget all state and the last error, to parse another document.
+  void reset();
+
+  /// Nesting depth above which feed() fails. Defaults to 1000.
+  void setStackLimit(size_t limit) { stackLimit_ = limit; }
+
+  /// Empty if no error has been found yet.
+  JSONCPP_STRING getFormattedErrorMessages() const { return error_; }
+
+  /// Byte offset of the error from the start of the first chunk, or -1.
+  ptrdiff_t getErrorOffset() const { return errorOffset_; }
+
+private:
+  typedef const char* Location;
+
+  // What the grammar allows next, outside of a token.
+  enum Expect {
+    expectValue,
+    expectValueOrEnd,  // just after '['
+    expectKey,
+    expectKeyOrEnd,    // just after '{'
+    expectColon,
+    expectCommaOrEnd,
+    expectNothing      // the root value is complete
+  };
+  // The token being read, which may continue in the next chunk.
+  enum Token {
+    tokenNone,
+    tokenString,
+    tokenNumber,
+    tokenLiteral,
+    tokenCommentStart, // after '/'
+    tokenBlockComment,
+    tokenLineComment
+  };
+
+  bool startToken();
+  bool continueToken();
+  bool endString(Location begin, Location end);
+  bool endNumber(Location begin, Location end);
+  bool endContainer(char close);
+  void endValue();
+  bool failExpected(ptrdiff_t offset);
+  bool fail(const char* message, ptrdiff_t offset);
+  void advanceLines(Location begin, Location end, ptrdiff_t offset);
+  ptrdiff_t offsetOf(Location where) const {
+    return consumed_ + (where - chunk_);
+  }
+
+  SaxHandler& handler_;
+  std::vector<char> containers_;  // '{' or '[' for every open container
+  JSONCPP_STRING pending_;  // the unfinished token, from its first byte
+  JSONCPP_STRING scratch_;
+  JSONCPP_STRING error_;
+  Location chunk_;
+  Location current_;
+  Location end_;
+  const char* literal_;     // rest of "true", "false" or "null" to match
+  ptrdiff_t consumed_;      // offset of chunk_
+  ptrdiff_t tokenStart_;    // offset of the first byte of the token
+  ptrdiff_t errorOffset_;
+  // Line of consumed_ and of tokenStart_, for error messages.
+  ptrdiff_t lineStart_;
+  ptrdiff_t tokenLineStart_;
+  int line_;
+  int tokenLine_;
+  size_t stackLimit_;
+  Features features_;
+  Expect expect_;
+  Token token_;
+  bool escaped_;    // the string token contains an escape sequence
+  bool backslash_;  // the chunk ended inside an escape sequence
+  bool star_;       // the chunk ended with '*' inside a block comment
+  bool cr_;         // the last byte counted by advanceLines() was '\r'
+};
+
+/** \brief SaxHandler that builds a Value tree from the events it receives.
+ *
+ * Lets SaxReader and IncrementalReader produce the same Value as Reader. When
+ * an object has duplicate member names, the last one wins.
+ */
+class JSON_API ValueBuilder : public SaxHandler {
+public:
+  /// \c root is overwritten by the first value reported.
+  explicit ValueBuilder(Value& root);
+
+  bool onStartObject() JSONCPP_OVERRIDE;
+  bool onEndObject() JSONCPP_OVERRIDE;
+  bool onStartArray() JSONCPP_OVERRIDE;
+  bool onEndArray() JSONCPP_OVERRIDE;
+  bool onKey(char const* begin, char const* end) JSONCPP_OVERRIDE;
+  bool onNull() JSONCPP_OVERRIDE;
+  bool onBool(bool value) JSONCPP_OVERRIDE;
+  bool onInt(LargestInt value) JSONCPP_OVERRIDE;
+  bool onUInt(LargestUInt value) JSONCPP_OVERRIDE;
+  bool onDouble(double value) JSONCPP_OVERRIDE;
+  bool onString(char const* begin, char const* end) JSONCPP_OVERRIDE;
+
+private:
+  ValueBuilder(ValueBuilder const&);
+  void operator=(ValueBuilder const&);
+
+  Value& next();
+
+  Value& root_;
+  std::vector<Value*> stack_;  // open containers; the innermost is last
+  JSONCPP_STRING key_;         // name of the next member of an object
+};
+
+/** \brief A JSON document that is decoded on access.
+ *
+ * parse() validates the document and records where every object and array
+ * ends, in one pass that converts no numbers and copies no strings. Values
+ * are decoded only when read through a Node, and looking up a member skips
+ * nested containers in constant time, so reading a few fields of a large
+ * document costs a fraction of building its whole Value tree.
+ *
+ * The document is not copied: it must outlive the LazyDocument and its
+ * Nodes. Only standard JSON is accepted: no comments. Numbers are only
+ * checked for syntax: one out of the range of double decodes as null.
+ *
+ * Usage:
+ * \code
+ * Json::LazyDocument doc;
+ * if (doc.parse(body.data(), body.data() + body.size()) &&
+ *     doc.root()["errorCode"].asInt() == 0)
+ *   userSig = doc.root()["data"]["userSig"].asString();
+ * \endcode
+ */
+class JSON_API LazyDocument {
+public:
+  /// A value of the document, or a missing one. Cheap to copy.
+  class JSON_API Node {
+  public:
+    Node();
+
+    /// \c false for the member or element of a failed lookup.
+    bool exists() const { return begin_ != NULL; }
+    /// nullValue if missing. Numbers are decoded to tell int from real.
+    ValueType type() const;
+
+    /// Member of an object. Missing if this is not an object.
+    Node operator[](const char* key) const;
+    Node operator[](const JSONCPP_STRING& key) const;
+    /// Member of an object. [begin, end) may contain embedded zeroes.
+    /// If the name appears more than once, the last one wins, as in Reader.
+    Node find(char const* begin, char const* end) const;
+    /// Element of an array. Missing if this is not an array.
+    Node operator[](ArrayIndex index) const;
+    /// Number of elements or distinct members; 0 for other values.
+    ArrayIndex size() const;
+
+    /// The value and all it contains; null if missing.
+    Value decode() const;
+    JSONCPP_STRING asString() const;
+    Int asInt() const;
+    UInt asUInt() const;
+#if defined(JSON_HAS_INT64)
+    Int64 asInt64() const;
+    UInt64 asUInt64() const;
+#endif // if defined(JSON_HAS_INT64)
+    double asDouble() const;
+    bool asBool() const;
+
+  private:
+    friend class LazyDocument;
+    Node(const LazyDocument* document, const char* begin, size_t container);
+
+    const LazyDocument* document_;
+    const char* begin_;    // first byte of the value
+    size_t container_;     // index in containers_, for an object or array
+  };
+
+  LazyDocument();
+
+  /** \brief Validate and index [beginDoc, endDoc).
+   * \return \c false if the document is not valid JSON.
+   */
+  bool parse(const char* beginDoc, const char* endDoc);
+
+  /// The root value; missing unless the last parse() succeeded.
+  Node root() const;
+
+  /// Empty if the last parse() succeeded.
+  JSONCPP_STRING getFormattedErrorMessages() const;
+
+  /// Byte offset of the last error in the parsed document, or -1.
+  ptrdiff_t getErrorOffset() const { return errorOffset_; }
+
+private:
+  friend class Node;
+  typedef const char* Location;
+
+  struct Container {
+    Location begin;  // '{' or '['
+    Location end;    // the matching '}' or ']'
+    size_t next;     // index of the first container after this one
+  };
+  typedef std::vector<Container> Containers;
+
+  Location readString(Location current);
+  Location readKey(Location current);
+  Location readScalar(Location current);
+  Location skipString(Location current, bool& escaped) const;
+  Location skipValue(Location current, size_t& container) const;
+  bool fail(const char* message, Location where);
+
+  Containers containers_;  // in document order
+  JSONCPP_STRING scratch_;
+  JSONCPP_STRING error_;
+  Location begin_;
+  Location end_;
+  ptrdiff_t errorOffset_;
+};
+
 } // namespace Json
 
 #pragma pack(pop)
@@ -1853,6 +2637,9 @@ public:
       - If true, outputs non-finite floating point values in the following way:
         NaN values as "NaN", positive infinity as "Infinity", and negative infinity
         as "-Infinity".
+    - "format": "json" or "cbor"
+      - "cbor" writes CBOR (RFC 7049) instead of JSON text. The other
+        settings do not apply to it, and comments are not written.
 
     You can examine 'settings_` yourself
     to see the defaults. You can also write and read them just like any
@@ -2072,6 +2859,70 @@ JSONCPP_STRING JSON_API valueToQuotedString(const char* value);
 /// \see Json::operator>>()
 JSON_API JSONCPP_OSTREAM& operator<<(JSONCPP_OSTREAM&, const Value& root);
 
+#if JSON_USE_THREADS
+/** \brief Parses or writes batches of documents on a pool of threads.
+ *
+ * Every thread keeps one CharReader and one StreamWriter, made by the
+ * factories at construction, and reuses them for every document it
+ * handles: the threads share nothing but the queue of documents.
+ * The calling thread takes part in each batch; batches started from
+ * several threads run one after the other.
+ *
+ * The roots of a batch must all stay valid while the thread's reader goes on
+ * to its next document, which a "zeroCopy" reader cannot do: its roots live
+ * in an arena that every parse() clears. A CharReaderBuilder with "zeroCopy"
+ * is therefore used with "zeroCopy" turned off. Other factories must not
+ * make readers whose roots depend on the reader outliving the next parse().
+ *
+ * Usage:
+ * \code
+ * Json::BatchProcessor batch((Json::CharReaderBuilder()),
+ *                            Json::StreamWriterBuilder());
+ * std::vector<Json::BatchProcessor::Input> inputs;  // one per document
+ * std::vector<Json::Value> roots;
+ * std::vector<JSONCPP_STRING> errors;
+ * size_t failures = batch.parse(inputs, roots, &errors);
+ * \endcode
+ */
+class JSON_API BatchProcessor {
+public:
+  struct Input {
+    const char* begin;
+    const char* end;
+  };
+
+  /// \param threads Number of threads, including the caller; 0 means one
+  ///                per hardware thread.
+  BatchProcessor(CharReader::Factory const& readers,
+                 StreamWriter::Factory const& writers,
+                 unsigned threads = 0);
+  ~BatchProcessor();
+
+  unsigned threadCount() const;
+
+  /** \brief Parse every input into the root of the same index.
+   * \param errors If not NULL, receives the messages of every input, empty
+   *               for those that parsed.
+   * \return The number of inputs that failed to parse.
+   * \throw The first exception thrown by a reader, once the batch is done.
+   */
+  size_t parse(std::vector<Input> const& inputs,
+               std::vector<Value>& roots,
+               std::vector<JSONCPP_STRING>* errors);
+
+  /// Write every root into the document of the same index.
+  void write(std::vector<Value> const& roots,
+             std::vector<JSONCPP_STRING>& documents);
+
+private:
+  BatchProcessor(BatchProcessor const&);
+  void operator=(BatchProcessor const&);
+
+  struct Pool;
+  Pool* pool_;
+};
+#endif // if JSON_USE_THREADS
+
 } // namespace Json
 
 #pragma pack(pop)
@@ -96,6 +96,26 @@ license you like.
 #ifndef JSONCPP_NO_LOCALE_SUPPORT
 #include <clocale>
 #endif
+#include <cstring>
+
+#if JSON_USE_SIMD
+#if defined(__AVX2__)
+#define JSONCPP_SIMD_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSONCPP_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define JSONCPP_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#if defined(_MSC_VER) && (defined(JSONCPP_SIMD_AVX2) ||                         \
+                          defined(JSONCPP_SIMD_SSE2) ||                         \
+                          defined(JSONCPP_SIMD_NEON))
+#include <intrin.h>
+#endif
+#endif // if JSON_USE_SIMD
 
 /* This header provides common string manipulation support, such as UTF-8,
  * portable conversion from/to string...
@@ -145,6 +165,147 @@ static inline JSONCPP_STRING codePointToUTF8(unsigned int cp) {
 /// Returns true if ch is a control character (in range [1,31]).
 static inline bool isControlCharacter(char ch) { return ch > 0 && ch <= 0x1F; }
 
+#if defined(JSONCPP_SIMD_AVX2) || defined(JSONCPP_SIMD_SSE2) ||                 \
+    defined(JSONCPP_SIMD_NEON)
+/// Index of the lowest set bit. \pre mask != 0
+static inline unsigned int lowestSetBit(unsigned int mask) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned int>(index);
+#else
+  return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+#if defined(JSONCPP_SIMD_NEON)
+/// Narrows a byte-wise comparison result to 4 bits per byte, so that the first
+/// matching byte is lowestSetBit() / 4. \pre some byte of 'matches' is set
+static inline unsigned int firstMatchingByte(uint8x16_t matches) {
+  uint8x8_t const nibbles =
+      vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+  uint64_t const bits = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+  unsigned int const low = static_cast<unsigned int>(bits);
+  if (low)
+    return lowestSetBit(low) / 4;
+  return 8 + lowestSetBit(static_cast<unsigned int>(bits >> 32)) / 4;
+}
+#endif
+
+/// Returns the first '"' or '\\' in [begin, end), or end.
+static inline char const* findQuoteOrBackslash(char const* begin,
+                                               char const* end) {
+  char const* current = begin;
+#if defined(JSONCPP_SIMD_AVX2)
+  __m256i const quote = _mm256_set1_epi8('"');
+  __m256i const backslash = _mm256_set1_epi8('\\');
+  for (; end - current >= 32; current += 32) {
+    __m256i const chunk =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(current));
+    unsigned int const mask = static_cast<unsigned int>(
+        _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                                             _mm256_cmpeq_epi8(chunk, backslash))));
+    if (mask)
+      return current + lowestSetBit(mask);
+  }
+#endif
+#if defined(JSONCPP_SIMD_AVX2) || defined(JSONCPP_SIMD_SSE2)
+  __m128i const quote16 = _mm_set1_epi8('"');
+  __m128i const backslash16 = _mm_set1_epi8('\\');
+  for (; end - current >= 16; current += 16) {
+    __m128i const chunk =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(current));
+    unsigned int const mask = static_cast<unsigned int>(
+        _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote16),
+                                       _mm_cmpeq_epi8(chunk, backslash16))));
+    if (mask)
+      return current + lowestSetBit(mask);
+  }
+#elif defined(JSONCPP_SIMD_NEON)
+  uint8x16_t const quote = vdupq_n_u8('"');
+  uint8x16_t const backslash = vdupq_n_u8('\\');
+  for (; end - current >= 16; current += 16) {
+    uint8x16_t const chunk =
+        vld1q_u8(reinterpret_cast<uint8_t const*>(current));
+    uint8x16_t const matches =
+        vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash));
+    if (vget_lane_u64(vreinterpret_u64_u8(vorr_u8(vget_low_u8(matches),
+                                                  vget_high_u8(matches))),
+                      0))
+      return current + firstMatchingByte(matches);
+  }
+#endif
+  for (; current != end; ++current) {
+    if (*current == '"' || *current == '\\')
+      return current;
+  }
+  return end;
+}
+
+/// Returns the first character in [begin, end) that the writers must escape
+/// ('"', '\\', or in range [0,31]), or end.
+static inline char const* findCharRequiringEscape(char const* begin,
+                                                  char const* end) {
+  char const* current = begin;
+#if defined(JSONCPP_SIMD_AVX2)
+  __m256i const quote = _mm256_set1_epi8('"');
+  __m256i const backslash = _mm256_set1_epi8('\\');
+  __m256i const lastControl = _mm256_set1_epi8(0x1F);
+  for (; end - current >= 32; current += 32) {
+    __m256i const chunk =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(current));
+    __m256i const control =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, lastControl), chunk);
+    unsigned int const mask = static_cast<unsigned int>(_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                                        _mm256_cmpeq_epi8(chunk, backslash)),
+                        control)));
+    if (mask)
+      return current + lowestSetBit(mask);
+  }
+#endif
+#if defined(JSONCPP_SIMD_AVX2) || defined(JSONCPP_SIMD_SSE2)
+  __m128i const quote16 = _mm_set1_epi8('"');
+  __m128i const backslash16 = _mm_set1_epi8('\\');
+  __m128i const lastControl16 = _mm_set1_epi8(0x1F);
+  for (; end - current >= 16; current += 16) {
+    __m128i const chunk =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(current));
+    // unsigned chunk <= 0x1F
+    __m128i const control =
+        _mm_cmpeq_epi8(_mm_min_epu8(chunk, lastControl16), chunk);
+    unsigned int const mask = static_cast<unsigned int>(_mm_movemask_epi8(
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote16),
+                                  _mm_cmpeq_epi8(chunk, backslash16)),
+                     control)));
+    if (mask)
+      return current + lowestSetBit(mask);
+  }
+#elif defined(JSONCPP_SIMD_NEON)
+  uint8x16_t const quote = vdupq_n_u8('"');
+  uint8x16_t const backslash = vdupq_n_u8('\\');
+  uint8x16_t const lastControl = vdupq_n_u8(0x1F);
+  for (; end - current >= 16; current += 16) {
+    uint8x16_t const chunk =
+        vld1q_u8(reinterpret_cast<uint8_t const*>(current));
+    uint8x16_t const matches =
+        vorrq_u8(vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)),
+                 vcleq_u8(chunk, lastControl));
+    if (vget_lane_u64(vreinterpret_u64_u8(vorr_u8(vget_low_u8(matches),
+                                                  vget_high_u8(matches))),
+                      0))
+      return current + firstMatchingByte(matches);
+  }
+#endif
+  for (; current != end; ++current) {
+    if (*current == '"' || *current == '\\' || *current == 0 ||
+        isControlCharacter(*current))
+      return current;
+  }
+  return end;
+}
+
 enum {
   /// Constant that specify the size of the buffer that must be passed to
   /// uintToString.
@@ -193,6 +354,382 @@ static inline void fixNumericLocaleInput(char* begin, char* end) {
   }
 }
 
+#if JSON_USE_FAST_NUMBERS
+
+// Shortest round-trip formatting of doubles with Grisu2 (F. Loitsch,
+// "Printing Floating-Point Numbers Quickly and Accurately with Integers",
+// PLDI 2010), after the implementation in RapidJSON. The digits always read
+// back to the same double; in rare cases they are one digit longer than the
+// shortest such string.
+
+/// A floating point number f * 2^e with a 64 bit significand.
+struct DiyFp {
+  DiyFp() : f(0), e(0) {}
+  DiyFp(uint64_t fp, int exp) : f(fp), e(exp) {}
+  uint64_t f;
+  int e;
+};
+
+static uint64_t const kDpSignificandMask = 0x000FFFFFFFFFFFFFULL;
+static uint64_t const kDpHiddenBit = 0x0010000000000000ULL;
+static int const kDpExponentBias = 0x3FF + 52;
+
+/// Upper 64 bits of the 128 bit product, rounded.
+static inline DiyFp multiply(DiyFp const& x, DiyFp const& y) {
+  uint64_t const M32 = 0xFFFFFFFFU;
+  uint64_t const a = x.f >> 32;
+  uint64_t const b = x.f & M32;
+  uint64_t const c = y.f >> 32;
+  uint64_t const d = y.f & M32;
+  uint64_t const ac = a * c;
+  uint64_t const bc = b * c;
+  uint64_t const ad = a * d;
+  uint64_t const bd = b * d;
+  uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+  tmp += 1U << 31; // round
+  return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64);
+}
+
+static inline DiyFp normalize(DiyFp v) {
+  while (!(v.f & (kDpHiddenBit << 11))) {
+    v.f <<= 1;
+    v.e--;
+  }
+  return v;
+}
+
+/// 10^-K as a normalized DiyFp, with K chosen so that the product with a
+/// significand of binary exponent 'e' has its exponent in [-60, -32].
+static DiyFp cachedPower(int e, int* K) {
+  // 10^-348, 10^-340, ..., 10^340
+  static struct {
+    uint64_t f;
+    int e;
+  } const kCachedPowers[] = {
+    {0xfa8fd5a0081c0288ULL, -1220}, {0xbaaee17fa23ebf76ULL, -1193},
+    {0x8b16fb203055ac76ULL, -1166}, {0xcf42894a5dce35eaULL, -1140},
+    {0x9a6bb0aa55653b2dULL, -1113}, {0xe61acf033d1a45dfULL, -1087},
+    {0xab70fe17c79ac6caULL, -1060}, {0xff77b1fcbebcdc4fULL, -1034},
+    {0xbe5691ef416bd60cULL, -1007}, {0x8dd01fad907ffc3cULL, -980},
+    {0xd3515c2831559a83ULL, -954}, {0x9d71ac8fada6c9b5ULL, -927},
+    {0xea9c227723ee8bcbULL, -901}, {0xaecc49914078536dULL, -874},
+    {0x823c12795db6ce57ULL, -847}, {0xc21094364dfb5637ULL, -821},
+    {0x9096ea6f3848984fULL, -794}, {0xd77485cb25823ac7ULL, -768},
+    {0xa086cfcd97bf97f4ULL, -741}, {0xef340a98172aace5ULL, -715},
+    {0xb23867fb2a35b28eULL, -688}, {0x84c8d4dfd2c63f3bULL, -661},
+    {0xc5dd44271ad3cdbaULL, -635}, {0x936b9fcebb25c996ULL, -608},
+    {0xdbac6c247d62a584ULL, -582}, {0xa3ab66580d5fdaf6ULL, -555},
+    {0xf3e2f893dec3f126ULL, -529}, {0xb5b5ada8aaff80b8ULL, -502},
+    {0x87625f056c7c4a8bULL, -475}, {0xc9bcff6034c13053ULL, -449},
+    {0x964e858c91ba2655ULL, -422}, {0xdff9772470297ebdULL, -396},
+    {0xa6dfbd9fb8e5b88fULL, -369}, {0xf8a95fcf88747d94ULL, -343},
+    {0xb94470938fa89bcfULL, -316}, {0x8a08f0f8bf0f156bULL, -289},
+    {0xcdb02555653131b6ULL, -263}, {0x993fe2c6d07b7facULL, -236},
+    {0xe45c10c42a2b3b06ULL, -210}, {0xaa242499697392d3ULL, -183},
+    {0xfd87b5f28300ca0eULL, -157}, {0xbce5086492111aebULL, -130},
+    {0x8cbccc096f5088ccULL, -103}, {0xd1b71758e219652cULL, -77},
+    {0x9c40000000000000ULL, -50}, {0xe8d4a51000000000ULL, -24},
+    {0xad78ebc5ac620000ULL, 3}, {0x813f3978f8940984ULL, 30},
+    {0xc097ce7bc90715b3ULL, 56}, {0x8f7e32ce7bea5c70ULL, 83},
+    {0xd5d238a4abe98068ULL, 109}, {0x9f4f2726179a2245ULL, 136},
+    {0xed63a231d4c4fb27ULL, 162}, {0xb0de65388cc8ada8ULL, 189},
+    {0x83c7088e1aab65dbULL, 216}, {0xc45d1df942711d9aULL, 242},
+    {0x924d692ca61be758ULL, 269}, {0xda01ee641a708deaULL, 295},
+    {0xa26da3999aef774aULL, 322}, {0xf209787bb47d6b85ULL, 348},
+    {0xb454e4a179dd1877ULL, 375}, {0x865b86925b9bc5c2ULL, 402},
+    {0xc83553c5c8965d3dULL, 428}, {0x952ab45cfa97a0b3ULL, 455},
+    {0xde469fbd99a05fe3ULL, 481}, {0xa59bc234db398c25ULL, 508},
+    {0xf6c69a72a3989f5cULL, 534}, {0xb7dcbf5354e9beceULL, 561},
+    {0x88fcf317f22241e2ULL, 588}, {0xcc20ce9bd35c78a5ULL, 614},
+    {0x98165af37b2153dfULL, 641}, {0xe2a0b5dc971f303aULL, 667},
+    {0xa8d9d1535ce3b396ULL, 694}, {0xfb9b7cd9a4a7443cULL, 720},
+    {0xbb764c4ca7a44410ULL, 747}, {0x8bab8eefb6409c1aULL, 774},
+    {0xd01fef10a657842cULL, 800}, {0x9b10a4e5e9913129ULL, 827},
+    {0xe7109bfba19c0c9dULL, 853}, {0xac2820d9623bf429ULL, 880},
+    {0x80444b5e7aa7cf85ULL, 907}, {0xbf21e44003acdd2dULL, 933},
+    {0x8e679c2f5e44ff8fULL, 960}, {0xd433179d9c8cb841ULL, 986},
+    {0x9e19db92b4e31ba9ULL, 1013}, {0xeb96bf6ebadf77d9ULL, 1039},
+    {0xaf87023b9bf0ee6bULL, 1066}
+  };
+  double const dk = (-61 - e) * 0.30102999566398114 + 347;
+  int k = static_cast<int>(dk);
+  if (dk - k > 0.0)
+    k++;
+  unsigned int const index = static_cast<unsigned int>((k >> 3) + 1);
+  *K = -(-348 + static_cast<int>(index) * 8);
+  return DiyFp(kCachedPowers[index].f, kCachedPowers[index].e);
+}
+
+static inline void grisuRound(char* buffer, int length, uint64_t delta,
+                              uint64_t rest, uint64_t tenKappa,
+                              uint64_t wpW) {
+  while (rest < wpW && delta - rest >= tenKappa &&
+         (rest + tenKappa < wpW || wpW - rest > rest + tenKappa - wpW)) {
+    buffer[length - 1]--;
+    rest += tenKappa;
+  }
+}
+
+static inline int countDecimalDigits(uint32_t n) {
+  int count = 1;
+  while (n >= 10 && count < 10) {
+    n /= 10;
+    ++count;
+  }
+  return count;
+}
+
+static void grisuDigitGen(DiyFp const& W, DiyFp const& Mp, uint64_t delta,
+                          char* buffer, int* length, int* K) {
+  static uint64_t const kPow10[] = {1ULL,
+                                    10ULL,
+                                    100ULL,
+                                    1000ULL,
+                                    10000ULL,
+                                    100000ULL,
+                                    1000000ULL,
+                                    10000000ULL,
+                                    100000000ULL,
+                                    1000000000ULL,
+                                    10000000000ULL,
+                                    100000000000ULL,
+                                    1000000000000ULL,
+                                    10000000000000ULL,
+                                    100000000000000ULL,
+                                    1000000000000000ULL,
+                                    10000000000000000ULL,
+                                    100000000000000000ULL,
+                                    1000000000000000000ULL,
+                                    10000000000000000000ULL};
+  DiyFp const one(uint64_t(1) << -Mp.e, Mp.e);
+  uint64_t const wpW = Mp.f - W.f;
+  uint32_t p1 = static_cast<uint32_t>(Mp.f >> -one.e);
+  uint64_t p2 = Mp.f & (one.f - 1);
+  int kappa = countDecimalDigits(p1);
+  *length = 0;
+
+  while (kappa > 0) {
+    uint32_t const divisor = static_cast<uint32_t>(kPow10[kappa - 1]);
+    uint32_t const d = p1 / divisor;
+    p1 %= divisor;
+    if (d || *length)
+      buffer[(*length)++] = static_cast<char>('0' + d);
+    kappa--;
+    uint64_t const rest = (static_cast<uint64_t>(p1) << -one.e) + p2;
+    if (rest <= delta) {
+      *K += kappa;
+      grisuRound(buffer, *length, delta, rest, kPow10[kappa] << -one.e, wpW);
+      return;
+    }
+  }
+
+  for (;;) {
+    p2 *= 10;
+    delta *= 10;
+    char const d = static_cast<char>(p2 >> -one.e);
+    if (d || *length)
+      buffer[(*length)++] = static_cast<char>('0' + d);
+    p2 &= one.f - 1;
+    kappa--;
+    if (p2 < delta) {
+      *K += kappa;
+      int const index = -kappa;
+      grisuRound(buffer, *length, delta, p2, one.f,
+                 wpW * (index < 20 ? kPow10[index] : 0));
+      return;
+    }
+  }
+}
+
+/// Writes at most 17 digits to 'buffer' such that digits * 10^K reads back
+/// as 'value'. Returns the number of digits.
+/// \pre value is finite and > 0.
+static int grisu2(double value, char* buffer, int* K) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  int const biasedExponent = static_cast<int>(bits >> 52) & 0x7FF;
+  uint64_t const significand = bits & kDpSignificandMask;
+  DiyFp const v = biasedExponent != 0
+                      ? DiyFp(significand + kDpHiddenBit,
+                              biasedExponent - kDpExponentBias)
+                      : DiyFp(significand, 1 - kDpExponentBias);
+
+  // Boundaries m- and m+ halfway to the neighbouring doubles.
+  DiyFp plus(v.f * 2 + 1, v.e - 1);
+  while (!(plus.f & (kDpHiddenBit << 1))) {
+    plus.f <<= 1;
+    plus.e--;
+  }
+  plus.f <<= 64 - 52 - 2;
+  plus.e -= 64 - 52 - 2;
+  DiyFp minus = (v.f == kDpHiddenBit) ? DiyFp(v.f * 4 - 1, v.e - 2)
+                                      : DiyFp(v.f * 2 - 1, v.e - 1);
+  minus.f <<= minus.e - plus.e;
+  minus.e = plus.e;
+
+  DiyFp const cached = cachedPower(plus.e, K);
+  DiyFp const W = multiply(normalize(v), cached);
+  DiyFp Wp = multiply(plus, cached);
+  DiyFp Wm = multiply(minus, cached);
+  Wm.f++;
+  Wp.f--;
+  int length;
+  grisuDigitGen(W, Wp, Wp.f - Wm.f, buffer, &length, K);
+  return length;
+}
+
+/// Same layout as snprintf("%.17g"), but with the digits from grisu2().
+/// 'buffer' needs room for 26 characters. Returns the length.
+/// \pre value is finite.
+static int shortestDoubleToString(double value, char* buffer) {
+  char* out = buffer;
+  if (value < 0 || (value == 0 && 1 / value < 0)) {
+    *out++ = '-';
+    value = -value;
+  }
+  if (value == 0) {
+    *out++ = '0';
+    *out = 0;
+    return static_cast<int>(out - buffer);
+  }
+
+  char digits[18];
+  int K;
+  int const length = grisu2(value, digits, &K);
+  // Drop trailing zeros, as %g does.
+  int significant = length;
+  while (significant > 1 && digits[significant - 1] == '0')
+    --significant;
+  K += length - significant;
+  int const exponent = significant + K - 1; // of the leading digit
+
+  if (exponent < -4 || exponent >= 17) {
+    *out++ = digits[0];
+    if (significant > 1) {
+      *out++ = '.';
+      memcpy(out, digits + 1, static_cast<size_t>(significant - 1));
+      out += significant - 1;
+    }
+    *out++ = 'e';
+    *out++ = exponent < 0 ? '-' : '+';
+    unsigned int e = static_cast<unsigned int>(exponent < 0 ? -exponent
+                                                            : exponent);
+    if (e >= 100) {
+      *out++ = static_cast<char>('0' + e / 100);
+      e %= 100;
+    }
+    *out++ = static_cast<char>('0' + e / 10);
+    *out++ = static_cast<char>('0' + e % 10);
+  } else if (exponent < 0) {
+    *out++ = '0';
+    *out++ = '.';
+    for (int i = -1; i > exponent; --i)
+      *out++ = '0';
+    memcpy(out, digits, static_cast<size_t>(significant));
+    out += significant;
+  } else {
+    int const integral = exponent + 1;
+    if (significant <= integral) {
+      memcpy(out, digits, static_cast<size_t>(significant));
+      out += significant;
+      for (int i = significant; i < integral; ++i)
+        *out++ = '0';
+    } else {
+      memcpy(out, digits, static_cast<size_t>(integral));
+      out += integral;
+      *out++ = '.';
+      memcpy(out, digits + integral, static_cast<size_t>(significant - integral));
+      out += significant - integral;
+    }
+  }
+  *out = 0;
+  return static_cast<int>(out - buffer);
+}
+
+/// Converts a JSON number token with a single correctly rounded operation
+/// when that is exact (Clinger's fast path): at most 19 significant digits
+/// that fit in 53 bits, and a power of ten that is itself exact.
+/// Returns false for anything else, leaving it to the C library.
+static bool parseDoubleFast(char const* begin, char const* end,
+                            double& result) {
+  static double const kExactPowersOfTen[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  uint64_t const kMaxExactMantissa = uint64_t(1) << 53;
+
+  char const* p = begin;
+  bool const isNegative = p != end && *p == '-';
+  if (isNegative)
+    ++p;
+  uint64_t mantissa = 0;
+  int digits = 0; // significant digits in mantissa
+  int exponent = 0;
+  char const* const integerBegin = p;
+  for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+    if (digits == 0 && *p == '0')
+      continue;
+    if (digits == 19)
+      return false;
+    mantissa = mantissa * 10 + static_cast<unsigned int>(*p - '0');
+    ++digits;
+  }
+  if (p == integerBegin)
+    return false;
+  if (p != end && *p == '.') {
+    char const* const fractionBegin = ++p;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+      --exponent;
+      if (digits == 0 && *p == '0')
+        continue;
+      if (digits == 19)
+        return false;
+      mantissa = mantissa * 10 + static_cast<unsigned int>(*p - '0');
+      ++digits;
+    }
+    if (p == fractionBegin)
+      return false;
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool const isNegativeExponent = p != end && *p == '-';
+    if (p != end && (*p == '+' || *p == '-'))
+      ++p;
+    char const* const exponentBegin = p;
+    int value = 0;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+      if (value >= 100000)
+        return false;
+      value = value * 10 + (*p - '0');
+    }
+    if (p == exponentBegin)
+      return false;
+    exponent += isNegativeExponent ? -value : value;
+  }
+  if (p != end || mantissa > kMaxExactMantissa)
+    return false;
+
+  if (mantissa == 0) {
+    result = isNegative ? -0.0 : 0.0;
+    return true;
+  }
+  // 15e30 == 15000000e24: move what does not fit into the mantissa.
+  while (exponent > 22 && mantissa * 10 <= kMaxExactMantissa) {
+    mantissa *= 10;
+    --exponent;
+  }
+  if (exponent > 22 || exponent < -22)
+    return false;
+  double value = static_cast<double>(mantissa);
+  if (exponent < 0)
+    value /= kExactPowersOfTen[-exponent];
+  else
+    value *= kExactPowersOfTen[exponent];
+  result = isNegative ? -value : value;
+  return true;
+}
+
+#endif // if JSON_USE_FAST_NUMBERS
+
 } // namespace Json {
 
 #endif // LIB_JSONCPP_JSON_TOOL_H_INCLUDED
@@ -222,6 +759,7 @@ static inline void fixNumericLocaleInput(char* begin, char* end) {
 #include <json/value.h>
 #include "json_tool.h"
 #endif // if !defined(JSON_IS_AMALGAMATION)
+#include <algorithm>
 #include <utility>
 #include <cstdio>
 #include <cassert>
@@ -231,6 +769,7 @@ static inline void fixNumericLocaleInput(char* begin, char* end) {
 #include <memory>
 #include <set>
 #include <limits>
+#include <cmath>
 
 #if defined(_MSC_VER)
 #if !defined(WINCE) && defined(__STDC_SECURE_LIB__) && _MSC_VER >= 1500 // VC++ 9.0 and above 
@@ -663,6 +1202,9 @@ void Reader::readNumber() {
 bool Reader::readString() {
   Char c = '\0';
   while (current_ != end_) {
+    current_ = findQuoteOrBackslash(current_, end_);
+    if (current_ == end_)
+      break;
     c = getNextChar();
     if (c == '\\')
       getNextChar();
@@ -830,6 +1372,12 @@ bool Reader::decodeDouble(Token& token) {
 
 bool Reader::decodeDouble(Token& token, Value& decoded) {
   double value = 0;
+#if JSON_USE_FAST_NUMBERS
+  if (parseDoubleFast(token.start_, token.end_, value)) {
+    decoded = value;
+    return true;
+  }
+#endif
   JSONCPP_STRING buffer(token.start_, token.end_);
   JSONCPP_ISTRINGSTREAM is(buffer);
   if (!(is >> value))
@@ -856,6 +1404,11 @@ bool Reader::decodeString(Token& token, JSONCPP_STRING& decoded) {
   Location current = token.start_ + 1; // skip '"'
   Location end = token.end_ - 1;       // do not include '"'
   while (current != end) {
+    Location const run = findQuoteOrBackslash(current, end);
+    decoded.append(current, run);
+    if (run == end)
+      break;
+    current = run;
     Char c = *current++;
     if (c == '"')
       break;
@@ -897,8 +1450,6 @@ bool Reader::decodeString(Token& token, JSONCPP_STRING& decoded) {
       default:
         return addError("Bad escape sequence in string", token, current);
       }
-    } else {
-      decoded += c;
     }
   }
   return true;
@@ -1140,7 +1691,7 @@ public:
     JSONCPP_STRING message;
   };
 
-  OurReader(OurFeatures const& features);
+  OurReader(OurFeatures const& features, Arena* arena = 0);
   bool parse(const char* beginDoc,
              const char* endDoc,
              Value& root,
@@ -1230,6 +1781,7 @@ private:
   JSONCPP_STRING getLocationLineAndColumn(Location location) const;
   void addComment(Location begin, Location end, CommentPlacement placement);
   void skipCommentTokens(Token& token);
+  void initContainer(Value& init, ValueType type);
 
   typedef std::stack<Value*> Nodes;
   Nodes nodes_;
@@ -1241,17 +1793,32 @@ private:
   Location lastValueEnd_;
   Value* lastValue_;
   JSONCPP_STRING commentsBefore_;
+  JSONCPP_STRING stringBuffer_;  // reused by zero-copy decodeString()
 
   OurFeatures const features_;
   bool collectComments_;
+  Arena* arena_;  // not owned; non-null in zero-copy mode
 };  // OurReader
 
 // complete copy of Read impl, for OurReader
 
-OurReader::OurReader(OurFeatures const& features)
+OurReader::OurReader(OurFeatures const& features, Arena* arena)
     : errors_(), document_(), begin_(), end_(), current_(), lastValueEnd_(),
-      lastValue_(), commentsBefore_(),
-      features_(features), collectComments_() {
+      lastValue_(), commentsBefore_(), stringBuffer_(),
+      features_(features), collectComments_(), arena_(arena) {
+}
+
+void OurReader::initContainer(Value& init, ValueType type) {
+  if (arena_) {
+    init.initArenaContainer(type, arena_);
+  } else {
+    Value container(type);
+    init.swapPayload(container);
+  }
+}
+
+static bool hasEscape(char const* begin, char const* end) {
+  return memchr(begin, '\\', static_cast<size_t>(end - begin)) != NULL;
 }
 
 bool OurReader::parse(const char* beginDoc,
@@ -1623,6 +2190,9 @@ bool OurReader::readNumber(bool checkInf) {
 bool OurReader::readString() {
   Char c = 0;
   while (current_ != end_) {
+    current_ = findQuoteOrBackslash(current_, end_);
+    if (current_ == end_)
+      break;
     c = getNextChar();
     if (c == '\\')
       getNextChar();
@@ -1648,19 +2218,28 @@ bool OurReader::readStringSingleQuote() {
 bool OurReader::readObject(Token& tokenStart) {
   Token tokenName;
   JSONCPP_STRING name;
-  Value init(objectValue);
+  Value init;
+  initContainer(init, objectValue);
   currentValue().swapPayload(init);
   currentValue().setOffsetStart(tokenStart.start_ - begin_);
+  ptrdiff_t lastNameLength = 0;
   while (readToken(tokenName)) {
     bool initialTokenOk = true;
     while (tokenName.type_ == tokenComment && initialTokenOk)
       initialTokenOk = readToken(tokenName);
     if (!initialTokenOk)
       break;
-    if (tokenName.type_ == tokenObjectEnd && name.empty()) // empty object
+    if (tokenName.type_ == tokenObjectEnd && lastNameLength == 0) // empty object
       return true;
     name.clear();
-    if (tokenName.type_ == tokenString) {
+    // In zero-copy mode a name without escapes is borrowed from the input.
+    Location nameBegin = 0;
+    Location nameEnd = 0;
+    if (tokenName.type_ == tokenString && arena_ &&
+        !hasEscape(tokenName.start_ + 1, tokenName.end_ - 1)) {
+      nameBegin = tokenName.start_ + 1;
+      nameEnd = tokenName.end_ - 1;
+    } else if (tokenName.type_ == tokenString) {
       if (!decodeString(tokenName, name))
         return recoverFromError(tokenObjectEnd);
     } else if (tokenName.type_ == tokenNumber && features_.allowNumericKeys_) {
@@ -1671,19 +2250,38 @@ bool OurReader::readObject(Token& tokenStart) {
     } else {
       break;
     }
+    if (!nameBegin) {
+      nameBegin = name.data();
+      nameEnd = nameBegin + name.length();
+    }
+    lastNameLength = nameEnd - nameBegin;
 
     Token colon;
     if (!readToken(colon) || colon.type_ != tokenMemberSeparator) {
       return addErrorAndRecover(
           "Missing ':' after object member name", colon, tokenObjectEnd);
     }
-    if (name.length() >= (1U<<30)) throwRuntimeError("keylength >= 2^30");
-    if (features_.rejectDupKeys_ && currentValue().isMember(name)) {
-      JSONCPP_STRING msg = "Duplicate key: '" + name + "'";
+    if (nameEnd - nameBegin >= static_cast<ptrdiff_t>(1U<<30))
+      throwRuntimeError("keylength >= 2^30");
+    if (features_.rejectDupKeys_ && currentValue().isMember(nameBegin, nameEnd)) {
+      JSONCPP_STRING msg = "Duplicate key: '" + JSONCPP_STRING(nameBegin, nameEnd) + "'";
       return addErrorAndRecover(
           msg, tokenName, tokenObjectEnd);
     }
-    Value& value = currentValue()[name];
+    Value* member;
+    if (arena_) {
+      if (nameBegin == name.data()) {
+        // Decoded name: keep a copy next to the tree it belongs to.
+        char* copy = static_cast<char*>(arena_->allocate(name.length()));
+        memcpy(copy, name.data(), name.length());
+        nameBegin = copy;
+        nameEnd = copy + name.length();
+      }
+      member = &currentValue().resolveBorrowedReference(nameBegin, nameEnd);
+    } else {
+      member = &currentValue()[name];
+    }
+    Value& value = *member;
     nodes_.push(&value);
     bool ok = readValue();
     nodes_.pop();
@@ -1708,7 +2306,8 @@ bool OurReader::readObject(Token& tokenStart) {
 }
 
 bool OurReader::readArray(Token& tokenStart) {
-  Value init(arrayValue);
+  Value init;
+  initContainer(init, arrayValue);
   currentValue().swapPayload(init);
   currentValue().setOffsetStart(tokenStart.start_ - begin_);
   skipSpaces();
@@ -1807,6 +2406,12 @@ bool OurReader::decodeDouble(Token& token) {
 
 bool OurReader::decodeDouble(Token& token, Value& decoded) {
   double value = 0;
+#if JSON_USE_FAST_NUMBERS
+  if (parseDoubleFast(token.start_, token.end_, value)) {
+    decoded = value;
+    return true;
+  }
+#endif
   const int bufferSize = 32;
   int count;
   ptrdiff_t const length = token.end_ - token.start_;
@@ -1844,10 +2449,26 @@ bool OurReader::decodeDouble(Token& token, Value& decoded) {
 }
 
 bool OurReader::decodeString(Token& token) {
-  JSONCPP_STRING decoded_string;
-  if (!decodeString(token, decoded_string))
-    return false;
-  Value decoded(decoded_string);
+  Value decoded;
+  if (arena_) {
+    Location const begin = token.start_ + 1;
+    Location const end = token.end_ - 1;
+    if (!hasEscape(begin, end)) {
+      decoded.initArenaString(begin, end, arena_);
+    } else {
+      stringBuffer_.clear();
+      if (!decodeString(token, stringBuffer_))
+        return false;
+      decoded.initArenaString(stringBuffer_.data(),
+                              stringBuffer_.data() + stringBuffer_.length(),
+                              arena_);
+    }
+  } else {
+    JSONCPP_STRING decoded_string;
+    if (!decodeString(token, decoded_string))
+      return false;
+    Value(decoded_string).swapPayload(decoded);
+  }
   currentValue().swapPayload(decoded);
   currentValue().setOffsetStart(token.start_ - begin_);
   currentValue().setOffsetLimit(token.end_ - begin_);
@@ -1859,6 +2480,11 @@ bool OurReader::decodeString(Token& token, JSONCPP_STRING& decoded) {
   Location current = token.start_ + 1; // skip '"'
   Location end = token.end_ - 1;       // do not include '"'
   while (current != end) {
+    Location const run = findQuoteOrBackslash(current, end);
+    decoded.append(current, run);
+    if (run == end)
+      break;
+    current = run;
     Char c = *current++;
     if (c == '"')
       break;
@@ -1900,8 +2526,6 @@ bool OurReader::decodeString(Token& token, JSONCPP_STRING& decoded) {
       default:
         return addError("Bad escape sequence in string", token, current);
       }
-    } else {
-      decoded += c;
     }
   }
   return true;
@@ -2107,17 +2731,27 @@ bool OurReader::good() const {
 
 class OurCharReader : public CharReader {
   bool const collectComments_;
+  bool const zeroCopy_;
+  Arena arena_;
   OurReader reader_;
 public:
   OurCharReader(
     bool collectComments,
-    OurFeatures const& features)
+    OurFeatures const& features,
+    bool zeroCopy)
   : collectComments_(collectComments)
-  , reader_(features)
+  , zeroCopy_(zeroCopy)
+  , arena_()
+  , reader_(features, zeroCopy ? &arena_ : 0)
   {}
   bool parse(
       char const* beginDoc, char const* endDoc,
       Value* root, JSONCPP_STRING* errs) JSONCPP_OVERRIDE {
+    if (zeroCopy_) {
+      // The previous document may still be referenced by 'root'.
+      *root = Value();
+      arena_.clear();
+    }
     bool ok = reader_.parse(beginDoc, endDoc, *root, collectComments_);
     if (errs) {
       *errs = reader_.getFormattedErrorMessages();
@@ -2126,6 +2760,255 @@ public:
   }
 };
 
+/// Reads CBOR (RFC 7049) into a Value tree: definite and indefinite lengths,
+/// half/single/double floats; tags are skipped. Byte strings become string
+/// values and undefined becomes null. Map keys must be strings.
+class CborCharReader : public CharReader {
+  typedef char const* Location;
+  int const stackLimit_;
+  bool const failIfExtra_;
+  bool const rejectDupKeys_;
+  Location begin_;
+  Location end_;
+  Location current_;
+  Location errorLocation_;
+  JSONCPP_STRING error_;
+public:
+  CborCharReader(OurFeatures const& features)
+  : stackLimit_(features.stackLimit_)
+  , failIfExtra_(features.failIfExtra_)
+  , rejectDupKeys_(features.rejectDupKeys_)
+  , begin_(), end_(), current_(), errorLocation_(), error_()
+  {}
+  bool parse(
+      char const* beginDoc, char const* endDoc,
+      Value* root, JSONCPP_STRING* errs) JSONCPP_OVERRIDE {
+    begin_ = beginDoc;
+    end_ = endDoc;
+    current_ = begin_;
+    error_.clear();
+    *root = Value();
+    bool ok = readValue(*root, 0);
+    if (ok && failIfExtra_ && current_ != end_)
+      ok = addError("Extra data after the CBOR data item", current_);
+    if (errs) {
+      *errs = ok ? JSONCPP_STRING() : getFormattedErrorMessages();
+    }
+    return ok;
+  }
+private:
+  enum { kIndefinite = 31 };
+
+  bool addError(const char* message, Location where) {
+    error_ = message;
+    errorLocation_ = where;
+    return false;
+  }
+  JSONCPP_STRING getFormattedErrorMessages() const {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "Offset %d",
+             static_cast<int>(errorLocation_ - begin_));
+    return "* " + JSONCPP_STRING(buffer) + "\n  " + error_ + "\n";
+  }
+
+  bool readHead(unsigned int& majorType, unsigned int& info,
+                uint64_t& argument) {
+    if (current_ == end_)
+      return addError("Unexpected end of input", current_);
+    Location const head = current_;
+    unsigned char const initial = static_cast<unsigned char>(*current_++);
+    majorType = initial >> 5;
+    info = initial & 0x1F;
+    if (info < 24 || info == kIndefinite) {
+      argument = info;
+      return true;
+    }
+    if (info > 27)
+      return addError("Reserved additional information value", head);
+    size_t const bytes = size_t(1) << (info - 24);
+    if (static_cast<size_t>(end_ - current_) < bytes)
+      return addError("Unexpected end of input", head);
+    argument = 0;
+    for (size_t i = 0; i < bytes; ++i)
+      argument = (argument << 8) | static_cast<unsigned char>(*current_++);
+    return true;
+  }
+
+  bool isBreak() const {
+    return current_ != end_ && static_cast<unsigned char>(*current_) == 0xFF;
+  }
+
+  // Appends a text or byte string whose head has been read.
+  bool readString(unsigned int majorType, unsigned int info,
+                  uint64_t length, JSONCPP_STRING& out) {
+    if (info != kIndefinite) {
+      if (static_cast<uint64_t>(end_ - current_) < length)
+        return addError("Unexpected end of input", current_);
+      out.append(current_, static_cast<size_t>(length));
+      current_ += length;
+      return true;
+    }
+    while (!isBreak()) {
+      Location const chunk = current_;
+      unsigned int chunkType, chunkInfo;
+      uint64_t chunkLength;
+      if (!readHead(chunkType, chunkInfo, chunkLength))
+        return false;
+      if (chunkType != majorType || chunkInfo == kIndefinite)
+        return addError("Bad chunk in indefinite-length string", chunk);
+      if (!readString(chunkType, chunkInfo, chunkLength, out))
+        return false;
+    }
+    ++current_; // break
+    return true;
+  }
+
+  bool readValue(Value& value, int depth) {
+    if (depth > stackLimit_)
+      throwRuntimeError("Exceeded stackLimit in readValue().");
+    Location const token = current_;
+    unsigned int majorType, info;
+    uint64_t argument;
+    if (!readHead(majorType, info, argument))
+      return false;
+    if (info == kIndefinite && (majorType < 2 || majorType == 6))
+      return addError("Unexpected indefinite length", token);
+
+    switch (majorType) {
+    case 0: // same integer types as Reader::decodeNumber()
+      if (argument <= static_cast<uint64_t>(Value::maxInt))
+        value = Value(static_cast<LargestInt>(argument));
+      else
+        value = Value(static_cast<LargestUInt>(argument));
+      return true;
+    case 1: // -1 - argument
+      if (argument <= static_cast<uint64_t>(Value::maxLargestInt))
+        value = Value(-1 - static_cast<LargestInt>(argument));
+      else
+        value = Value(-1.0 - static_cast<double>(argument));
+      return true;
+    case 2:
+    case 3: {
+      if (info != kIndefinite) {
+        if (static_cast<uint64_t>(end_ - current_) < argument)
+          return addError("Unexpected end of input", token);
+        Value(current_, current_ + argument).swapPayload(value);
+        current_ += argument;
+        return true;
+      }
+      JSONCPP_STRING decoded;
+      if (!readString(majorType, info, argument, decoded))
+        return false;
+      Value(decoded.data(), decoded.data() + decoded.length())
+          .swapPayload(value);
+      return true;
+    }
+    case 4: {
+      Value init(arrayValue);
+      value.swapPayload(init);
+      // Every element takes at least one byte.
+      if (info != kIndefinite &&
+          argument > static_cast<uint64_t>(end_ - current_))
+        return addError("Unexpected end of input", token);
+      for (uint64_t index = 0; info == kIndefinite ? !isBreak()
+                                                   : index < argument;
+           ++index) {
+        if (!readValue(value.append(Value()), depth + 1))
+          return false;
+      }
+      if (info == kIndefinite)
+        return current_ != end_ ? (++current_, true)
+                                : addError("Unexpected end of input", token);
+      return true;
+    }
+    case 5: {
+      Value init(objectValue);
+      value.swapPayload(init);
+      if (info != kIndefinite &&
+          argument > static_cast<uint64_t>(end_ - current_) / 2)
+        return addError("Unexpected end of input", token);
+      JSONCPP_STRING name;
+      for (uint64_t index = 0; info == kIndefinite ? !isBreak()
+                                                   : index < argument;
+           ++index) {
+        Location const key = current_;
+        unsigned int keyType, keyInfo;
+        uint64_t keyLength;
+        if (!readHead(keyType, keyInfo, keyLength))
+          return false;
+        if (keyType != 2 && keyType != 3)
+          return addError("Object member name must be a string", key);
+        name.clear();
+        if (!readString(keyType, keyInfo, keyLength, name))
+          return false;
+        if (name.length() >= (1U << 30))
+          throwRuntimeError("keylength >= 2^30");
+        if (rejectDupKeys_ && value.isMember(name.data(),
+                                             name.data() + name.length()))
+          return addError("Duplicate key", key);
+        if (!readValue(value[name], depth + 1))
+          return false;
+      }
+      if (info == kIndefinite)
+        return current_ != end_ ? (++current_, true)
+                                : addError("Unexpected end of input", token);
+      return true;
+    }
+    case 6: // tag: keep the tagged item only
+      return readValue(value, depth + 1);
+    default:
+      break;
+    }
+
+    // major type 7
+    switch (info) {
+    case 20:
+      value = false;
+      return true;
+    case 21:
+      value = true;
+      return true;
+    case 22: // null
+    case 23: // undefined
+      value = Value();
+      return true;
+    case 25: { // IEEE 754 half precision
+      unsigned int const half = static_cast<unsigned int>(argument);
+      unsigned int const exponent = (half >> 10) & 0x1F;
+      unsigned int const mantissa = half & 0x3FF;
+      double d;
+      if (exponent == 0)
+        d = ldexp(static_cast<double>(mantissa), -24);
+      else if (exponent != 31)
+        d = ldexp(static_cast<double>(mantissa + 1024),
+                  static_cast<int>(exponent) - 25);
+      else
+        d = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                          : std::numeric_limits<double>::quiet_NaN();
+      value = (half & 0x8000) ? -d : d;
+      return true;
+    }
+    case 26: {
+      uint32_t const bits = static_cast<uint32_t>(argument);
+      float f;
+      memcpy(&f, &bits, sizeof(f));
+      value = static_cast<double>(f);
+      return true;
+    }
+    case 27: {
+      double d;
+      memcpy(&d, &argument, sizeof(d));
+      value = d;
+      return true;
+    }
+    case kIndefinite:
+      return addError("Unexpected break", token);
+    default:
+      return addError("Unsupported simple value", token);
+    }
+  }
+};
+
 CharReaderBuilder::CharReaderBuilder()
 {
   setDefaults(&settings_);
@@ -2145,7 +3028,14 @@ CharReader* CharReaderBuilder::newCharReader() const
   features.failIfExtra_ = settings_["failIfExtra"].asBool();
   features.rejectDupKeys_ = settings_["rejectDupKeys"].asBool();
   features.allowSpecialFloats_ = settings_["allowSpecialFloats"].asBool();
-  return new OurCharReader(collectComments, features);
+  JSONCPP_STRING format = settings_["format"].asString();
+  if (format == "cbor") {
+    return new CborCharReader(features);
+  } else if (format != "json") {
+    throwRuntimeError("format must be 'json' or 'cbor'");
+  }
+  bool zeroCopy = settings_["zeroCopy"].asBool();
+  return new OurCharReader(collectComments, features, zeroCopy);
 }
 static void getValidReaderKeys(std::set<JSONCPP_STRING>* valid_keys)
 {
@@ -2160,6 +3050,8 @@ static void getValidReaderKeys(std::set<JSONCPP_STRING>* valid_keys)
   valid_keys->insert("failIfExtra");
   valid_keys->insert("rejectDupKeys");
   valid_keys->insert("allowSpecialFloats");
+  valid_keys->insert("zeroCopy");
+  valid_keys->insert("format");
 }
 bool CharReaderBuilder::validate(Json::Value* invalid) const
 {
@@ -2176,75 +3068,1395 @@ bool CharReaderBuilder::validate(Json::Value* invalid) const
       inv[key] = settings_[key];
     }
   }
-  return 0u == inv.size();
+  return 0u == inv.size();
+}
+Value& CharReaderBuilder::operator[](JSONCPP_STRING key)
+{
+  return settings_[key];
+}
+// static
+void CharReaderBuilder::strictMode(Json::Value* settings)
+{
+//! [CharReaderBuilderStrictMode]
+  (*settings)["allowComments"] = false;
+  (*settings)["strictRoot"] = true;
+  (*settings)["allowDroppedNullPlaceholders"] = false;
+  (*settings)["allowNumericKeys"] = false;
+  (*settings)["allowSingleQuotes"] = false;
+  (*settings)["stackLimit"] = 1000;
+  (*settings)["failIfExtra"] = true;
+  (*settings)["rejectDupKeys"] = true;
+  (*settings)["allowSpecialFloats"] = false;
+//! [CharReaderBuilderStrictMode]
+}
+// static
+void CharReaderBuilder::setDefaults(Json::Value* settings)
+{
+//! [CharReaderBuilderDefaults]
+  (*settings)["collectComments"] = true;
+  (*settings)["allowComments"] = true;
+  (*settings)["strictRoot"] = false;
+  (*settings)["allowDroppedNullPlaceholders"] = false;
+  (*settings)["allowNumericKeys"] = false;
+  (*settings)["allowSingleQuotes"] = false;
+  (*settings)["stackLimit"] = 1000;
+  (*settings)["failIfExtra"] = false;
+  (*settings)["rejectDupKeys"] = false;
+  (*settings)["allowSpecialFloats"] = false;
+  (*settings)["zeroCopy"] = false;
+  (*settings)["format"] = "json";
+//! [CharReaderBuilderDefaults]
+}
+
+//////////////////////////////////
+// global functions
+
+bool parseFromStream(
+    CharReader::Factory const& fact, JSONCPP_ISTREAM& sin,
+    Value* root, JSONCPP_STRING* errs)
+{
+  JSONCPP_OSTRINGSTREAM ssin;
+  ssin << sin.rdbuf();
+  JSONCPP_STRING doc = ssin.str();
+  char const* begin = doc.data();
+  char const* end = begin + doc.size();
+  // Note that we do not actually need a null-terminator.
+  CharReaderPtr const reader(fact.newCharReader());
+  return reader->parse(begin, end, root, errs);
+}
+
+JSONCPP_ISTREAM& operator>>(JSONCPP_ISTREAM& sin, Value& root) {
+  CharReaderBuilder b;
+  JSONCPP_STRING errs;
+  bool ok = parseFromStream(b, sin, &root, &errs);
+  if (!ok) {
+    fprintf(stderr,
+            "Error from reader: %s",
+            errs.c_str());
+
+    throwRuntimeError(errs);
+  }
+  return sin;
+}
+
+// Class SaxHandler
+// //////////////////////////////////////////////////////////////////
+
+SaxHandler::~SaxHandler() {}
+bool SaxHandler::onStartObject() { return true; }
+bool SaxHandler::onEndObject() { return true; }
+bool SaxHandler::onStartArray() { return true; }
+bool SaxHandler::onEndArray() { return true; }
+bool SaxHandler::onKey(char const*, char const*) { return true; }
+bool SaxHandler::onNull() { return true; }
+bool SaxHandler::onBool(bool) { return true; }
+bool SaxHandler::onInt(LargestInt) { return true; }
+bool SaxHandler::onUInt(LargestUInt) { return true; }
+bool SaxHandler::onDouble(double) { return true; }
+bool SaxHandler::onString(char const*, char const*) { return true; }
+
+// Class SaxReader
+// //////////////////////////////////////////////////////////////////
+
+static char const kSaxAborted[] = "Aborted by handler.";
+
+// Decodes the escape sequences of the string contents [begin, end) into
+// decoded. Returns NULL on success, else an error message about 'where'.
+static char const* decodeJsonString(char const* begin,
+                                    char const* end,
+                                    JSONCPP_STRING& decoded,
+                                    char const*& where) {
+  decoded.clear();
+  decoded.reserve(static_cast<size_t>(end - begin));
+  for (char const* p = begin; p != end;) {
+    char const* const run = findQuoteOrBackslash(p, end);
+    decoded.append(p, run);
+    if (run == end)
+      break;
+    p = run + 1; // skip '\\'; any '"' before 'end' is escaped
+    char const escape = *p++;
+    switch (escape) {
+    case '"':
+      decoded += '"';
+      break;
+    case '/':
+      decoded += '/';
+      break;
+    case '\\':
+      decoded += '\\';
+      break;
+    case 'b':
+      decoded += '\b';
+      break;
+    case 'f':
+      decoded += '\f';
+      break;
+    case 'n':
+      decoded += '\n';
+      break;
+    case 'r':
+      decoded += '\r';
+      break;
+    case 't':
+      decoded += '\t';
+      break;
+    case 'u': {
+      unsigned int unicode = 0;
+      for (int half = 0; half < 2; ++half) {
+        where = p;
+        if (end - p < 4)
+          return "Bad unicode escape sequence in string: four digits expected.";
+        unsigned int unit = 0;
+        for (int index = 0; index < 4; ++index) {
+          char const h = *p++;
+          unit *= 16;
+          if (h >= '0' && h <= '9')
+            unit += static_cast<unsigned int>(h - '0');
+          else if (h >= 'a' && h <= 'f')
+            unit += static_cast<unsigned int>(h - 'a' + 10);
+          else if (h >= 'A' && h <= 'F')
+            unit += static_cast<unsigned int>(h - 'A' + 10);
+          else {
+            where = p;
+            return "Bad unicode escape sequence in string: hexadecimal "
+                   "digit expected.";
+          }
+        }
+        if (half == 1) {
+          unicode = 0x10000 + ((unicode & 0x3FF) << 10) + (unit & 0x3FF);
+          break;
+        }
+        unicode = unit;
+        if (unicode < 0xD800 || unicode > 0xDBFF)
+          break;
+        // surrogate pairs
+        if (end - p < 6 || p[0] != '\\' || p[1] != 'u') {
+          where = p;
+          return "expecting another \\u token to begin the second half "
+                 "of a unicode surrogate pair";
+        }
+        p += 2;
+      }
+      decoded += codePointToUTF8(unicode);
+    } break;
+    default:
+      where = p - 1;
+      return "Bad escape sequence in string";
+    }
+  }
+  return NULL;
+}
+
+// Returns the end of the number that starts at begin, or begin if there is
+// none. Lenient about empty fractions and exponents, like Reader.
+static char const* scanNumber(char const* begin, char const* end) {
+  char const* current = begin;
+  if (current != end && *current == '-')
+    ++current;
+  char const* const digits = current;
+  while (current != end && *current >= '0' && *current <= '9')
+    ++current;
+  if (current == digits)
+    return begin;
+  if (current != end && *current == '.') {
+    ++current;
+    while (current != end && *current >= '0' && *current <= '9')
+      ++current;
+  }
+  if (current != end && (*current == 'e' || *current == 'E')) {
+    ++current;
+    if (current != end && (*current == '+' || *current == '-'))
+      ++current;
+    while (current != end && *current >= '0' && *current <= '9')
+      ++current;
+  }
+  return current;
+}
+
+// Reports the number [begin, end), as delimited by scanNumber(), to handler.
+// Returns NULL on success, else an error message about 'begin'.
+static char const* dispatchNumber(char const* begin,
+                                  char const* end,
+                                  SaxHandler& handler) {
+  bool const isNegative = *begin == '-';
+  char const* const digits = isNegative ? begin + 1 : begin;
+  char const* last = digits;
+  while (last != end && *last >= '0' && *last <= '9')
+    ++last;
+
+  if (last == end) {
+    // Same classification as Reader::decodeNumber().
+    Value::LargestUInt maxIntegerValue =
+        isNegative ? Value::LargestUInt(Value::maxLargestInt) + 1
+                   : Value::maxLargestUInt;
+    Value::LargestUInt threshold = maxIntegerValue / 10;
+    Value::LargestUInt value = 0;
+    char const* p = digits;
+    for (; p != end; ++p) {
+      Value::UInt digit(static_cast<Value::UInt>(*p - '0'));
+      if (value >= threshold &&
+          (value > threshold || p + 1 != end ||
+           digit > maxIntegerValue % 10))
+        break;
+      value = value * 10 + digit;
+    }
+    if (p == end) {
+      bool ok;
+      if (isNegative && value == maxIntegerValue)
+        ok = handler.onInt(Value::minLargestInt);
+      else if (isNegative)
+        ok = handler.onInt(-Value::LargestInt(value));
+      else if (value <= Value::LargestUInt(Value::maxInt))
+        ok = handler.onInt(Value::LargestInt(value));
+      else
+        ok = handler.onUInt(value);
+      return ok ? NULL : kSaxAborted;
+    }
+    // Too large for an integer: fall back to double, like Reader.
+  }
+
+  double value = 0;
+#if JSON_USE_FAST_NUMBERS
+  if (parseDoubleFast(begin, end, value))
+    return handler.onDouble(value) ? NULL : kSaxAborted;
+#endif
+  JSONCPP_STRING buffer(begin, end);
+  JSONCPP_ISTRINGSTREAM is(buffer);
+  if (!(is >> value))
+    return "Invalid number.";
+  return handler.onDouble(value) ? NULL : kSaxAborted;
+}
+
+// Formats message about location in [begin, end) the same way as Reader.
+static JSONCPP_STRING formatErrorMessage(char const* begin,
+                                         char const* end,
+                                         char const* location,
+                                         JSONCPP_STRING const& message) {
+  // column & line start at 1, as in Reader
+  int line = 1;
+  char const* lastLineStart = begin;
+  for (char const* current = begin; current < location && current != end;) {
+    char const c = *current++;
+    if (c == '\n' || (c == '\r' && (current == end || *current != '\n'))) {
+      lastLineStart = current;
+      ++line;
+    }
+  }
+  char buffer[18 + 16 + 16 + 1];
+  snprintf(buffer, sizeof(buffer), "Line %d, Column %d", line,
+           int(location - lastLineStart) + 1);
+  return "* " + JSONCPP_STRING(buffer) + "\n  " + message + "\n";
+}
+
+SaxReader::SaxReader()
+    : containers_(), scratch_(), error_(), begin_(), end_(), current_(),
+      errorOffset_(-1), stackLimit_(stackLimit_g),
+      features_(Features::all()) {}
+
+SaxReader::SaxReader(const Features& features)
+    : containers_(), scratch_(), error_(), begin_(), end_(), current_(),
+      errorOffset_(-1), stackLimit_(stackLimit_g), features_(features) {}
+
+bool SaxReader::parse(const char* beginDoc,
+                      const char* endDoc,
+                      SaxHandler& handler) {
+  begin_ = beginDoc;
+  end_ = endDoc;
+  current_ = begin_;
+  containers_.clear();
+  error_.clear();
+  errorOffset_ = -1;
+
+  if (!skipSpacesAndComments())
+    return false;
+  if (features_.strictRoot_ &&
+      (current_ == end_ || (*current_ != '{' && *current_ != '['))) {
+    return fail(
+        "A valid JSON document must be either an array or an object value.",
+        current_);
+  }
+
+  // Iterative rather than recursive: the only per-level state is the kind
+  // of container, kept in containers_.
+  bool needValue = true;
+  for (;;) {
+    if (needValue) {
+      if (!skipSpacesAndComments())
+        return false;
+      char const open = current_ != end_ ? *current_ : 0;
+      if (open == '{' || open == '[') {
+        if (containers_.size() >= stackLimit_)
+          return fail("Exceeded stackLimit in SaxReader::parse().", current_);
+        Location token = current_++;
+        if (!(open == '{' ? handler.onStartObject() : handler.onStartArray()))
+          return fail(kSaxAborted, token);
+        if (!skipSpacesAndComments())
+          return false;
+        char const close = open == '{' ? '}' : ']';
+        if (current_ != end_ && *current_ == close) {
+          token = current_++;
+          if (!(close == '}' ? handler.onEndObject() : handler.onEndArray()))
+            return fail(kSaxAborted, token);
+        } else {
+          containers_.push_back(open);
+          if (open == '{' && !readKey(handler))
+            return false;
+          continue;
+        }
+      } else if (!readValue(handler)) {
+        return false;
+      }
+    }
+
+    // A complete value has just been read.
+    if (containers_.empty())
+      break;
+    if (!skipSpacesAndComments())
+      return false;
+    char const open = containers_.back();
+    char const close = open == '{' ? '}' : ']';
+    Location const token = current_;
+    char const c = current_ != end_ ? *current_++ : 0;
+    if (c == ',') {
+      if (open == '{' && !readKey(handler))
+        return false;
+      needValue = true;
+    } else if (c == close) {
+      containers_.pop_back();
+      if (!(close == '}' ? handler.onEndObject() : handler.onEndArray()))
+        return fail(kSaxAborted, token);
+      needValue = false;
+    } else {
+      return fail(open == '{' ? "Missing ',' or '}' in object declaration"
+                              : "Missing ',' or ']' in array declaration",
+                  token);
+    }
+  }
+  return true;
+}
+
+bool SaxReader::readValue(SaxHandler& handler) {
+  Location const token = current_;
+  bool ok = true;
+  switch (current_ != end_ ? *current_ : 0) {
+  case '"': {
+    Location begin;
+    Location end;
+    if (!readString(begin, end))
+      return false;
+    ok = handler.onString(begin, end);
+  } break;
+  case '0':
+  case '1':
+  case '2':
+  case '3':
+  case '4':
+  case '5':
+  case '6':
+  case '7':
+  case '8':
+  case '9':
+  case '-':
+    return readNumber(handler);
+  case 't':
+    if (!match("true", 4))
+      return fail("Syntax error: value, object or array expected.", token);
+    ok = handler.onBool(true);
+    break;
+  case 'f':
+    if (!match("false", 5))
+      return fail("Syntax error: value, object or array expected.", token);
+    ok = handler.onBool(false);
+    break;
+  case 'n':
+    if (!match("null", 4))
+      return fail("Syntax error: value, object or array expected.", token);
+    ok = handler.onNull();
+    break;
+  case ',':
+  case ']':
+  case '}':
+    if (features_.allowDroppedNullPlaceholders_) {
+      // Leave the separator for the caller; report the missing value.
+      ok = handler.onNull();
+      break;
+    } // Else, fall through...
+  default:
+    return fail("Syntax error: value, object or array expected.", token);
+  }
+  return ok ? true : fail(kSaxAborted, token);
+}
+
+bool SaxReader::readKey(SaxHandler& handler) {
+  if (!skipSpacesAndComments())
+    return false;
+  Location const token = current_;
+  char const c = current_ != end_ ? *current_ : 0;
+  Location begin;
+  Location end;
+  if (c == '"') {
+    if (!readString(begin, end))
+      return false;
+  } else if (features_.allowNumericKeys_ && ((c >= '0' && c <= '9') || c == '-')) {
+    // Reported verbatim, as the text of the number.
+    begin = current_++;
+    while (current_ != end_ &&
+           ((*current_ >= '0' && *current_ <= '9') || *current_ == '.' ||
+            *current_ == 'e' || *current_ == 'E' || *current_ == '+' ||
+            *current_ == '-'))
+      ++current_;
+    end = current_;
+  } else {
+    return fail("Missing '}' or object member name", token);
+  }
+  if (end - begin >= static_cast<ptrdiff_t>(1U << 30))
+    return fail("keylength >= 2^30", token);
+  if (!handler.onKey(begin, end))
+    return fail(kSaxAborted, token);
+
+  if (!skipSpacesAndComments())
+    return false;
+  if (current_ == end_ || *current_ != ':')
+    return fail("Missing ':' after object member name", current_);
+  ++current_;
+  return true;
+}
+
+// On success, [begin, end) is the decoded string: a view into the document
+// if it has no escapes, otherwise scratch_.
+bool SaxReader::readString(Location& begin, Location& end) {
+  Location const token = current_++; // skip '"'
+  Location const first = current_;
+  bool escaped = false;
+  for (;;) {
+    current_ = findQuoteOrBackslash(current_, end_);
+    if (current_ == end_)
+      return fail("Missing '\"' at end of string", token);
+    char const c = *current_++;
+    if (c == '"')
+      break;
+    if (c == '\\') {
+      escaped = true;
+      if (current_ == end_)
+        return fail("Empty escape sequence in string", token);
+      ++current_;
+    }
+  }
+  Location const last = current_ - 1; // the closing '"'
+  if (!escaped) {
+    begin = first;
+    end = last;
+    return true;
+  }
+
+  Location where = first;
+  if (char const* message = decodeJsonString(first, last, scratch_, where))
+    return fail(message, where);
+  begin = scratch_.data();
+  end = begin + scratch_.length();
+  return true;
+}
+
+bool SaxReader::readNumber(SaxHandler& handler) {
+  Location const token = current_;
+  current_ = scanNumber(token, end_);
+  if (current_ == token)
+    return fail("Syntax error: value, object or array expected.", token);
+  char const* const message = dispatchNumber(token, current_, handler);
+  return message ? fail(message, token) : true;
+}
+
+bool SaxReader::skipSpacesAndComments() {
+  for (;;) {
+    while (current_ != end_ && (*current_ == ' ' || *current_ == '\t' ||
+                                *current_ == '\r' || *current_ == '\n'))
+      ++current_;
+    if (!features_.allowComments_ || current_ == end_ || *current_ != '/')
+      return true;
+    Location const token = current_++;
+    char const c = current_ != end_ ? *current_++ : 0;
+    if (c == '*') {
+      while (current_ != end_ && !(current_[0] == '*' && current_ + 1 != end_ &&
+                                   current_[1] == '/'))
+        ++current_;
+      if (current_ == end_)
+        return fail("Unterminated comment.", token);
+      current_ += 2;
+    } else if (c == '/') {
+      while (current_ != end_ && *current_ != '\n' && *current_ != '\r')
+        ++current_;
+    } else {
+      return fail("Syntax error: value, object or array expected.", token);
+    }
+  }
+}
+
+bool SaxReader::match(const char* pattern, int patternLength) {
+  if (end_ - current_ < patternLength)
+    return false;
+  if (memcmp(current_, pattern, static_cast<size_t>(patternLength)) != 0)
+    return false;
+  current_ += patternLength;
+  return true;
+}
+
+bool SaxReader::fail(const char* message, Location where) {
+  error_ = message;
+  errorOffset_ = where - begin_;
+  return false;
+}
+
+JSONCPP_STRING SaxReader::getFormattedErrorMessages() const {
+  if (errorOffset_ < 0)
+    return JSONCPP_STRING();
+  return formatErrorMessage(begin_, end_, begin_ + errorOffset_, error_);
+}
+
+// Class IncrementalReader
+// //////////////////////////////////////////////////////////////////
+
+static char const kStrictRoot[] =
+    "A valid JSON document must be either an array or an object value.";
+static char const kValueExpected[] =
+    "Syntax error: value, object or array expected.";
+static char const kTrue[] = "true";
+static char const kFalse[] = "false";
+static char const kNull[] = "null";
+
+IncrementalReader::IncrementalReader(SaxHandler& handler)
+    : handler_(handler), stackLimit_(stackLimit_g),
+      features_(Features::all()) {
+  reset();
+}
+
+IncrementalReader::IncrementalReader(SaxHandler& handler,
+                                     const Features& features)
+    : handler_(handler), stackLimit_(stackLimit_g), features_(features) {
+  reset();
+}
+
+void IncrementalReader::reset() {
+  containers_.clear();
+  pending_.clear();
+  error_.clear();
+  chunk_ = current_ = end_ = NULL;
+  literal_ = NULL;
+  consumed_ = tokenStart_ = 0;
+  errorOffset_ = -1;
+  lineStart_ = tokenLineStart_ = 0;
+  line_ = tokenLine_ = 1;
+  expect_ = expectValue;
+  token_ = tokenNone;
+  escaped_ = backslash_ = star_ = cr_ = false;
+}
+
+bool IncrementalReader::feed(const char* beginChunk, const char* endChunk) {
+  if (errorOffset_ >= 0)
+    return false;
+  chunk_ = current_ = beginChunk;
+  end_ = endChunk;
+  for (;;) {
+    if (token_ != tokenNone) {
+      if (!continueToken())
+        return false;
+      if (token_ != tokenNone)
+        break; // continues in the next chunk
+    }
+    while (current_ != end_ && (*current_ == ' ' || *current_ == '\t' ||
+                                *current_ == '\r' || *current_ == '\n'))
+      ++current_;
+    if (current_ == end_)
+      break;
+    if (expect_ == expectNothing) {
+      current_ = end_;
+      break;
+    }
+    if (!startToken())
+      return false;
+  }
+
+  // Keep what the next chunk needs, and count the lines of this one.
+  if (token_ != tokenNone && tokenStart_ >= consumed_) {
+    Location const tokenBegin = chunk_ + (tokenStart_ - consumed_);
+    advanceLines(chunk_, tokenBegin, consumed_);
+    tokenLine_ = line_;
+    tokenLineStart_ = lineStart_;
+    if (token_ == tokenString || token_ == tokenNumber)
+      pending_.assign(tokenBegin, end_);
+    advanceLines(tokenBegin, end_, tokenStart_);
+  } else {
+    if (token_ == tokenString || token_ == tokenNumber)
+      pending_.append(chunk_, end_);
+    advanceLines(chunk_, end_, consumed_);
+  }
+  consumed_ += end_ - chunk_;
+  chunk_ = current_ = end_ = NULL;
+  return true;
+}
+
+bool IncrementalReader::finish() {
+  if (errorOffset_ >= 0)
+    return false;
+  switch (token_) {
+  case tokenNone:
+  case tokenLineComment:
+    break;
+  case tokenString:
+    return fail(backslash_ ? "Empty escape sequence in string"
+                           : "Missing '\"' at end of string",
+                tokenStart_);
+  case tokenNumber:
+    token_ = tokenNone;
+    if (!endNumber(pending_.data(), pending_.data() + pending_.size()))
+      return false;
+    break;
+  case tokenLiteral:
+  case tokenCommentStart:
+    return fail(kValueExpected, tokenStart_);
+  case tokenBlockComment:
+    return fail("Unterminated comment.", tokenStart_);
+  }
+  token_ = tokenNone;
+  return expect_ == expectNothing ? true : failExpected(consumed_);
+}
+
+// Reads the structural character at current_, or the start of a token.
+bool IncrementalReader::startToken() {
+  char const c = *current_;
+  tokenStart_ = offsetOf(current_);
+  literal_ = NULL;
+  if (c == '/' && features_.allowComments_) {
+    ++current_;
+    token_ = tokenCommentStart;
+    return true;
+  }
+  switch (expect_) {
+  case expectColon:
+    if (c != ':')
+      return failExpected(tokenStart_);
+    ++current_;
+    expect_ = expectValue;
+    return true;
+  case expectCommaOrEnd:
+    if (c == ',') {
+      ++current_;
+      expect_ = containers_.back() == '{' ? expectKey : expectValue;
+      return true;
+    }
+    return endContainer(c);
+  case expectKeyOrEnd:
+    if (c == '}')
+      return endContainer(c);
+    // Else, fall through...
+  case expectKey:
+    if (c == '"')
+      break;
+    if (features_.allowNumericKeys_ && ((c >= '0' && c <= '9') || c == '-'))
+      break;
+    return failExpected(tokenStart_);
+  case expectValueOrEnd:
+    if (c == ']')
+      return endContainer(c);
+    // Else, fall through...
+  case expectValue:
+    if (containers_.empty() && features_.strictRoot_ && c != '{' && c != '[')
+      return fail(kStrictRoot, tokenStart_);
+    switch (c) {
+    case '{':
+    case '[':
+      if (containers_.size() >= stackLimit_)
+        return fail("Exceeded stackLimit in IncrementalReader::feed().",
+                    tokenStart_);
+      ++current_;
+      containers_.push_back(c);
+      if (!(c == '{' ? handler_.onStartObject() : handler_.onStartArray()))
+        return fail(kSaxAborted, tokenStart_);
+      expect_ = c == '{' ? expectKeyOrEnd : expectValueOrEnd;
+      return true;
+    case 't':
+      literal_ = kTrue + 1;
+      break;
+    case 'f':
+      literal_ = kFalse + 1;
+      break;
+    case 'n':
+      literal_ = kNull + 1;
+      break;
+    case ',':
+    case ']':
+    case '}':
+      if (features_.allowDroppedNullPlaceholders_) {
+        // Leave the separator for expectCommaOrEnd; report the missing value.
+        if (!handler_.onNull())
+          return fail(kSaxAborted, tokenStart_);
+        endValue();
+        return true;
+      }
+      return fail(kValueExpected, tokenStart_);
+    default:
+      if (c != '"' && c != '-' && (c < '0' || c > '9'))
+        return fail(kValueExpected, tokenStart_);
+    }
+    break;
+  case expectNothing:
+    break;
+  }
+
+  ++current_;
+  pending_.clear();
+  if (literal_)
+    token_ = tokenLiteral;
+  else if (c == '"') {
+    token_ = tokenString;
+    escaped_ = backslash_ = false;
+  } else
+    token_ = tokenNumber;
+  return true;
+}
+
+// Reads the rest of the current token, as far as the chunk goes.
+bool IncrementalReader::continueToken() {
+  switch (token_) {
+  case tokenNone:
+    break;
+  case tokenString:
+    for (;;) {
+      if (backslash_) {
+        if (current_ == end_)
+          return true;
+        ++current_;
+        backslash_ = false;
+      }
+      current_ = findQuoteOrBackslash(current_, end_);
+      if (current_ == end_)
+        return true;
+      if (*current_++ == '\\') {
+        escaped_ = backslash_ = true;
+        continue;
+      }
+      token_ = tokenNone;
+      if (tokenStart_ >= consumed_) // the whole string is in this chunk
+        return endString(chunk_ + (tokenStart_ - consumed_) + 1, current_ - 1);
+      pending_.append(chunk_, current_ - 1);
+      return endString(pending_.data() + 1, pending_.data() + pending_.size());
+    }
+  case tokenNumber:
+    while (current_ != end_ &&
+           ((*current_ >= '0' && *current_ <= '9') || *current_ == '.' ||
+            *current_ == 'e' || *current_ == 'E' || *current_ == '+' ||
+            *current_ == '-'))
+      ++current_;
+    if (current_ == end_)
+      return true;
+    token_ = tokenNone;
+    if (tokenStart_ >= consumed_)
+      return endNumber(chunk_ + (tokenStart_ - consumed_), current_);
+    pending_.append(chunk_, current_);
+    return endNumber(pending_.data(), pending_.data() + pending_.size());
+  case tokenLiteral:
+    for (; *literal_ && current_ != end_; ++literal_, ++current_) {
+      if (*current_ != *literal_)
+        return fail(kValueExpected, tokenStart_);
+    }
+    if (*literal_)
+      return true;
+    token_ = tokenNone;
+    {
+      bool const ok = literal_ == kNull + 4 ? handler_.onNull()
+                                            : handler_.onBool(literal_ == kTrue + 4);
+      if (!ok)
+        return fail(kSaxAborted, tokenStart_);
+    }
+    endValue();
+    return true;
+  case tokenCommentStart:
+    if (current_ == end_)
+      return true;
+    if (*current_ == '*')
+      token_ = tokenBlockComment;
+    else if (*current_ == '/')
+      token_ = tokenLineComment;
+    else
+      return fail(kValueExpected, tokenStart_);
+    ++current_;
+    star_ = false;
+    return continueToken();
+  case tokenBlockComment:
+    for (; current_ != end_; ++current_) {
+      if (star_ && *current_ == '/') {
+        ++current_;
+        token_ = tokenNone;
+        return true;
+      }
+      star_ = *current_ == '*';
+    }
+    return true;
+  case tokenLineComment:
+    while (current_ != end_ && *current_ != '\n' && *current_ != '\r')
+      ++current_;
+    if (current_ != end_)
+      token_ = tokenNone;
+    return true;
+  }
+  return true;
+}
+
+bool IncrementalReader::endString(Location begin, Location end) {
+  if (escaped_) {
+    Location where = begin;
+    if (char const* message = decodeJsonString(begin, end, scratch_, where))
+      return fail(message, tokenStart_ + 1 + (where - begin));
+    begin = scratch_.data();
+    end = begin + scratch_.length();
+  }
+  if (expect_ == expectValue || expect_ == expectValueOrEnd) {
+    if (!handler_.onString(begin, end))
+      return fail(kSaxAborted, tokenStart_);
+    endValue();
+    return true;
+  }
+  if (end - begin >= static_cast<ptrdiff_t>(1U << 30))
+    return fail("keylength >= 2^30", tokenStart_);
+  if (!handler_.onKey(begin, end))
+    return fail(kSaxAborted, tokenStart_);
+  expect_ = expectColon;
+  return true;
+}
+
+bool IncrementalReader::endNumber(Location begin, Location end) {
+  if (expect_ == expectKey || expect_ == expectKeyOrEnd) {
+    // Reported verbatim, as the text of the number.
+    if (!handler_.onKey(begin, end))
+      return fail(kSaxAborted, tokenStart_);
+    expect_ = expectColon;
+    return true;
+  }
+  Location const stop = scanNumber(begin, end);
+  if (stop == begin)
+    return fail(kValueExpected, tokenStart_);
+  if (char const* message = dispatchNumber(begin, stop, handler_))
+    return fail(message, tokenStart_);
+  endValue();
+  // Whatever follows the number cannot be a separator.
+  if (stop != end && expect_ != expectNothing)
+    return failExpected(tokenStart_ + (stop - begin));
+  return true;
+}
+
+bool IncrementalReader::endContainer(char close) {
+  char const open = containers_.back();
+  if (close != (open == '{' ? '}' : ']'))
+    return failExpected(tokenStart_);
+  ++current_;
+  containers_.pop_back();
+  if (!(close == '}' ? handler_.onEndObject() : handler_.onEndArray()))
+    return fail(kSaxAborted, tokenStart_);
+  endValue();
+  return true;
+}
+
+void IncrementalReader::endValue() {
+  expect_ = containers_.empty() ? expectNothing : expectCommaOrEnd;
+}
+
+// Fails with the same message as SaxReader for the current state.
+bool IncrementalReader::failExpected(ptrdiff_t offset) {
+  switch (expect_) {
+  case expectKey:
+  case expectKeyOrEnd:
+    return fail("Missing '}' or object member name", offset);
+  case expectColon:
+    return fail("Missing ':' after object member name", offset);
+  case expectCommaOrEnd:
+    return fail(containers_.back() == '{'
+                    ? "Missing ',' or '}' in object declaration"
+                    : "Missing ',' or ']' in array declaration",
+                offset);
+  default:
+    break;
+  }
+  if (containers_.empty() && features_.strictRoot_)
+    return fail(kStrictRoot, offset);
+  return fail(kValueExpected, offset);
+}
+
+bool IncrementalReader::fail(const char* message, ptrdiff_t offset) {
+  // The line counters are at the start of the chunk, or of the token when
+  // the error is in a part of it that came in earlier chunks.
+  if (offset >= consumed_) {
+    advanceLines(chunk_, chunk_ + (offset - consumed_), consumed_);
+  } else {
+    line_ = tokenLine_;
+    lineStart_ = tokenLineStart_;
+    cr_ = false;
+    advanceLines(pending_.data(), pending_.data() + (offset - tokenStart_),
+                 tokenStart_);
+  }
+  errorOffset_ = offset;
+  // column & line start at 1, as in Reader
+  char buffer[18 + 16 + 16 + 1];
+  snprintf(buffer, sizeof(buffer), "Line %d, Column %d", line_,
+           int(offset - lineStart_) + 1);
+  error_ = "* " + JSONCPP_STRING(buffer) + "\n  " + message + "\n";
+  return false;
+}
+
+// Counts the line breaks in [begin, end), which starts at 'offset'.
+void IncrementalReader::advanceLines(Location begin,
+                                     Location end,
+                                     ptrdiff_t offset) {
+  for (Location current = begin; current != end; ++current) {
+    char const c = *current;
+    if (c == '\n' || c == '\r') {
+      if (!(c == '\n' && cr_))
+        ++line_;
+      lineStart_ = offset + (current - begin) + 1;
+    }
+    cr_ = c == '\r';
+  }
+}
+
+// Class ValueBuilder
+// //////////////////////////////////////////////////////////////////
+
+ValueBuilder::ValueBuilder(Value& root) : root_(root), stack_(), key_() {}
+
+Value& ValueBuilder::next() {
+  if (stack_.empty())
+    return root_;
+  Value& top = *stack_.back();
+  if (top.type() == arrayValue)
+    return top.append(Value());
+  return top[key_];
+}
+
+bool ValueBuilder::onStartObject() {
+  Value& value = next();
+  value = Value(objectValue);
+  stack_.push_back(&value);
+  return true;
+}
+
+bool ValueBuilder::onEndObject() {
+  stack_.pop_back();
+  return true;
+}
+
+bool ValueBuilder::onStartArray() {
+  Value& value = next();
+  value = Value(arrayValue);
+  stack_.push_back(&value);
+  return true;
+}
+
+bool ValueBuilder::onEndArray() {
+  stack_.pop_back();
+  return true;
+}
+
+bool ValueBuilder::onKey(char const* begin, char const* end) {
+  key_.assign(begin, end);
+  return true;
+}
+
+bool ValueBuilder::onNull() {
+  next() = Value();
+  return true;
+}
+
+bool ValueBuilder::onBool(bool value) {
+  next() = Value(value);
+  return true;
+}
+
+bool ValueBuilder::onInt(LargestInt value) {
+  next() = Value(value);
+  return true;
+}
+
+bool ValueBuilder::onUInt(LargestUInt value) {
+  next() = Value(value);
+  return true;
+}
+
+bool ValueBuilder::onDouble(double value) {
+  next() = Value(value);
+  return true;
+}
+
+bool ValueBuilder::onString(char const* begin, char const* end) {
+  next() = Value(begin, end);
+  return true;
+}
+
+// Class LazyDocument
+// //////////////////////////////////////////////////////////////////
+
+static inline char const* skipJsonSpaces(char const* current,
+                                         char const* end) {
+  while (current != end && (*current == ' ' || *current == '\t' ||
+                            *current == '\r' || *current == '\n'))
+    ++current;
+  return current;
+}
+
+LazyDocument::LazyDocument()
+    : containers_(), scratch_(), error_(), begin_(), end_(),
+      errorOffset_(-1) {}
+
+bool LazyDocument::parse(const char* beginDoc, const char* endDoc) {
+  begin_ = beginDoc;
+  end_ = endDoc;
+  containers_.clear();
+  error_.clear();
+  errorOffset_ = -1;
+
+  // Same grammar and messages as SaxReader without comments, and the same
+  // loop; only the positions of containers are kept.
+  std::vector<size_t> open; // indexes in containers_ of the open containers
+  Location current = begin_;
+  bool needValue = true;
+  for (;;) {
+    if (needValue) {
+      current = skipJsonSpaces(current, end_);
+      char const c = current != end_ ? *current : 0;
+      if (c == '{' || c == '[') {
+        if (open.size() >= stackLimit_g)
+          return fail("Exceeded stackLimit in LazyDocument::parse().", current);
+        Container const container = {current, NULL, 0};
+        open.push_back(containers_.size());
+        containers_.push_back(container);
+        current = skipJsonSpaces(current + 1, end_);
+        if (current == end_ || *current != (c == '{' ? '}' : ']')) {
+          if (c == '{' && !(current = readKey(current)))
+            return false;
+          continue;
+        }
+        containers_.back().end = current++;
+        containers_.back().next = containers_.size();
+        open.pop_back();
+      } else if (!(current = readScalar(current))) {
+        return false;
+      }
+    }
+
+    // A complete value has just been read.
+    if (open.empty())
+      break;
+    current = skipJsonSpaces(current, end_);
+    Container& container = containers_[open.back()];
+    char const close = *container.begin == '{' ? '}' : ']';
+    Location const token = current;
+    char const c = current != end_ ? *current++ : 0;
+    if (c == ',') {
+      if (close == '}' && !(current = readKey(current)))
+        return false;
+      needValue = true;
+    } else if (c == close) {
+      container.end = token;
+      container.next = containers_.size();
+      open.pop_back();
+      needValue = false;
+    } else {
+      return fail(close == '}' ? "Missing ',' or '}' in object declaration"
+                               : "Missing ',' or ']' in array declaration",
+                  token);
+    }
+  }
+  return true;
+}
+
+// Checks the string at current; returns the end of it, or NULL.
+LazyDocument::Location LazyDocument::readString(Location current) {
+  Location const token = current++; // skip '"'
+  bool escaped = false;
+  for (;;) {
+    current = findQuoteOrBackslash(current, end_);
+    if (current == end_) {
+      fail("Missing '\"' at end of string", token);
+      return NULL;
+    }
+    if (*current++ == '"')
+      break;
+    escaped = true;
+    if (current == end_) {
+      fail("Empty escape sequence in string", token);
+      return NULL;
+    }
+    ++current;
+  }
+  Location where = token;
+  if (escaped) {
+    if (char const* message =
+            decodeJsonString(token + 1, current - 1, scratch_, where)) {
+      fail(message, where);
+      return NULL;
+    }
+  }
+  return current;
+}
+
+// Checks the member name and ':' at current; returns the end, or NULL.
+LazyDocument::Location LazyDocument::readKey(Location current) {
+  current = skipJsonSpaces(current, end_);
+  if (current == end_ || *current != '"') {
+    fail("Missing '}' or object member name", current);
+    return NULL;
+  }
+  if (!(current = readString(current)))
+    return NULL;
+  current = skipJsonSpaces(current, end_);
+  if (current == end_ || *current != ':') {
+    fail("Missing ':' after object member name", current);
+    return NULL;
+  }
+  return current + 1;
+}
+
+// Checks the string, number or literal at current; returns the end, or NULL.
+LazyDocument::Location LazyDocument::readScalar(Location current) {
+  char const c = current != end_ ? *current : 0;
+  if (c == '"')
+    return readString(current);
+  char const* message = kValueExpected;
+  if (c == '-' || (c >= '0' && c <= '9')) {
+    Location const end = scanNumber(current, end_);
+    // An exponent without digits is the only form SaxReader cannot convert.
+    message = end == current ? kValueExpected : "Invalid number.";
+    if (end != current && end[-1] != 'e' && end[-1] != 'E' &&
+        end[-1] != '+' && end[-1] != '-')
+      return end;
+  } else {
+    char const* const literal =
+        c == 't' ? kTrue : c == 'f' ? kFalse : c == 'n' ? kNull : NULL;
+    size_t const length = literal ? strlen(literal) : 0;
+    if (literal && static_cast<size_t>(end_ - current) >= length &&
+        memcmp(current, literal, length) == 0)
+      return current + length;
+  }
+  fail(message, current);
+  return NULL;
+}
+
+// Returns the end of the valid string at current.
+LazyDocument::Location LazyDocument::skipString(Location current,
+                                                bool& escaped) const {
+  ++current; // skip '"'
+  for (;;) {
+    current = findQuoteOrBackslash(current, end_);
+    if (*current++ == '"')
+      return current;
+    escaped = true;
+    ++current;
+  }
+}
+
+// Returns the end of the valid value at current. Advances container past
+// the containers it holds.
+LazyDocument::Location LazyDocument::skipValue(Location current,
+                                               size_t& container) const {
+  switch (*current) {
+  case '{':
+  case '[': {
+    Container const& skipped = containers_[container];
+    container = skipped.next;
+    return skipped.end + 1;
+  }
+  case '"': {
+    bool escaped = false;
+    return skipString(current, escaped);
+  }
+  default:
+    while (current != end_ && *current != ',' && *current != '}' &&
+           *current != ']' && *current != ' ' && *current != '\t' &&
+           *current != '\r' && *current != '\n')
+      ++current;
+    return current;
+  }
 }
-Value& CharReaderBuilder::operator[](JSONCPP_STRING key)
-{
-  return settings_[key];
+
+bool LazyDocument::fail(const char* message, Location where) {
+  error_ = message;
+  errorOffset_ = where - begin_;
+  containers_.clear();
+  return false;
 }
-// static
-void CharReaderBuilder::strictMode(Json::Value* settings)
-{
-//! [CharReaderBuilderStrictMode]
-  (*settings)["allowComments"] = false;
-  (*settings)["strictRoot"] = true;
-  (*settings)["allowDroppedNullPlaceholders"] = false;
-  (*settings)["allowNumericKeys"] = false;
-  (*settings)["allowSingleQuotes"] = false;
-  (*settings)["stackLimit"] = 1000;
-  (*settings)["failIfExtra"] = true;
-  (*settings)["rejectDupKeys"] = true;
-  (*settings)["allowSpecialFloats"] = false;
-//! [CharReaderBuilderStrictMode]
+
+LazyDocument::Node LazyDocument::root() const {
+  if (errorOffset_ >= 0 || !begin_)
+    return Node();
+  return Node(this, skipJsonSpaces(begin_, end_), 0);
 }
-// static
-void CharReaderBuilder::setDefaults(Json::Value* settings)
-{
-//! [CharReaderBuilderDefaults]
-  (*settings)["collectComments"] = true;
-  (*settings)["allowComments"] = true;
-  (*settings)["strictRoot"] = false;
-  (*settings)["allowDroppedNullPlaceholders"] = false;
-  (*settings)["allowNumericKeys"] = false;
-  (*settings)["allowSingleQuotes"] = false;
-  (*settings)["stackLimit"] = 1000;
-  (*settings)["failIfExtra"] = false;
-  (*settings)["rejectDupKeys"] = false;
-  (*settings)["allowSpecialFloats"] = false;
-//! [CharReaderBuilderDefaults]
+
+JSONCPP_STRING LazyDocument::getFormattedErrorMessages() const {
+  if (errorOffset_ < 0)
+    return JSONCPP_STRING();
+  return formatErrorMessage(begin_, end_, begin_ + errorOffset_, error_);
 }
 
-//////////////////////////////////
-// global functions
+// Class LazyDocument::Node
+// //////////////////////////////////////////////////////////////////
 
-bool parseFromStream(
-    CharReader::Factory const& fact, JSONCPP_ISTREAM& sin,
-    Value* root, JSONCPP_STRING* errs)
-{
-  JSONCPP_OSTRINGSTREAM ssin;
-  ssin << sin.rdbuf();
-  JSONCPP_STRING doc = ssin.str();
-  char const* begin = doc.data();
-  char const* end = begin + doc.size();
-  // Note that we do not actually need a null-terminator.
-  CharReaderPtr const reader(fact.newCharReader());
-  return reader->parse(begin, end, root, errs);
+LazyDocument::Node::Node() : document_(NULL), begin_(NULL), container_(0) {}
+
+LazyDocument::Node::Node(const LazyDocument* document,
+                         const char* begin,
+                         size_t container)
+    : document_(document), begin_(begin), container_(container) {}
+
+ValueType LazyDocument::Node::type() const {
+  switch (begin_ ? *begin_ : 'n') {
+  case '{':
+    return objectValue;
+  case '[':
+    return arrayValue;
+  case '"':
+    return stringValue;
+  case 't':
+  case 'f':
+    return booleanValue;
+  case 'n':
+    return nullValue;
+  default:
+    return decode().type();
+  }
 }
 
-JSONCPP_ISTREAM& operator>>(JSONCPP_ISTREAM& sin, Value& root) {
-  CharReaderBuilder b;
-  JSONCPP_STRING errs;
-  bool ok = parseFromStream(b, sin, &root, &errs);
-  if (!ok) {
-    fprintf(stderr,
-            "Error from reader: %s",
-            errs.c_str());
+LazyDocument::Node LazyDocument::Node::operator[](const char* key) const {
+  return find(key, key + strlen(key));
+}
 
-    throwRuntimeError(errs);
+LazyDocument::Node LazyDocument::Node::
+operator[](const JSONCPP_STRING& key) const {
+  return find(key.data(), key.data() + key.length());
+}
+
+LazyDocument::Node LazyDocument::Node::find(char const* begin,
+                                            char const* end) const {
+  if (!begin_ || *begin_ != '{')
+    return Node();
+  LazyDocument const& document = *document_;
+  Location const last = document.containers_[container_].end;
+  size_t child = container_ + 1; // next container in document order
+  Location current = begin_ + 1;
+  JSONCPP_STRING decoded;
+  Node match;
+  for (;;) {
+    current = skipJsonSpaces(current, last);
+    if (current == last)
+      return match;
+    Location const name = current;
+    bool escaped = false;
+    current = document.skipString(current, escaped);
+    bool found;
+    if (!escaped) {
+      found = current - name - 2 == end - begin &&
+              memcmp(name + 1, begin, static_cast<size_t>(end - begin)) == 0;
+    } else {
+      Location where = name;
+      decodeJsonString(name + 1, current - 1, decoded, where);
+      found = decoded.length() == static_cast<size_t>(end - begin) &&
+              memcmp(decoded.data(), begin, decoded.length()) == 0;
+    }
+    current = skipJsonSpaces(current, last) + 1; // skip ':'
+    current = skipJsonSpaces(current, last);
+    // Keep going: with duplicate names the last one wins, as in Reader.
+    if (found)
+      match = Node(document_, current, child);
+    current = skipJsonSpaces(document.skipValue(current, child), last);
+    if (*current == ',')
+      ++current;
   }
-  return sin;
 }
 
+LazyDocument::Node LazyDocument::Node::operator[](ArrayIndex index) const {
+  if (!begin_ || *begin_ != '[')
+    return Node();
+  LazyDocument const& document = *document_;
+  Location const last = document.containers_[container_].end;
+  size_t child = container_ + 1;
+  Location current = skipJsonSpaces(begin_ + 1, last);
+  for (ArrayIndex i = 0; current != last; ++i) {
+    if (i == index)
+      return Node(document_, current, child);
+    current = skipJsonSpaces(document.skipValue(current, child), last);
+    if (*current == ',')
+      current = skipJsonSpaces(current + 1, last);
+  }
+  return Node();
+}
+
+ArrayIndex LazyDocument::Node::size() const {
+  if (!begin_ || (*begin_ != '{' && *begin_ != '['))
+    return 0;
+  LazyDocument const& document = *document_;
+  Location const last = document.containers_[container_].end;
+  size_t child = container_ + 1;
+  Location current = skipJsonSpaces(begin_ + 1, last);
+  ArrayIndex count = 0;
+  std::vector<JSONCPP_STRING> names; // of an object, to count duplicates once
+  for (; current != last; ++count) {
+    if (*begin_ == '{') {
+      Location const name = current;
+      bool escaped = false;
+      current = document.skipString(current, escaped);
+      names.push_back(JSONCPP_STRING());
+      if (!escaped) {
+        names.back().assign(name + 1, current - 1);
+      } else {
+        Location where = name;
+        decodeJsonString(name + 1, current - 1, names.back(), where);
+      }
+      current = skipJsonSpaces(skipJsonSpaces(current, last) + 1, last);
+    }
+    current = skipJsonSpaces(document.skipValue(current, child), last);
+    if (*current == ',')
+      current = skipJsonSpaces(current + 1, last);
+  }
+  if (*begin_ == '{') {
+    std::sort(names.begin(), names.end());
+    count = static_cast<ArrayIndex>(
+        std::unique(names.begin(), names.end()) - names.begin());
+  }
+  return count;
+}
+
+Value LazyDocument::Node::decode() const {
+  Value value;
+  if (!begin_)
+    return value;
+  Features features = Features::strictMode();
+  features.strictRoot_ = false;
+  SaxReader reader(features);
+  ValueBuilder builder(value);
+  reader.parse(begin_, document_->end_, builder);
+  return value;
+}
+
+JSONCPP_STRING LazyDocument::Node::asString() const {
+  if (begin_ && *begin_ == '"') {
+    bool escaped = false;
+    Location const end = document_->skipString(begin_, escaped);
+    if (!escaped)
+      return JSONCPP_STRING(begin_ + 1, end - 1);
+  }
+  return decode().asString();
+}
+
+Int LazyDocument::Node::asInt() const { return decode().asInt(); }
+
+UInt LazyDocument::Node::asUInt() const { return decode().asUInt(); }
+
+#if defined(JSON_HAS_INT64)
+Int64 LazyDocument::Node::asInt64() const { return decode().asInt64(); }
+
+UInt64 LazyDocument::Node::asUInt64() const { return decode().asUInt64(); }
+#endif // if defined(JSON_HAS_INT64)
+
+double LazyDocument::Node::asDouble() const { return decode().asDouble(); }
+
+bool LazyDocument::Node::asBool() const { return decode().asBool(); }
+
 } // namespace Json
 
 // //////////////////////////////////////////////////////////////////////
@@ -2299,7 +4511,7 @@ void ValueIteratorBase::decrement() {
 
 ValueIteratorBase::difference_type
 ValueIteratorBase::computeDistance(const SelfType& other) const {
-#ifdef JSON_USE_CPPTL_SMALLMAP
+#if defined(JSON_USE_CPPTL_SMALLMAP) || JSON_USE_FLAT_MAP
   return other.current_ - current_;
 #else
   // Iterator for null value are initialized using the default
@@ -2657,6 +4869,73 @@ JSONCPP_NORETURN void throwLogicError(JSONCPP_STRING const& msg)
   throw LogicError(msg);
 }
 
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Arena
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+// Every chunk is aligned like a Block header, which holds a pointer and a
+// size_t; round that up so doubles and 64-bit integers are safe on 32-bit too.
+static size_t const kArenaAlignment =
+    sizeof(void*) * 2 > sizeof(double) ? sizeof(void*) * 2 : sizeof(double);
+
+static inline size_t arenaAlign(size_t size) {
+  return (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+}
+
+Arena::Arena(size_t blockSize)
+    : blocks_(0), current_(0), limit_(0), blockSize_(blockSize), used_(0) {}
+
+Arena::~Arena() {
+  while (blocks_) {
+    Block* next = blocks_->next_;
+    free(blocks_);
+    blocks_ = next;
+  }
+}
+
+void Arena::addBlock(size_t minSize) {
+  size_t const header = arenaAlign(sizeof(Block));
+  size_t size = blockSize_ > minSize ? blockSize_ : minSize;
+  Block* block = static_cast<Block*>(malloc(header + size));
+  if (block == NULL) {
+    throwRuntimeError(
+        "in Json::Arena::allocate(): Failed to allocate arena block");
+  }
+  block->size_ = size;
+  block->next_ = blocks_;
+  blocks_ = block;
+  current_ = reinterpret_cast<char*>(block) + header;
+  limit_ = current_ + size;
+}
+
+void* Arena::allocate(size_t size) {
+  size = arenaAlign(size ? size : 1);
+  if (static_cast<size_t>(limit_ - current_) < size)
+    addBlock(size);
+  void* chunk = current_;
+  current_ += size;
+  used_ += size;
+  return chunk;
+}
+
+void Arena::clear() {
+  if (!blocks_)
+    return;
+  // Keep the oldest block, it is the one sized for the common case.
+  while (blocks_->next_) {
+    Block* next = blocks_->next_;
+    free(blocks_);
+    blocks_ = next;
+  }
+  current_ = reinterpret_cast<char*>(blocks_) + arenaAlign(sizeof(Block));
+  limit_ = current_ + blocks_->size_;
+  used_ = 0;
+}
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -2789,8 +5068,7 @@ Value::Value(ValueType vtype) {
   static char const emptyString[] = "";
   initBasic(vtype);
   switch (vtype) {
-  case nullValue:
-    break;
+  case nullValue: // so that copying or swapping a null never reads garbage
   case intValue:
   case uintValue:
     value_.int_ = 0;
@@ -2875,7 +5153,7 @@ Value::Value(bool value) {
 }
 
 Value::Value(Value const& other)
-    : type_(other.type_), allocated_(false)
+    : type_(other.type_), allocated_(false), arena_(false)
       ,
       comments_(0), start_(other.start_), limit_(other.limit_)
 {
@@ -2902,7 +5180,9 @@ Value::Value(Value const& other)
     break;
   case arrayValue:
   case objectValue:
-    value_.map_ = new ObjectValues(*other.value_.map_);
+    // Range construction, so that a copy of an arena map lands on the heap.
+    value_.map_ = new ObjectValues(other.value_.map_->begin(),
+                                   other.value_.map_->end());
     break;
   default:
     JSON_ASSERT_UNREACHABLE;
@@ -2935,12 +5215,15 @@ Value::~Value() {
   case booleanValue:
     break;
   case stringValue:
-    if (allocated_)
+    if (allocated_ && !arena_)
       releasePrefixedStringValue(value_.string_);
     break;
   case arrayValue:
   case objectValue:
-    delete value_.map_;
+    if (arena_)
+      value_.map_->~ObjectValues();
+    else
+      delete value_.map_;
     break;
   default:
     JSON_ASSERT_UNREACHABLE;
@@ -2964,6 +5247,9 @@ void Value::swapPayload(Value& other) {
   int temp2 = allocated_;
   allocated_ = other.allocated_;
   other.allocated_ = temp2 & 0x1;
+  int temp3 = arena_;
+  arena_ = other.arena_;
+  other.arena_ = temp3 & 0x1;
 }
 
 void Value::swap(Value& other) {
@@ -3464,11 +5750,67 @@ const Value& Value::operator[](int index) const {
 void Value::initBasic(ValueType vtype, bool allocated) {
   type_ = vtype;
   allocated_ = allocated;
+  arena_ = false;
   comments_ = 0;
   start_ = 0;
   limit_ = 0;
 }
 
+// @pre '*this' is a freshly constructed nullValue.
+void Value::initArenaContainer(ValueType vtype, Arena* arena) {
+  JSON_ASSERT(type_ == nullValue && (vtype == arrayValue || vtype == objectValue));
+  void* storage = arena->allocate(sizeof(ObjectValues));
+  value_.map_ = new (storage) ObjectValues(
+      std::less<CZString>(), ObjectValues::allocator_type(arena));
+  type_ = vtype;
+  arena_ = true;
+}
+
+// Same layout as duplicateAndPrefixStringValue(), but carved from 'arena'.
+// @pre '*this' is a freshly constructed nullValue.
+void Value::initArenaString(const char* beginValue, const char* endValue,
+                            Arena* arena) {
+  JSON_ASSERT(type_ == nullValue);
+  unsigned length = static_cast<unsigned>(endValue - beginValue);
+  JSON_ASSERT_MESSAGE(length <= static_cast<unsigned>(Value::maxInt) - sizeof(unsigned) - 1U,
+                      "in Json::Value::initArenaString(): "
+                      "length too big for prefixing");
+  char* newString = static_cast<char*>(
+      arena->allocate(sizeof(unsigned) + length + 1U));
+  *reinterpret_cast<unsigned*>(newString) = length;
+  memcpy(newString + sizeof(unsigned), beginValue, length);
+  newString[sizeof(unsigned) + length] = 0;
+  value_.string_ = newString;
+  type_ = stringValue;
+  allocated_ = true; // prefixed
+  arena_ = true;     // but not owned
+}
+
+// Like resolveReference(key, cend), but the key is neither copied on insertion
+// nor released: it must outlive the member, which holds for keys that live in
+// the parsed buffer or in the same arena as the map. Copies of the member
+// duplicate the key, as with CZString::duplicateOnCopy.
+// @param key is not null-terminated.
+Value& Value::resolveBorrowedReference(char const* key, char const* cend)
+{
+  JSON_ASSERT_MESSAGE(
+      type_ == objectValue,
+      "in Json::Value::resolveBorrowedReference(key, end): requires objectValue");
+  CZString actualKey(
+      key, static_cast<unsigned>(cend-key), CZString::duplicateOnCopy);
+  ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
+  if (it != value_.map_->end() && (*it).first == actualKey)
+    return (*it).second;
+
+#if JSON_HAS_RVALUE_REFERENCES
+  it = value_.map_->emplace_hint(it, std::move(actualKey), Value());
+#else
+  ObjectValues::value_type defaultValue(actualKey, nullSingleton());
+  it = value_.map_->insert(it, defaultValue);
+#endif
+  return (*it).second;
+}
+
 // Access an object value by name, create a null member if it does not exist.
 // @pre Type of '*this' is object or null.
 // @param key is null-terminated.
@@ -4070,6 +6412,86 @@ Value& Path::make(Value& root) const {
   return *node;
 }
 
+// class Pointer
+// //////////////////////////////////////////////////////////////////
+
+Pointer::Pointer(const JSONCPP_STRING& pointer) {
+  const char* current = pointer.c_str();
+  const char* end = current + pointer.length();
+  if (current != end && *current != '/')
+    throwLogicError("JSON Pointer must be empty or start with '/': " + pointer);
+  while (current != end) {
+    ++current; // skip '/'
+    tokens_.push_back(Token());
+    Token& token = tokens_.back();
+    for (; current != end && *current != '/'; ++current) {
+      if (*current != '~') {
+        token.key_ += *current;
+      } else if (current + 1 != end && (current[1] == '0' || current[1] == '1')) {
+        token.key_ += *++current == '0' ? '~' : '/';
+      } else {
+        throwLogicError("Bad escape sequence in JSON Pointer: " + pointer);
+      }
+    }
+    // RFC 6901: an index has no leading zeroes. Longer ones cannot be valid.
+    token.index_ = 0;
+    token.isIndex_ = !token.key_.empty() && token.key_.length() <= 9 &&
+                     (token.key_[0] != '0' || token.key_.length() == 1);
+    for (size_t i = 0; token.isIndex_ && i < token.key_.length(); ++i) {
+      char const c = token.key_[i];
+      if (c < '0' || c > '9')
+        token.isIndex_ = false;
+      else
+        token.index_ = token.index_ * 10 + ArrayIndex(c - '0');
+    }
+  }
+}
+
+const Value* Pointer::find(const Value& root) const {
+  const Value* node = &root;
+  for (Tokens::const_iterator it = tokens_.begin(); it != tokens_.end(); ++it) {
+    const Token& token = *it;
+    if (node->isObject()) {
+      node = node->find(token.key_.data(),
+                        token.key_.data() + token.key_.length());
+      if (!node)
+        return NULL;
+    } else if (node->isArray() && token.isIndex_ &&
+               node->isValidIndex(token.index_)) {
+      node = &((*node)[token.index_]);
+    } else {
+      return NULL;
+    }
+  }
+  return node;
+}
+
+const Value& Pointer::resolve(const Value& root) const {
+  const Value* node = find(root);
+  return node ? *node : Value::null;
+}
+
+Value Pointer::resolve(const Value& root, const Value& defaultValue) const {
+  const Value* node = find(root);
+  return node ? *node : defaultValue;
+}
+
+Value& Pointer::make(Value& root) const {
+  Value* node = &root;
+  for (Tokens::const_iterator it = tokens_.begin(); it != tokens_.end(); ++it) {
+    const Token& token = *it;
+    if (node->isArray() && token.key_ == "-") {
+      node = &node->append(Value());
+    } else if (node->isArray() && token.isIndex_) {
+      node = &((*node)[token.index_]);
+    } else {
+      // Asserts unless node is an object or null.
+      node = &((*node)[token.key_]);
+    }
+  }
+  return *node;
+}
+
 } // namespace Json
 
 // //////////////////////////////////////////////////////////////////////
@@ -4102,6 +6524,14 @@ Value& Path::make(Value& root) const {
 #include <cassert>
 #include <cstring>
 #include <cstdio>
+#if JSON_USE_THREADS
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#endif // if JSON_USE_THREADS
 
 #if defined(_MSC_VER) && _MSC_VER >= 1200 && _MSC_VER < 1800 // Between VC++ 6.0 and VC++ 11.0
 #include <float.h>
@@ -4176,16 +6606,6 @@ static bool containsControlCharacter(const char* str) {
   return false;
 }
 
-static bool containsControlCharacter0(const char* str, unsigned len) {
-  char const* end = str + len;
-  while (end != str) {
-    if (isControlCharacter(*str) || 0==*str)
-      return true;
-    ++str;
-  }
-  return false;
-}
-
 JSONCPP_STRING valueToString(LargestInt value) {
   UIntToStringBuffer buffer;
   char* current = buffer + sizeof(buffer);
@@ -4236,6 +6656,13 @@ JSONCPP_STRING valueToString(double value, bool useSpecialFloats, unsigned int p
   // that always has a decimal point because JSON doesn't distingish the
   // concepts of reals and integers.
   if (isfinite(value)) {
+#if JSON_USE_FAST_NUMBERS
+    // 17 digits is what it takes to round-trip; the shortest digits that do
+    // the same are what the caller wants.
+    if (precision == 17)
+      len = shortestDoubleToString(value, buffer);
+    else
+#endif
     len = snprintf(buffer, sizeof(buffer), formatString, value);
     
     // try to ensure we preserve the fact that this was given to us as a double on input
@@ -4326,28 +6753,20 @@ JSONCPP_STRING valueToQuotedString(const char* value) {
   return result;
 }
 
-// https://github.com/upcaste/upcaste/blob/master/src/upcore/src/cstring/strnpbrk.cpp
-static char const* strnpbrk(char const* s, char const* accept, size_t n) {
-  assert((s || !n) && accept);
-
-  char const* const end = s + n;
-  for (char const* cur = s; cur < end; ++cur) {
-    int const c = *cur;
-    for (char const* a = accept; *a; ++a) {
-      if (*a == c) {
-        return cur;
-      }
-    }
-  }
-  return NULL;
-}
 static JSONCPP_STRING valueToQuotedStringN(const char* value, unsigned length) {
   if (value == NULL)
     return "";
+  char const* end = value + length;
+  char const* c = findCharRequiringEscape(value, end);
   // Not sure how to handle unicode...
-  if (strnpbrk(value, "\"\\\b\f\n\r\t", length) == NULL &&
-      !containsControlCharacter0(value, length))
-    return JSONCPP_STRING("\"") + value + "\"";
+  if (c == end) {
+    JSONCPP_STRING result;
+    result.reserve(length + 2);
+    result += "\"";
+    result.append(value, length);
+    result += "\"";
+    return result;
+  }
   // We have to walk value and escape any special characters.
   // Appending to JSONCPP_STRING is not efficient, but this should be rare.
   // (Note: forward slashes are *not* rare, but I am not escaping them.)
@@ -4356,8 +6775,14 @@ static JSONCPP_STRING valueToQuotedStringN(const char* value, unsigned length) {
   JSONCPP_STRING result;
   result.reserve(maxsize); // to avoid lots of mallocs
   result += "\"";
-  char const* end = value + length;
-  for (const char* c = value; c != end; ++c) {
+  result.append(value, c);
+  for (; c != end; ++c) {
+    // Copy the run up to the next character that needs escaping in one go.
+    char const* run = findCharRequiringEscape(c, end);
+    result.append(c, run);
+    if (run == end)
+      break;
+    c = run;
     switch (*c) {
     case '\"':
       result += "\\\"";
@@ -5200,6 +7625,109 @@ bool BuiltStyledStreamWriter::hasCommentForValue(const Value& value) {
          value.hasComment(commentAfter);
 }
 
+//////////////////
+// CborStreamWriter
+
+/// Writes CBOR (RFC 7049): definite lengths, integers and lengths in their
+/// shortest encoding, reals as 64 bit floats. Comments are dropped.
+struct CborStreamWriter : public StreamWriter
+{
+  CborStreamWriter();
+  int write(Value const& root, JSONCPP_OSTREAM* sout) JSONCPP_OVERRIDE;
+private:
+  void writeValue(Value const& value);
+  void writeHead(unsigned int majorType, uint64_t argument);
+
+  JSONCPP_STRING buffer_;
+};
+CborStreamWriter::CborStreamWriter()
+  : buffer_()
+{
+}
+int CborStreamWriter::write(Value const& root, JSONCPP_OSTREAM* sout)
+{
+  buffer_.clear();
+  writeValue(root);
+  sout->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  return 0;
+}
+void CborStreamWriter::writeValue(Value const& value) {
+  switch (value.type()) {
+  case nullValue:
+    buffer_ += '\xF6';
+    break;
+  case intValue: {
+    LargestInt const i = value.asLargestInt();
+    if (i >= 0)
+      writeHead(0, static_cast<uint64_t>(i));
+    else // -1 - n
+      writeHead(1, static_cast<uint64_t>(-(i + 1)));
+  } break;
+  case uintValue:
+    writeHead(0, value.asLargestUInt());
+    break;
+  case realValue: {
+    double const d = value.asDouble();
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    buffer_ += '\xFB';
+    for (int shift = 56; shift >= 0; shift -= 8)
+      buffer_ += static_cast<char>(bits >> shift);
+  } break;
+  case stringValue:
+  {
+    char const* str;
+    char const* end;
+    bool ok = value.getString(&str, &end);
+    if (!ok) str = end = "";
+    writeHead(3, static_cast<uint64_t>(end - str));
+    buffer_.append(str, end);
+    break;
+  }
+  case booleanValue:
+    buffer_ += value.asBool() ? '\xF5' : '\xF4';
+    break;
+  case arrayValue: {
+    ArrayIndex const size = value.size();
+    writeHead(4, size);
+    for (ArrayIndex index = 0; index < size; ++index)
+      writeValue(value[index]);
+  } break;
+  case objectValue: {
+    writeHead(5, value.size());
+    for (Value::const_iterator it = value.begin(); it != value.end(); ++it) {
+      char const* end;
+      char const* name = it.memberName(&end);
+      writeHead(3, static_cast<uint64_t>(end - name));
+      buffer_.append(name, end);
+      writeValue(*it);
+    }
+  } break;
+  }
+}
+void CborStreamWriter::writeHead(unsigned int majorType, uint64_t argument) {
+  char const type = static_cast<char>(majorType << 5);
+  int bytes;
+  if (argument < 24) {
+    buffer_ += static_cast<char>(type | static_cast<char>(argument));
+    return;
+  } else if (argument <= 0xFFU) {
+    buffer_ += static_cast<char>(type | 24);
+    bytes = 1;
+  } else if (argument <= 0xFFFFU) {
+    buffer_ += static_cast<char>(type | 25);
+    bytes = 2;
+  } else if (argument <= 0xFFFFFFFFU) {
+    buffer_ += static_cast<char>(type | 26);
+    bytes = 4;
+  } else {
+    buffer_ += static_cast<char>(type | 27);
+    bytes = 8;
+  }
+  for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8)
+    buffer_ += static_cast<char>(argument >> shift);
+}
+
 ///////////////
 // StreamWriter
 
@@ -5220,6 +7748,12 @@ StreamWriterBuilder::~StreamWriterBuilder()
 {}
 StreamWriter* StreamWriterBuilder::newStreamWriter() const
 {
+  JSONCPP_STRING format = settings_["format"].asString();
+  if (format == "cbor") {
+    return new CborStreamWriter();
+  } else if (format != "json") {
+    throwRuntimeError("format must be 'json' or 'cbor'");
+  }
   JSONCPP_STRING indentation = settings_["indentation"].asString();
   JSONCPP_STRING cs_str = settings_["commentStyle"].asString();
   bool eyc = settings_["enableYAMLCompatibility"].asBool();
@@ -5259,6 +7793,7 @@ static void getValidWriterKeys(std::set<JSONCPP_STRING>* valid_keys)
   valid_keys->insert("dropNullPlaceholders");
   valid_keys->insert("useSpecialFloats");
   valid_keys->insert("precision");
+  valid_keys->insert("format");
 }
 bool StreamWriterBuilder::validate(Json::Value* invalid) const
 {
@@ -5291,6 +7826,7 @@ void StreamWriterBuilder::setDefaults(Json::Value* settings)
   (*settings)["dropNullPlaceholders"] = false;
   (*settings)["useSpecialFloats"] = false;
   (*settings)["precision"] = 17;
+  (*settings)["format"] = "json";
   //! [StreamWriterBuilderDefaults]
 }
 
@@ -5308,6 +7844,166 @@ JSONCPP_OSTREAM& operator<<(JSONCPP_OSTREAM& sout, Value const& root) {
   return sout;
 }
 
+#if JSON_USE_THREADS
+// class BatchProcessor
+// //////////////////////////////////////////////////////////////////
+
+struct BatchProcessor::Pool {
+  // Per-thread state, kept across batches.
+  struct Worker {
+    CharReaderPtr reader;
+    StreamWriterPtr writer;
+    JSONCPP_OSTRINGSTREAM sout;
+  };
+  typedef std::function<void(Worker&, size_t)> Job;
+
+  void run(size_t count, Job const& job);
+  void work(Worker& worker);
+  void loop(Worker& worker);
+
+  std::vector<std::unique_ptr<Worker> > workers; // workers[0] is the caller's
+  std::vector<std::thread> threads;
+  std::mutex batch;                 // one batch at a time
+  std::mutex mutex;                 // guards the members below
+  std::condition_variable started;
+  std::condition_variable finished;
+  Job job;
+  size_t count;
+  std::atomic<size_t> next;         // index of the next item to take
+  unsigned busy;                    // pool threads still in the batch
+  unsigned long generation;         // incremented for every batch
+  bool stop;
+  std::exception_ptr error;         // first exception of the batch
+};
+
+void BatchProcessor::Pool::run(size_t items, Job const& task) {
+  std::lock_guard<std::mutex> const one(batch);
+  {
+    std::lock_guard<std::mutex> const lock(mutex);
+    job = task;
+    count = items;
+    next = 0;
+    busy = static_cast<unsigned>(threads.size());
+    error = std::exception_ptr();
+    ++generation;
+  }
+  started.notify_all();
+  work(*workers[0]);
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [this] { return busy == 0; });
+  job = Job();
+  if (error)
+    std::rethrow_exception(error);
+}
+
+void BatchProcessor::Pool::work(Worker& worker) {
+  try {
+    for (size_t index; (index = next++) < count;)
+      job(worker, index);
+  } catch (...) {
+    std::lock_guard<std::mutex> const lock(mutex);
+    if (!error)
+      error = std::current_exception();
+    next = count; // the others stop at their next item
+  }
+}
+
+void BatchProcessor::Pool::loop(Worker& worker) {
+  unsigned long seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      started.wait(lock, [&] { return stop || generation != seen; });
+      if (stop)
+        return;
+      seen = generation;
+    }
+    work(worker);
+    std::lock_guard<std::mutex> const lock(mutex);
+    if (--busy == 0)
+      finished.notify_one();
+  }
+}
+
+BatchProcessor::BatchProcessor(CharReader::Factory const& readers,
+                               StreamWriter::Factory const& writers,
+                               unsigned threads)
+    : pool_(new Pool) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  pool_->count = 0;
+  pool_->next = 0;
+  pool_->busy = 0;
+  pool_->generation = 0;
+  pool_->stop = false;
+  // A zero-copy root lives in its reader's arena, which the reader's next
+  // parse() reuses: every root of the batch would end up pointing at the
+  // last document the thread parsed.
+  CharReader::Factory const* factory = &readers;
+  CharReaderBuilder copying;
+  CharReaderBuilder const* builder =
+      dynamic_cast<CharReaderBuilder const*>(&readers);
+  if (builder && builder->settings_["zeroCopy"].asBool()) {
+    copying.settings_ = builder->settings_;
+    copying.settings_["zeroCopy"] = false;
+    factory = &copying;
+  }
+  // The factories are only used here, on the calling thread.
+  for (unsigned i = 0; i < threads; ++i) {
+    pool_->workers.push_back(std::unique_ptr<Pool::Worker>(new Pool::Worker));
+    pool_->workers.back()->reader.reset(factory->newCharReader());
+    pool_->workers.back()->writer.reset(writers.newStreamWriter());
+  }
+  for (unsigned i = 1; i < threads; ++i)
+    pool_->threads.push_back(
+        std::thread(&Pool::loop, pool_, std::ref(*pool_->workers[i])));
+}
+
+BatchProcessor::~BatchProcessor() {
+  {
+    std::lock_guard<std::mutex> const lock(pool_->mutex);
+    pool_->stop = true;
+  }
+  pool_->started.notify_all();
+  for (size_t i = 0; i < pool_->threads.size(); ++i)
+    pool_->threads[i].join();
+  delete pool_;
+}
+
+unsigned BatchProcessor::threadCount() const {
+  return static_cast<unsigned>(pool_->workers.size());
+}
+
+size_t BatchProcessor::parse(std::vector<Input> const& inputs,
+                             std::vector<Value>& roots,
+                             std::vector<JSONCPP_STRING>* errors) {
+  roots.resize(inputs.size());
+  if (errors)
+    errors->resize(inputs.size());
+  std::atomic<size_t> failures(0);
+  pool_->run(inputs.size(), [&](Pool::Worker& worker, size_t index) {
+    Input const& input = inputs[index];
+    JSONCPP_STRING* errs = errors ? &(*errors)[index] : NULL;
+    if (errs)
+      errs->clear();
+    if (!worker.reader->parse(input.begin, input.end, &roots[index], errs))
+      ++failures;
+  });
+  return failures;
+}
+
+void BatchProcessor::write(std::vector<Value> const& roots,
+                           std::vector<JSONCPP_STRING>& documents) {
+  documents.resize(roots.size());
+  pool_->run(roots.size(), [&](Pool::Worker& worker, size_t index) {
+    worker.sout.str(JSONCPP_STRING());
+    worker.sout.clear();
+    worker.writer->write(roots[index], &worker.sout);
+    documents[index] = worker.sout.str();
+  });
+}
+#endif // if JSON_USE_THREADS
+
 } // namespace Json
 
 // //////////////////////////////////////////////////////////////////////
@@ -0,0 +1,377 @@
+#include "TestHttpServer.h"
+#include <algorithm>
+#include <chrono>
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+/**************************************************************************/
+
+namespace
+{
+    const char* reasonPhrase(unsigned int status)
+    {
+        switch (status)
+        {
+        case 200: return "OK";
+        case 404: return "Not Found";
+        case 407: return "Proxy Authentication Required";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "Status";
+        }
+    }
+
+    std::string toLower(std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](char c) { return static_cast<char>(::tolower(static_cast<unsigned char>(c))); });
+        return text;
+    }
+}
+
+std::string TestHttpRequest::header(const std::string& lowerName) const
+{
+    std::map<std::string, std::string>::const_iterator it = headers.find(lowerName);
+    return headers.end() == it ? std::string() : it->second;
+}
+
+// ƳٺշѴֽӦĵʱʵʺʱĲ˯߲
+class TestHttpServer::Throttle
+{
+public:
+    explicit Throttle(size_t bytesPerSecond) : m_rate(bytesPerSecond), m_bytes(0), m_start(std::chrono::steady_clock::now()) {}
+
+    size_t chunkSize(size_t wanted) const
+    {
+        return 0 == m_rate ? wanted : (std::min)(wanted, (std::max)(m_rate / 50, static_cast<size_t>(1)));
+    }
+
+    void transferred(size_t bytes)
+    {
+        if (0 == m_rate)
+        {
+            return;
+        }
+        m_bytes += bytes;
+        std::chrono::steady_clock::time_point due = m_start + std::chrono::microseconds(m_bytes * 1000000ULL / m_rate);
+        std::this_thread::sleep_until(due);
+    }
+
+private:
+    size_t m_rate;
+    unsigned long long m_bytes;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+TestHttpServer::TestHttpServer(const Handler& handler)
+    : m_handler(handler)
+    , m_listen(-1)
+    , m_port(0)
+    , m_bandwidth(0)
+    , m_running(0)
+    , m_stopped(false)
+    , m_connections(0)
+    , m_requests(0)
+    , m_bytesReceived(0)
+    , m_bytesSent(0)
+{
+
+}
+
+TestHttpServer::~TestHttpServer()
+{
+    stop();
+}
+
+bool TestHttpServer::start()
+{
+    m_listen = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listen < 0)
+    {
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address;
+    ::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (0 != ::bind(m_listen, reinterpret_cast<sockaddr*>(&address), sizeof(address))
+        || 0 != ::listen(m_listen, 1024)
+        || 0 != ::getsockname(m_listen, reinterpret_cast<sockaddr*>(&address), &length))
+    {
+        ::close(m_listen);
+        m_listen = -1;
+        return false;
+    }
+    m_port = ntohs(address.sin_port);
+    m_acceptThread = std::thread(&TestHttpServer::acceptLoop, this);
+    return true;
+}
+
+void TestHttpServer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopped)
+        {
+            return;
+        }
+        m_stopped = true;
+        for (std::set<int>::iterator it = m_clients.begin(); m_clients.end() != it; ++it)
+        {
+            ::shutdown(*it, SHUT_RDWR);
+        }
+    }
+    if (m_listen >= 0)
+    {
+        ::shutdown(m_listen, SHUT_RDWR);    //  accept() ϵ߳
+    }
+    if (m_acceptThread.joinable())
+    {
+        m_acceptThread.join();
+    }
+    if (m_listen >= 0)
+    {
+        ::close(m_listen);
+        m_listen = -1;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (0 != m_running)
+    {
+        m_exited.wait(lock);
+    }
+}
+
+void TestHttpServer::setBandwidth(size_t bytesPerSecond)
+{
+    m_bandwidth = bytesPerSecond;
+}
+
+std::wstring TestHttpServer::url(const std::string& path) const
+{
+    char text[64] = { 0 };
+    ::snprintf(text, sizeof(text), "http://127.0.0.1:%u", static_cast<unsigned int>(m_port));
+    std::string full = text + path;
+    return std::wstring(full.begin(), full.end());
+}
+
+void TestHttpServer::resetCounters()
+{
+    m_connections = 0;
+    m_requests = 0;
+    m_bytesReceived = 0;
+    m_bytesSent = 0;
+}
+
+void TestHttpServer::acceptLoop()
+{
+    for (;;)
+    {
+        int fd = ::accept4(m_listen, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (EINTR == errno || ECONNABORTED == errno)
+            {
+                continue;
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopped)
+            {
+                ::close(fd);
+                return;
+            }
+            m_clients.insert(fd);
+            ++m_running;
+        }
+        ++m_connections;
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        std::thread(&TestHttpServer::serve, this, fd).detach();
+    }
+}
+
+void TestHttpServer::serve(int fd)
+{
+    Throttle throttle(m_bandwidth);
+    std::string buffer;
+    for (;;)
+    {
+        TestHttpRequest request;
+        if (false == readRequest(fd, buffer, request, throttle))
+        {
+            break;
+        }
+        ++m_requests;
+
+        TestHttpResponse response;
+        m_handler(request, response);
+        if (0 != response.delayMs)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(response.delayMs));
+        }
+
+        if (TestFaultReset == response.fault)
+        {
+            linger option = { 1, 0 };
+            ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &option, sizeof(option));
+            break;
+        }
+        if (TestFaultClose == response.fault)
+        {
+            break;
+        }
+        if (TestFaultHang == response.fault)
+        {
+            waitClosed(fd);
+            break;
+        }
+
+        bool close = response.close || "close" == toLower(request.header("connection"));
+        char line[128] = { 0 };
+        ::snprintf(line, sizeof(line), "HTTP/1.1 %u %s\r\n", response.status, reasonPhrase(response.status));
+        std::string data = line;
+        for (std::vector<std::string>::const_iterator it = response.headers.begin(); response.headers.end() != it; ++it)
+        {
+            data += *it + "\r\n";
+        }
+        if (response.chunked)
+        {
+            data += "Transfer-Encoding: chunked\r\n";
+        }
+        else if (false == response.close)
+        {
+            data += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+        }
+        if (close)
+        {
+            data += "Connection: close\r\n";
+        }
+        data += "\r\n";
+
+        if (TestFaultTruncate == response.fault)
+        {
+            data.append(response.body, 0, response.body.size() / 2);
+            sendAll(fd, data, throttle);
+            break;
+        }
+        if (response.chunked)
+        {
+            // ֳɳ̲һĿ飬ǿ鳤ȵĲͬλ
+            size_t offset = 0;
+            for (size_t size = 1; offset < response.body.size(); size *= 7)
+            {
+                size_t chunk = (std::min)(size, response.body.size() - offset);
+                char header[32] = { 0 };
+                ::snprintf(header, sizeof(header), "%zx\r\n", chunk);
+                data += header;
+                data.append(response.body, offset, chunk);
+                data += "\r\n";
+                offset += chunk;
+            }
+            data += "0\r\n\r\n";
+        }
+        else
+        {
+            data += response.body;
+        }
+        if (false == sendAll(fd, data, throttle) || close)
+        {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_clients.erase(fd);
+    ::close(fd);
+    --m_running;
+    m_exited.notify_all();
+}
+
+bool TestHttpServer::readRequest(int fd, std::string& buffer, TestHttpRequest& request, Throttle& throttle)
+{
+    char chunk[16 * 1024];
+    size_t headerEnd = std::string::npos;
+    size_t contentLength = 0;
+    for (;;)
+    {
+        if (std::string::npos == headerEnd)
+        {
+            headerEnd = buffer.find("\r\n\r\n");
+            if (std::string::npos != headerEnd)
+            {
+                size_t lineEnd = buffer.find("\r\n");
+                std::string requestLine = buffer.substr(0, lineEnd);
+                size_t space = requestLine.find(' ');
+                request.method = requestLine.substr(0, space);
+                request.path = requestLine.substr(space + 1, requestLine.rfind(' ') - space - 1);
+
+                size_t position = lineEnd + 2;
+                while (position < headerEnd)
+                {
+                    size_t next = buffer.find("\r\n", position);
+                    std::string line = buffer.substr(position, next - position);
+                    size_t colon = line.find(':');
+                    if (std::string::npos != colon)
+                    {
+                        size_t value = line.find_first_not_of(' ', colon + 1);
+                        request.headers[toLower(line.substr(0, colon))] = (std::string::npos == value ? std::string() : line.substr(value));
+                    }
+                    position = next + 2;
+                }
+                contentLength = ::strtoul(request.header("content-length").c_str(), NULL, 10);
+            }
+        }
+        if (std::string::npos != headerEnd && buffer.size() >= headerEnd + 4 + contentLength)
+        {
+            request.body = buffer.substr(headerEnd + 4, contentLength);
+            buffer.erase(0, headerEnd + 4 + contentLength);
+            return true;
+        }
+
+        ssize_t received = ::recv(fd, chunk, throttle.chunkSize(sizeof(chunk)), 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+        m_bytesReceived += received;
+        throttle.transferred(received);
+        buffer.append(chunk, received);
+    }
+}
+
+bool TestHttpServer::sendAll(int fd, const std::string& data, Throttle& throttle)
+{
+    size_t offset = 0;
+    while (offset < data.size())
+    {
+        ssize_t sent = ::send(fd, data.data() + offset, throttle.chunkSize(data.size() - offset), MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        m_bytesSent += sent;
+        throttle.transferred(sent);
+        offset += sent;
+    }
+    return true;
+}
+
+void TestHttpServer::waitClosed(int fd)
+{
+    char chunk[1024];
+    while (::recv(fd, chunk, sizeof(chunk), 0) > 0)
+    {
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef __TESTHTTPSERVER_H__
+#define __TESTHTTPSERVER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+/**************************************************************************/
+
+struct TestHttpRequest
+{
+    std::string method;
+    std::string path;
+    std::map<std::string, std::string> headers;     // ΪСд
+    std::string body;
+
+    std::string header(const std::string& lowerName) const;
+};
+
+enum TestHttpFault
+{
+    TestFaultNone,
+    TestFaultReset,         // Ӧֱ RST Ͽ
+    TestFaultClose,         // Ӧر
+    TestFaultHang,          // Ӧֱͻ˶Ͽֹͣ
+    TestFaultTruncate,      // ӦͷȣֻһӦ͹ر
+};
+
+struct TestHttpResponse
+{
+    TestHttpResponse() : status(200), chunked(false), close(false), delayMs(0), fault(TestFaultNone) {}
+
+    unsigned int status;
+    std::vector<std::string> headers;   // "Name: value"Content-Length/Transfer-Encoding ɷ
+    std::string body;
+    bool chunked;           // ֿ鷢Ӧ
+    bool close;             // ȣԹرӽӦ
+    unsigned int delayMs;   // Ӧǰȴ
+    TestHttpFault fault;
+};
+
+/*
+* õı HTTP/1.1  127.0.0.1 ˿ڣÿһ̣֧߳ keep-alive
+*
+* Ӧ Handler Handler ڸӵ߳ϲã١עϣͳշֽ
+*/
+class TestHttpServer
+{
+public:
+    typedef std::function<void(const TestHttpRequest& request, TestHttpResponse& response)> Handler;
+
+    explicit TestHttpServer(const Handler& handler);
+    ~TestHttpServer();
+
+    bool start();
+    void stop();    // ϿӲȴ߳˳
+
+    // ÿÿĴޣֽ/룩0 ʾ٣Ĭϣ
+    void setBandwidth(size_t bytesPerSecond);
+
+    unsigned short port() const { return m_port; }
+    std::wstring url(const std::string& path) const;
+
+    size_t connections() const { return m_connections; }
+    size_t requests() const { return m_requests; }
+    unsigned long long bytesReceived() const { return m_bytesReceived; }
+    unsigned long long bytesSent() const { return m_bytesSent; }
+    void resetCounters();
+
+private:
+    class Throttle;
+
+    void acceptLoop();
+    void serve(int fd);
+    bool readRequest(int fd, std::string& buffer, TestHttpRequest& request, Throttle& throttle);
+    bool sendAll(int fd, const std::string& data, Throttle& throttle);
+    void waitClosed(int fd);
+
+    TestHttpServer(const TestHttpServer&);
+    void operator=(const TestHttpServer&);
+
+private:
+    Handler m_handler;
+    int m_listen;
+    unsigned short m_port;
+    std::thread m_acceptThread;
+    std::atomic<size_t> m_bandwidth;
+
+    std::mutex m_mutex;
+    std::condition_variable m_exited;
+    std::set<int> m_clients;        //  m_mutex stop() ʱ shutdown
+    size_t m_running;               //  m_mutex е߳
+    bool m_stopped;
+
+    std::atomic<size_t> m_connections;
+    std::atomic<size_t> m_requests;
+    std::atomic<unsigned long long> m_bytesReceived;
+    std::atomic<unsigned long long> m_bytesSent;
+};
+
+#endif /* __TESTHTTPSERVER_H__ */
@@ -0,0 +1,69 @@
+#ifndef __TESTPLAINTLS_H__
+#define __TESTPLAINTLS_H__
+
+#include "HttpSocketTransport.h"
+#include <atomic>
+#include <errno.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+/**************************************************************************/
+
+/*
+* ܵ TLS ӣֱͨ socket շģԷ֤飬
+* ֤ https 󾭹 provider ͨշԼӸõ TLS ޹ص߼
+*/
+class TestPlainChannel : public HttpTlsChannel
+{
+public:
+    explicit TestPlainChannel(int fd) : m_fd(fd), m_want(0) {}
+
+    virtual DWORD handshake() { return ERROR_SUCCESS; }
+    virtual DWORD send(const char* data, size_t size, size_t& sent)
+    {
+        return result(::send(m_fd, data, size, MSG_NOSIGNAL), POLLOUT, sent);
+    }
+    virtual DWORD receive(char* buffer, size_t size, size_t& received)
+    {
+        return result(::recv(m_fd, buffer, size, 0), POLLIN, received);
+    }
+    virtual short wantEvents() const { return m_want; }
+
+private:
+    DWORD result(ssize_t ret, short events, size_t& count)
+    {
+        if (ret >= 0)
+        {
+            count = static_cast<size_t>(ret);
+            m_want = 0;
+            return ERROR_SUCCESS;
+        }
+        if (EAGAIN == errno || EWOULDBLOCK == errno)
+        {
+            m_want = events;
+            return EAGAIN;
+        }
+        return errno;
+    }
+
+    int m_fd;
+    short m_want;
+};
+
+class TestPlainTlsProvider : public HttpTlsProvider
+{
+public:
+    TestPlainTlsProvider() : channels(0) {}
+
+    virtual HttpTlsChannel* createChannel(int fd, const std::string& host)
+    {
+        ++channels;
+        lastHost = host;
+        return new TestPlainChannel(fd);
+    }
+
+    std::atomic<int> channels;
+    std::string lastHost;       // ֻڵ̵߳
+};
+
+#endif /* __TESTPLAINTLS_H__ */
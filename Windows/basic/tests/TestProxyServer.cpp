@@ -0,0 +1,462 @@
+#include "TestProxyServer.h"
+#include <chrono>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+/**************************************************************************/
+
+namespace
+{
+    bool receiveAll(int fd, unsigned char* data, size_t size)
+    {
+        size_t offset = 0;
+        while (offset < size)
+        {
+            ssize_t received = ::recv(fd, data + offset, size - offset, 0);
+            if (received <= 0)
+            {
+                return false;
+            }
+            offset += received;
+        }
+        return true;
+    }
+
+    bool sendAll(int fd, const char* data, size_t size)
+    {
+        size_t offset = 0;
+        while (offset < size)
+        {
+            ssize_t sent = ::send(fd, data + offset, size - offset, MSG_NOSIGNAL);
+            if (sent <= 0)
+            {
+                return false;
+            }
+            offset += sent;
+        }
+        return true;
+    }
+
+    std::string base64(const std::string& text)
+    {
+        static const char* const kAlphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string encoded;
+        for (size_t i = 0; i < text.size(); i += 3)
+        {
+            unsigned int group = static_cast<unsigned char>(text[i]) << 16;
+            if (i + 1 < text.size())
+            {
+                group |= static_cast<unsigned char>(text[i + 1]) << 8;
+            }
+            if (i + 2 < text.size())
+            {
+                group |= static_cast<unsigned char>(text[i + 2]);
+            }
+            encoded += kAlphabet[(group >> 18) & 0x3F];
+            encoded += kAlphabet[(group >> 12) & 0x3F];
+            encoded += (i + 1 < text.size()) ? kAlphabet[(group >> 6) & 0x3F] : '=';
+            encoded += (i + 2 < text.size()) ? kAlphabet[group & 0x3F] : '=';
+        }
+        return encoded;
+    }
+}
+
+TestProxyServer::TestProxyServer(const std::string& username, const std::string& password)
+    : m_username(username)
+    , m_password(password)
+    , m_fragmented(false)
+    , m_listen(-1)
+    , m_port(0)
+    , m_running(0)
+    , m_stopped(false)
+    , m_connections(0)
+    , m_authFailures(0)
+{
+
+}
+
+TestProxyServer::~TestProxyServer()
+{
+    stop();
+}
+
+void TestProxyServer::setFragmented(bool fragmented)
+{
+    m_fragmented = fragmented;
+}
+
+bool TestProxyServer::start()
+{
+    m_listen = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listen < 0)
+    {
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address;
+    ::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (0 != ::bind(m_listen, reinterpret_cast<sockaddr*>(&address), sizeof(address))
+        || 0 != ::listen(m_listen, 256)
+        || 0 != ::getsockname(m_listen, reinterpret_cast<sockaddr*>(&address), &length))
+    {
+        ::close(m_listen);
+        m_listen = -1;
+        return false;
+    }
+    m_port = ntohs(address.sin_port);
+    m_acceptThread = std::thread(&TestProxyServer::acceptLoop, this);
+    return true;
+}
+
+void TestProxyServer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopped)
+        {
+            return;
+        }
+        m_stopped = true;
+        for (std::set<int>::iterator it = m_sockets.begin(); m_sockets.end() != it; ++it)
+        {
+            ::shutdown(*it, SHUT_RDWR);
+        }
+    }
+    if (m_listen >= 0)
+    {
+        ::shutdown(m_listen, SHUT_RDWR);
+    }
+    if (m_acceptThread.joinable())
+    {
+        m_acceptThread.join();
+    }
+    if (m_listen >= 0)
+    {
+        ::close(m_listen);
+        m_listen = -1;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (0 != m_running)
+    {
+        m_exited.wait(lock);
+    }
+}
+
+std::vector<std::string> TestProxyServer::lines() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lines;
+}
+
+void TestProxyServer::acceptLoop()
+{
+    for (;;)
+    {
+        int fd = ::accept4(m_listen, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (EINTR == errno || ECONNABORTED == errno)
+            {
+                continue;
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopped)
+            {
+                ::close(fd);
+                return;
+            }
+            m_sockets.insert(fd);
+            ++m_running;
+        }
+        ++m_connections;
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        std::thread(&TestProxyServer::serve, this, fd).detach();
+    }
+}
+
+void TestProxyServer::serve(int fd)
+{
+    char first = 0;
+    int upstream = -1;
+    if (1 == ::recv(fd, &first, 1, 0))
+    {
+        upstream = (0x05 == first) ? socks(fd) : http(fd, first);
+    }
+    if (upstream >= 0)
+    {
+        splice(fd, upstream);
+        untrack(upstream);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sockets.erase(fd);
+    ::close(fd);
+    --m_running;
+    m_exited.notify_all();
+}
+
+int TestProxyServer::socks(int fd)
+{
+    unsigned char count = 0;
+    unsigned char methods[255];
+    if (false == receiveAll(fd, &count, 1) || false == receiveAll(fd, methods, count))
+    {
+        return -1;
+    }
+    unsigned char wanted = m_username.empty() ? 0x00 : 0x02;
+    if (NULL == ::memchr(methods, wanted, count))
+    {
+        ++m_authFailures;
+        reply(fd, std::string("\x05\xFF", 2));
+        return -1;
+    }
+    reply(fd, std::string("\x05", 1) + static_cast<char>(wanted));
+
+    if (0x02 == wanted)
+    {
+        unsigned char version = 0;
+        unsigned char length = 0;
+        char username[256] = { 0 };
+        char password[256] = { 0 };
+        if (false == receiveAll(fd, &version, 1)
+            || false == receiveAll(fd, &length, 1) || false == receiveAll(fd, reinterpret_cast<unsigned char*>(username), length)
+            || false == receiveAll(fd, &length, 1) || false == receiveAll(fd, reinterpret_cast<unsigned char*>(password), length))
+        {
+            return -1;
+        }
+        if (m_username != username || m_password != password)
+        {
+            ++m_authFailures;
+            reply(fd, std::string("\x01\x01", 2));
+            return -1;
+        }
+        reply(fd, std::string("\x01\x00", 2));
+    }
+
+    unsigned char header[4];
+    if (false == receiveAll(fd, header, sizeof(header)))
+    {
+        return -1;
+    }
+    std::string host;
+    if (0x01 == header[3] || 0x04 == header[3])
+    {
+        unsigned char address[16];
+        char text[INET6_ADDRSTRLEN] = { 0 };
+        int family = (0x01 == header[3]) ? AF_INET : AF_INET6;
+        if (false == receiveAll(fd, address, (AF_INET == family) ? 4 : 16))
+        {
+            return -1;
+        }
+        host = ::inet_ntop(family, address, text, sizeof(text));
+    }
+    else
+    {
+        unsigned char length = 0;
+        char name[256] = { 0 };
+        if (false == receiveAll(fd, &length, 1) || false == receiveAll(fd, reinterpret_cast<unsigned char*>(name), length))
+        {
+            return -1;
+        }
+        host = name;
+    }
+    unsigned char port[2];
+    if (false == receiveAll(fd, port, sizeof(port)))
+    {
+        return -1;
+    }
+    unsigned short targetPort = static_cast<unsigned short>((port[0] << 8) | port[1]);
+    record("socks " + host + ":" + std::to_string(targetPort));
+
+    int upstream = connectTo(host, targetPort);
+    if (upstream < 0)
+    {
+        reply(fd, std::string("\x05\x05\x00\x01\0\0\0\0\0\0", 10));
+        return -1;
+    }
+    // 󶨵ַͣͻҪ 5 ֽӦ𳤶
+    reply(fd, std::string("\x05\x00\x00\x03\x09localhost\x10\x92", 16));
+    return upstream;
+}
+
+int TestProxyServer::http(int fd, char first)
+{
+    std::string buffer(1, first);
+    char chunk[4096];
+    size_t headerEnd = std::string::npos;
+    while (std::string::npos == (headerEnd = buffer.find("\r\n\r\n")))
+    {
+        ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+        {
+            return -1;
+        }
+        buffer.append(chunk, received);
+    }
+    std::string head = buffer.substr(0, headerEnd + 4);
+    std::string line = head.substr(0, head.find("\r\n"));
+    std::string method = line.substr(0, line.find(' '));
+    std::string target = line.substr(method.size() + 1, line.rfind(' ') - method.size() - 1);
+    record(line);
+
+    if (false == m_username.empty()
+        && std::string::npos == head.find("\r\nProxy-Authorization: Basic " + base64(m_username + ":" + m_password) + "\r\n"))
+    {
+        ++m_authFailures;
+        reply(fd, "HTTP/1.1 407 Proxy Authentication Required\r\nProxy-Authenticate: Basic realm=\"test\"\r\nContent-Length: 0\r\n\r\n");
+        return -1;
+    }
+
+    if ("CONNECT" == method)
+    {
+        size_t colon = target.rfind(':');
+        int upstream = connectTo(target.substr(0, colon), static_cast<unsigned short>(::atoi(target.c_str() + colon + 1)));
+        if (upstream < 0)
+        {
+            reply(fd, "HTTP/1.1 502 Bad Gateway\r\nContent-Length: 0\r\n\r\n");
+            return -1;
+        }
+        reply(fd, "HTTP/1.1 200 Connection established\r\nVia: test-proxy\r\n\r\n");
+        return upstream;
+    }
+
+    // ԵַתϵһԴվ֮ԭת
+    size_t hostBegin = target.find("://");
+    if (std::string::npos == hostBegin)
+    {
+        return -1;
+    }
+    hostBegin += 3;
+    size_t hostEnd = target.find('/', hostBegin);
+    std::string authority = target.substr(hostBegin, hostEnd - hostBegin);
+    size_t colon = authority.rfind(':');
+    unsigned short port = (std::string::npos == colon) ? 80 : static_cast<unsigned short>(::atoi(authority.c_str() + colon + 1));
+    int upstream = connectTo(authority.substr(0, colon), port);
+    if (upstream < 0)
+    {
+        reply(fd, "HTTP/1.1 502 Bad Gateway\r\nContent-Length: 0\r\n\r\n");
+        return -1;
+    }
+    if (false == sendAll(upstream, buffer.data(), buffer.size()))
+    {
+        untrack(upstream);
+        return -1;
+    }
+    return upstream;
+}
+
+int TestProxyServer::connectTo(const std::string& host, unsigned short port)
+{
+    // Էֻ 127.0.0.1localhost ֻȡ IPv4 ַ
+    addrinfo hints;
+    ::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = NULL;
+    if (0 != ::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result))
+    {
+        return -1;
+    }
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && 0 != ::connect(fd, result->ai_addr, result->ai_addrlen))
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(result);
+    if (fd < 0 || false == track(fd))
+    {
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+bool TestProxyServer::reply(int fd, const std::string& data)
+{
+    if (false == m_fragmented)
+    {
+        return sendAll(fd, data.data(), data.size());
+    }
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        if (false == sendAll(fd, data.data() + i, 1))
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void TestProxyServer::splice(int client, int upstream)
+{
+    pollfd fds[2] = { { client, POLLIN, 0 }, { upstream, POLLIN, 0 } };
+    char chunk[64 * 1024];
+    for (;;)
+    {
+        if (::poll(fds, 2, -1) < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            break;
+        }
+        for (int i = 0; i < 2; ++i)
+        {
+            if (0 == fds[i].revents)
+            {
+                continue;
+            }
+            ssize_t received = ::recv(fds[i].fd, chunk, sizeof(chunk), 0);
+            if (received <= 0 || false == sendAll(fds[1 - i].fd, chunk, received))
+            {
+                return;
+            }
+        }
+    }
+}
+
+void TestProxyServer::record(const std::string& line)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lines.push_back(line);
+}
+
+bool TestProxyServer::track(int fd)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopped)
+    {
+        ::close(fd);
+        return false;
+    }
+    m_sockets.insert(fd);
+    return true;
+}
+
+void TestProxyServer::untrack(int fd)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sockets.erase(fd);
+    ::close(fd);
+}
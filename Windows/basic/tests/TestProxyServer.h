@@ -0,0 +1,70 @@
+#ifndef __TESTPROXYSERVER_H__
+#define __TESTPROXYSERVER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+/**************************************************************************/
+
+/*
+* õıشͬһ˿ϰһֽ SOCKS5RFC 1928/1929 HTTP CONNECT Եַת
+*
+* username ǿʱҪ֤˫ԭתֱһ˹رաÿһ߳
+* ¼ÿĿ꣨"socks host:port" HTTP յУԼ
+*/
+class TestProxyServer
+{
+public:
+    TestProxyServer(const std::string& username, const std::string& password);
+    ~TestProxyServer();
+
+    // ֽ׶εӦֽڷͣǿͻ˷ֶζӦ start() ֮ǰ
+    void setFragmented(bool fragmented);
+
+    bool start();
+    void stop();
+
+    unsigned short port() const { return m_port; }
+    size_t connections() const { return m_connections; }
+    size_t authFailures() const { return m_authFailures; }
+    std::vector<std::string> lines() const;
+
+private:
+    void acceptLoop();
+    void serve(int fd);
+    int socks(int fd);
+    int http(int fd, char first);
+    int connectTo(const std::string& host, unsigned short port);
+    bool reply(int fd, const std::string& data);
+    void splice(int client, int upstream);
+    void record(const std::string& line);
+    bool track(int fd);
+    void untrack(int fd);
+
+    TestProxyServer(const TestProxyServer&);
+    void operator=(const TestProxyServer&);
+
+private:
+    std::string m_username;
+    std::string m_password;
+    bool m_fragmented;
+    int m_listen;
+    unsigned short m_port;
+    std::thread m_acceptThread;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_exited;
+    std::set<int> m_sockets;        //  m_mutex ͻӣstop() ʱ shutdown
+    size_t m_running;               //  m_mutex 
+    bool m_stopped;
+    std::vector<std::string> m_lines;   //  m_mutex 
+
+    std::atomic<size_t> m_connections;
+    std::atomic<size_t> m_authFailures;
+};
+
+#endif /* __TESTPROXYSERVER_H__ */
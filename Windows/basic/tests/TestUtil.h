@@ -0,0 +1,57 @@
+#ifndef __TESTUTIL_H__
+#define __TESTUTIL_H__
+
+#include <chrono>
+#include <stdio.h>
+/**************************************************************************/
+
+/*
+* Ժͻ׼õСߣԿ
+*
+* ÿһĳTEST_CHECK ʧʱӡλòִУmain  return testResult(...)
+*  Makefile  build Ŀ¼Удļ
+*/
+
+inline int& testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define TEST_CHECK(expr) \
+    do \
+    { \
+        if (!(expr)) \
+        { \
+            ++testFailures(); \
+            ::fprintf(stderr, "%s:%d: TEST_CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+        } \
+    } while (0)
+
+inline int testResult(const char* name)
+{
+    if (0 == testFailures())
+    {
+        ::printf("%s: OK\n", name);
+        return 0;
+    }
+    ::printf("%s: %d check(s) failed\n", name, testFailures());
+    return 1;
+}
+
+class TestStopwatch
+{
+public:
+    TestStopwatch() : m_start(std::chrono::steady_clock::now()) {}
+
+    void restart() { m_start = std::chrono::steady_clock::now(); }
+    double elapsedMs() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#endif /* __TESTUTIL_H__ */
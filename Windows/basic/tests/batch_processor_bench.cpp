@@ -0,0 +1,122 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+/**************************************************************************/
+
+/*
+* BatchProcessor дһͳƿյĺʱ߳벻ͬ߳ĴԱ
+*/
+
+namespace
+{
+    const size_t kDocuments = 20000;
+    const int kRuns = 5;
+
+    std::string makeSnapshot(std::mt19937& random, size_t index)
+    {
+        Json::Value stats;
+        stats["timestamp"] = static_cast<Json::Int64>(1790000000000LL + index * 2000);
+        stats["rtt"] = static_cast<int>(random() % 400);
+        stats["upLoss"] = static_cast<int>(random() % 30);
+        stats["downLoss"] = static_cast<int>(random() % 30);
+        for (int user = 0; user < 4; ++user)
+        {
+            Json::Value remote;
+            remote["userId"] = "user_" + std::to_string(1000 + user);
+            remote["finalLoss"] = static_cast<double>(random() % 1000) / 100.0;
+            remote["width"] = 640;
+            remote["height"] = 360;
+            remote["frameRate"] = 15;
+            remote["videoBitrate"] = 500 + static_cast<int>(random() % 300);
+            stats["remoteStatistics"].append(remote);
+        }
+        Json::StreamWriterBuilder writer;
+        writer["indentation"] = "";
+        return Json::writeString(writer, stats);
+    }
+
+    void report(const char* name, double parseMs, double writeMs, double baseParse, double baseWrite)
+    {
+        ::printf("  %-14s parse %8.2f ms (%4.1fx)   write %8.2f ms (%4.1fx)\n"
+            , name, parseMs, baseParse / parseMs, writeMs, baseWrite / writeMs);
+    }
+}
+
+int main()
+{
+    std::mt19937 random(17);
+    std::vector<std::string> documents;
+    std::vector<Json::BatchProcessor::Input> inputs;
+    for (size_t i = 0; i < kDocuments; ++i)
+    {
+        documents.push_back(makeSnapshot(random, i));
+    }
+    for (size_t i = 0; i < kDocuments; ++i)
+    {
+        Json::BatchProcessor::Input input = { documents[i].data(), documents[i].data() + documents[i].size() };
+        inputs.push_back(input);
+    }
+    ::printf("batch_processor_bench: %zu documents of ~%zu bytes, %u hardware threads, best of %d runs\n"
+        , kDocuments, documents[0].size(), std::thread::hardware_concurrency(), kRuns);
+
+    Json::CharReaderBuilder builder;
+    Json::StreamWriterBuilder writers;
+    writers["indentation"] = "";
+
+    // ߣһ CharReaderһ StreamWriter 
+    double baseParse = 1e18;
+    double baseWrite = 1e18;
+    std::vector<Json::Value> expected(kDocuments);
+    std::vector<std::string> written(kDocuments);
+    {
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        std::unique_ptr<Json::StreamWriter> writer(writers.newStreamWriter());
+        for (int run = 0; run < kRuns; ++run)
+        {
+            TestStopwatch watch;
+            for (size_t i = 0; i < kDocuments; ++i)
+            {
+                reader->parse(inputs[i].begin, inputs[i].end, &expected[i], NULL);
+            }
+            baseParse = (std::min)(baseParse, watch.elapsedMs());
+            watch.restart();
+            for (size_t i = 0; i < kDocuments; ++i)
+            {
+                std::ostringstream out;
+                writer->write(expected[i], &out);
+                written[i] = out.str();
+            }
+            baseWrite = (std::min)(baseWrite, watch.elapsedMs());
+        }
+    }
+    report("loop", baseParse, baseWrite, baseParse, baseWrite);
+
+    static const unsigned kThreads[] = { 1, 2, 4, 8, 0 };
+    for (size_t t = 0; t < sizeof(kThreads) / sizeof(kThreads[0]); ++t)
+    {
+        Json::BatchProcessor processor(builder, writers, kThreads[t]);
+        double bestParse = 1e18;
+        double bestWrite = 1e18;
+        std::vector<Json::Value> roots;
+        std::vector<std::string> output;
+        for (int run = 0; run < kRuns; ++run)
+        {
+            TestStopwatch watch;
+            TEST_CHECK(0 == processor.parse(inputs, roots, NULL));
+            bestParse = (std::min)(bestParse, watch.elapsedMs());
+            watch.restart();
+            processor.write(roots, output);
+            bestWrite = (std::min)(bestWrite, watch.elapsedMs());
+        }
+        TEST_CHECK(expected == roots && written == output);
+        std::string name = std::to_string(processor.threadCount()) + " thread(s)";
+        report(name.c_str(), bestParse, bestWrite, baseParse, baseWrite);
+    }
+    return testResult("batch_processor_bench");
+}
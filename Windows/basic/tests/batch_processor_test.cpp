@@ -0,0 +1,238 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+/**************************************************************************/
+
+/*
+* BatchProcessorÿĽͬһ±꣨뵥߳ CharReader Ľͬ
+* ϢʧܸӦ"zeroCopy"  builder ҲõɡڴٺȻЧĽb819aea
+* reader ׳쳣׳Լʹã߳ͬʱύλ
+*/
+
+namespace
+{
+    std::string makeDocument(size_t index, std::mt19937& random)
+    {
+        Json::Value root;
+        root["index"] = static_cast<Json::UInt64>(index);
+        root["userId"] = "user_" + std::to_string(index);
+        root["text"] = std::string(random() % 200, static_cast<char>('a' + index % 26)) + "\"\\\n";
+        for (size_t i = random() % 20; i > 0; --i)
+        {
+            root["list"].append(static_cast<double>(random() % 1000) / 8);
+        }
+        Json::StreamWriterBuilder writer;
+        writer["indentation"] = (index % 2) ? "" : "  ";
+        return Json::writeString(writer, root);
+    }
+
+    struct Batch
+    {
+        std::vector<std::string> documents;
+        std::vector<Json::BatchProcessor::Input> inputs;
+
+        void add(const std::string& document)
+        {
+            documents.push_back(document);
+        }
+        void seal()
+        {
+            inputs.clear();
+            for (size_t i = 0; i < documents.size(); ++i)
+            {
+                Json::BatchProcessor::Input input = { documents[i].data(), documents[i].data() + documents[i].size() };
+                inputs.push_back(input);
+            }
+        }
+    };
+
+    // ÿ badEvery һĵ0 ʾû
+    Batch makeBatch(size_t count, size_t badEvery, unsigned seed)
+    {
+        std::mt19937 random(seed);
+        Batch batch;
+        for (size_t i = 0; i < count; ++i)
+        {
+            batch.add((badEvery && 0 == i % badEvery) ? "{\"index\":" + std::to_string(i) + ",]" : makeDocument(i, random));
+        }
+        batch.seal();
+        return batch;
+    }
+
+    // 뵥߳Ľգزһµĸ
+    size_t verify(const Batch& batch, const std::vector<Json::Value>& roots, const std::vector<std::string>& errors
+        , size_t failures, Json::CharReaderBuilder& builder)
+    {
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        size_t mismatches = 0;
+        size_t expectedFailures = 0;
+        if (roots.size() != batch.inputs.size() || errors.size() != batch.inputs.size())
+        {
+            return batch.inputs.size() + 1;
+        }
+        for (size_t i = 0; i < batch.inputs.size(); ++i)
+        {
+            Json::Value expected;
+            std::string expectedErrors;
+            bool ok = reader->parse(batch.inputs[i].begin, batch.inputs[i].end, &expected, &expectedErrors);
+            expectedFailures += ok ? 0 : 1;
+            if (expectedErrors != errors[i] || (ok && false == (expected == roots[i])) || (ok && i != roots[i]["index"].asUInt64()))
+            {
+                ++mismatches;
+            }
+        }
+        return mismatches + (failures == expectedFailures ? 0 : 1);
+    }
+
+    void testResultsInOrder()
+    {
+        Json::CharReaderBuilder builder;
+        Json::StreamWriterBuilder writers;
+        static const unsigned kThreads[] = { 1, 2, 4, 0 };
+        for (size_t t = 0; t < sizeof(kThreads) / sizeof(kThreads[0]); ++t)
+        {
+            Json::BatchProcessor processor(builder, writers, kThreads[t]);
+            TEST_CHECK(kThreads[t] ? kThreads[t] == processor.threadCount() : processor.threadCount() >= 1);
+            for (unsigned round = 0; round < 3; ++round)
+            {
+                Batch batch = makeBatch(500 + round * 250, 7 + round, round);
+                std::vector<Json::Value> roots;
+                std::vector<std::string> errors;
+                size_t failures = processor.parse(batch.inputs, roots, &errors);
+                TEST_CHECK(failures > 0);
+                TEST_CHECK(0 == verify(batch, roots, errors, failures, builder));
+            }
+
+            // κͲҪϢ
+            std::vector<Json::Value> roots(3);
+            TEST_CHECK(0 == processor.parse(std::vector<Json::BatchProcessor::Input>(), roots, NULL));
+            TEST_CHECK(roots.empty());
+            Batch good = makeBatch(100, 0, 9);
+            TEST_CHECK(0 == processor.parse(good.inputs, roots, NULL));
+            TEST_CHECK(99 == roots[99]["index"].asInt());
+        }
+    }
+
+    void testZeroCopyBuilder()
+    {
+        // һ߳νĸĵĸͬĵһķ
+        Json::CharReaderBuilder zeroCopy;
+        zeroCopy["zeroCopy"] = true;
+        Json::CharReaderBuilder copying;
+        std::vector<Json::Value> roots;
+        std::vector<std::string> errors;
+        {
+            Batch batch = makeBatch(4, 0, 1);
+            {
+                Json::BatchProcessor processor(zeroCopy, Json::StreamWriterBuilder(), 1);
+                TEST_CHECK(0 == processor.parse(batch.inputs, roots, &errors));
+            }
+            TEST_CHECK(0 == verify(batch, roots, errors, 0, copying));
+
+            // 붼٣ȻԶд
+            Batch more = makeBatch(2000, 0, 2);
+            Json::BatchProcessor processor(zeroCopy, Json::StreamWriterBuilder(), 4);
+            std::vector<Json::Value> moreRoots;
+            TEST_CHECK(0 == processor.parse(more.inputs, moreRoots, &errors));
+            TEST_CHECK(0 == verify(more, moreRoots, errors, 0, copying));
+            roots.insert(roots.end(), moreRoots.begin(), moreRoots.end());
+        }
+        TEST_CHECK(2004 == roots.size());
+        for (size_t i = 0; i < roots.size(); ++i)
+        {
+            TEST_CHECK(roots[i]["userId"].asString() == "user_" + std::to_string(i < 4 ? i : i - 4));
+        }
+    }
+
+    void testWrite()
+    {
+        Json::CharReaderBuilder builder;
+        Json::StreamWriterBuilder writers;
+        writers["indentation"] = "";
+        Json::BatchProcessor processor(builder, writers, 4);
+        Batch batch = makeBatch(1000, 0, 3);
+        std::vector<Json::Value> roots;
+        TEST_CHECK(0 == processor.parse(batch.inputs, roots, NULL));
+
+        std::vector<std::string> documents(5, "stale");
+        processor.write(roots, documents);
+        TEST_CHECK(roots.size() == documents.size());
+        size_t mismatches = 0;
+        for (size_t i = 0; i < roots.size(); ++i)
+        {
+            if (Json::writeString(writers, roots[i]) != documents[i])
+            {
+                ++mismatches;
+            }
+        }
+        TEST_CHECK(0 == mismatches);
+    }
+
+    void testException()
+    {
+        //  stackLimit ʱ CharReader 쳣׸ߣ֮βӰ
+        Json::CharReaderBuilder builder;
+        builder["stackLimit"] = 50;
+        Json::BatchProcessor processor(builder, Json::StreamWriterBuilder(), 4);
+        Batch batch = makeBatch(400, 0, 4);
+        batch.documents[200] = std::string(100, '[') + std::string(100, ']');
+        batch.seal();
+        std::vector<Json::Value> roots;
+        bool thrown = false;
+        try
+        {
+            processor.parse(batch.inputs, roots, NULL);
+        }
+        catch (const Json::RuntimeError&)
+        {
+            thrown = true;
+        }
+        TEST_CHECK(thrown);
+
+        Batch good = makeBatch(400, 0, 5);
+        std::vector<std::string> errors;
+        TEST_CHECK(0 == processor.parse(good.inputs, roots, &errors));
+        TEST_CHECK(0 == verify(good, roots, errors, 0, builder));
+    }
+
+    void testConcurrentBatches()
+    {
+        Json::CharReaderBuilder builder;
+        Json::BatchProcessor processor(builder, Json::StreamWriterBuilder(), 3);
+        std::vector<size_t> mismatches(4, 0);
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < mismatches.size(); ++t)
+        {
+            threads.push_back(std::thread([&, t]() {
+                Json::CharReaderBuilder local;
+                for (unsigned round = 0; round < 10; ++round)
+                {
+                    Batch batch = makeBatch(200, 5, t * 100 + round);
+                    std::vector<Json::Value> roots;
+                    std::vector<std::string> errors;
+                    size_t failures = processor.parse(batch.inputs, roots, &errors);
+                    mismatches[t] += verify(batch, roots, errors, failures, local);
+                }
+            }));
+        }
+        for (size_t i = 0; i < threads.size(); ++i)
+        {
+            threads[i].join();
+            TEST_CHECK(0 == mismatches[i]);
+        }
+    }
+}
+
+int main()
+{
+    testResultsInOrder();
+    testZeroCopyBuilder();
+    testWrite();
+    testException();
+    testConcurrentBatches();
+    return testResult("batch_processor_test");
+}
@@ -0,0 +1,201 @@
+#include "TestUtil.h"
+#include "FileWatcher.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <thread>
+/**************************************************************************/
+
+/*
+* FileWatcherinotifyʱļǺԭطּдֻصһΣһ޸һ޸
+* debounce ֮ϲһλصͬĿ¼ļ޸Ĳصص׳쳣֮޸ճ֪ͨ
+* stop() ȻûڵĻص
+*/
+
+namespace
+{
+    const unsigned int kDebounceMs = 100;
+    const int kSettleMs = 400;      // ȴϲĻصִ
+
+    // صһλصʱ䣻صڼִ߳
+    class CallCounter
+    {
+    public:
+        CallCounter() : m_calls(0) {}
+
+        void hit()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_calls;
+            m_last = std::chrono::steady_clock::now();
+        }
+
+        int calls()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_calls;
+        }
+
+        std::chrono::steady_clock::time_point last()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_last;
+        }
+
+    private:
+        std::mutex m_mutex;
+        int m_calls;
+        std::chrono::steady_clock::time_point m_last;
+    };
+
+    void sleepMs(int ms)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+
+    void writeFile(const char* path, const std::string& content)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << content;
+    }
+
+    // ༭ CConfigMgr ı淽ʽ
+    void replaceFile(const char* path, const std::string& content)
+    {
+        std::string tmpPath = std::string(path) + ".tmp";
+        writeFile(tmpPath.c_str(), content);
+        std::rename(tmpPath.c_str(), path);
+    }
+
+    // ͬһļϷּд
+    void writeInPlace(const char* path, int pieces)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        for (int i = 0; i < pieces; ++i)
+        {
+            file << "piece " << i << "\n";
+            file.flush();
+            sleepMs(10);
+        }
+    }
+
+    void testRewrites()
+    {
+        writeFile("watched/config.ini", "[a]\n");
+        CallCounter config;
+        CallCounter unrelated;
+        FileWatcher watcher;
+        TEST_CHECK(watcher.watch(L"watched/config.ini", [&config] { config.hit(); }));
+        TEST_CHECK(watcher.watch(L"watched/other.ini", [&unrelated] { unrelated.hit(); }));
+        TEST_CHECK(watcher.start(kDebounceMs));
+
+        replaceFile("watched/config.ini", "[b]\n");
+        sleepMs(kSettleMs);
+        TEST_CHECK(1 == config.calls());
+
+        writeInPlace("watched/config.ini", 5);
+        sleepMs(kSettleMs);
+        TEST_CHECK(2 == config.calls());
+
+        // С debounce һ޸ģһ޸֮Żصֻصһ
+        std::chrono::steady_clock::time_point lastWrite;
+        for (int i = 0; i < 10; ++i)
+        {
+            if (0 == i % 2)
+            {
+                replaceFile("watched/config.ini", "[burst]\n");
+            }
+            else
+            {
+                writeFile("watched/config.ini", "[burst]\n");
+            }
+            lastWrite = std::chrono::steady_clock::now();
+            sleepMs(kDebounceMs / 3);
+            TEST_CHECK(2 == config.calls());
+        }
+        sleepMs(kSettleMs);
+        TEST_CHECK(3 == config.calls());
+        double afterLastMs = std::chrono::duration<double, std::milli>(config.last() - lastWrite).count();
+        TEST_CHECK(afterLastMs >= kDebounceMs - 5);
+        ::printf("  burst of 10 rewrites: 1 callback %.0f ms after the last one\n", afterLastMs);
+
+        // ͬĿ¼ûмӵļõʱļ
+        writeFile("watched/unwatched.ini", "x");
+        replaceFile("watched/unwatched.ini", "y");
+        sleepMs(kSettleMs);
+        TEST_CHECK(3 == config.calls());
+        TEST_CHECK(0 == unrelated.calls());
+
+        // ӵļʱҲյ
+        replaceFile("watched/other.ini", "created");
+        sleepMs(kSettleMs);
+        TEST_CHECK(1 == unrelated.calls());
+        TEST_CHECK(3 == config.calls());
+        watcher.stop();
+    }
+
+    void testThrowingCallback()
+    {
+        std::atomic<int> calls(0);
+        FileWatcher watcher;
+        TEST_CHECK(watcher.watch(L"watched/broken.ini", [&calls] {
+            ++calls;
+            throw std::runtime_error("half-written file");
+        }));
+        TEST_CHECK(watcher.start(kDebounceMs));
+
+        replaceFile("watched/broken.ini", "1");
+        sleepMs(kSettleMs);
+        TEST_CHECK(1 == calls);
+        writeInPlace("watched/broken.ini", 2);
+        sleepMs(kSettleMs);
+        TEST_CHECK(2 == calls);
+        replaceFile("watched/broken.ini", "3");
+        sleepMs(kSettleMs);
+        TEST_CHECK(3 == calls);
+    }
+
+    void testStop()
+    {
+        // ʱ
+        {
+            FileWatcher watcher;
+            TEST_CHECK(watcher.watch(L"watched/config.ini", [] {}));
+            TEST_CHECK(watcher.start(kDebounceMs));
+            sleepMs(50);
+            TestStopwatch watch;
+            watcher.stop();
+            TEST_CHECK(watch.elapsedMs() < 100);
+        }
+
+        // һûڵĻصҲִ
+        std::atomic<int> calls(0);
+        FileWatcher watcher;
+        TEST_CHECK(watcher.watch(L"watched/config.ini", [&calls] { ++calls; }));
+        TEST_CHECK(watcher.start(5000));
+        replaceFile("watched/config.ini", "[pending]\n");
+        sleepMs(50);
+        TestStopwatch watch;
+        watcher.stop();
+        double stopMs = watch.elapsedMs();
+        TEST_CHECK(stopMs < 100);
+        TEST_CHECK(0 == calls);
+        ::printf("  stop() with a pending callback: %.2f ms\n", stopMs);
+
+        watcher.stop();     // ظ stop() ޺ʱٵһ
+    }
+}
+
+int main()
+{
+    ::mkdir("watched", 0755);
+
+    testRewrites();
+    testThrowingCallback();
+    testStop();
+    return testResult("file_watcher_test");
+}
@@ -0,0 +1,335 @@
+#include "TestUtil.h"
+#include "TestHttpServer.h"
+#include "TestPlainTls.h"
+#include "HttpClient.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+/**************************************************************************/
+
+/*
+* socket/epoll ˶ HttpClient ӿڵΪӦķ֡ʽ 200 Ӧʽֹ
+* 롢TLS ӣͬ첽ӿڴԼ첽ӿڵʽ
+*/
+
+namespace
+{
+    std::string makeBody(size_t size)
+    {
+        std::string body(size, '\0');
+        for (size_t i = 0; i < size; ++i)
+        {
+            body[i] = static_cast<char>('a' + i % 26);
+        }
+        return body;
+    }
+
+    void handle(const TestHttpRequest& request, TestHttpResponse& response)
+    {
+        if (0 == request.path.compare(0, 5, "/echo"))
+        {
+            response.body = request.method + ":" + request.header("x-test") + ":" + request.body;
+        }
+        else if ("/chunked" == request.path)
+        {
+            response.body = makeBody(100000);
+            response.chunked = true;
+        }
+        else if ("/eof" == request.path)
+        {
+            response.body = "until-close";
+            response.close = true;
+        }
+        else if ("/large" == request.path)
+        {
+            response.body = makeBody(2 * 1024 * 1024);
+        }
+        else if ("/truncated" == request.path)
+        {
+            response.body = makeBody(1000);
+            response.fault = TestFaultTruncate;
+        }
+        else
+        {
+            response.status = 404;
+            response.body = "nop";
+        }
+    }
+
+    class CountingSink : public HttpBodySink
+    {
+    public:
+        explicit CountingSink(size_t limit = 0) : bytes(0), chunks(0), m_limit(limit) {}
+
+        virtual bool onData(const char*, size_t size)
+        {
+            bytes += size;
+            ++chunks;
+            return 0 == m_limit || bytes < m_limit;
+        }
+
+        size_t bytes;
+        size_t chunks;
+
+    private:
+        size_t m_limit;
+    };
+
+    // Ӧ岢 onData ڵ߳
+    class CollectingSink : public HttpBodySink
+    {
+    public:
+        CollectingSink() : chunks(0) {}
+
+        virtual bool onData(const char* data, size_t size)
+        {
+            this->data.append(data, size);
+            ++chunks;
+            thread = std::this_thread::get_id();
+            return true;
+        }
+
+        std::string data;
+        size_t chunks;
+        std::thread::id thread;
+    };
+
+    class AsyncWaiter
+    {
+    public:
+        explicit AsyncWaiter(int count) : m_left(count) {}
+
+        HttpCallback callback(const std::function<void(DWORD, std::string&)>& check)
+        {
+            return [this, check](DWORD error, std::string& data) {
+                check(error, data);
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (0 == --m_left)
+                {
+                    m_done.notify_all();
+                }
+            };
+        }
+
+        HttpSinkCallback sinkCallback(const std::function<void(DWORD)>& check)
+        {
+            HttpCallback done = callback([check](DWORD error, std::string&) { check(error); });
+            return [done](DWORD error) {
+                std::string empty;
+                done(error, empty);
+            };
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (0 != m_left)
+            {
+                m_done.wait(lock);
+            }
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_done;
+        int m_left;
+    };
+
+    void testBodies(HttpClient& client, TestHttpServer& server)
+    {
+        std::vector<std::wstring> headers(1, L"X-Test: 1");
+        std::string data;
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/echo"), headers, data));
+        TEST_CHECK("GET:1:" == data);
+
+        data.clear();
+        TEST_CHECK(ERROR_SUCCESS == client.http_post(server.url("/echo"), headers, "{\"userId\":\"u\"}", data));
+        TEST_CHECK("POST:1:{\"userId\":\"u\"}" == data);
+
+        data.clear();
+        TEST_CHECK(ERROR_SUCCESS == client.http_put(server.url("/echo"), headers, "put-body", data));
+        TEST_CHECK("PUT:1:put-body" == data);
+
+        data.clear();
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/chunked"), headers, data));
+        TEST_CHECK(makeBody(100000) == data);
+
+        data.clear();
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/eof"), headers, data));
+        TEST_CHECK("until-close" == data);
+
+        //  200 ʱ EcHttpCodeErrorӦճ÷
+        data.clear();
+        TEST_CHECK(EcHttpCodeError == client.http_get(server.url("/missing"), headers, data));
+        TEST_CHECK("nop" == data);
+
+        data.clear();
+        TEST_CHECK(ERROR_SUCCESS != client.http_get(server.url("/truncated"), headers, data));
+    }
+
+    void testStreaming(HttpClient& client, TestHttpServer& server)
+    {
+        std::vector<std::wstring> headers;
+        CountingSink sink;
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/large"), headers, sink));
+        TEST_CHECK(2 * 1024 * 1024 == sink.bytes);
+        TEST_CHECK(sink.chunks > 1);
+
+        CountingSink aborting(64 * 1024);
+        TEST_CHECK(EcHttpAborted == client.http_get(server.url("/large"), headers, aborting));
+        TEST_CHECK(aborting.bytes < 2 * 1024 * 1024);
+
+        // ֹӲڳб
+        std::string data;
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/echo"), headers, data));
+        TEST_CHECK("GET::" == data);
+    }
+
+    void testErrors(HttpClient& client, TestHttpServer& server)
+    {
+        std::vector<std::wstring> headers;
+        std::string data;
+        TEST_CHECK(EcHttpInvalidUrl == client.http_get(L"not a url", headers, data));
+        TEST_CHECK(ECONNREFUSED == client.http_get(L"http://127.0.0.1:1/", headers, data));
+
+        std::wstring https = server.url("/echo");
+        https.replace(0, 4, L"https");
+        TEST_CHECK(EcHttpUnsupported == client.http_get(https, headers, data));
+    }
+
+    void testTlsHook(TestHttpServer& server)
+    {
+        TestPlainTlsProvider provider;
+        HttpClient client(L"http_backend_test");
+        client.setTlsProvider(&provider);
+        std::wstring https = server.url("/echo");
+        https.replace(0, 4, L"https");
+        std::vector<std::wstring> headers;
+        for (int i = 0; i < 3; ++i)
+        {
+            std::string data;
+            TEST_CHECK(ERROR_SUCCESS == client.http_get(https, headers, data));
+            TEST_CHECK("GET::" == data);
+        }
+        TEST_CHECK(1 == provider.channels);     // õӲ
+        TEST_CHECK("127.0.0.1" == provider.lastHost);
+
+        AsyncWaiter waiter(1);
+        client.http_get_async(https, headers, waiter.callback([](DWORD error, std::string& data) {
+            TEST_CHECK(ERROR_SUCCESS == error && "GET::" == data);
+        }));
+        waiter.wait();
+    }
+
+    void testAsync(HttpClient& client, TestHttpServer& server)
+    {
+        const int kRequests = 300;
+        std::vector<std::wstring> headers;
+        std::atomic<int> failures(0);
+        AsyncWaiter waiter(kRequests);
+        for (int i = 0; i < kRequests; ++i)
+        {
+            switch (i % 4)
+            {
+            case 0:
+                client.http_post_async(server.url("/echo"), headers, std::to_string(i), waiter.callback([i, &failures](DWORD error, std::string& data) {
+                    failures += (ERROR_SUCCESS != error || "POST::" + std::to_string(i) != data);
+                }));
+                break;
+            case 1:
+                client.http_get_async(server.url("/chunked"), headers, waiter.callback([&failures](DWORD error, std::string& data) {
+                    failures += (ERROR_SUCCESS != error || 100000 != data.size());
+                }));
+                break;
+            case 2:
+                client.http_get_async(server.url("/eof"), headers, waiter.callback([&failures](DWORD error, std::string& data) {
+                    failures += (ERROR_SUCCESS != error || "until-close" != data);
+                }));
+                break;
+            default:
+                client.http_get_async(server.url("/missing"), headers, waiter.callback([&failures](DWORD error, std::string& data) {
+                    failures += (EcHttpCodeError != error || "nop" != data);
+                }));
+                break;
+            }
+        }
+        waiter.wait();
+        TEST_CHECK(0 == failures);
+
+        // ͬص
+        AsyncWaiter errors(2);
+        client.http_get_async(L"not a url", headers, errors.callback([](DWORD error, std::string&) {
+            TEST_CHECK(EcHttpInvalidUrl == error);
+        }));
+        client.http_get_async(L"http://127.0.0.1:1/", headers, errors.callback([](DWORD error, std::string&) {
+            TEST_CHECK(ECONNREFUSED == error);
+        }));
+        errors.wait();
+    }
+
+    void testAsyncStreaming(HttpClient& client, TestHttpServer& server)
+    {
+        std::vector<std::wstring> headers;
+        CollectingSink large;
+        size_t completedWith = 0;
+        AsyncWaiter waiter(1);
+        client.http_get_async(server.url("/large"), headers, large, waiter.sinkCallback([&](DWORD error) {
+            TEST_CHECK(ERROR_SUCCESS == error);
+            completedWith = large.data.size();
+        }));
+        waiter.wait();
+        // ص֮ǰӦѾȫ I/O ߳Ͻ sink
+        TEST_CHECK(2 * 1024 * 1024 == completedWith);
+        TEST_CHECK(makeBody(2 * 1024 * 1024) == large.data);
+        TEST_CHECK(large.chunks > 1);
+        TEST_CHECK(std::this_thread::get_id() != large.thread);
+
+        CollectingSink chunked;
+        CollectingSink posted;
+        CollectingSink missing;
+        CountingSink aborting(64 * 1024);
+        AsyncWaiter others(4);
+        client.http_get_async(server.url("/chunked"), headers, chunked, others.sinkCallback([](DWORD error) {
+            TEST_CHECK(ERROR_SUCCESS == error);
+        }));
+        client.http_post_async(server.url("/echo"), headers, "body", posted, others.sinkCallback([](DWORD error) {
+            TEST_CHECK(ERROR_SUCCESS == error);
+        }));
+        client.http_get_async(server.url("/missing"), headers, missing, others.sinkCallback([](DWORD error) {
+            TEST_CHECK(EcHttpCodeError == error);
+        }));
+        client.http_get_async(server.url("/large"), headers, aborting, others.sinkCallback([](DWORD error) {
+            TEST_CHECK(EcHttpAborted == error);
+        }));
+        others.wait();
+        TEST_CHECK(makeBody(100000) == chunked.data);
+        TEST_CHECK("POST::body" == posted.data);
+        TEST_CHECK("nop" == missing.data);
+        TEST_CHECK(aborting.bytes < 2 * 1024 * 1024);
+
+        // ֹûлصУ
+        CollectingSink after;
+        AsyncWaiter last(1);
+        client.http_get_async(server.url("/echo"), headers, after, last.sinkCallback([](DWORD error) {
+            TEST_CHECK(ERROR_SUCCESS == error);
+        }));
+        last.wait();
+        TEST_CHECK("GET::" == after.data);
+    }
+}
+
+int main()
+{
+    TestHttpServer server(handle);
+    TEST_CHECK(server.start());
+
+    HttpClient client(L"http_backend_test");
+    testBodies(client, server);
+    testStreaming(client, server);
+    testErrors(client, server);
+    testTlsHook(server);
+    testAsync(client, server);
+    testAsyncStreaming(client, server);
+    return testResult("http_backend_test");
+}
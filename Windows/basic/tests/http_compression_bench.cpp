@@ -0,0 +1,138 @@
+#include "TestUtil.h"
+#include "TestHttpServer.h"
+#include "HttpClient.h"
+#include "HttpContentCoding.h"
+#include "json.h"
+#include <cstdio>
+#include <zlib.h>
+/**************************************************************************/
+
+/*
+* ѹ棺ٵ·ϣÿ 512KB/sغϴͬһ JSON
+* رѹʱ·ϵֽÿĺʱ
+*/
+
+namespace
+{
+    const size_t kBandwidth = 512 * 1024;
+    const int kRounds = 5;
+
+    std::string makePayload()
+    {
+        Json::Value root;
+        root["errorCode"] = 0;
+        Json::Value& users = root["data"]["users"];
+        for (int i = 0; i < 1500; ++i)
+        {
+            Json::Value user;
+            user["userId"] = "user_" + std::to_string(100000 + i);
+            user["nickName"] = "nick " + std::to_string(i % 97);
+            user["roomId"] = 1000 + i % 20;
+            user["role"] = (0 == i % 10) ? "anchor" : "audience";
+            user["streamUrl"] = "rtmp://live.example.com/live/1400000000_" + std::to_string(100000 + i);
+            user["online"] = (0 != i % 3);
+            users.append(user);
+        }
+        Json::FastWriter writer;
+        return writer.write(root);
+    }
+
+    bool gunzip(const std::string& data, std::string& out)
+    {
+        z_stream stream = z_stream();
+        if (Z_OK != inflateInit2(&stream, 15 + 16))
+        {
+            return false;
+        }
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        char buffer[64 * 1024];
+        int ret = Z_OK;
+        while (Z_OK == ret)
+        {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer);
+            stream.avail_out = sizeof(buffer);
+            ret = inflate(&stream, Z_NO_FLUSH);
+            out.append(buffer, sizeof(buffer) - stream.avail_out);
+        }
+        inflateEnd(&stream);
+        return Z_STREAM_END == ret;
+    }
+
+    const std::string& payload()
+    {
+        static const std::string data = makePayload();
+        return data;
+    }
+
+    void handle(const TestHttpRequest& request, TestHttpResponse& response)
+    {
+        if ("POST" == request.method)
+        {
+            std::string body = request.body;
+            if ("gzip" == request.header("content-encoding"))
+            {
+                body.clear();
+                if (false == gunzip(request.body, body))
+                {
+                    response.status = 400;
+                    return;
+                }
+            }
+            response.body = (payload() == body) ? "ok" : "mismatch";
+            return;
+        }
+
+        response.body = payload();
+        if (std::string::npos != request.header("accept-encoding").find("gzip"))
+        {
+            httpGzip(payload(), response.body);
+            response.headers.push_back("Content-Encoding: gzip");
+        }
+    }
+
+    void run(TestHttpServer& server, const char* name, bool upload, bool compress)
+    {
+        HttpClient client(L"http_compression_bench");
+        client.setDecompression(compress);
+        client.setRequestCompression(compress ? 1024 : 0);
+        std::vector<std::wstring> headers(1, L"Content-Type: application/json");
+
+        std::string data;
+        client.http_get(server.url("/warmup"), headers, data);     // ӽúټʱ
+        server.resetCounters();
+
+        TestStopwatch watch;
+        for (int i = 0; i < kRounds; ++i)
+        {
+            data.clear();
+            if (upload)
+            {
+                TEST_CHECK(ERROR_SUCCESS == client.http_post(server.url("/upload"), headers, payload(), data));
+                TEST_CHECK("ok" == data);
+            }
+            else
+            {
+                TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/download"), headers, data));
+                TEST_CHECK(payload() == data);
+            }
+        }
+        double ms = watch.elapsedMs() / kRounds;
+        unsigned long long wire = (upload ? server.bytesReceived() : server.bytesSent()) / kRounds;
+        ::printf("  %-22s %8llu bytes on the wire  %7.1f ms per request\n", name, wire, ms);
+    }
+}
+
+int main()
+{
+    TestHttpServer server(handle);
+    TEST_CHECK(server.start());
+    server.setBandwidth(kBandwidth);
+
+    ::printf("http_compression_bench: %zu byte JSON, %zu KB/s each way\n", payload().size(), kBandwidth / 1024);
+    run(server, "download, identity", false, false);
+    run(server, "download, gzip", false, true);
+    run(server, "upload, identity", true, false);
+    run(server, "upload, gzip", true, true);
+    return testResult("http_compression_bench");
+}
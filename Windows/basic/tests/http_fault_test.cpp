@@ -0,0 +1,320 @@
+#include "TestUtil.h"
+#include "TestHttpServer.h"
+#include "HttpClient.h"
+#include <condition_variable>
+#include <cstdlib>
+#include <errno.h>
+#include <map>
+#include <mutex>
+#include <thread>
+/**************************************************************************/
+
+/*
+* ע룺˰·ֱ RSTӦ͹رաסءضӦӦ
+* ֹ֤ʱ䡢ԣֻݵ󣩡ʱȡȴеԡԳԼЩʽ첽ӿϵı
+*
+* · /<>/<key>/<n>ͬһ key ǰ n עϣ֮ "recovered"
+*/
+
+namespace
+{
+    std::mutex g_mutex;
+    std::map<std::string, int> g_counters;     // key -> յ
+
+    void handle(const TestHttpRequest& request, TestHttpResponse& response)
+    {
+        std::string path = request.path;
+        size_t first = path.find('/', 1);
+        size_t second = (std::string::npos == first) ? std::string::npos : path.find('/', first + 1);
+        if ("/hang" == path)
+        {
+            response.fault = TestFaultHang;
+            return;
+        }
+        if ("/truncate" == path)
+        {
+            response.body = std::string(1000, 'x');
+            response.fault = TestFaultTruncate;
+            return;
+        }
+        if (std::string::npos == second)
+        {
+            response.status = 404;
+            return;
+        }
+
+        std::string fault = path.substr(1, first - 1);
+        std::string key = path.substr(first + 1, second - first - 1);
+        int limit = std::atoi(path.c_str() + second + 1);
+        int count = 0;
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            if ("count" == fault)
+            {
+                response.body = std::to_string(g_counters[key]);
+                return;
+            }
+            count = g_counters[key]++;
+        }
+
+        response.body = "recovered";
+        if (count < limit)
+        {
+            if ("reset" == fault)
+            {
+                response.fault = TestFaultReset;
+            }
+            else if ("close" == fault)
+            {
+                response.fault = TestFaultClose;
+            }
+            else if ("slow" == fault)
+            {
+                response.delayMs = 1000;
+            }
+        }
+    }
+
+    int serverCount(HttpClient& client, TestHttpServer& server, const std::string& key)
+    {
+        std::string data;
+        client.http_get(server.url("/count/" + key + "/0"), std::vector<std::wstring>(), data);
+        return std::atoi(data.c_str());
+    }
+
+    class AsyncResult
+    {
+    public:
+        AsyncResult() : m_done(false), error(0) {}
+
+        HttpCallback callback()
+        {
+            return [this](DWORD ret, std::string& respData) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                error = ret;
+                data = respData;
+                m_done = true;
+                m_finished.notify_all();
+            };
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (false == m_done)
+            {
+                m_finished.wait(lock);
+            }
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_finished;
+        bool m_done;
+
+    public:
+        DWORD error;
+        std::string data;
+    };
+
+    // ʽ첽ӿڵĽӦ徭 HttpStringSink ս data
+    class AsyncSinkResult : public AsyncResult
+    {
+    public:
+        AsyncSinkResult() : sink(data) {}
+
+        HttpSinkCallback sinkCallback()
+        {
+            HttpCallback done = callback();
+            return [this, done](DWORD ret) {
+                std::string received = data;    // callback() ûص data
+                done(ret, received);
+            };
+        }
+
+        HttpStringSink sink;
+    };
+
+    void testDeadline(TestHttpServer& server)
+    {
+        HttpClient client(L"http_fault_test");
+        client.setRequestTimeout(300);
+        std::vector<std::wstring> headers;
+
+        std::string data;
+        TestStopwatch watch;
+        TEST_CHECK(ETIMEDOUT == client.http_get(server.url("/hang"), headers, data));
+        TEST_CHECK(watch.elapsedMs() < 1000);
+
+        AsyncResult result;
+        watch.restart();
+        client.http_get_async(server.url("/hang"), headers, result.callback());
+        result.wait();
+        TEST_CHECK(ETIMEDOUT == result.error);
+        TEST_CHECK(watch.elapsedMs() < 1000);
+
+        // ӳŶӵֹͬʱ䷵
+        client.setMaxConnectionsPerHost(1);
+        AsyncResult queued[3];
+        watch.restart();
+        for (int i = 0; i < 3; ++i)
+        {
+            client.http_get_async(server.url("/hang"), headers, queued[i].callback());
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            queued[i].wait();
+            TEST_CHECK(ETIMEDOUT == queued[i].error);
+        }
+        TEST_CHECK(watch.elapsedMs() < 1000);
+
+        data.clear();
+        TEST_CHECK(ERROR_SUCCESS != client.http_get(server.url("/truncate"), headers, data));
+    }
+
+    void testRetry(TestHttpServer& server)
+    {
+        HttpRetryPolicy policy;
+        policy.maxAttempts = 3;
+        policy.initialBackoffMs = 50;
+        std::vector<std::wstring> headers;
+
+        HttpClient client(L"http_fault_test");
+        client.setRetryPolicy(policy);
+        std::string data;
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/reset/a/2"), headers, data));
+        TEST_CHECK("recovered" == data);
+        TEST_CHECK(3 == serverCount(client, server, "a"));
+
+        data.clear();
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/close/b/2"), headers, data));
+        TEST_CHECK("recovered" == data);
+
+        AsyncResult put;
+        client.http_put_async(server.url("/reset/c/2"), headers, "x", put.callback());
+        put.wait();
+        TEST_CHECK(ERROR_SUCCESS == put.error && "recovered" == put.data);
+
+        // POST ݵȵģԣµ HttpClient⸴ʧʱ˱ͻһط
+        HttpClient postClient(L"http_fault_test");
+        postClient.setRetryPolicy(policy);
+        data.clear();
+        TEST_CHECK(ERROR_SUCCESS != postClient.http_post(server.url("/reset/d/2"), headers, "x", data));
+        TEST_CHECK(1 == serverCount(client, server, "d"));
+
+        // 󷵻һεĴ
+        HttpClient exhausted(L"http_fault_test");
+        exhausted.setRetryPolicy(policy);
+        data.clear();
+        TEST_CHECK(ERROR_SUCCESS != exhausted.http_get(server.url("/reset/e/5"), headers, data));
+        TEST_CHECK(3 == serverCount(client, server, "e"));
+
+        //  200 Ƿ˵ش𣬲ԣĬϲҲ
+        data.clear();
+        TEST_CHECK(EcHttpCodeError == client.http_get(server.url("/missing"), headers, data));
+        HttpClient noRetry(L"http_fault_test");
+        TEST_CHECK(ERROR_SUCCESS != noRetry.http_get(server.url("/reset/f/1"), headers, data));
+    }
+
+    void testCancelDuringBackoff(TestHttpServer& server)
+    {
+        HttpRetryPolicy policy;
+        policy.maxAttempts = 5;
+        policy.initialBackoffMs = 2000;
+        policy.maxBackoffMs = 2000;
+
+        AsyncResult result;
+        TestStopwatch watch;
+        {
+            HttpClient client(L"http_fault_test");
+            client.setRetryPolicy(policy);
+            client.http_get_async(server.url("/reset/g/9"), std::vector<std::wstring>(), result.callback());
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        result.wait();
+        TEST_CHECK(ECANCELED == result.error);
+        TEST_CHECK(watch.elapsedMs() < 1000);
+    }
+
+    void testHedging(TestHttpServer& server)
+    {
+        HttpRetryPolicy policy;
+        policy.hedgeDelayMs = 100;
+        std::vector<std::wstring> headers;
+
+        // һҪ 1 룬100ms 󷢳ĶԳ
+        HttpClient client(L"http_fault_test");
+        client.setRetryPolicy(policy);
+        std::string data;
+        TestStopwatch watch;
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/slow/h/1"), headers, data));
+        TEST_CHECK("recovered" == data);
+        double syncMs = watch.elapsedMs();
+        TEST_CHECK(syncMs < 800);
+
+        AsyncResult result;
+        watch.restart();
+        client.http_get_async(server.url("/slow/i/1"), headers, result.callback());
+        result.wait();
+        double asyncMs = watch.elapsedMs();
+        TEST_CHECK(ERROR_SUCCESS == result.error && "recovered" == result.data);
+        TEST_CHECK(asyncMs < 800);
+        ::printf("  hedged request against a 1000 ms server: sync %.0f ms, async %.0f ms\n", syncMs, asyncMs);
+
+        // ֹʱͬԼԳе
+        client.setRequestTimeout(300);
+        data.clear();
+        watch.restart();
+        TEST_CHECK(ETIMEDOUT == client.http_get(server.url("/hang"), headers, data));
+        TEST_CHECK(watch.elapsedMs() < 1000);
+    }
+
+    void testStreamingAsync(TestHttpServer& server)
+    {
+        HttpRetryPolicy policy;
+        policy.maxAttempts = 3;
+        policy.initialBackoffMs = 50;
+        policy.hedgeDelayMs = 100;
+        std::vector<std::wstring> headers;
+
+        // ǰ sink  rewind()ֻһεӦ
+        HttpClient client(L"http_fault_test");
+        client.setRetryPolicy(policy);
+        AsyncSinkResult retried;
+        client.http_get_async(server.url("/reset/j/2"), headers, retried.sink, retried.sinkCallback());
+        retried.wait();
+        TEST_CHECK(ERROR_SUCCESS == retried.error && "recovered" == retried.data);
+        TEST_CHECK(3 == serverCount(client, server, "j"));
+
+        // Գ壺ͬʱдͬһ sink
+        AsyncSinkResult slow;
+        TestStopwatch watch;
+        client.http_get_async(server.url("/slow/k/1"), headers, slow.sink, slow.sinkCallback());
+        slow.wait();
+        TEST_CHECK(ERROR_SUCCESS == slow.error && "recovered" == slow.data);
+        TEST_CHECK(watch.elapsedMs() >= 900);
+        TEST_CHECK(1 == serverCount(client, server, "k"));
+
+        // ֹʱÿγԼִ
+        client.setRequestTimeout(300);
+        AsyncSinkResult hung;
+        watch.restart();
+        client.http_get_async(server.url("/hang"), headers, hung.sink, hung.sinkCallback());
+        hung.wait();
+        TEST_CHECK(ETIMEDOUT == hung.error);
+        TEST_CHECK(watch.elapsedMs() < 1000);
+    }
+}
+
+int main()
+{
+    TestHttpServer server(handle);
+    TEST_CHECK(server.start());
+
+    testDeadline(server);
+    testRetry(server);
+    testCancelDuringBackoff(server);
+    testHedging(server);
+    testStreamingAsync(server);
+    return testResult("http_fault_test");
+}
@@ -0,0 +1,72 @@
+#include "TestUtil.h"
+#include "TestHttpServer.h"
+#include "HttpClient.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+/**************************************************************************/
+
+/*
+* ӳص棺ͬ UserSig 󣬸ÿ http_close()ǰΪÿ
+*/
+
+namespace
+{
+    const int kRequests = 4000;
+    const char* const kUserSig = "{\"errorCode\":0,\"data\":{\"userSig\":\"eJwtzEELgjAYBuD\"}}";
+
+    double run(TestHttpServer& server, int threads, bool pooled, int& failures)
+    {
+        HttpClient client(L"http_pool_bench");
+        std::vector<std::wstring> headers(1, L"Content-Type: application/json");
+        std::atomic<int> errors(0);
+        server.resetCounters();
+
+        TestStopwatch watch;
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.push_back(std::thread([&]() {
+                for (int i = 0; i < kRequests / threads; ++i)
+                {
+                    std::string data;
+                    if (ERROR_SUCCESS != client.http_post(server.url("/getUserSig"), headers, "{\"userId\":\"user_1\"}", data) || kUserSig != data)
+                    {
+                        ++errors;
+                    }
+                    if (false == pooled)
+                    {
+                        client.http_close();
+                    }
+                }
+            }));
+        }
+        for (size_t t = 0; t < workers.size(); ++t)
+        {
+            workers[t].join();
+        }
+        double seconds = watch.elapsedMs() / 1000.0;
+        failures += errors;
+        ::printf("  %-9s %2d thread(s): %8.0f req/s  (%zu connections)\n", pooled ? "pooled" : "no pool", threads, kRequests / seconds, server.connections());
+        return kRequests / seconds;
+    }
+}
+
+int main()
+{
+    TestHttpServer server([](const TestHttpRequest&, TestHttpResponse& response) {
+        response.body = kUserSig;
+    });
+    TEST_CHECK(server.start());
+
+    ::printf("http_pool_bench: %d POST requests to a local server\n", kRequests);
+    int failures = 0;
+    for (int threads = 1; threads <= 8; threads *= 8)
+    {
+        double withPool = run(server, threads, true, failures);
+        double withoutPool = run(server, threads, false, failures);
+        ::printf("  speedup: %.2fx\n", withPool / withoutPool);
+    }
+    TEST_CHECK(0 == failures);
+    return testResult("http_pool_bench");
+}
@@ -0,0 +1,164 @@
+#include "TestUtil.h"
+#include "TestHttpServer.h"
+#include "HttpClient.h"
+#include "HttpConnectionPool.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+/**************************************************************************/
+
+/*
+* HttpConnectionPoolгʱ host ЧӲáÿ host ޣ
+* HttpClient ط֤ȷʵãhttp_close() Ϳгʱ֮½
+*/
+
+namespace
+{
+    std::atomic<int> g_liveConnections(0);
+
+    class FakeConnection : public HttpConnection
+    {
+    public:
+        explicit FakeConnection(bool alive = true) : m_alive(alive) { ++g_liveConnections; }
+        ~FakeConnection() { --g_liveConnections; }
+        virtual bool isAlive() const { return m_alive; }
+
+    private:
+        bool m_alive;
+    };
+
+    HttpEndpoint endpoint(const char* host)
+    {
+        HttpEndpoint result;
+        result.scheme = "http";
+        result.host = host;
+        result.port = 80;
+        return result;
+    }
+
+    void testIdleTimeoutCoversAllHosts()
+    {
+        HttpConnectionPool pool;
+        pool.setIdleTimeout(50);
+        HttpEndpoint a = endpoint("a.example.com");
+        HttpEndpoint b = endpoint("b.example.com");
+        pool.acquire(a);
+        pool.release(a, std::unique_ptr<HttpConnection>(new FakeConnection()), true);
+        pool.acquire(b);
+        pool.release(b, std::unique_ptr<HttpConnection>(new FakeConnection()), true);
+        TEST_CHECK(2 == pool.idleCount());
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        // ֻ ba ĿҲҪر
+        std::unique_ptr<HttpConnection> connection = pool.acquire(b);
+        TEST_CHECK(!connection);
+        TEST_CHECK(0 == pool.idleCount());
+        TEST_CHECK(0 == g_liveConnections);
+        pool.release(b, std::unique_ptr<HttpConnection>(), false);
+    }
+
+    void testDeadConnectionSkipped()
+    {
+        HttpConnectionPool pool;
+        HttpEndpoint a = endpoint("a.example.com");
+        pool.acquire(a);
+        pool.acquire(a);
+        pool.release(a, std::unique_ptr<HttpConnection>(new FakeConnection(true)), true);
+        pool.release(a, std::unique_ptr<HttpConnection>(new FakeConnection(false)), true);   // 黹ȡ
+
+        std::unique_ptr<HttpConnection> connection = pool.acquire(a);
+        TEST_CHECK(connection && connection->isAlive());
+        TEST_CHECK(1 == g_liveConnections);
+        TEST_CHECK(1 == pool.stats().reused);
+        pool.release(a, std::move(connection), false);
+        TEST_CHECK(0 == g_liveConnections);
+    }
+
+    void testPerHostLimit()
+    {
+        HttpConnectionPool pool;
+        pool.setMaxConnectionsPerHost(2);
+        HttpEndpoint a = endpoint("a.example.com");
+        HttpEndpoint b = endpoint("b.example.com");
+        std::unique_ptr<HttpConnection> connection;
+        TEST_CHECK(pool.tryAcquire(a, connection));
+        TEST_CHECK(pool.tryAcquire(a, connection));
+        TEST_CHECK(false == pool.tryAcquire(a, connection));
+        TEST_CHECK(pool.tryAcquire(b, connection));      //  host 
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        TEST_CHECK(false == pool.acquireUntil(a, start + std::chrono::milliseconds(50), connection));
+        TEST_CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+
+        std::thread releaser([&pool, &a]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            pool.release(a, std::unique_ptr<HttpConnection>(), false);
+        });
+        TEST_CHECK(pool.acquireUntil(a, std::chrono::steady_clock::now() + std::chrono::seconds(5), connection));
+        releaser.join();
+    }
+
+    void testClientReusesConnections()
+    {
+        TestHttpServer server([](const TestHttpRequest& request, TestHttpResponse& response) {
+            response.body = "pong:" + request.path;
+        });
+        TEST_CHECK(server.start());
+        std::vector<std::wstring> headers;
+
+        HttpClient client(L"http_pool_test");
+        for (int i = 0; i < 20; ++i)
+        {
+            std::string data;
+            TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/ping"), headers, data));
+            TEST_CHECK("pong:/ping" == data);
+        }
+        TEST_CHECK(1 == server.connections());
+        TEST_CHECK(20 == client.poolStats().acquired);
+        TEST_CHECK(19 == client.poolStats().reused);
+
+        // رտӺ½
+        client.http_close();
+        std::string data;
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/ping"), headers, data));
+        TEST_CHECK(2 == server.connections());
+
+        // гʱӲٸ
+        client.setIdleTimeout(50);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        data.clear();
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/ping"), headers, data));
+        TEST_CHECK(3 == server.connections());
+    }
+
+    void testServerClosesAfterEachResponse()
+    {
+        TestHttpServer server([](const TestHttpRequest&, TestHttpResponse& response) {
+            response.body = "once";
+            response.headers.push_back("Connection: close");
+            response.close = false;
+        });
+        TEST_CHECK(server.start());
+        std::vector<std::wstring> headers;
+
+        HttpClient client(L"http_pool_test");
+        for (int i = 0; i < 10; ++i)
+        {
+            std::string data;
+            TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/once"), headers, data));
+            TEST_CHECK("once" == data);
+        }
+        TEST_CHECK(10 == server.connections());
+        TEST_CHECK(0 == client.poolStats().reused);
+    }
+}
+
+int main()
+{
+    testIdleTimeoutCoversAllHosts();
+    testDeadConnectionSkipped();
+    testPerHostLimit();
+    testClientReusesConnections();
+    testServerClosesAfterEachResponse();
+    return testResult("http_pool_test");
+}
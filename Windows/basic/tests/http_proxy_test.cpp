@@ -0,0 +1,249 @@
+#include "TestUtil.h"
+#include "TestHttpServer.h"
+#include "TestPlainTls.h"
+#include "TestProxyServer.h"
+#include "HttpClient.h"
+#include <algorithm>
+#include <condition_variable>
+#include <errno.h>
+#include <mutex>
+/**************************************************************************/
+
+/*
+* ʣSOCKS5  HTTP ֤벻֤Ӧ𱻲ɵֽڣhttp  https Ŀꣻ
+* ͬ첽Ҫɹӳظã֤ʧܡĿ겻ɴɴﷵظԵĴ
+*
+* https òܵ TLS ӣ͸õ߼ TLS ͬ
+*/
+
+namespace
+{
+    const char* const kBody = "{\"errorCode\":0,\"data\":{\"userSig\":\"eJwtzEELgjAYBuD\"}}";
+
+    std::wstring localhostUrl(const TestHttpServer& server, bool secure)
+    {
+        std::string url = std::string(secure ? "https" : "http") + "://localhost:" + std::to_string(server.port()) + "/getUserSig";
+        return std::wstring(url.begin(), url.end());
+    }
+
+    HttpProxy makeProxy(HttpProxyType type, const TestProxyServer& server, const std::string& username, const std::string& password)
+    {
+        HttpProxy proxy;
+        proxy.type = type;
+        proxy.host = "127.0.0.1";
+        proxy.port = server.port();
+        proxy.username = username;
+        proxy.password = password;
+        return proxy;
+    }
+
+    bool hasLine(const TestProxyServer& proxy, const std::string& line)
+    {
+        std::vector<std::string> lines = proxy.lines();
+        return lines.end() != std::find(lines.begin(), lines.end(), line);
+    }
+
+    class AsyncCounter
+    {
+    public:
+        explicit AsyncCounter(int count) : failures(0), lastError(0), m_left(count) {}
+
+        HttpCallback callback(const std::string& expected)
+        {
+            return [this, expected](DWORD error, std::string& data) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                lastError = error;
+                failures += (ERROR_SUCCESS != error || expected != data);
+                if (0 == --m_left)
+                {
+                    m_done.notify_all();
+                }
+            };
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (0 != m_left)
+            {
+                m_done.wait(lock);
+            }
+        }
+
+        int failures;
+        DWORD lastError;
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_done;
+        int m_left;
+    };
+
+    // 50 ͬ 200 첽󣬾Ӳÿ host ޣ඼Ǹ
+    void testThroughProxy(const char* name, TestHttpServer& origin, TestProxyServer& proxyServer, const HttpProxy& proxy, bool secure)
+    {
+        TestPlainTlsProvider tls;
+        HttpClient client(L"http_proxy_test");
+        client.setTlsProvider(&tls);
+        client.setProxy(proxy);
+        client.setMaxConnectionsPerHost(4);
+
+        std::mutex mutex;
+        int fresh = 0;
+        int reusedWithHandshake = 0;
+        double proxyMs = 0;
+        client.setTimingListener([&](const HttpTiming& timing) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (timing.reused)
+            {
+                reusedWithHandshake += (-1 != timing.proxyMs);
+                return;
+            }
+            ++fresh;
+            proxyMs += timing.proxyMs;
+        });
+
+        size_t before = proxyServer.connections();
+        std::wstring url = localhostUrl(origin, secure);
+        std::vector<std::wstring> headers;
+        int failures = 0;
+        for (int i = 0; i < 50; ++i)
+        {
+            std::string data;
+            failures += (ERROR_SUCCESS != client.http_get(url, headers, data) || kBody != data);
+        }
+        AsyncCounter async(200);
+        for (int i = 0; i < 200; ++i)
+        {
+            client.http_get_async(url, headers, async.callback(kBody));
+        }
+        async.wait();
+
+        size_t tunnels = proxyServer.connections() - before;
+        std::lock_guard<std::mutex> lock(mutex);
+        ::printf("  %-12s %-5s 250 requests: %d failed, %zu proxy connection(s), proxy handshake %.2f ms\n"
+            , name, secure ? "https" : "http", failures + async.failures, tunnels, fresh ? proxyMs / fresh : -1);
+        TEST_CHECK(0 == failures && 0 == async.failures);
+        TEST_CHECK(tunnels >= 1 && tunnels <= 4);
+        TEST_CHECK(static_cast<size_t>(fresh) == tunnels);
+        TEST_CHECK(0 == reusedWithHandshake);
+        // HTTP תʱҪ
+        if (HttpProxyHttp == proxy.type && false == secure)
+        {
+            TEST_CHECK(-1 == proxyMs / fresh);
+        }
+        else
+        {
+            TEST_CHECK(proxyMs / fresh >= 0);
+        }
+        TEST_CHECK(false == secure || tls.channels == fresh);
+    }
+
+    void expectError(const char* name, const HttpProxy& proxy, const std::wstring& url, DWORD expected)
+    {
+        TestPlainTlsProvider tls;
+        HttpClient client(L"http_proxy_test");
+        client.setTlsProvider(&tls);
+        client.setProxy(proxy);
+        std::vector<std::wstring> headers;
+        std::string data;
+        DWORD error = client.http_get(url, headers, data);
+
+        AsyncCounter async(1);
+        client.http_get_async(url, headers, async.callback(""));
+        async.wait();
+        ::printf("  %-36s sync %#lx, async %#lx\n", name, error, async.lastError);
+        TEST_CHECK(expected == error);
+        TEST_CHECK(expected == async.lastError);
+    }
+}
+
+int main()
+{
+    TestHttpServer origin([](const TestHttpRequest&, TestHttpResponse& response) {
+        response.body = kBody;
+    });
+    TestProxyServer open("", "");
+    TestProxyServer authenticated("u", "p@ss:w");
+    TestProxyServer fragmented("", "");
+    fragmented.setFragmented(true);
+    TEST_CHECK(origin.start() && open.start() && authenticated.start() && fragmented.start());
+
+    struct Case
+    {
+        const char* name;
+        HttpProxyType type;
+        TestProxyServer* server;
+        const char* username;
+        const char* password;
+    };
+    const Case cases[] = {
+        { "socks5", HttpProxySocks5, &open, "", "" },
+        { "socks5 auth", HttpProxySocks5, &authenticated, "u", "p@ss:w" },
+        { "socks5 frag", HttpProxySocks5, &fragmented, "", "" },
+        { "http", HttpProxyHttp, &open, "", "" },
+        { "http auth", HttpProxyHttp, &authenticated, "u", "p@ss:w" },
+        { "http frag", HttpProxyHttp, &fragmented, "", "" },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+    {
+        for (int secure = 0; secure < 2; ++secure)
+        {
+            HttpProxy proxy = makeProxy(cases[i].type, *cases[i].server, cases[i].username, cases[i].password);
+            testThroughProxy(cases[i].name, origin, *cases[i].server, proxy, 0 != secure);
+        }
+    }
+
+    // SOCKS5 ɴHTTP  https  CONNECT http þԵַ
+    std::string port = std::to_string(origin.port());
+    TEST_CHECK(hasLine(authenticated, "socks localhost:" + port));
+    TEST_CHECK(hasLine(authenticated, "CONNECT localhost:" + port + " HTTP/1.1"));
+    TEST_CHECK(hasLine(authenticated, "GET http://localhost:" + port + "/getUserSig HTTP/1.1"));
+    TEST_CHECK(0 == authenticated.authFailures());
+
+    std::wstring http = localhostUrl(origin, false);
+    std::wstring https = localhostUrl(origin, true);
+    expectError("socks5 wrong password", makeProxy(HttpProxySocks5, authenticated, "u", "bad"), https, EcHttpProxyAuthFailed);
+    expectError("socks5 without credentials", makeProxy(HttpProxySocks5, authenticated, "", ""), https, EcHttpProxyAuthFailed);
+    expectError("http wrong password (CONNECT)", makeProxy(HttpProxyHttp, authenticated, "u", "bad"), https, EcHttpProxyAuthFailed);
+    expectError("http wrong password (forward)", makeProxy(HttpProxyHttp, authenticated, "u", "bad"), http, EcHttpProxyAuthFailed);
+    expectError("socks5 target refused", makeProxy(HttpProxySocks5, open, "", ""), L"https://127.0.0.1:1/", ECONNREFUSED);
+    expectError("http CONNECT target refused", makeProxy(HttpProxyHttp, open, "", ""), L"https://127.0.0.1:1/", EcHttpProxyError);
+    HttpProxy down = makeProxy(HttpProxySocks5, open, "", "");
+    down.port = 1;
+    expectError("proxy not reachable", down, https, ECONNREFUSED);
+
+    TestPlainTlsProvider tls;
+    std::vector<std::wstring> headers;
+    {
+        // ɽӿڵͬڲ֤ SOCKS5ip Ϊʱֱ
+        HttpClient client(L"http_proxy_test");
+        client.setTlsProvider(&tls);
+        TEST_CHECK(client.setProxy("127.0.0.1", open.port()));     // socket ֧ SOCKS5
+        size_t before = open.connections();
+        std::string data;
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(https, headers, data) && kBody == data);
+        TEST_CHECK(before + 1 == open.connections());
+
+        TEST_CHECK(client.setProxy("", 1080));
+        data.clear();
+        size_t direct = origin.connections();
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(https, headers, data) && kBody == data);
+        TEST_CHECK(direct + 1 == origin.connections());
+    }
+    {
+        // ˴ܸ֮þǰһ
+        HttpClient client(L"http_proxy_test");
+        client.setTlsProvider(&tls);
+        size_t first = open.connections();
+        size_t second = fragmented.connections();
+        std::string data;
+        client.setProxy(makeProxy(HttpProxySocks5, open, "", ""));
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(https, headers, data));
+        client.setProxy(makeProxy(HttpProxySocks5, fragmented, "", ""));
+        TEST_CHECK(ERROR_SUCCESS == client.http_get(https, headers, data));
+        TEST_CHECK(first + 1 == open.connections());
+        TEST_CHECK(second + 1 == fragmented.connections());
+    }
+    return testResult("http_proxy_test");
+}
@@ -0,0 +1,301 @@
+#include "TestUtil.h"
+#include "TestHttpServer.h"
+#include "HttpTimingStats.h"
+#include "json.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+/**************************************************************************/
+
+/*
+* ʱֽܣͬ첽ӿ½ʱ DNSӡֽ͡ںʹ׶Σõû DNS ӣ
+* HttpTimingStats ļܺۼͰͬ¼һ£ϽֵڸϽͰ
+*/
+
+namespace
+{
+    const unsigned int kDelayMs = 50;
+    const size_t kBodySize = 512 * 1024;
+
+    //  HttpTimingStats.h ˵ͰϽͬһ +Inf
+    const double kBounds[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000 };
+    const size_t kBoundCount = sizeof(kBounds) / sizeof(kBounds[0]);
+
+    void handle(const TestHttpRequest& request, TestHttpResponse& response)
+    {
+        response.body = ("/large" == request.path ? std::string(kBodySize, 'x') : std::string("ok"));
+        response.delayMs = kDelayMs;
+    }
+
+    // ÿγԵĺʱͬʱ HttpTimingStats߿ I/O ߳ϱ
+    class TimingLog
+    {
+    public:
+        explicit TimingLog(HttpTimingStats& stats) : m_stats(stats) {}
+
+        void record(const HttpTiming& timing)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_samples.push_back(timing);
+            m_stats.record(timing);
+        }
+
+        std::vector<HttpTiming> samples()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_samples;
+        }
+
+    private:
+        HttpTimingStats& m_stats;
+        std::mutex m_mutex;
+        std::vector<HttpTiming> m_samples;
+    };
+
+    class AsyncWaiter
+    {
+    public:
+        AsyncWaiter() : m_done(false), error(0) {}
+
+        HttpCallback callback()
+        {
+            return [this](DWORD ret, std::string& data) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                error = ret;
+                size = data.size();
+                m_done = true;
+                m_finished.notify_all();
+            };
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_finished.wait(lock, [this] { return m_done; });
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_finished;
+        bool m_done;
+
+    public:
+        DWORD error;
+        size_t size;
+    };
+
+    Json::Value exportStats(const HttpTimingStats& stats)
+    {
+        Json::Reader reader;
+        Json::Value root;
+        TEST_CHECK(reader.parse(stats.exportJson(), root));
+        return root;
+    }
+
+    // һ׶Ƚϣֵʾûоý׶Σ
+    void checkPhase(const Json::Value& phase, const std::vector<double>& values)
+    {
+        unsigned long long count = 0;
+        double sum = 0;
+        std::vector<unsigned long long> cumulative(kBoundCount + 1, 0);
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (values[i] < 0)
+            {
+                continue;
+            }
+            ++count;
+            sum += values[i];
+            for (size_t j = 0; j <= kBoundCount; ++j)
+            {
+                if (kBoundCount == j || values[i] <= kBounds[j])
+                {
+                    ++cumulative[j];
+                }
+            }
+        }
+
+        TEST_CHECK(count == phase["count"].asUInt64());
+        TEST_CHECK(sum - phase["sumMs"].asDouble() < 1e-6 && phase["sumMs"].asDouble() - sum < 1e-6);
+        const Json::Value& buckets = phase["buckets"];
+        TEST_CHECK(buckets.isArray() && kBoundCount + 1 == buckets.size());
+        for (Json::ArrayIndex j = 0; j < buckets.size() && j <= kBoundCount; ++j)
+        {
+            if (j < kBoundCount)
+            {
+                TEST_CHECK(kBounds[j] == buckets[j]["le"].asDouble());
+            }
+            else
+            {
+                TEST_CHECK("+Inf" == buckets[j]["le"].asString());
+            }
+            TEST_CHECK(cumulative[j] == buckets[j]["count"].asUInt64());
+        }
+    }
+
+    std::vector<double> phaseOf(const std::vector<HttpTiming>& samples, double HttpTiming::*field)
+    {
+        std::vector<double> values;
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            values.push_back(samples[i].*field);
+        }
+        return values;
+    }
+
+    void testHistogram()
+    {
+        HttpTimingStats stats;
+        // 0.5  1 ڵһͰ2 ϽΪ 2 Ͱ10000 һͰ20000 ֻ +Inf
+        const double values[] = { 0.5, 1, 1.5, 2, 7, 10000, 20000 };
+        std::vector<double> dns;
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+        {
+            HttpTiming timing;
+            timing.error = (0 == i % 3 ? 1 : ERROR_SUCCESS);
+            timing.reused = (1 == i % 2);
+            timing.dnsMs = values[i];
+            timing.totalMs = values[i] + 1;
+            timing.bytesSent = 10;
+            timing.bytesReceived = 100;
+            stats.record(timing);
+            dns.push_back(values[i]);
+        }
+
+        Json::Value root = exportStats(stats);
+        TEST_CHECK(7 == root["requests"].asUInt64());
+        TEST_CHECK(3 == root["errors"].asUInt64());
+        TEST_CHECK(3 == root["reused"].asUInt64());
+        TEST_CHECK(70 == root["bytesSent"].asUInt64());
+        TEST_CHECK(700 == root["bytesReceived"].asUInt64());
+        checkPhase(root["phases"]["dns"], dns);
+        TEST_CHECK(0 == root["phases"]["connect"]["count"].asUInt64());     //  -1ûо
+
+        //  4 ϽΪ 2 Ͱ 7  +InfԾֵһϽнϴһ
+        TEST_CHECK(2 == root["phases"]["dns"]["p50Ms"].asDouble());
+        TEST_CHECK(10000 == root["phases"]["dns"]["p99Ms"].asDouble());
+
+        stats.reset();
+        root = exportStats(stats);
+        TEST_CHECK(0 == root["requests"].asUInt64());
+        checkPhase(root["phases"]["dns"], std::vector<double>());
+    }
+
+    void checkNewConnection(const HttpTiming& timing, size_t bodySize)
+    {
+        TEST_CHECK(ERROR_SUCCESS == timing.error);
+        TEST_CHECK("127.0.0.1" == timing.host);
+        TEST_CHECK(false == timing.reused);
+        TEST_CHECK(timing.dnsMs >= 0);
+        TEST_CHECK(timing.connectMs >= 0);
+        TEST_CHECK(timing.proxyMs < 0 && timing.tlsMs < 0);
+        TEST_CHECK(timing.sendMs >= 0);
+        TEST_CHECK(timing.ttfbMs >= kDelayMs - 1);     // ڷӦǰȴ kDelayMs
+        TEST_CHECK(timing.transferMs >= 0);
+        double phases = timing.dnsMs + timing.connectMs + timing.sendMs + timing.ttfbMs + timing.transferMs;
+        TEST_CHECK(timing.totalMs >= timing.ttfbMs && phases <= timing.totalMs + 1);
+        TEST_CHECK(timing.bytesSent > 0);
+        TEST_CHECK(timing.bytesReceived > bodySize);   // Ӧͷ
+    }
+
+    void checkReused(const HttpTiming& timing)
+    {
+        TEST_CHECK(ERROR_SUCCESS == timing.error);
+        TEST_CHECK(timing.reused);
+        TEST_CHECK(timing.dnsMs < 0 && timing.connectMs < 0);
+        TEST_CHECK(timing.sendMs >= 0);
+        TEST_CHECK(timing.ttfbMs >= kDelayMs - 1);
+        TEST_CHECK(timing.transferMs >= 0);
+        TEST_CHECK(timing.totalMs >= timing.ttfbMs);
+    }
+
+    void testPhases(TestHttpServer& server)
+    {
+        HttpTimingStats stats;
+        TimingLog log(stats);
+        std::vector<std::wstring> headers;
+        {
+            HttpClient client(L"http_timing_test");
+            client.setTimingListener(std::bind(&TimingLog::record, &log, std::placeholders::_1));
+
+            std::string data;
+            TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/large"), headers, data));
+            TEST_CHECK(ERROR_SUCCESS == client.http_get(server.url("/small"), headers, data));
+            std::vector<HttpTiming> samples = log.samples();
+            TEST_CHECK(2 == samples.size());
+            if (2 == samples.size())
+            {
+                checkNewConnection(samples[0], kBodySize);
+                checkReused(samples[1]);
+            }
+
+            // 첽 I/O ̻߳صɻص֮ǰãͬµڳпԸ
+            for (int i = 0; i < 2; ++i)
+            {
+                AsyncWaiter waiter;
+                client.http_get_async(server.url("/large"), headers, waiter.callback());
+                waiter.wait();
+                TEST_CHECK(ERROR_SUCCESS == waiter.error && kBodySize == waiter.size);
+            }
+            samples = log.samples();
+            TEST_CHECK(4 == samples.size());
+            if (4 == samples.size())
+            {
+                checkReused(samples[2]);
+                checkReused(samples[3]);
+            }
+        }
+        {
+            HttpClient client(L"http_timing_test");
+            client.setTimingListener(std::bind(&TimingLog::record, &log, std::placeholders::_1));
+            AsyncWaiter waiter;
+            client.http_get_async(server.url("/large"), headers, waiter.callback());
+            waiter.wait();
+            std::vector<HttpTiming> samples = log.samples();
+            TEST_CHECK(5 == samples.size());
+            if (5 == samples.size())
+            {
+                checkNewConnection(samples[4], kBodySize);
+            }
+        }
+
+        // ÿԵ
+        std::vector<HttpTiming> samples = log.samples();
+        Json::Value root = exportStats(stats);
+        TEST_CHECK(samples.size() == root["requests"].asUInt64());
+        TEST_CHECK(0 == root["errors"].asUInt64());
+        TEST_CHECK(3 == root["reused"].asUInt64());
+        unsigned long long sent = 0;
+        unsigned long long received = 0;
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            sent += samples[i].bytesSent;
+            received += samples[i].bytesReceived;
+        }
+        TEST_CHECK(sent == root["bytesSent"].asUInt64());
+        TEST_CHECK(received == root["bytesReceived"].asUInt64());
+
+        const Json::Value& phases = root["phases"];
+        checkPhase(phases["queue"], phaseOf(samples, &HttpTiming::queueMs));
+        checkPhase(phases["dns"], phaseOf(samples, &HttpTiming::dnsMs));
+        checkPhase(phases["connect"], phaseOf(samples, &HttpTiming::connectMs));
+        checkPhase(phases["proxy"], phaseOf(samples, &HttpTiming::proxyMs));
+        checkPhase(phases["tls"], phaseOf(samples, &HttpTiming::tlsMs));
+        checkPhase(phases["send"], phaseOf(samples, &HttpTiming::sendMs));
+        checkPhase(phases["ttfb"], phaseOf(samples, &HttpTiming::ttfbMs));
+        checkPhase(phases["transfer"], phaseOf(samples, &HttpTiming::transferMs));
+        checkPhase(phases["total"], phaseOf(samples, &HttpTiming::totalMs));
+        TEST_CHECK(2 == phases["dns"]["count"].asUInt64() && 5 == phases["ttfb"]["count"].asUInt64());
+    }
+}
+
+int main()
+{
+    TestHttpServer server(handle);
+    TEST_CHECK(server.start());
+
+    testHistogram();
+    testPhases(server);
+    return testResult("http_timing_test");
+}
@@ -0,0 +1,318 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <random>
+#include <string>
+#include <vector>
+/**************************************************************************/
+
+/*
+* IncrementalReaderͬһĵⷽʽп飨ַתС֡
+* UTF-8 ַֽעмһֽһֽڵУι룬 Json::Reader һ£
+* ضϻ뱨Ϣλп鷽ʽ޹
+*
+* Json::Reader ԸȽϿɣ "-"ļĩβδַܶ
+* ԴֻҪ IncrementalReader Ҫ Reader һ
+*/
+
+namespace
+{
+    const char* kDocuments[] = {
+        "{\"userId\":\"user_1001\",\"roomId\":1234,\"ok\":true,\"none\":null,\"off\":false}",
+        "[\"esc \\\" \\\\ \\/ \\b \\f \\n \\r \\t\",\"\\u0041\\u00e9\\u4e2d\",\"\\ud83d\\ude00 pair\",\"\\u0000 zero\"]",
+        "[\"raw \xe4\xb8\xad\xe6\x96\x87 \xf0\x9f\x98\x80 \xc3\xa9\",\"\xe4\xb8\xad\"]",
+        "[0,-0,1,-1,123456789,2147483647,-2147483648,4294967295,9223372036854775807,-9223372036854775808,"
+        "18446744073709551615,18446744073709551616,0.5,-0.25,1e10,1E-5,-1.5e+300,3.14159265358979,1.7976931348623157e308]",
+        "  \r\n{ \"a\" : [ ] , \"b\" : { } , \"c\" : [ [ ] , { \"d\" : [ 1 , [ 2 , [ 3 ] ] ] } ] }  \r\n",
+        "// leading comment\n{/* block */\"a\":/**/1, // trailing\n\"b\":[1/* in array */,2]}/* after */",
+        "\"just a string\"",
+        "-12.5e-3",
+        "true",
+        "null",
+        "{\"dup\":1,\"dup\":2}",
+        "[1]   trailing text is ignored",
+    };
+
+    const char* kMalformed[] = {
+        "{\"a\" 1}", "{\"a\":1,}", "[1,,2]", "[1 2]", "{1:2}", "]", "}", "tru", "nul", "falsy",
+        "[\"bad \\x escape\"]", "[\"\\u12\"]", "[\"\\u12zz\"]", "\"unterminated", "[1,", "{\"a\":", "{\"a\"",
+        "[-]", "[1e]", "[.5]", "[+1]", "[\"a\" \"b\"]", "/* open comment", "/x", "",  "   ",
+    };
+
+    Json::Value readWithReader(const std::string& text, bool& ok)
+    {
+        Json::Reader reader;
+        Json::Value root;
+        ok = reader.parse(text, root);
+        return root;
+    }
+
+    struct Result
+    {
+        bool ok;
+        Json::Value root;
+        std::string errors;
+        ptrdiff_t errorOffset;
+    };
+
+    //  cuts λп飬ÿ鸴ƵĻ feed() ͷ
+    Result readInChunks(const std::string& text, const std::vector<size_t>& cuts)
+    {
+        Result result;
+        Json::ValueBuilder builder(result.root);
+        Json::IncrementalReader reader(builder);
+        bool fed = true;
+        size_t begin = 0;
+        for (size_t i = 0; i <= cuts.size() && fed; ++i)
+        {
+            size_t end = i < cuts.size() ? cuts[i] : text.size();
+            std::vector<char> chunk(text.begin() + begin, text.begin() + end);
+            fed = reader.feed(chunk.data(), chunk.data() + chunk.size());
+            begin = end;
+        }
+        result.ok = reader.finish() && fed;
+        result.errors = reader.getFormattedErrorMessages();
+        result.errorOffset = reader.getErrorOffset();
+        return result;
+    }
+
+    std::vector<size_t> everyByte(size_t length)
+    {
+        std::vector<size_t> cuts;
+        for (size_t i = 1; i < length; ++i)
+        {
+            cuts.push_back(i);
+        }
+        return cuts;
+    }
+
+    std::vector<size_t> randomCuts(size_t length, std::mt19937& random)
+    {
+        std::vector<size_t> cuts;
+        size_t position = 0;
+        while (length > 0)
+        {
+            position += 1 + random() % (random() % 2 ? 4 : 64);
+            if (position >= length)
+            {
+                break;
+            }
+            cuts.push_back(position);
+        }
+        return cuts;
+    }
+
+    // п鷽ʽĽֵͬ Json::Reader һ£valid ʱ Reader ܶҲܶ
+    int checkDocument(const std::string& text, bool valid, std::mt19937& random)
+    {
+        bool expectedOk = false;
+        Json::Value expected = readWithReader(text, expectedOk);
+        Result whole = readInChunks(text, std::vector<size_t>());
+        int mismatches = 0;
+        if ((whole.ok && false == expectedOk) || (valid && whole.ok != expectedOk) || (whole.ok && false == (whole.root == expected)))
+        {
+            ::fprintf(stderr, "whole: %s -> %d (Reader %d) %s\n", text.c_str(), whole.ok, expectedOk, whole.errors.c_str());
+            ++mismatches;
+        }
+
+        std::vector<std::vector<size_t> > splits;
+        splits.push_back(everyByte(text.size()));
+        for (size_t i = 1; i < text.size(); ++i)
+        {
+            splits.push_back(std::vector<size_t>(1, i));
+        }
+        for (int i = 0; i < 20; ++i)
+        {
+            splits.push_back(randomCuts(text.size(), random));
+        }
+        for (size_t i = 0; i < splits.size(); ++i)
+        {
+            Result chunked = readInChunks(text, splits[i]);
+            if (chunked.ok != whole.ok || chunked.errors != whole.errors || chunked.errorOffset != whole.errorOffset
+                || (whole.ok && false == (chunked.root == whole.root)))
+            {
+                if (++mismatches <= 5)
+                {
+                    ::fprintf(stderr, "split %zu: %s -> %d %s\n", i, text.c_str(), chunked.ok, chunked.errors.c_str());
+                }
+            }
+        }
+        return mismatches;
+    }
+
+    void testDocuments()
+    {
+        std::mt19937 random(11);
+        int mismatches = 0;
+        for (size_t i = 0; i < sizeof(kDocuments) / sizeof(kDocuments[0]); ++i)
+        {
+            TEST_CHECK(readInChunks(kDocuments[i], std::vector<size_t>()).ok);
+            mismatches += checkDocument(kDocuments[i], true, random);
+        }
+        TEST_CHECK(0 == mismatches);
+    }
+
+    void testTruncated()
+    {
+        // ÿǰ׺Ҫô Reader һֵֵǰ׺Ҫô
+        std::mt19937 random(12);
+        int mismatches = 0;
+        for (size_t i = 0; i < sizeof(kDocuments) / sizeof(kDocuments[0]); ++i)
+        {
+            std::string text = kDocuments[i];
+            for (size_t length = 0; length < text.size(); ++length)
+            {
+                mismatches += checkDocument(text.substr(0, length), false, random);
+            }
+        }
+        TEST_CHECK(0 == mismatches);
+
+        Result truncated = readInChunks("{\"a\":[1,2", everyByte(9));
+        TEST_CHECK(false == truncated.ok && false == truncated.errors.empty());
+    }
+
+    void testMalformed()
+    {
+        std::mt19937 random(13);
+        int mismatches = 0;
+        for (size_t i = 0; i < sizeof(kMalformed) / sizeof(kMalformed[0]); ++i)
+        {
+            Result result = readInChunks(kMalformed[i], std::vector<size_t>());
+            TEST_CHECK(false == result.ok && false == result.errors.empty());
+            mismatches += checkDocument(kMalformed[i], false, random);
+        }
+        TEST_CHECK(0 == mismatches);
+    }
+
+    void testErrorOffset()
+    {
+        Result result = readInChunks("{\"a\":1,\n \"b\" 2}", everyByte(15));
+        TEST_CHECK(false == result.ok);
+        TEST_CHECK(13 == result.errorOffset);
+        TEST_CHECK(std::string::npos != result.errors.find("Line 2"));
+    }
+
+    void testDepthLimit()
+    {
+        std::string deep = std::string(5000, '[') + std::string(5000, ']');
+        std::mt19937 random(14);
+        Result result = readInChunks(deep, randomCuts(deep.size(), random));
+        TEST_CHECK(false == result.ok);
+        TEST_CHECK(std::string::npos != result.errors.find("stackLimit"));
+
+        // ֮
+        std::string shallow = std::string(500, '[') + std::string(500, ']');
+        TEST_CHECK(readInChunks(shallow, randomCuts(shallow.size(), random)).ok);
+    }
+
+    Json::Value randomValue(std::mt19937& random, int depth)
+    {
+        switch (random() % (depth < 4 ? 8 : 6))
+        {
+        case 0: return Json::Value();
+        case 1: return Json::Value(0 == random() % 2);
+        case 2: return Json::Value(static_cast<Json::Int64>(random()) - static_cast<Json::Int64>(random() % 3) * 0x80000000);
+        case 3: return Json::Value(static_cast<double>(static_cast<int>(random())) / 64.0);
+        case 4:
+        case 5:
+        {
+            static const char* kPieces[] = { "a", "\"", "\\", "\n", "\xe4\xb8\xad", "\x01", "/", " ", "\xf0\x9f\x98\x80" };
+            std::string text;
+            for (size_t n = random() % 12; n > 0; --n)
+            {
+                text += kPieces[random() % 9];
+            }
+            return Json::Value(text);
+        }
+        case 6:
+        {
+            Json::Value array(Json::arrayValue);
+            for (size_t n = random() % 6; n > 0; --n)
+            {
+                array.append(randomValue(random, depth + 1));
+            }
+            return array;
+        }
+        default:
+        {
+            Json::Value object(Json::objectValue);
+            for (size_t n = random() % 6; n > 0; --n)
+            {
+                object["k" + std::to_string(random() % 20) + (random() % 4 ? "" : "\t\xc3\xa9")] = randomValue(random, depth + 1);
+            }
+            return object;
+        }
+        }
+    }
+
+    void testRandomDocuments()
+    {
+        std::mt19937 random(15);
+        Json::StyledWriter styled;
+        Json::FastWriter fast;
+        int mismatches = 0;
+        for (int i = 0; i < 300; ++i)
+        {
+            Json::Value value = randomValue(random, 0);
+            std::string text = (i % 2) ? styled.write(value) : fast.write(value);
+            //  maxInt  uintValue Reader ֵȽϣ value Ƚ
+            bool readerOk = false;
+            Json::Value expected = readWithReader(text, readerOk);
+            Result result = readInChunks(text, randomCuts(text.size(), random));
+            if (false == readerOk || false == result.ok || false == (result.root == expected))
+            {
+                ++mismatches;
+            }
+            if (text.size() < 400)
+            {
+                mismatches += checkDocument(text, true, random);
+            }
+        }
+        TEST_CHECK(0 == mismatches);
+    }
+
+    // ¼ǳıValueBuilder ܿĵãreset() ֻ reader
+    class EventLog : public Json::SaxHandler
+    {
+    public:
+        std::string log;
+
+        virtual bool onStartObject() { log += "{"; return true; }
+        virtual bool onEndObject() { log += "}"; return true; }
+        virtual bool onStartArray() { log += "["; return true; }
+        virtual bool onEndArray() { log += "]"; return true; }
+        virtual bool onKey(char const* begin, char const* end) { log += "k:" + std::string(begin, end) + ","; return true; }
+        virtual bool onInt(Json::LargestInt value) { log += std::to_string(value) + ","; return true; }
+    };
+
+    void testReset()
+    {
+        EventLog events;
+        Json::IncrementalReader reader(events);
+        const char broken[] = "[1,}";
+        TEST_CHECK(false == reader.feed(broken, broken + 4));
+        TEST_CHECK(false == reader.feed("2]", "2]" + 2));   // ٽ
+        TEST_CHECK(false == reader.finish());
+
+        TEST_CHECK("[1," == events.log);
+
+        reader.reset();
+        events.log.clear();
+        TEST_CHECK(reader.getFormattedErrorMessages().empty() && -1 == reader.getErrorOffset());
+        const char good[] = "{\"again\":[1,2]}";
+        TEST_CHECK(reader.feed(good, good + 7) && reader.feed(good + 7, good + sizeof(good) - 1));
+        TEST_CHECK(reader.finish());
+        TEST_CHECK("{k:again,[1,2,]}" == events.log);
+    }
+}
+
+int main()
+{
+    testDocuments();
+    testTruncated();
+    testMalformed();
+    testErrorOffset();
+    testDepthLimit();
+    testRandomDocuments();
+    testReset();
+    return testResult("incremental_reader_test");
+}
@@ -0,0 +1,108 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <memory>
+#include <random>
+#include <string>
+/**************************************************************************/
+
+/*
+* ı JSON  CBOR ͱʱݷϱ TRTCStatistics 
+*/
+
+namespace
+{
+    const int kSnapshots = 2000;
+    const int kRuns = 5;
+
+    Json::Value makeTelemetry()
+    {
+        std::mt19937 random(42);
+        Json::Value root(Json::arrayValue);
+        for (int i = 0; i < kSnapshots; ++i)
+        {
+            Json::Value stats;
+            stats["appCpu"] = static_cast<int>(random() % 100);
+            stats["systemCpu"] = static_cast<int>(random() % 100);
+            stats["rtt"] = static_cast<int>(random() % 400);
+            stats["upLoss"] = static_cast<int>(random() % 30);
+            stats["downLoss"] = static_cast<int>(random() % 30);
+            stats["sendBytes"] = static_cast<Json::UInt64>(random()) * 16;
+            stats["receiveBytes"] = static_cast<Json::UInt64>(random()) * 16;
+            stats["timestamp"] = static_cast<Json::Int64>(1790000000000LL + i * 2000);
+
+            Json::Value local;
+            local["width"] = 1280;
+            local["height"] = 720;
+            local["frameRate"] = 15 + static_cast<int>(random() % 10);
+            local["videoBitrate"] = 900 + static_cast<int>(random() % 600);
+            local["audioSampleRate"] = 48000;
+            local["audioBitrate"] = 64;
+            local["streamType"] = "big";
+            stats["localStatistics"].append(local);
+
+            for (int user = 0; user < 3; ++user)
+            {
+                Json::Value remote;
+                remote["userId"] = "user_" + std::to_string(1000 + user);
+                remote["finalLoss"] = static_cast<double>(random() % 1000) / 100.0;
+                remote["width"] = 640;
+                remote["height"] = 360;
+                remote["frameRate"] = 15;
+                remote["videoBitrate"] = 500 + static_cast<int>(random() % 300);
+                remote["jitterBufferDelay"] = static_cast<int>(random() % 200);
+                stats["remoteStatistics"].append(remote);
+            }
+            root.append(stats);
+        }
+
+        // ıһ飬Ǹͳһɶʱ intValueںͽֱӱȽ
+        Json::StreamWriterBuilder writer;
+        std::string text = Json::writeString(writer, root);
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        Json::Value normalized;
+        std::string errors;
+        reader->parse(text.data(), text.data() + text.size(), &normalized, &errors);
+        return normalized;
+    }
+
+    void measure(const char* name, const Json::Value& value, Json::StreamWriterBuilder& writer, Json::CharReaderBuilder& reader)
+    {
+        std::unique_ptr<Json::CharReader> charReader(reader.newCharReader());
+        std::string data;
+        double bestWrite = 1e18;
+        double bestRead = 1e18;
+        for (int run = 0; run < kRuns; ++run)
+        {
+            TestStopwatch watch;
+            data = Json::writeString(writer, value);
+            bestWrite = (std::min)(bestWrite, watch.elapsedMs());
+
+            Json::Value decoded;
+            std::string errors;
+            watch.restart();
+            bool ok = charReader->parse(data.data(), data.data() + data.size(), &decoded, &errors);
+            bestRead = (std::min)(bestRead, watch.elapsedMs());
+            TEST_CHECK(ok && value == decoded);
+        }
+        ::printf("  %-5s %9zu bytes   write %7.2f ms   parse %7.2f ms\n", name, data.size(), bestWrite, bestRead);
+    }
+}
+
+int main()
+{
+    Json::Value telemetry = makeTelemetry();
+    ::printf("json_cbor_bench: %d statistics snapshots, best of %d runs\n", kSnapshots, kRuns);
+
+    Json::StreamWriterBuilder textWriter;
+    textWriter["indentation"] = "";
+    Json::CharReaderBuilder textReader;
+    measure("json", telemetry, textWriter, textReader);
+
+    Json::StreamWriterBuilder cborWriter;
+    cborWriter["format"] = "cbor";
+    Json::CharReaderBuilder cborReader;
+    cborReader["format"] = "cbor";
+    measure("cbor", telemetry, cborWriter, cborReader);
+    return testResult("json_cbor_bench");
+}
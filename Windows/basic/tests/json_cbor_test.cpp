@@ -0,0 +1,254 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <string>
+/**************************************************************************/
+
+/*
+* "format": "cbor"ı JSON  CBOR дٶرԭֵͬRFC 7049 ¼ A ȷ룻
+* ضϡͶⳤֻܽʧܣܱĳȷڴ
+*/
+
+namespace
+{
+    class DocumentGenerator
+    {
+    public:
+        explicit DocumentGenerator(unsigned long long seed) : m_random(seed) {}
+
+        std::string document(int depth = 0)
+        {
+            switch (m_random() % (depth > 4 ? 3 : 6))
+            {
+            case 0:
+                return string();
+            case 1:
+                return number();
+            case 2:
+                return 0 == m_random() % 3 ? "true" : (0 == m_random() % 2 ? "false" : "null");
+            case 3:
+            case 4:
+                {
+                    std::string text = "{";
+                    for (int i = 0, count = static_cast<int>(m_random() % 6); i < count; ++i)
+                    {
+                        text += (0 == i ? "" : ",") + string() + ":" + document(depth + 1);
+                    }
+                    return text + "}";
+                }
+            default:
+                {
+                    std::string text = "[";
+                    for (int i = 0, count = static_cast<int>(m_random() % 6); i < count; ++i)
+                    {
+                        text += (0 == i ? "" : ",") + document(depth + 1);
+                    }
+                    return text + "]";
+                }
+            }
+        }
+
+    private:
+        std::string string()
+        {
+            static const char* const pieces[] = { "a", "key", "\\\"", "\\\\", "\\n", "\\u00e9", "\\ud83d\\ude00", "x y", "\xc3\xa9", "/" };
+            std::string text = "\"";
+            for (int i = 0, count = static_cast<int>(m_random() % 6); i < count; ++i)
+            {
+                text += pieces[m_random() % (sizeof(pieces) / sizeof(pieces[0]))];
+            }
+            if (0 == m_random() % 10)
+            {
+                text.append(20 + m_random() % 300, 'z');    //  1 ֽں 2 ֽڳȵı߽
+            }
+            return text + "\"";
+        }
+
+        std::string number()
+        {
+            char text[64] = { 0 };
+            switch (m_random() % 6)
+            {
+            case 0:
+                return std::to_string(static_cast<long long>(m_random()));
+            case 1:
+                return std::to_string(static_cast<long long>(m_random() % 70000) - 35000);
+            case 2:
+                return "18446744073709551615";
+            case 3:
+                return "-9223372036854775808";
+            case 4:
+                ::snprintf(text, sizeof(text), "%.17g", static_cast<double>(m_random() % 100000) / (1 + m_random() % 1000));
+                return text;
+            default:
+                return "-0.0";
+            }
+        }
+
+        std::mt19937_64 m_random;
+    };
+
+    std::string fromHex(const char* hex)
+    {
+        std::string bytes;
+        for (; '\0' != hex[0] && '\0' != hex[1]; hex += 2)
+        {
+            unsigned int byte = 0;
+            ::sscanf(hex, "%2x", &byte);
+            bytes.push_back(static_cast<char>(byte));
+        }
+        return bytes;
+    }
+
+    bool parseCbor(Json::CharReader& reader, const std::string& bytes, Json::Value& value)
+    {
+        std::string errors;
+        return reader.parse(bytes.data(), bytes.data() + bytes.size(), &value, &errors);
+    }
+
+    void testEncoding()
+    {
+        Json::StreamWriterBuilder builder;
+        builder["format"] = "cbor";
+        TEST_CHECK(fromHex("00") == Json::writeString(builder, Json::Value(0)));
+        TEST_CHECK(fromHex("17") == Json::writeString(builder, Json::Value(23)));
+        TEST_CHECK(fromHex("1818") == Json::writeString(builder, Json::Value(24)));
+        TEST_CHECK(fromHex("1901f4") == Json::writeString(builder, Json::Value(500)));
+        TEST_CHECK(fromHex("20") == Json::writeString(builder, Json::Value(-1)));
+        TEST_CHECK(fromHex("6161") == Json::writeString(builder, Json::Value("a")));
+        TEST_CHECK(fromHex("f5") == Json::writeString(builder, Json::Value(true)));
+        TEST_CHECK(fromHex("f6") == Json::writeString(builder, Json::Value()));
+        TEST_CHECK(fromHex("80") == Json::writeString(builder, Json::Value(Json::arrayValue)));
+        TEST_CHECK(fromHex("a0") == Json::writeString(builder, Json::Value(Json::objectValue)));
+    }
+
+    void testDecodeRfcExamples()
+    {
+        Json::CharReaderBuilder builder;
+        builder["format"] = "cbor";
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        Json::StreamWriterBuilder writer;
+        writer["indentation"] = "";
+
+        struct Example
+        {
+            const char* hex;
+            const char* json;
+        };
+        const Example examples[] = {
+            { "f93c00", "1.0" },
+            { "fb3ff199999999999a", "1.1" },
+            { "c11a514b67b0", "1363896240" },       // ǩ
+            { "7f657374726561646d696e67ff", "\"streaming\"" },
+            { "9f018202039f0405ffff", "[1,[2,3],[4,5]]" },
+            { "bf61610161629f0203ffff", "{\"a\":1,\"b\":[2,3]}" },
+            { "f7", "null" },
+            { "a0", "{}" },
+            { "80", "[]" },
+        };
+        for (size_t i = 0; i < sizeof(examples) / sizeof(examples[0]); ++i)
+        {
+            Json::Value value;
+            TEST_CHECK(parseCbor(*reader, fromHex(examples[i].hex), value));
+            TEST_CHECK(examples[i].json == Json::writeString(writer, value));
+        }
+    }
+
+    void testRoundTrip()
+    {
+        Json::CharReaderBuilder textBuilder;
+        std::unique_ptr<Json::CharReader> textReader(textBuilder.newCharReader());
+        Json::CharReaderBuilder cborBuilder;
+        cborBuilder["format"] = "cbor";
+        std::unique_ptr<Json::CharReader> cborReader(cborBuilder.newCharReader());
+        Json::StreamWriterBuilder cborWriter;
+        cborWriter["format"] = "cbor";
+        Json::StreamWriterBuilder textWriter;
+        textWriter["indentation"] = "";
+
+        DocumentGenerator generator(5);
+        int mismatches = 0;
+        int truncatedAccepted = 0;
+        for (int i = 0; i < 20000; ++i)
+        {
+            std::string text = generator.document();
+            Json::Value value;
+            std::string errors;
+            if (false == textReader->parse(text.data(), text.data() + text.size(), &value, &errors))
+            {
+                continue;
+            }
+
+            std::string bytes = Json::writeString(cborWriter, value);
+            Json::Value decoded;
+            if (false == parseCbor(*cborReader, bytes, decoded) || false == (value == decoded)
+                || Json::writeString(textWriter, value) != Json::writeString(textWriter, decoded))
+            {
+                if (++mismatches <= 10)
+                {
+                    ::fprintf(stderr, "round trip: %s\n", text.c_str());
+                }
+            }
+
+            // CBOR Զģĵκǰ׺
+            for (size_t length = 0; length < bytes.size(); length += 1 + bytes.size() / 16)
+            {
+                if (parseCbor(*cborReader, bytes.substr(0, length), decoded))
+                {
+                    ++truncatedAccepted;
+                }
+            }
+        }
+        TEST_CHECK(0 == mismatches);
+        TEST_CHECK(0 == truncatedAccepted);
+    }
+
+    void testMalformed()
+    {
+        Json::CharReaderBuilder builder;
+        builder["format"] = "cbor";
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        Json::Value value;
+
+        // ˾޴󳤶ȵû
+        TEST_CHECK(false == parseCbor(*reader, fromHex("9bffffffffffffffff"), value));
+        TEST_CHECK(false == parseCbor(*reader, fromHex("bb0000001000000000"), value));
+        TEST_CHECK(false == parseCbor(*reader, fromHex("5bfffffffffffffff0"), value));
+
+        // Ƕ׳ stackLimit ʱı CharReader һ׳ RuntimeError
+        std::string deep(2000000, '\x81');
+        deep.push_back('\x01');
+        bool threw = false;
+        try
+        {
+            parseCbor(*reader, deep, value);
+        }
+        catch (const Json::RuntimeError&)
+        {
+            threw = true;
+        }
+        TEST_CHECK(threw);
+
+        std::mt19937_64 random(11);
+        for (int i = 0; i < 100000; ++i)
+        {
+            std::string garbage;
+            for (int length = static_cast<int>(random() % 40); length > 0; --length)
+            {
+                garbage.push_back(static_cast<char>(random()));
+            }
+            parseCbor(*reader, garbage, value);     // ֻҪ󲻱
+        }
+    }
+}
+
+int main()
+{
+    testEncoding();
+    testDecodeRfcExamples();
+    testRoundTrip();
+    testMalformed();
+    return testResult("json_cbor_test");
+}
@@ -0,0 +1,91 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+/**************************************************************************/
+
+/*
+* ԱҺͶ󹹽ĺʱͬСĶ󣬰Һͽĵ
+*  JSON_USE_FLAT_MAP=1 ͬһ׼json_lookup_bench_flatmapԱ
+*/
+
+namespace
+{
+    const int kLookups = 2000000;
+    const int kRuns = 5;
+
+    void measure(size_t members)
+    {
+        std::mt19937 random(static_cast<unsigned>(members));
+        Json::Value object(Json::objectValue);
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < members; ++i)
+        {
+            keys.push_back("member_" + std::to_string(random() % 1000000));
+            object[keys.back()] = static_cast<int>(i);
+        }
+        std::vector<size_t> order;
+        for (int i = 0; i < 4096; ++i)
+        {
+            order.push_back(random() % keys.size());
+        }
+
+        // һĵ㹻ֶʹʱԲ
+        Json::Value document(Json::arrayValue);
+        for (size_t i = 0; i < (std::max)(size_t(1), 200000 / members); ++i)
+        {
+            document.append(object);
+        }
+        Json::StreamWriterBuilder writer;
+        writer["indentation"] = "";
+        std::string text = Json::writeString(writer, document);
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+        double bestLookup = 1e18;
+        double bestParse = 1e18;
+        long long sum = 0;
+        for (int run = 0; run < kRuns; ++run)
+        {
+            const Json::Value& constObject = object;
+            TestStopwatch watch;
+            for (int i = 0; i < kLookups; ++i)
+            {
+                const std::string& key = keys[order[i & 4095]];
+                const Json::Value* found = constObject.find(key.data(), key.data() + key.size());
+                sum += found ? found->asInt() : -1;
+            }
+            bestLookup = (std::min)(bestLookup, watch.elapsedMs());
+
+            Json::Value parsed;
+            std::string errors;
+            watch.restart();
+            bool ok = reader->parse(text.data(), text.data() + text.size(), &parsed, &errors);
+            parsed = Json::Value();
+            bestParse = (std::min)(bestParse, watch.elapsedMs());
+            TEST_CHECK(ok);
+        }
+        TEST_CHECK(sum > 0 || 1 == members);
+        ::printf("  %5zu members   lookup %6.1f ns   parse+free %7.2f ms (%zu bytes)\n"
+            , members, bestLookup * 1e6 / kLookups, bestParse, text.size());
+    }
+}
+
+int main()
+{
+#if JSON_USE_FLAT_MAP
+    const char* name = "json_lookup_bench_flatmap";
+#else
+    const char* name = "json_lookup_bench";
+#endif
+    ::printf("%s: %d lookups per size, best of %d runs\n", name, kLookups, kRuns);
+    static const size_t kSizes[] = { 1, 4, 8, 16, 64, 1024 };
+    for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i)
+    {
+        measure(kSizes[i]);
+    }
+    return testResult(name);
+}
@@ -0,0 +1,136 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <cfloat>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+/**************************************************************************/
+
+/*
+* JSON_USE_FAST_NUMBERSGrisu2 д double  reader غλͬ
+* ·ʮ strtod Ľλͬ
+*/
+
+namespace
+{
+    const int kIterations = 200000;
+
+    bool sameBits(double a, double b)
+    {
+        return 0 == ::memcmp(&a, &b, sizeof(a));
+    }
+
+    double randomDouble(std::mt19937_64& random, int mode)
+    {
+        unsigned long long bits = random();
+        double value = 0;
+        switch (mode)
+        {
+        case 0:     // λģʽǴ͸ָ
+            ::memcpy(&value, &bits, sizeof(value));
+            break;
+        case 1:     // ͳﳣĶС
+            value = static_cast<double>(bits % 2000000) / 1000.0;
+            break;
+        case 2:
+            value = std::ldexp(static_cast<double>(bits >> 11), static_cast<int>(random() % 200) - 150);
+            break;
+        default:    // ֵ double
+            value = static_cast<double>(static_cast<long long>(bits >> 11)) * ((bits & 1) ? -1 : 1);
+            break;
+        }
+        return std::isfinite(value) ? value : 1.5;
+    }
+
+    //  reader Ҫܶ textضֵʧʱΪ NaN
+    void readBack(Json::CharReader& charReader, const std::string& text, double results[3])
+    {
+        Json::Value value;
+        std::string errors;
+        results[0] = charReader.parse(text.data(), text.data() + text.size(), &value, &errors) ? value.asDouble() : NAN;
+
+        Json::Reader reader;
+        results[1] = reader.parse(text, value) ? value.asDouble() : NAN;
+
+        Json::SaxReader saxReader;
+        Json::ValueBuilder builder(value);
+        results[2] = saxReader.parse(text.data(), text.data() + text.size(), builder) ? value.asDouble() : NAN;
+    }
+
+    void testKnownValues()
+    {
+        Json::FastWriter writer;
+        TEST_CHECK("0.1\n" == writer.write(Json::Value(0.1)));
+        TEST_CHECK("0.3\n" == writer.write(Json::Value(0.3)));
+        TEST_CHECK("1.0\n" == writer.write(Json::Value(1.0)));
+        TEST_CHECK("-0.0\n" == writer.write(Json::Value(-0.0)));
+        TEST_CHECK("123456.789\n" == writer.write(Json::Value(123456.789)));
+        TEST_CHECK("1e+300\n" == writer.write(Json::Value(1e300)));
+        TEST_CHECK("5e-324\n" == writer.write(Json::Value(5e-324)));
+        TEST_CHECK("1.7976931348623157e+308\n" == writer.write(Json::Value(DBL_MAX)));
+    }
+
+    void testWriteRoundTrip()
+    {
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> charReader(builder.newCharReader());
+        Json::FastWriter writer;
+        std::mt19937_64 random(20261016);
+
+        int mismatches = 0;
+        for (int i = 0; i < kIterations; ++i)
+        {
+            double value = randomDouble(random, i % 4);
+            std::string text = writer.write(Json::Value(value));
+            double results[3];
+            readBack(*charReader, text, results);
+            if (false == sameBits(value, results[0]) || false == sameBits(value, results[1]) || false == sameBits(value, results[2]))
+            {
+                if (++mismatches <= 10)
+                {
+                    ::fprintf(stderr, "round trip %.17g -> %s", value, text.c_str());
+                }
+            }
+        }
+        TEST_CHECK(0 == mismatches);
+    }
+
+    void testParseMatchesStrtod()
+    {
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> charReader(builder.newCharReader());
+        std::mt19937_64 random(7);
+
+        int mismatches = 0;
+        for (int i = 0; i < kIterations; ++i)
+        {
+            char text[64] = { 0 };
+            ::snprintf(text, sizeof(text), "%lld.%llue%d"
+                , static_cast<long long>(random() % 10000000000000LL) - 5000000000000LL
+                , static_cast<unsigned long long>(random() % 1000000ULL)
+                , static_cast<int>(random() % 50) - 25);
+            double expected = ::strtod(text, NULL);
+            double results[3];
+            readBack(*charReader, text, results);
+            if (false == sameBits(expected, results[0]) || false == sameBits(expected, results[1]) || false == sameBits(expected, results[2]))
+            {
+                if (++mismatches <= 10)
+                {
+                    ::fprintf(stderr, "parse %s: expected %.17g, got %.17g %.17g %.17g\n", text, expected, results[0], results[1], results[2]);
+                }
+            }
+        }
+        TEST_CHECK(0 == mismatches);
+    }
+}
+
+int main()
+{
+    testKnownValues();
+    testWriteRoundTrip();
+    testParseMatchesStrtod();
+    return testResult("json_number_test");
+}
@@ -0,0 +1,276 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+/**************************************************************************/
+
+/*
+* Ĵ洢std::mapĬϣ JSON_USE_FLAT_MAP  FlatMap Ϊͬ
+* 롢ǡremoveMemberremoveIndex  std::map ģ𲽶գԱ
+* Ƕϴ洢֮лơȽԼ zeroCopy  arena Ķ
+* Makefile ѱԺ json Ը JSON_USE_FLAT_MAP=1 ٱһݣ*_flatmap
+*/
+
+namespace
+{
+    typedef std::map<std::string, int> Model;
+
+    bool sameAsModel(const Json::Value& object, const Model& model)
+    {
+        if (false == (object.isObject() || (object.isNull() && model.empty())) || object.size() != model.size())
+        {
+            return false;
+        }
+        Model::const_iterator expected = model.begin();
+        for (Json::Value::const_iterator it = object.begin(); it != object.end(); ++it, ++expected)
+        {
+            const char* end = NULL;
+            const char* begin = it.memberName(&end);
+            if (expected->first != std::string(begin, end) || expected->second != (*it).asInt())
+            {
+                return false;
+            }
+        }
+        for (Model::const_iterator it = model.begin(); it != model.end(); ++it)
+        {
+            const Json::Value* found = object.find(it->first.data(), it->first.data() + it->first.size());
+            if (NULL == found || it->second != found->asInt())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string randomKey(std::mt19937& random)
+    {
+        // ļ֤гԱǰ׺ͬǶ \0 ļ
+        static const char* kPrefixes[] = { "", "a", "ab", "user", "user_" };
+        std::string key = kPrefixes[random() % 5] + std::to_string(random() % 40);
+        if (0 == random() % 16)
+        {
+            key += std::string(1, '\0') + "z";
+        }
+        return key;
+    }
+
+    void testRandomEdits()
+    {
+        std::mt19937 random(2024);
+        int mismatches = 0;
+        for (int round = 0; round < 200; ++round)
+        {
+            Json::Value object;
+            Model model;
+            int steps = static_cast<int>(random() % 200);
+            for (int step = 0; step < steps; ++step)
+            {
+                std::string key = randomKey(random);
+                int value = static_cast<int>(random() % 1000);
+                switch (random() % 4)
+                {
+                case 0:
+                case 1:
+                    object[key] = value;
+                    model[key] = value;
+                    break;
+                case 2:
+                {
+                    Json::Value removed;
+                    bool found = object.isObject() && object.removeMember(key, &removed);
+                    Model::iterator it = model.find(key);
+                    if (found != (it != model.end()) || (found && removed.asInt() != it->second))
+                    {
+                        ++mismatches;
+                    }
+                    if (it != model.end())
+                    {
+                        model.erase(it);
+                    }
+                    break;
+                }
+                default:
+                    if (object.isMember(key) != (model.count(key) != 0))
+                    {
+                        ++mismatches;
+                    }
+                    break;
+                }
+                if (false == sameAsModel(object, model))
+                {
+                    ++mismatches;
+                }
+            }
+
+            // ƵõĶ޸ԭӰ츱
+            Json::Value copy(object);
+            TEST_CHECK(copy == object);
+            object["extra"] = 1;
+            TEST_CHECK(sameAsModel(copy, model));
+            TEST_CHECK(false == (copy == object));
+        }
+        TEST_CHECK(0 == mismatches);
+    }
+
+    void testInlineToHeap()
+    {
+        // ԱǶ4 Աı߽
+        Json::Value object(Json::objectValue);
+        Model model;
+        for (int i = 9; i >= 0; --i)
+        {
+            std::string key = "k" + std::to_string(i);
+            object[key] = i;
+            model[key] = i;
+            TEST_CHECK(sameAsModel(object, model));
+        }
+        Json::Value reference = object;
+        for (int i = 0; i < 10; i += 2)
+        {
+            std::string key = "k" + std::to_string(i);
+            TEST_CHECK(i == object.removeMember(key).asInt());
+            model.erase(key);
+            TEST_CHECK(sameAsModel(object, model));
+        }
+        TEST_CHECK(object.removeMember("missing").isNull());
+        TEST_CHECK(5 == object.size());
+        TEST_CHECK(object < reference);
+        TEST_CHECK(reference == Json::Value(reference));
+
+        std::vector<std::string> names = object.getMemberNames();
+        TEST_CHECK(5 == names.size() && "k1" == names[0] && "k9" == names[4]);
+        object.clear();
+        TEST_CHECK(object.isObject() && object.empty());
+    }
+
+    void testArrays()
+    {
+        std::mt19937 random(99);
+        Json::Value array(Json::arrayValue);
+        std::vector<int> model;
+        for (int i = 0; i < 50; ++i)
+        {
+            array.append(i);
+            model.push_back(i);
+        }
+        array[Json::ArrayIndex(59)] = 59;   // м䲹 null
+        model.resize(59, -1);
+        model.push_back(59);
+        int mismatches = 0;
+        while (false == model.empty())
+        {
+            Json::ArrayIndex index = static_cast<Json::ArrayIndex>(random() % model.size());
+            Json::Value removed;
+            if (false == array.removeIndex(index, &removed) || removed.asInt() != (model[index] < 0 ? 0 : model[index]))
+            {
+                ++mismatches;
+            }
+            model.erase(model.begin() + index);
+            if (array.size() != model.size())
+            {
+                ++mismatches;
+                break;
+            }
+            Json::ArrayIndex i = 0;
+            for (Json::Value::const_iterator it = array.begin(); it != array.end(); ++it, ++i)
+            {
+                if (i != it.index() || (model[i] < 0 ? false == (*it).isNull() : model[i] != (*it).asInt()))
+                {
+                    ++mismatches;
+                }
+            }
+        }
+        TEST_CHECK(0 == mismatches);
+        TEST_CHECK(false == array.removeIndex(0, NULL));
+    }
+
+    void testParsedObjects()
+    {
+        // ĳԱֱظĳԱЧ
+        const char document[] = "{\"zeta\":1,\"alpha\":2,\"mid\":3,\"beta\":4,\"omega\":5,\"alpha\":6,\"a\":{\"y\":1,\"x\":2}}";
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        builder["zeroCopy"] = true;
+        std::unique_ptr<Json::CharReader> zeroCopyReader(builder.newCharReader());
+
+        Json::Value root;
+        std::string errors;
+        TEST_CHECK(reader->parse(document, document + sizeof(document) - 1, &root, &errors));
+        Model model;
+        model["zeta"] = 1;
+        model["alpha"] = 6;
+        model["mid"] = 3;
+        model["beta"] = 4;
+        model["omega"] = 5;
+        Json::Value nested = root.removeMember("a");
+        TEST_CHECK(sameAsModel(root, model));
+        TEST_CHECK("x" == nested.getMemberNames()[0]);
+
+        Json::Value copy;
+        {
+            Json::Value arenaRoot;
+            TEST_CHECK(zeroCopyReader->parse(document, document + sizeof(document) - 1, &arenaRoot, &errors));
+            arenaRoot.removeMember("a");
+            TEST_CHECK(sameAsModel(arenaRoot, model));
+            arenaRoot["inserted"] = 7;     // arena ĶҲԼ޸
+            copy = arenaRoot;
+        }
+        zeroCopyReader.reset();
+        model["inserted"] = 7;
+        TEST_CHECK(sameAsModel(copy, model));
+    }
+
+#if JSON_USE_FLAT_MAP
+    void testFlatMapDirectly()
+    {
+        typedef Json::FlatMap<int, int, std::less<int>, std::allocator<std::pair<const int, int> >, 4> Map;
+        Map map;
+        std::map<int, int> model;
+        std::mt19937 random(5);
+        int mismatches = 0;
+        for (int step = 0; step < 5000; ++step)
+        {
+            int key = static_cast<int>(random() % 64);
+            if (random() % 3)
+            {
+                // hint ⣬Ӱ
+                Map::const_iterator hint = map.begin() + (map.empty() ? 0 : random() % (map.size() + 1));
+                map.insert(hint, std::make_pair(key, step));
+                model.insert(std::make_pair(key, step));
+            }
+            else if (map.erase(key) != model.erase(key))
+            {
+                ++mismatches;
+            }
+            if (map.size() != model.size() || false == std::equal(map.begin(), map.end(), model.begin()))
+            {
+                ++mismatches;
+            }
+        }
+        TEST_CHECK(0 == mismatches);
+
+        Map copy(map);
+        TEST_CHECK(copy == map);
+        map.clear();
+        TEST_CHECK(map.empty() && map.begin() == map.end());
+        TEST_CHECK(map < copy || copy.empty());
+    }
+#endif
+}
+
+int main()
+{
+    testRandomEdits();
+    testInlineToHeap();
+    testArrays();
+    testParsedObjects();
+#if JSON_USE_FLAT_MAP
+    testFlatMapDirectly();
+    return testResult("json_object_test_flatmap");
+#else
+    return testResult("json_object_test");
+#endif
+}
@@ -0,0 +1,83 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+/**************************************************************************/
+
+/*
+* ַɨ£ͬȵַɵ飬ֱд
+*  JSON_USE_SIMD=0  jsoncpp ͬһ׼json_scan_bench_nosimdԱ
+*/
+
+namespace
+{
+    const size_t kDocumentBytes = 4 * 1024 * 1024;
+    const int kRuns = 5;
+
+    // ÿ every ֽһҪתַ0 ʾû
+    Json::Value makeStrings(size_t length, size_t every)
+    {
+        Json::Value root(Json::arrayValue);
+        size_t count = kDocumentBytes / (length + 3);
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string text;
+            for (size_t j = 0; j < length; ++j)
+            {
+                size_t n = i * length + j;
+                text += (every && 0 == n % every) ? '"' : static_cast<char>('a' + n % 26);
+            }
+            root.append(text);
+        }
+        return root;
+    }
+
+    void measure(size_t length, size_t every)
+    {
+        Json::Value value = makeStrings(length, every);
+        Json::StreamWriterBuilder writer;
+        writer["indentation"] = "";
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+        std::string document;
+        double bestWrite = 1e18;
+        double bestRead = 1e18;
+        for (int run = 0; run < kRuns; ++run)
+        {
+            TestStopwatch watch;
+            document = Json::writeString(writer, value);
+            bestWrite = (std::min)(bestWrite, watch.elapsedMs());
+
+            Json::Value decoded;
+            std::string errors;
+            watch.restart();
+            bool ok = reader->parse(document.data(), document.data() + document.size(), &decoded, &errors);
+            bestRead = (std::min)(bestRead, watch.elapsedMs());
+            TEST_CHECK(ok && value == decoded);
+        }
+        double megabytes = static_cast<double>(document.size()) / (1024 * 1024);
+        ::printf("  %5zu-byte strings, %-12s write %7.1f MB/s   parse %7.1f MB/s\n", length
+            , every ? ("escape/" + std::to_string(every)).c_str() : "no escapes"
+            , megabytes * 1000 / bestWrite, megabytes * 1000 / bestRead);
+    }
+}
+
+int main()
+{
+#if JSON_USE_SIMD
+    const char* name = "json_scan_bench";
+#else
+    const char* name = "json_scan_bench_nosimd";
+#endif
+    ::printf("%s: %zu MB of string arrays, best of %d runs\n", name, kDocumentBytes / (1024 * 1024), kRuns);
+    static const size_t kLengths[] = { 8, 15, 16, 17, 64, 256, 4096 };
+    for (size_t i = 0; i < sizeof(kLengths) / sizeof(kLengths[0]); ++i)
+    {
+        measure(kLengths[i], 0);
+    }
+    measure(256, 64);
+    measure(256, 8);
+    return testResult(name);
+}
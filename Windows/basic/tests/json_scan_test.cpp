@@ -0,0 +1,267 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <memory>
+#include <stdio.h>
+#include <string>
+/**************************************************************************/
+
+/*
+* JSON_USE_SIMDַɨ谴 16AVX2  32ֽһУʣಿֽڴ
+*  0  70 ֽڵַÿλ÷Ҫתַšбܡַ\0
+*  reader Ľ͸ writer תֽڵĲοʵһ£
+* ߽磨15/16/1731/32/33 ֽڣϵַ©Ҳ 0x7F  UTF-8 ַֽ
+* ͬһݲҲ JSON_USE_SIMD=0  jsoncpp һ飨*_nosimd
+*/
+
+namespace
+{
+    const size_t kMaxLength = 70;
+
+    //  writer ͬתֽʵ
+    std::string quote(const std::string& raw)
+    {
+        std::string result = "\"";
+        for (size_t i = 0; i < raw.size(); ++i)
+        {
+            unsigned char c = static_cast<unsigned char>(raw[i]);
+            switch (c)
+            {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\b': result += "\\b"; break;
+            case '\f': result += "\\f"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (c < 0x20)
+                {
+                    char escaped[8];
+                    ::snprintf(escaped, sizeof(escaped), "\\u%04X", c);
+                    result += escaped;
+                }
+                else
+                {
+                    result += static_cast<char>(c);
+                }
+                break;
+            }
+        }
+        return result + "\"";
+    }
+
+    //  {"<raw>":"<raw>"} ĳԱֵ߶Ӧ raw
+    bool checkMember(const Json::Value& root, const std::string& raw)
+    {
+        if (false == root.isObject() || 1 != root.size())
+        {
+            return false;
+        }
+        Json::Value::const_iterator it = root.begin();
+        const char* end = NULL;
+        const char* begin = it.memberName(&end);
+        return raw == std::string(begin, end) && (*it).isString() && raw == (*it).asString();
+    }
+
+    class Readers
+    {
+    public:
+        Readers()
+        {
+            Json::CharReaderBuilder builder;
+            m_charReader.reset(builder.newCharReader());
+            builder["zeroCopy"] = true;
+            m_zeroCopyReader.reset(builder.newCharReader());
+        }
+
+        // ض reader 
+        int check(const std::string& document, const std::string& raw)
+        {
+            int failures = 0;
+            const char* begin = document.data();
+            const char* end = begin + document.size();
+            std::string errors;
+
+            Json::Value root;
+            if (false == m_charReader->parse(begin, end, &root, &errors) || false == checkMember(root, raw))
+            {
+                ++failures;
+            }
+            {
+                Json::Value zeroCopyRoot;
+                if (false == m_zeroCopyReader->parse(begin, end, &zeroCopyRoot, &errors) || false == checkMember(zeroCopyRoot, raw))
+                {
+                    ++failures;
+                }
+            }
+
+            Json::Reader reader;
+            if (false == reader.parse(document, root) || false == checkMember(root, raw))
+            {
+                ++failures;
+            }
+
+            Json::SaxReader saxReader;
+            Json::ValueBuilder saxBuilder(root);
+            if (false == saxReader.parse(begin, end, saxBuilder) || false == checkMember(root, raw))
+            {
+                ++failures;
+            }
+
+            Json::ValueBuilder incrementalBuilder(root);
+            Json::IncrementalReader incrementalReader(incrementalBuilder);
+            if (false == incrementalReader.feed(begin, end) || false == incrementalReader.finish() || false == checkMember(root, raw))
+            {
+                ++failures;
+            }
+
+            Json::LazyDocument lazy;
+            if (false == lazy.parse(begin, end) || raw != lazy.root().find(raw.data(), raw.data() + raw.size()).asString())
+            {
+                ++failures;
+            }
+            return failures;
+        }
+
+    private:
+        std::unique_ptr<Json::CharReader> m_charReader;
+        std::unique_ptr<Json::CharReader> m_zeroCopyReader;
+    };
+
+    // д writer 
+    int checkWriters(const std::string& raw, const std::string& quoted)
+    {
+        int failures = 0;
+        Json::Value root;
+        root[raw] = raw;
+        std::string expected = "{" + quoted + ":" + quoted + "}";
+
+        Json::FastWriter fastWriter;
+        fastWriter.omitEndingLineFeed();
+        if (expected != fastWriter.write(root))
+        {
+            ++failures;
+        }
+
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        if (expected != Json::writeString(builder, root))
+        {
+            ++failures;
+        }
+
+        // StyledWriter  valueToQuotedString  C ַԱ֧Ƕ \0
+        bool embeddedZero = raw.find('\0') != std::string::npos;
+        Json::StyledWriter styledWriter;
+        if (false == embeddedZero && "{\n   " + quoted + " : " + quoted + "\n}\n" != styledWriter.write(root))
+        {
+            ++failures;
+        }
+
+        if (false == embeddedZero && quoted != Json::valueToQuotedString(raw.c_str()))
+        {
+            ++failures;
+        }
+        return failures;
+    }
+
+    std::string filler(size_t length, size_t seed)
+    {
+        std::string text;
+        for (size_t i = 0; i < length; ++i)
+        {
+            text += static_cast<char>('a' + (i + seed) % 26);
+        }
+        return text;
+    }
+
+    void check(Readers& readers, const std::string& raw, int& mismatches)
+    {
+        std::string quoted = quote(raw);
+        int failures = checkWriters(raw, quoted) + readers.check("{" + quoted + ":" + quoted + "}", raw);
+        if (failures && ++mismatches <= 10)
+        {
+            ::fprintf(stderr, "%d failure(s) for %s (%zu bytes)\n", failures, quoted.c_str(), raw.size());
+        }
+    }
+
+    void testSpecialAtEveryPosition()
+    {
+        static const char kSpecials[] = { '"', '\\', '\n', '\t', '\x01', '\x1f', '\0', '\x7f', '/' };
+        Readers readers;
+        int mismatches = 0;
+        for (size_t length = 0; length <= kMaxLength; ++length)
+        {
+            check(readers, filler(length, length), mismatches);
+            for (size_t position = 0; position < length; ++position)
+            {
+                for (size_t s = 0; s < sizeof(kSpecials); ++s)
+                {
+                    std::string raw = filler(length, position);
+                    raw[position] = kSpecials[s];
+                    check(readers, raw, mismatches);
+
+                    // ͬһһԼһֽ
+                    raw[length - 1] = '"';
+                    raw[(position + 16) % length] = '\\';
+                    check(readers, raw, mismatches);
+                }
+            }
+        }
+        TEST_CHECK(0 == mismatches);
+    }
+
+    void testMultiByteAcrossBoundaries()
+    {
+        // "" ֽ E4 B8 AD λ 1зűȽϻǵɿַ
+        Readers readers;
+        int mismatches = 0;
+        for (size_t length = 3; length <= kMaxLength; ++length)
+        {
+            for (size_t position = 0; position + 3 <= length; ++position)
+            {
+                std::string raw = filler(length, position);
+                raw.replace(position, 3, "\xe4\xb8\xad");
+                check(readers, raw, mismatches);
+                raw[length - 1] = '\x02';
+                check(readers, raw, mismatches);
+            }
+        }
+        TEST_CHECK(0 == mismatches);
+    }
+
+    void testUnterminatedAtBoundaries()
+    {
+        // ȱʧתʱɨ費Խĩβ
+        Readers readers;
+        for (size_t length = 0; length <= kMaxLength; ++length)
+        {
+            std::string unterminated = "{\"key\":\"" + filler(length, 0);
+            std::string escapedQuote = unterminated + "\\\"";
+            for (int variant = 0; variant < 2; ++variant)
+            {
+                std::string document = variant ? escapedQuote : unterminated;
+                Json::Value root;
+                Json::Reader reader;
+                TEST_CHECK(false == reader.parse(document, root));
+                Json::SaxReader saxReader;
+                Json::ValueBuilder builder(root);
+                TEST_CHECK(false == saxReader.parse(document.data(), document.data() + document.size(), builder));
+                Json::LazyDocument lazy;
+                TEST_CHECK(false == lazy.parse(document.data(), document.data() + document.size()));
+            }
+        }
+    }
+}
+
+int main()
+{
+    testSpecialAtEveryPosition();
+    testMultiByteAcrossBoundaries();
+    testUnterminatedAtBoundaries();
+#if JSON_USE_SIMD
+    return testResult("json_scan_test");
+#else
+    return testResult("json_scan_test_nosimd");
+#endif
+}
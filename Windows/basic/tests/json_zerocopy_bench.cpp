@@ -0,0 +1,74 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+/**************************************************************************/
+
+/*
+* "zeroCopy" ͨ CharReader ͬһĵĺʱĵշԱб
+* Աת壬һֵַת
+*/
+
+namespace
+{
+    const int kUsers = 20000;
+    const int kRuns = 10;
+
+    std::string makeRoster()
+    {
+        std::mt19937 random(7);
+        Json::Value root;
+        root["roomId"] = 1234;
+        Json::Value& users = root["users"];
+        for (int i = 0; i < kUsers; ++i)
+        {
+            Json::Value user;
+            user["userId"] = "user_" + std::to_string(100000 + i);
+            user["nickName"] = (0 == i % 4) ? "\"nick\"\t" + std::to_string(i) : "nick_" + std::to_string(i);
+            user["role"] = (0 == i % 10) ? "anchor" : "audience";
+            user["videoBitrate"] = 300 + static_cast<int>(random() % 1500);
+            user["muted"] = 0 == random() % 3;
+            users.append(user);
+        }
+        Json::StreamWriterBuilder writer;
+        writer["indentation"] = "";
+        return Json::writeString(writer, root);
+    }
+
+    double measure(bool zeroCopy, const std::string& document)
+    {
+        Json::CharReaderBuilder builder;
+        builder["zeroCopy"] = zeroCopy;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        double best = 1e18;
+        Json::Value root;
+        for (int run = 0; run < kRuns; ++run)
+        {
+            std::string errors;
+            TestStopwatch watch;
+            bool ok = reader->parse(document.data(), document.data() + document.size(), &root, &errors);
+            // ͨ reader ͷҲڣzeroCopy ͷŷһ parse() 
+            if (false == zeroCopy)
+            {
+                root = Json::Value();
+            }
+            best = (std::min)(best, watch.elapsedMs());
+            TEST_CHECK(ok);
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    std::string document = makeRoster();
+    ::printf("json_zerocopy_bench: %d users, %zu bytes, best of %d runs\n", kUsers, document.size(), kRuns);
+
+    double copying = measure(false, document);
+    double zeroCopy = measure(true, document);
+    ::printf("  copying    %8.2f ms\n", copying);
+    ::printf("  zeroCopy   %8.2f ms   (%.2fx)\n", zeroCopy, copying / zeroCopy);
+    return testResult("json_zerocopy_bench");
+}
@@ -0,0 +1,169 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <memory>
+#include <string.h>
+#include <string>
+#include <vector>
+/**************************************************************************/
+
+/*
+* CharReaderBuilder "zeroCopy"ͨ reader ͬתĳԱֱָ룬
+* תĳԱֵַ arena Ƴ Value  reader ޹
+*/
+
+namespace
+{
+    const char kDocument[] =
+        "{\"userId\":\"user_1001\",\"roomId\":1234,"
+        "\"tips\":\"line1\\nline2 \\\"quoted\\\" \\u4e2d\","
+        "\"esc\\taped\":[1,2,{\"inner\":\"value\",\"n\\u0061me\":null}],"
+        "\"empty\":\"\",\"flag\":true}";
+
+    std::unique_ptr<Json::CharReader> newReader(bool zeroCopy)
+    {
+        Json::CharReaderBuilder builder;
+        builder["zeroCopy"] = zeroCopy;
+        return std::unique_ptr<Json::CharReader>(builder.newCharReader());
+    }
+
+    bool parse(Json::CharReader& reader, const std::vector<char>& buffer, Json::Value& root)
+    {
+        std::string errors;
+        return reader.parse(buffer.data(), buffer.data() + buffer.size(), &root, &errors) && errors.empty();
+    }
+
+    bool inside(const std::vector<char>& buffer, const char* p)
+    {
+        return p >= buffer.data() && p < buffer.data() + buffer.size();
+    }
+
+    // Ϊ name ĳԱ
+    const char* memberNameOf(const Json::Value& object, const std::string& name)
+    {
+        for (Json::Value::const_iterator it = object.begin(); it != object.end(); ++it)
+        {
+            const char* end = NULL;
+            const char* begin = it.memberName(&end);
+            if (name == std::string(begin, end))
+            {
+                return begin;
+            }
+        }
+        return NULL;
+    }
+
+    void testSameAsCopyingReader()
+    {
+        std::vector<char> buffer(kDocument, kDocument + sizeof(kDocument) - 1);
+        Json::Value expected;
+        TEST_CHECK(parse(*newReader(false), buffer, expected));
+        // root  reader ٣ reader  arena 
+        std::unique_ptr<Json::CharReader> reader = newReader(true);
+        Json::Value root;
+        TEST_CHECK(parse(*reader, buffer, root));
+        TEST_CHECK(expected == root);
+        TEST_CHECK("line1\nline2 \"quoted\" \xe4\xb8\xad" == root["tips"].asString());
+        TEST_CHECK(root.isMember("esc\taped"));
+        TEST_CHECK(root["esc\taped"][2].isMember("name"));
+    }
+
+    void testWhereStringsLive()
+    {
+        std::vector<char> buffer(kDocument, kDocument + sizeof(kDocument) - 1);
+        std::unique_ptr<Json::CharReader> reader = newReader(true);
+        Json::Value root;
+        TEST_CHECK(parse(*reader, buffer, root));
+
+        // תĳԱ룬תĽһ
+        TEST_CHECK(inside(buffer, memberNameOf(root, "userId")));
+        TEST_CHECK(inside(buffer, memberNameOf(root["esc\taped"][2], "inner")));
+        const char* escapedName = memberNameOf(root, "esc\taped");
+        TEST_CHECK(NULL != escapedName && false == inside(buffer, escapedName));
+        escapedName = memberNameOf(root["esc\taped"][2], "name");
+        TEST_CHECK(NULL != escapedName && false == inside(buffer, escapedName));
+
+        // ֵַǸƽ arena
+        const char* begin = NULL;
+        const char* end = NULL;
+        TEST_CHECK(root["userId"].getString(&begin, &end) && false == inside(buffer, begin));
+        TEST_CHECK(root["tips"].getString(&begin, &end) && false == inside(buffer, begin));
+
+        // 󣬲Ĳֱֲ䡣õĳԱѱƻֻܰ˳ܰ
+        std::vector<Json::Value> values;
+        for (Json::Value::const_iterator it = root.begin(); it != root.end(); ++it)
+        {
+            values.push_back(Json::Value(*it));
+        }
+        ::memset(buffer.data(), '#', buffer.size());
+        const Json::Value& constRoot = root;
+        size_t index = 0;
+        for (Json::Value::const_iterator it = constRoot.begin(); it != constRoot.end(); ++it, ++index)
+        {
+            // Ƕ׶ĳԱͬѱƻֻȽϱ
+            TEST_CHECK(index < values.size() && values[index].type() == it->type());
+            TEST_CHECK(index < values.size() && (it->isObject() || it->isArray() || values[index] == *it));
+        }
+        TEST_CHECK(values.size() == index);
+        TEST_CHECK(NULL != memberNameOf(constRoot, "esc\taped"));
+    }
+
+    void testCopyDetaches()
+    {
+        std::unique_ptr<Json::CharReader> reader = newReader(true);
+        Json::Value copy;
+        {
+            std::vector<char> buffer(kDocument, kDocument + sizeof(kDocument) - 1);
+            Json::Value root;
+            TEST_CHECK(parse(*reader, buffer, root));
+            copy = root;
+            TEST_CHECK(false == inside(buffer, memberNameOf(copy, "userId")));
+            TEST_CHECK(false == inside(buffer, memberNameOf(copy["esc\taped"][2], "inner")));
+            ::memset(buffer.data(), '#', buffer.size());
+        }
+
+        // ͷţreader һ parse()  arena
+        std::string next = std::string(1000, ' ') + "{\"userId\":\"someone else\",\"roomId\":1}";
+        std::vector<char> other(next.begin(), next.end());
+        Json::Value root;
+        TEST_CHECK(parse(*reader, other, root));
+        TEST_CHECK("someone else" == root["userId"].asString());
+
+        Json::Value expected;
+        std::vector<char> original(kDocument, kDocument + sizeof(kDocument) - 1);
+        TEST_CHECK(parse(*newReader(false), original, expected));
+        TEST_CHECK(expected == copy);
+        TEST_CHECK(inside(other, memberNameOf(root, "userId")));
+
+        // reader ٺ󸱱ȻãҲ޸
+        root = Json::Value();
+        reader.reset();
+        copy["userId"] = "changed";
+        copy["esc\taped"].append("more");
+        TEST_CHECK("changed" == copy["userId"].asString());
+        TEST_CHECK(4 == copy["esc\taped"].size());
+    }
+
+    void testReuseAfterError()
+    {
+        std::unique_ptr<Json::CharReader> reader = newReader(true);
+        const char broken[] = "{\"userId\":\"user_1001\",\"roomId\":";
+        std::vector<char> buffer(broken, broken + sizeof(broken) - 1);
+        Json::Value root;
+        std::string errors;
+        TEST_CHECK(false == reader->parse(buffer.data(), buffer.data() + buffer.size(), &root, &errors));
+        TEST_CHECK(false == errors.empty());
+
+        std::vector<char> good(kDocument, kDocument + sizeof(kDocument) - 1);
+        TEST_CHECK(parse(*reader, good, root));
+        TEST_CHECK("user_1001" == root["userId"].asString());
+    }
+}
+
+int main()
+{
+    testSameAsCopyingReader();
+    testWhereStringsLive();
+    testCopyDetaches();
+    testReuseAfterError();
+    return testResult("json_zerocopy_test");
+}
@@ -0,0 +1,90 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+/**************************************************************************/
+
+/*
+* ӽϴӦжȡֶΣLazyDocument  CharReader ٶȡĺʱԱȡ
+* Ӧյ¼ CGI ķأuserSig ֮⸽Աб
+*/
+
+namespace
+{
+    const int kRuns = 10;
+
+    std::string makeResponse(int members)
+    {
+        std::mt19937 random(3);
+        Json::Value root;
+        Json::Value& data = root["data"];
+        Json::Value& list = data["members"];
+        for (int i = 0; i < members; ++i)
+        {
+            Json::Value member;
+            member["userId"] = "user_" + std::to_string(100000 + i);
+            member["nickName"] = "nick \"" + std::to_string(i) + "\"";
+            member["role"] = (0 == i % 20) ? "anchor" : "audience";
+            member["joinTime"] = static_cast<Json::Int64>(1790000000000LL + random() % 100000);
+            member["videoBitrate"] = 300 + static_cast<int>(random() % 1500);
+            member["tags"].append("t" + std::to_string(random() % 10));
+            list.append(member);
+        }
+        data["userSig"] = "eJyrVgrxCdYrSy1SslIy0jNQ0gHzM1PySvKTMvMA";
+        data["expire"] = 604800;
+        root["errorCode"] = 0;
+        root["errorMessage"] = "";
+        Json::StreamWriterBuilder writer;
+        writer["indentation"] = "";
+        return Json::writeString(writer, root);
+    }
+
+    void measure(int members)
+    {
+        std::string response = makeResponse(members);
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+        double bestEager = 1e18;
+        double bestLazy = 1e18;
+        for (int run = 0; run < kRuns; ++run)
+        {
+            TestStopwatch watch;
+            Json::Value root;
+            std::string errors;
+            bool ok = reader->parse(response.data(), response.data() + response.size(), &root, &errors);
+            std::string eagerSig = root["data"]["userSig"].asString();
+            int eagerCode = root["errorCode"].asInt();
+            std::string eagerLast = root["data"]["members"][members - 1]["userId"].asString();
+            root = Json::Value();
+            bestEager = (std::min)(bestEager, watch.elapsedMs());
+
+            watch.restart();
+            Json::LazyDocument document;
+            bool lazyOk = document.parse(response.data(), response.data() + response.size());
+            Json::LazyDocument::Node data = document.root()["data"];
+            std::string lazySig = data["userSig"].asString();
+            int lazyCode = document.root()["errorCode"].asInt();
+            std::string lazyLast = data["members"][members - 1]["userId"].asString();
+            bestLazy = (std::min)(bestLazy, watch.elapsedMs());
+
+            TEST_CHECK(ok && lazyOk);
+            TEST_CHECK(eagerSig == lazySig && eagerCode == lazyCode && eagerLast == lazyLast);
+        }
+        ::printf("  %6d members %9zu bytes   CharReader %8.3f ms   LazyDocument %8.3f ms   (%.1fx)\n"
+            , members, response.size(), bestEager, bestLazy, bestEager / bestLazy);
+    }
+}
+
+int main()
+{
+    ::printf("lazy_document_bench: read userSig, errorCode and the last member, best of %d runs\n", kRuns);
+    static const int kMembers[] = { 1, 100, 10000, 100000 };
+    for (size_t i = 0; i < sizeof(kMembers) / sizeof(kMembers[0]); ++i)
+    {
+        measure(kMembers[i]);
+    }
+    return testResult("lazy_document_bench");
+}
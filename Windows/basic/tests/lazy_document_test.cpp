@@ -0,0 +1,259 @@
+#include "TestUtil.h"
+#include "json.h"
+#include <random>
+#include <string>
+#include <vector>
+/**************************************************************************/
+
+/*
+* LazyDocumentĽ Json::Reader һԽĽһ£Ա
+*  as*() תȱʧĳԱԽ±귵زڵ NodeǶ׹ʹĵ false 쳣
+*/
+
+namespace
+{
+    const char* kDocuments[] = {
+        "{\"errorCode\":0,\"errorMessage\":\"\",\"data\":{\"userSig\":\"eJyrVgrxCdYrSy1SslIy0jNQ0gHzM1PySvKT\",\"expire\":604800}}",
+        "[0,-0,1,-1,2147483647,-2147483648,4294967295,9223372036854775807,-9223372036854775808,18446744073709551615,"
+        "0.5,-0.25,1e10,1E-5,-1.5e+300,3.14159265358979]",
+        "[\"esc \\\" \\\\ \\/ \\b \\f \\n \\r \\t\",\"\\u0041\\u00e9\\u4e2d\",\"\\ud83d\\ude00\",\"raw \xe4\xb8\xad\",\"\\u0000z\"]",
+        " { \"a\" : [ ] , \"b\" : { } , \"c\" : [ [ ] , { \"d\" : [ 1 , [ 2 , [ 3 ] ] ] } ] , \"e\" : null , \"f\" : true , \"g\" : false } ",
+        "{\"dup\":1,\"dup\":2}",
+        "{\"k\\u0065y\":\"escaped name\",\"key2\":1}",
+        "\"top-level string\"",
+        "42",
+        "null",
+    };
+
+    // node  value ڸʷʽһ£ݹȽ
+    int compare(const Json::LazyDocument::Node& node, const Json::Value& value)
+    {
+        int mismatches = 0;
+        if (false == node.exists() || node.type() != value.type() || false == (node.decode() == value))
+        {
+            ++mismatches;
+        }
+        switch (value.type())
+        {
+        case Json::arrayValue:
+            if (node.size() != value.size() || node[value.size()].exists())
+            {
+                ++mismatches;
+            }
+            for (Json::ArrayIndex i = 0; i < value.size(); ++i)
+            {
+                mismatches += compare(node[i], value[i]);
+            }
+            break;
+        case Json::objectValue:
+        {
+            if (node.size() != value.size() || node["no such member"].exists())
+            {
+                ++mismatches;
+            }
+            Json::Value::Members names = value.getMemberNames();
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                mismatches += compare(node.find(names[i].data(), names[i].data() + names[i].size()), value[names[i]]);
+                if (names[i].find('\0') == std::string::npos && false == node[names[i]].exists())
+                {
+                    ++mismatches;
+                }
+            }
+            break;
+        }
+        case Json::stringValue:
+            if (node.asString() != value.asString())
+            {
+                ++mismatches;
+            }
+            break;
+        case Json::booleanValue:
+            if (node.asBool() != value.asBool() || node.asInt() != value.asInt())
+            {
+                ++mismatches;
+            }
+            break;
+        case Json::intValue:
+        case Json::uintValue:
+            if (node.asDouble() != value.asDouble() || node.asString() != value.asString()
+                || (value.isInt64() && node.asInt64() != value.asInt64())
+                || (value.isUInt64() && node.asUInt64() != value.asUInt64())
+                || (value.isInt() && node.asInt() != value.asInt()))
+            {
+                ++mismatches;
+            }
+            break;
+        case Json::realValue:
+            if (node.asDouble() != value.asDouble())
+            {
+                ++mismatches;
+            }
+            break;
+        default:
+            if (node.asString() != value.asString() || 0 != node.size())
+            {
+                ++mismatches;
+            }
+            break;
+        }
+        return mismatches;
+    }
+
+    int checkDocument(const std::string& text)
+    {
+        Json::Reader reader;
+        Json::Value expected;
+        bool readerOk = reader.parse(text, expected);
+        Json::LazyDocument document;
+        bool lazyOk = document.parse(text.data(), text.data() + text.size());
+        if (false == readerOk || false == lazyOk)
+        {
+            ::fprintf(stderr, "%s: Reader %d, LazyDocument %d %s\n", text.c_str(), readerOk, lazyOk, document.getFormattedErrorMessages().c_str());
+            return 1;
+        }
+        return compare(document.root(), expected);
+    }
+
+    void testMatchesReader()
+    {
+        int mismatches = 0;
+        for (size_t i = 0; i < sizeof(kDocuments) / sizeof(kDocuments[0]); ++i)
+        {
+            mismatches += checkDocument(kDocuments[i]);
+        }
+        TEST_CHECK(0 == mismatches);
+
+        // ظĳԱȡߣ Reader ͬ
+        Json::LazyDocument document;
+        const char dup[] = "{\"dup\":1,\"dup\":2}";
+        TEST_CHECK(document.parse(dup, dup + sizeof(dup) - 1));
+        TEST_CHECK(2 == document.root()["dup"].asInt());
+    }
+
+    Json::Value randomValue(std::mt19937& random, int depth)
+    {
+        switch (random() % (depth < 5 ? 8 : 6))
+        {
+        case 0: return Json::Value();
+        case 1: return Json::Value(0 == random() % 2);
+        case 2: return Json::Value(static_cast<Json::Int64>(random()) - static_cast<Json::Int64>(random() % 3) * 0x80000000);
+        case 3: return Json::Value(static_cast<double>(static_cast<int>(random())) / 1024.0);
+        case 4:
+        case 5:
+        {
+            static const char* kPieces[] = { "a", "\"", "\\", "\n", "\xe4\xb8\xad", "\x01", "/", " " };
+            std::string text;
+            for (size_t n = random() % 10; n > 0; --n)
+            {
+                text += kPieces[random() % 8];
+            }
+            return Json::Value(text);
+        }
+        case 6:
+        {
+            Json::Value array(Json::arrayValue);
+            for (size_t n = random() % 8; n > 0; --n)
+            {
+                array.append(randomValue(random, depth + 1));
+            }
+            return array;
+        }
+        default:
+        {
+            Json::Value object(Json::objectValue);
+            for (size_t n = random() % 8; n > 0; --n)
+            {
+                object["m" + std::to_string(random() % 30) + (random() % 5 ? "" : "\"\\")] = randomValue(random, depth + 1);
+            }
+            return object;
+        }
+        }
+    }
+
+    void testRandomDocuments()
+    {
+        std::mt19937 random(9);
+        Json::StyledWriter styled;
+        Json::FastWriter fast;
+        int mismatches = 0;
+        for (int i = 0; i < 500; ++i)
+        {
+            Json::Value value = randomValue(random, 0);
+            mismatches += checkDocument((i % 2) ? styled.write(value) : fast.write(value));
+        }
+        TEST_CHECK(0 == mismatches);
+    }
+
+    void testMissing()
+    {
+        const char text[] = "{\"a\":[1,{\"b\":2}],\"s\":\"str\"}";
+        Json::LazyDocument document;
+        TEST_CHECK(false == document.root().exists());     // û parse()
+        TEST_CHECK(document.parse(text, text + sizeof(text) - 1));
+        Json::LazyDocument::Node root = document.root();
+        TEST_CHECK(false == root["missing"].exists());
+        TEST_CHECK(false == root["missing"]["deeper"][3].exists());
+        TEST_CHECK(false == root["a"][2].exists());
+        TEST_CHECK(false == root["a"]["b"].exists());       // 鲻
+        TEST_CHECK(false == root[Json::ArrayIndex(0)].exists());   // 󲻰±
+        TEST_CHECK(false == root["s"]["x"].exists());
+        TEST_CHECK(2 == root["a"][1]["b"].asInt());
+        TEST_CHECK(Json::nullValue == root["missing"].type());
+        TEST_CHECK(root["missing"].decode().isNull());
+        TEST_CHECK(0 == root["missing"].asInt() && root["missing"].asString().empty());
+
+        // ʧܺ root() 
+        const char broken[] = "{\"a\":";
+        TEST_CHECK(false == document.parse(broken, broken + sizeof(broken) - 1));
+        TEST_CHECK(false == document.root().exists());
+    }
+
+    void testErrors()
+    {
+        // Ƕ׹ false λã쳣
+        std::string deep = "{\"a\":" + std::string(5000, '[') + std::string(5000, ']') + "}";
+        Json::LazyDocument document;
+        bool ok = true;
+        try
+        {
+            ok = document.parse(deep.data(), deep.data() + deep.size());
+        }
+        catch (const std::exception&)
+        {
+            TEST_CHECK(false && "LazyDocument::parse must not throw");
+        }
+        TEST_CHECK(false == ok);
+        TEST_CHECK(std::string::npos != document.getFormattedErrorMessages().find("stackLimit"));
+        TEST_CHECK(document.getErrorOffset() > 5 && document.getErrorOffset() < 2000);
+
+        std::string shallow = std::string(900, '[') + std::string(900, ']');
+        TEST_CHECK(document.parse(shallow.data(), shallow.data() + shallow.size()));
+        TEST_CHECK(document.getFormattedErrorMessages().empty() && -1 == document.getErrorOffset());
+
+        static const char* kMalformed[] = {
+            "", " ", "{", "}", "[1,]", "{\"a\":1,}", "{\"a\" 1}", "[1 2]", "{1:2}", "tru", "nul", "\"unterminated",
+            "[\"bad \\x\"]", "[\"\\u12\"]", "[-]", "[1e]", "// comment\n1", "[1/* c */]",
+        };
+        for (size_t i = 0; i < sizeof(kMalformed) / sizeof(kMalformed[0]); ++i)
+        {
+            std::string text = kMalformed[i];
+            bool parsed = document.parse(text.data(), text.data() + text.size());
+            TEST_CHECK(false == parsed);
+            TEST_CHECK(false == document.getFormattedErrorMessages().empty());
+            if (parsed)
+            {
+                ::fprintf(stderr, "accepted: %s\n", text.c_str());
+            }
+        }
+    }
+}
+
+int main()
+{
+    testMatchesReader();
+    testRandomDocuments();
+    testMissing();
+    testErrors();
+    return testResult("lazy_document_test");
+}
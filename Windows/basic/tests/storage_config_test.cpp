@@ -0,0 +1,159 @@
+#include "TestUtil.h"
+#include "StorageConfigMgr.h"
+#include <Windows.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+/**************************************************************************/
+
+/*
+* CConfigMgr ӳдأֵû SetValue дļһ޸һ޸ 500ms ϲһд
+* Flush() дδ޸ģļʱļ滻ĳһ
+*
+* дļĴȡ win32/Windows.h  MoveFileExW ļ
+*/
+
+namespace
+{
+    const char* const kIniPath = "TRTStorageConfig.ini";
+
+    void sleepMs(int ms)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+
+    int writes()
+    {
+        return win32MoveFileCount();
+    }
+
+    std::string readFile(const char* path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    bool fileExists(const char* path)
+    {
+        std::ifstream file(path);
+        return file.good();
+    }
+
+    bool fileHasValue(const std::string& value)
+    {
+        return std::string::npos != readFile(kIniPath).find("\r\nkey=" + value + "\r\n");
+    }
+
+    void testUnchanged()
+    {
+        CConfigMgr config;
+        int before = writes();
+        TEST_CHECK(config.SetValue(L"TRTCDemo", L"key", L"first"));
+        sleepMs(800);
+        TEST_CHECK(before + 1 == writes());
+        TEST_CHECK(fileHasValue("first"));
+
+        // ڴеֵͬ޸ģȲӳдأFlush() Ҳд
+        TEST_CHECK(config.SetValue(L"TRTCDemo", L"key", L"first"));
+        sleepMs(800);
+        TEST_CHECK(before + 1 == writes());
+        TEST_CHECK(1 == config.Flush());
+        TEST_CHECK(before + 1 == writes());
+    }
+
+    void testBurst()
+    {
+        CConfigMgr config;
+        int before = writes();
+        TestStopwatch watch;
+        for (int i = 0; i < 20; ++i)
+        {
+            config.SetValue(L"TRTCDemo", L"key", L"burst" + std::to_wstring(i));
+            sleepMs(10);
+        }
+        double burstMs = watch.elapsedMs();
+        // ÿ޸ĶдƳٵ 500ms ֮޸ڼһζд
+        TEST_CHECK(before == writes());
+        sleepMs(300);
+        TEST_CHECK(before == writes());
+        sleepMs(500);
+        TEST_CHECK(before + 1 == writes());
+        TEST_CHECK(fileHasValue("burst19"));
+        ::printf("  20 changes over %.0f ms: %d write(s)\n", burstMs, writes() - before);
+    }
+
+    void testFlushAndDestructor()
+    {
+        int before = writes();
+        {
+            CConfigMgr config;
+            config.SetValue(L"TRTCDemo", L"key", L"flushed");
+            TEST_CHECK(1 == config.Flush());
+            TEST_CHECK(before + 1 == writes());
+            TEST_CHECK(fileHasValue("flushed"));
+            sleepMs(700);
+            TEST_CHECK(before + 1 == writes());   // Ѿдд̲߳ظд
+
+            // ʱû 500ms ޸ͬд
+            config.SetValue(L"TRTCDemo", L"key", L"destructed");
+            config.SetValue(L"TRTCDemo", L"other", L"value");
+        }
+        TEST_CHECK(before + 2 == writes());
+        TEST_CHECK(fileHasValue("destructed"));
+
+        CConfigMgr reloaded;
+        TEST_CHECK(L"destructed" == reloaded.GetValue(L"TRTCDemo", L"key"));
+        TEST_CHECK(L"value" == reloaded.GetValue(L"TRTCDemo", L"other"));
+    }
+
+    void testAtomicReplace()
+    {
+        // ֵ̽ԭؽضдʱ߻ļ
+        std::atomic<bool> stop(false);
+        std::atomic<int> reads(0);
+        std::atomic<int> partial(0);
+        std::thread reader([&] {
+            while (false == stop)
+            {
+                std::string content = readFile(kIniPath);
+                ++reads;
+                bool complete = (0 == content.compare(0, 11, "[TRTCDemo]\r")) && content.size() >= 2
+                    && 0 == content.compare(content.size() - 2, 2, "\r\n")
+                    && std::string::npos != content.find("\r\nkey=") && std::string::npos != content.find("\r\nother=value\r\n");
+                partial += (complete ? 0 : 1);
+            }
+        });
+
+        {
+            CConfigMgr config;
+            int before = writes();
+            for (int i = 0; i < 200; ++i)
+            {
+                config.SetValue(L"TRTCDemo", L"key", std::wstring(0 == i % 2 ? 4000 : 1, L'x') + std::to_wstring(i));
+                config.Flush();
+            }
+            TEST_CHECK(before + 200 == writes());
+        }
+        stop = true;
+        reader.join();
+
+        TEST_CHECK(0 == partial);
+        TEST_CHECK(false == fileExists("TRTStorageConfig.ini.tmp"));
+        TEST_CHECK(fileHasValue("x199"));
+        ::printf("  200 writes, %d concurrent reads, %d partial\n", static_cast<int>(reads), static_cast<int>(partial));
+    }
+}
+
+int main()
+{
+    std::remove(kIniPath);
+
+    testUnchanged();
+    testBurst();
+    testFlushAndDestructor();
+    testAtomicReplace();
+    return testResult("storage_config_test");
+}
@@ -0,0 +1,126 @@
+#include "TestUtil.h"
+#include "StorageConfigMgr.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+/**************************************************************************/
+
+/*
+*  INI Ľʱ200 ڡÿ 200 Լ 1MBעֵֵ͡
+* ֱ⹹ CConfigMgr״ζ룩ļⲿ޸ĺ Reload ĺʱ
+*/
+
+namespace
+{
+    const int kSections = 200;
+    const int kKeys = 200;
+    const int kRounds = 20;
+
+    // Ƶ_<n>UTF-8
+    const char* const kChineseValue = "\xE8\xA7\x86\xE9\xA2\x91\xE5\x8F\x82\xE6\x95\xB0_";
+
+    size_t writeIni(int generation)
+    {
+        FILE* file = ::fopen("TRTStorageConfig.ini", "wb");
+        if (NULL == file)
+        {
+            return 0;
+        }
+        ::fprintf(file, "[TRTCDemo]\r\nINI_KEY_VIDEO_BITRATE=%d\r\nINI_KEY_VIDEO_RESOLUTION=108\r\nINI_KEY_VIDEO_FPS=15\r\n", 550 + generation);
+        for (int s = 0; s < kSections; ++s)
+        {
+            ::fprintf(file, "; section %d\r\n[Section_%05d]\r\n", s, s);
+            for (int k = 0; k < kKeys; ++k)
+            {
+                switch (k % 10)
+                {
+                case 3:
+                    ::fprintf(file, "INI_KEY_%05d=%s%d\r\n", k, kChineseValue, k * 7);
+                    break;
+                case 5:
+                    ::fprintf(file, "INI_KEY_%05d = \"quoted ; value %d\"\r\n", k, k);
+                    break;
+                case 7:
+                    ::fprintf(file, "INI_KEY_%05d=%d ; trailing comment\r\n", k, k * 7 + s);
+                    break;
+                default:
+                    ::fprintf(file, "INI_KEY_%05d=%d\r\n", k, k * 7 + s);
+                    break;
+                }
+            }
+        }
+        long size = ::ftell(file);
+        ::fclose(file);
+        return static_cast<size_t>(size);
+    }
+
+    void checkContent(CConfigMgr& config, int generation)
+    {
+        TEST_CHECK(kSections + 1 == config.GetSize());
+        TEST_CHECK(std::to_wstring(550 + generation) == config.GetValue(INI_ROOT_KEY, INI_KEY_VIDEO_BITRATE));
+        TEST_CHECK(L"\u89C6\u9891\u53C2\u6570_21" == config.GetValue(L"Section_00007", L"INI_KEY_00003"));
+        TEST_CHECK(L"quoted ; value 15" == config.GetValue(L"Section_00199", L"INI_KEY_00015"));
+        TEST_CHECK(std::to_wstring(17 * 7 + 42) == config.GetValue(L"Section_00042", L"INI_KEY_00017"));
+        TEST_CHECK(std::to_wstring(199 * 7 + 1) == config.GetValue(L"Section_00001", L"INI_KEY_00199"));
+        TEST_CHECK(config.GetValue(L"Section_00001", L"INI_KEY_00200").empty());
+    }
+
+    void report(const char* name, double best, double total, size_t bytes)
+    {
+        ::printf("  %-24s best %7.2f ms  avg %7.2f ms  %6.1f MB/s\n", name, best, total / kRounds, bytes / best / 1000.0);
+    }
+}
+
+int main()
+{
+    size_t bytes = writeIni(0);
+    TEST_CHECK(0 != bytes);
+    ::printf("storage_ini_bench: %d sections x %d keys, %zu bytes\n", kSections, kKeys, bytes);
+
+    double best = 1e18;
+    double total = 0;
+    for (int i = 0; i < kRounds; ++i)
+    {
+        TestStopwatch watch;
+        CConfigMgr config;
+        double ms = watch.elapsedMs();
+        best = (std::min)(best, ms);
+        total += ms;
+        if (0 == i)
+        {
+            checkContent(config, 0);
+        }
+    }
+    report("load (constructor)", best, total, bytes);
+
+    // ݽ仯ÿ Reload Ҫ
+    CConfigMgr config;
+    best = 1e18;
+    total = 0;
+    for (int i = 1; i <= kRounds; ++i)
+    {
+        writeIni(i);
+        TestStopwatch watch;
+        int changed = config.Reload();
+        double ms = watch.elapsedMs();
+        TEST_CHECK(1 == changed);
+        best = (std::min)(best, ms);
+        total += ms;
+    }
+    checkContent(config, kRounds);
+    report("reload (changed)", best, total, bytes);
+
+    // ûʱֻļȽϣ
+    best = 1e18;
+    total = 0;
+    for (int i = 0; i < kRounds; ++i)
+    {
+        TestStopwatch watch;
+        TEST_CHECK(0 == config.Reload());
+        double ms = watch.elapsedMs();
+        best = (std::min)(best, ms);
+        total += ms;
+    }
+    report("reload (unchanged)", best, total, bytes);
+    return testResult("storage_ini_bench");
+}
@@ -0,0 +1,178 @@
+#include "TestUtil.h"
+#include "StorageConfigMgr.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <new>
+#include <string>
+/**************************************************************************/
+
+/*
+* ͻñ֤ȱʧϷֵȡĬֵдû޸ʱдļ޸
+* ٱȽ·ϰַ GetValue תCSettingRegistry ±ȡGetSnapshot ַʽ
+* ÿζȡĺʱڴ
+*/
+
+namespace
+{
+    std::atomic<size_t> g_allocations(0);
+
+    const char* const kIniPath = "TRTStorageConfig.ini";
+
+    void writeFile(const std::string& content)
+    {
+        FILE* file = ::fopen(kIniPath, "wb");
+        ::fwrite(content.data(), 1, content.size(), file);
+        ::fclose(file);
+    }
+
+    std::string readFile()
+    {
+        std::string content;
+        FILE* file = ::fopen(kIniPath, "rb");
+        if (NULL == file)
+        {
+            return content;
+        }
+        char buffer[4096];
+        size_t size = 0;
+        while ((size = ::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            content.append(buffer, size);
+        }
+        ::fclose(file);
+        return content;
+    }
+
+    void testDefaults()
+    {
+        writeFile("[TRTCDemo]\r\nINI_KEY_VIDEO_BITRATE=800\r\nINI_KEY_VIDEO_FPS=abc\r\nINI_KEY_VIDEO_QUALITY=7\r\n"
+            "INI_KEY_SET_PUSH_SMALLVIDEO=1\r\nINI_KEY_VIDEO_RESOLUTION=112\r\n");
+        {
+            TRTCStorageConfigMgr manager;
+            manager.ReadStorageConfig();
+            TRTCStorageConfigSnapshot snapshot = manager.GetSnapshot();
+            TEST_CHECK(800 == snapshot.videoEncParams.videoBitrate);
+            TEST_CHECK(15 == snapshot.videoEncParams.videoFps);
+            TEST_CHECK(TRTCVideoResolution_1280_720 == snapshot.videoEncParams.videoResolution);
+            TEST_CHECK(TRTCVideoQosPreferenceClear == snapshot.qosParams.preference);
+            TEST_CHECK(snapshot.bPushSmallVideo);
+            TEST_CHECK(false == snapshot.bPlaySmallVideo);
+        }
+        // ϷȱʧĬֵд
+        TEST_CHECK("[TRTCDemo]\r\nINI_KEY_SET_PLAY_SMALLVIDEO=0\r\nINI_KEY_SET_PUSH_SMALLVIDEO=1\r\nINI_KEY_VIDEO_BITRATE=800\r\n"
+            "INI_KEY_VIDEO_FPS=15\r\nINI_KEY_VIDEO_QUALITY=2\r\nINI_KEY_VIDEO_QUALITY_CONTROL=1\r\nINI_KEY_VIDEO_RESOLUTION=112\r\n" == readFile());
+
+        // û޸ʱдļļͬһݣдػḲǵ
+        std::string marked = readFile() + "; marker\r\n";
+        writeFile(marked);
+        {
+            TRTCStorageConfigMgr manager;
+            manager.ReadStorageConfig();
+            manager.Publish(manager.GetSnapshot());
+            manager.WriteStorageConfig();
+        }
+        TEST_CHECK(marked == readFile());
+
+        {
+            TRTCStorageConfigMgr manager;
+            manager.ReadStorageConfig();
+            TRTCStorageConfigSnapshot snapshot = manager.GetSnapshot();
+            snapshot.videoEncParams.videoFps = 20;
+            snapshot.bPlaySmallVideo = true;
+            manager.Publish(snapshot);
+        }
+        {
+            TRTCStorageConfigMgr manager;
+            manager.ReadStorageConfig();
+            TRTCStorageConfigSnapshot snapshot = manager.GetSnapshot();
+            TEST_CHECK(20 == snapshot.videoEncParams.videoFps);
+            TEST_CHECK(snapshot.bPlaySmallVideo);
+            TEST_CHECK(800 == snapshot.videoEncParams.videoBitrate);
+        }
+
+        // ûļʱǰĹ캯һ
+        std::remove(kIniPath);
+        {
+            TRTCStorageConfigMgr manager;
+            TEST_CHECK(500 == manager.GetSnapshot().videoEncParams.videoBitrate);
+            manager.ReadStorageConfig();
+            TRTCStorageConfigSnapshot snapshot = manager.GetSnapshot();
+            TEST_CHECK(500 == snapshot.videoEncParams.videoBitrate);
+            TEST_CHECK(15 == snapshot.videoEncParams.videoFps);
+            TEST_CHECK(TRTCVideoResolution_640_360 == snapshot.videoEncParams.videoResolution);
+        }
+    }
+
+    template <typename Read>
+    void measure(const char* name, int reads, Read read)
+    {
+        volatile long sink = 0;
+        size_t allocations = g_allocations;
+        TestStopwatch watch;
+        for (int i = 0; i < reads; ++i)
+        {
+            sink = sink + read();
+        }
+        double ns = watch.elapsedMs() * 1e6 / reads;
+        ::printf("  %-30s %8.2f ns/read  %5.2f allocations/read\n", name, ns, static_cast<double>(g_allocations - allocations) / reads);
+    }
+}
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* pointer = std::malloc(0 == size ? 1 : size);
+    if (NULL == pointer)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+int main()
+{
+    testDefaults();
+
+    TRTCStorageConfigMgr manager;
+    manager.ReadStorageConfig();
+    manager.WriteStorageConfig();   // дĬֵ֮Ķȡҵ
+    CConfigMgr config;
+    CSettingRegistry registry;
+    registry.Load(config);
+
+    const int kReads = 2000000;
+    ::printf("storage_registry_bench: %d reads of the video bitrate\n", kReads);
+    measure("GetValue + wcstol", kReads, [&config]() {
+        return ::wcstol(config.GetValue(INI_ROOT_KEY, INI_KEY_VIDEO_BITRATE).c_str(), NULL, 10);
+    });
+    measure("CSettingRegistry::GetInt", kReads, [&registry]() {
+        return static_cast<long>(registry.GetInt(Config::SettingVideoBitrate));
+    });
+    measure("GetSnapshot", kReads, [&manager]() {
+        return static_cast<long>(manager.GetSnapshot().videoEncParams.videoBitrate);
+    });
+
+    size_t allocations = g_allocations;
+    TestStopwatch watch;
+    const int kWrites = 10000;
+    for (int i = 0; i < kWrites; ++i)
+    {
+        manager.WriteStorageConfig();
+    }
+    ::printf("  %-30s %8.2f ns/call  %5.2f allocations/call\n", "unchanged WriteStorageConfig", watch.elapsedMs() * 1e6 / kWrites
+        , static_cast<double>(g_allocations - allocations) / kWrites);
+    TEST_CHECK(500 == registry.GetInt(Config::SettingVideoBitrate));     // testDefaults ɾļ
+    return testResult("storage_registry_bench");
+}
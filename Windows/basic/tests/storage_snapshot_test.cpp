@@ -0,0 +1,124 @@
+#include "TestUtil.h"
+#include "StorageConfigMgr.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+/**************************************************************************/
+
+/*
+* ÿյ˳̲߳ͣ Publish̲߳ͣ GetSnapshot
+* ÿնͬһ Publish˺ѣͬһдߵİ汾ܵˣ
+* 󷢲ֵд INI ¶
+*/
+
+namespace
+{
+    const int kWriters = 2;
+    const int kReaders = 6;
+    const int kDurationMs = 1000;
+    const unsigned int kFirstVersion = 1000;
+
+    // ֶζ version Ƴ߾ݴжϿǷͬһη
+    TRTCStorageConfigSnapshot makeSnapshot(unsigned int version)
+    {
+        TRTCStorageConfigSnapshot config;
+        config.videoEncParams.videoBitrate = version;
+        config.videoEncParams.videoFps = version;
+        config.videoEncParams.videoResolution = static_cast<TRTCVideoResolution>(version);
+        config.qosParams.preference = static_cast<TRTCVideoQosPreference>(1 + (version & 1));
+        config.qosParams.controlMode = static_cast<TRTCQosControlMode>(version & 1);
+        config.bPushSmallVideo = (0 != (version & 1));
+        config.bPlaySmallVideo = (0 != (version & 1));
+        return config;
+    }
+
+    bool consistent(const TRTCStorageConfigSnapshot& config)
+    {
+        unsigned int version = config.videoEncParams.videoBitrate;
+        return version == config.videoEncParams.videoFps
+            && version == static_cast<unsigned int>(config.videoEncParams.videoResolution)
+            && static_cast<int>(1 + (version & 1)) == config.qosParams.preference
+            && static_cast<int>(version & 1) == config.qosParams.controlMode
+            && (0 != (version & 1)) == config.bPushSmallVideo
+            && (0 != (version & 1)) == config.bPlaySmallVideo;
+    }
+}
+
+int main()
+{
+    std::remove("TRTStorageConfig.ini");
+    TRTCStorageConfigMgr* manager = new TRTCStorageConfigMgr;
+    manager->ReadStorageConfig();
+
+    std::atomic<bool> stop(false);
+    std::atomic<long long> publishes(0);
+    std::atomic<long long> reads(0);
+    std::atomic<long long> torn(0);
+    std::atomic<long long> backwards(0);
+    std::vector<std::thread> threads;
+    for (int w = 0; w < kWriters; ++w)
+    {
+        // д w  kFirstVersion + w+ kWriters+ 2 * kWriters ...汾ųдд
+        threads.push_back(std::thread([&, w]() {
+            for (unsigned int version = kFirstVersion + w; false == stop; version += kWriters)
+            {
+                manager->Publish(makeSnapshot(version));
+                ++publishes;
+            }
+        }));
+    }
+    for (int r = 0; r < kReaders; ++r)
+    {
+        threads.push_back(std::thread([&]() {
+            long long count = 0;
+            unsigned int last[kWriters] = { 0 };
+            while (false == stop)
+            {
+                TRTCStorageConfigSnapshot config = manager->GetSnapshot();
+                ++count;
+                unsigned int version = config.videoEncParams.videoBitrate;
+                if (version < kFirstVersion)
+                {
+                    continue;   // ûд߷Ĭֵ
+                }
+                if (false == consistent(config))
+                {
+                    ++torn;
+                }
+                unsigned int writer = (version - kFirstVersion) % kWriters;
+                if (version < last[writer])
+                {
+                    ++backwards;
+                }
+                last[writer] = version;
+            }
+            reads += count;
+        }));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDurationMs));
+    stop = true;
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+    ::printf("  %d ms: %lld publishes, %lld snapshots (%.1f M/s), %lld torn, %lld went backwards\n"
+        , kDurationMs, publishes.load(), reads.load(), reads / 1000.0 / kDurationMs, torn.load(), backwards.load());
+    TEST_CHECK(0 != publishes && 0 != reads);
+    TEST_CHECK(0 == torn);
+    TEST_CHECK(0 == backwards);
+
+    // ʱдأģʽ̶ƶ˿ƣ¶Ƿʱֵ
+    TRTCStorageConfigSnapshot last = manager->GetSnapshot();
+    delete manager;
+    TRTCStorageConfigMgr again;
+    again.ReadStorageConfig();
+    TRTCStorageConfigSnapshot reloaded = again.GetSnapshot();
+    TEST_CHECK(last.videoEncParams.videoBitrate == reloaded.videoEncParams.videoBitrate);
+    TEST_CHECK(last.videoEncParams.videoFps == reloaded.videoEncParams.videoFps);
+    TEST_CHECK(last.bPlaySmallVideo == reloaded.bPlaySmallVideo);
+    TEST_CHECK(TRTCQosControlModeServer == reloaded.qosParams.controlMode);
+    return testResult("storage_snapshot_test");
+}
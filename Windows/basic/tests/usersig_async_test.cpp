@@ -0,0 +1,169 @@
+#include "TestUtil.h"
+#include "TestHttpServer.h"
+#include "TRTCGetUserIDAndUserSig.h"
+#include "json.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+/**************************************************************************/
+
+/*
+* getUserSigFromServerAsync̣߳ص HttpClient  I/O ִ߳вطص userSig
+* лʱڵֱ߳ӻصʧܡʱص userSig Ϊ
+*/
+
+namespace
+{
+    std::mutex g_mutex;
+    std::set<std::thread::id> g_serverThreads;
+    bool g_fail = false;
+
+    void handle(const TestHttpRequest& request, TestHttpResponse& response)
+    {
+        Json::Reader reader;
+        Json::Value root;
+        reader.parse(request.body, root);
+        response.delayMs = 100;
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_serverThreads.insert(std::this_thread::get_id());
+        response.body = g_fail ? "{\"errorCode\":7,\"errorMessage\":\"bad pwd\"}"
+            : "{\"errorCode\":0,\"data\":{\"userSig\":\"sig-" + root["identifier"].asString() + "\"}}";
+    }
+
+    struct Completion
+    {
+        Completion() : done(false) {}
+
+        std::string userSig;
+        std::thread::id thread;
+        bool done;
+    };
+
+    class Waiter
+    {
+    public:
+        std::function<void(const std::string&)> callback(Completion& completion)
+        {
+            return [this, &completion](const std::string& userSig)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                completion.userSig = userSig;
+                completion.thread = std::this_thread::get_id();
+                completion.done = true;
+                m_changed.notify_all();
+            };
+        }
+
+        bool waitAll(const std::vector<Completion>& completions)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, std::chrono::seconds(10), [&]
+            {
+                for (size_t i = 0; i < completions.size(); ++i)
+                {
+                    if (false == completions[i].done)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            });
+        }
+
+        bool isDone(const Completion& completion)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return completion.done;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+    };
+
+    bool isServerThread(std::thread::id id)
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        return g_serverThreads.count(id) != 0;
+    }
+
+    void testCallbackOnIoThread(TRTCGetUserIDAndUserSig& api)
+    {
+        const size_t kUsers = 16;
+        std::vector<Completion> completions(kUsers);
+        Waiter waiter;
+        TestStopwatch watch;
+        for (size_t i = 0; i < kUsers; ++i)
+        {
+            api.getUserSigFromServerAsync("async_" + std::to_string(i), "pw", 11, 1400, waiter.callback(completions[i]));
+        }
+        // ÿӳ 100msܵ
+        TEST_CHECK(watch.elapsedMs() < 80);
+        TEST_CHECK(false == waiter.isDone(completions[0]));
+
+        TEST_CHECK(waiter.waitAll(completions));
+        std::set<std::thread::id> callbackThreads;
+        for (size_t i = 0; i < kUsers; ++i)
+        {
+            TEST_CHECK("sig-async_" + std::to_string(i) == completions[i].userSig);
+            TEST_CHECK(std::this_thread::get_id() != completions[i].thread);
+            TEST_CHECK(false == isServerThread(completions[i].thread));
+            callbackThreads.insert(completions[i].thread);
+        }
+        // лصͬһ I/O ߳
+        TEST_CHECK(1 == callbackThreads.size());
+
+        // д뻺棺ͬӿںٴ첽öֱУڵ߳ϻص
+        TEST_CHECK("sig-async_3" == api.getUserSigFromServer("async_3", "pw", 11, 1400));
+        std::vector<Completion> one(1);
+        api.getUserSigFromServerAsync("async_5", "pw", 11, 1400, waiter.callback(one[0]));
+        TEST_CHECK(waiter.isDone(one[0]));
+        TEST_CHECK("sig-async_5" == one[0].userSig);
+        TEST_CHECK(std::this_thread::get_id() == one[0].thread);
+    }
+
+    void testErrors(TRTCGetUserIDAndUserSig& api, TestHttpServer& server)
+    {
+        Waiter waiter;
+        std::vector<Completion> completions(2);
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            g_fail = true;
+        }
+        api.getUserSigFromServerAsync("rejected", "wrong", 11, 1400, waiter.callback(completions[0]));
+
+        // ӱܾһѾֹͣĵַ
+        TestHttpServer closed(handle);
+        TEST_CHECK(closed.start());
+        std::wstring closedUrl = closed.url("/login");
+        closed.stop();
+        api.setServerUrl(closedUrl);
+        api.getUserSigFromServerAsync("unreachable", "pw", 11, 1400, waiter.callback(completions[1]));
+
+        TEST_CHECK(waiter.waitAll(completions));
+        for (size_t i = 0; i < completions.size(); ++i)
+        {
+            TEST_CHECK(completions[i].userSig.empty());
+            TEST_CHECK(std::this_thread::get_id() != completions[i].thread);
+        }
+        api.setServerUrl(server.url("/login"));
+    }
+}
+
+int main()
+{
+    std::remove("UserSigCache.json");   // ϴ̵Ŀֱ
+    TestHttpServer server(handle);
+    TEST_CHECK(server.start());
+    TRTCGetUserIDAndUserSig& api = TRTCGetUserIDAndUserSig::instance();
+    api.setServerUrl(server.url("/login"));
+
+    testCallbackOnIoThread(api);
+    testErrors(api, server);
+    return testResult("usersig_async_test");
+}
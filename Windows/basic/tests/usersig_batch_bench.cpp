@@ -0,0 +1,120 @@
+#include "TestUtil.h"
+#include "TestHttpServer.h"
+#include "TRTCGetUserIDAndUserSig.h"
+#include "json.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+/**************************************************************************/
+
+/*
+* ȡ UserSig1000 ûģĵ¼ CGIÿ 5ms ˺ʱ
+* ͬ getUserSigsFromServer ڲͬµܺʱӳٷֲͽ
+*/
+
+namespace
+{
+    const size_t kUsers = 1000;
+    const unsigned int kServerDelayMs = 5;
+
+    void handle(const TestHttpRequest& request, TestHttpResponse& response)
+    {
+        Json::Reader reader;
+        Json::Value root;
+        if (false == reader.parse(request.body, root) || false == root.isMember("identifier"))
+        {
+            response.status = 500;
+            return;
+        }
+        response.delayMs = kServerDelayMs;
+        response.body = "{\"errorCode\":0,\"data\":{\"userSig\":\"sig-" + root["identifier"].asString() + "\"}}";
+    }
+
+    int checkResults(const std::vector<UserLogin>& users, const std::vector<UserSigResult>& results)
+    {
+        int bad = (results.size() != users.size()) ? 1 : 0;
+        for (size_t i = 0; i < results.size() && i < users.size(); ++i)
+        {
+            if (ERROR_SUCCESS != results[i].error || users[i].userId != results[i].userId || "sig-" + users[i].userId != results[i].userSig)
+            {
+                ++bad;
+            }
+        }
+        return bad;
+    }
+
+    void printLatency(const std::vector<UserSigResult>& results)
+    {
+        std::vector<double> latency;
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            latency.push_back(results[i].latencyMs);
+        }
+        std::sort(latency.begin(), latency.end());
+        ::printf("  p50 %.1f  p99 %.1f  max %.1f ms", latency[latency.size() / 2], latency[latency.size() * 99 / 100], latency.back());
+    }
+}
+
+int main()
+{
+    std::remove("UserSigCache.json");   // ϴ̵Ŀֱ
+
+    TestHttpServer server(handle);
+    TEST_CHECK(server.start());
+
+    std::vector<UserLogin> users(kUsers);
+    for (size_t i = 0; i < users.size(); ++i)
+    {
+        users[i].userId = "user" + std::to_string(i);
+        users[i].pwd = "pwd";
+    }
+
+    TRTCGetUserIDAndUserSig& api = TRTCGetUserIDAndUserSig::instance();
+    api.setServerUrl(server.url("/login"));
+    ::printf("usersig_batch_bench: %zu users, %u ms per request on the server\n", kUsers, kServerDelayMs);
+
+    // ÿһֻһ roomIdǰһֵĻ
+    int roomId = 1;
+    TestStopwatch watch;
+    int bad = 0;
+    for (size_t i = 0; i < users.size(); ++i)
+    {
+        bad += ("sig-" + users[i].userId != api.getUserSigFromServer(users[i].userId, users[i].pwd, roomId, 1400000000));
+    }
+    TEST_CHECK(0 == bad);
+    ::printf("  serial          %6.0f ms  (%zu new connections)\n", watch.elapsedMs(), server.connections());
+
+    const size_t parallel[] = { 1, 6, 32 };
+    for (size_t p = 0; p < sizeof(parallel) / sizeof(parallel[0]); ++p)
+    {
+        server.resetCounters();
+        watch.restart();
+        std::vector<UserSigResult> results = api.getUserSigsFromServer(users, ++roomId, 1400000000, parallel[p]);
+        double elapsed = watch.elapsedMs();
+        TEST_CHECK(0 == checkResults(users, results));
+        TEST_CHECK(kUsers == server.requests());
+        ::printf("  batch x%-2zu       %6.0f ms  (%zu new connections)", parallel[p], elapsed, server.connections());
+        printLatency(results);
+        ::printf("\n");
+    }
+
+    // ͬһûһΣȫл棬
+    server.resetCounters();
+    watch.restart();
+    std::vector<UserSigResult> cached = api.getUserSigsFromServer(users, roomId, 1400000000, 32);
+    TEST_CHECK(0 == checkResults(users, cached));
+    TEST_CHECK(0 == server.requests());
+    ::printf("  cached          %6.1f ms\n", watch.elapsedMs());
+
+    // ɴÿһŴ󷵻أǹס
+    api.setServerUrl(L"http://127.0.0.1:1/login");
+    std::vector<UserLogin> some(users.begin(), users.begin() + 50);
+    std::vector<UserSigResult> refused = api.getUserSigsFromServer(some, ++roomId, 1400000000, 8);
+    TEST_CHECK(some.size() == refused.size());
+    for (size_t i = 0; i < refused.size(); ++i)
+    {
+        TEST_CHECK(ERROR_SUCCESS != refused[i].error && refused[i].userSig.empty());
+    }
+    TEST_CHECK(api.getUserSigsFromServer(std::vector<UserLogin>(), roomId, 1400000000, 4).empty());
+    return testResult("usersig_batch_bench");
+}
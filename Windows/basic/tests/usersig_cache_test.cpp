@@ -0,0 +1,242 @@
+#include "TestUtil.h"
+#include "TestHttpServer.h"
+#include "TRTCGetUserIDAndUserSig.h"
+#include "UserSigCache.h"
+#include "json.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <thread>
+/**************************************************************************/
+
+/*
+* UserSig 棺δС roomId ֡ǰĺ̨ˢ¡ˢʧʱʹþֵ
+* ʧЧ»ȡӿ߻桢벻УԼ̺¼أļû룬߿ɶ
+*
+* ģĵ¼ CGI ÿηزͬ userSigţݴжǷ
+*/
+
+namespace
+{
+    std::atomic<int> g_requests(0);
+    std::atomic<bool> g_fail(false);
+
+    void handle(const TestHttpRequest& request, TestHttpResponse& response)
+    {
+        Json::Reader reader;
+        Json::Value root;
+        reader.parse(request.body, root);
+        int serial = ++g_requests;
+        response.delayMs = 5;
+        if (g_fail)
+        {
+            response.body = "{\"errorCode\":1}";
+            return;
+        }
+        response.body = "{\"errorCode\":0,\"data\":{\"userSig\":\"sig-" + root["identifier"].asString() + "-" + std::to_string(serial) + "\"}}";
+    }
+
+    void sleepMs(int ms)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+
+    bool fileExists(const char* path)
+    {
+        std::ifstream file(path);
+        return file.good();
+    }
+
+    std::string readFile(const char* path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    void testLookup(TRTCGetUserIDAndUserSig& api)
+    {
+        TestStopwatch watch;
+        std::string first = api.getUserSigFromServer("alice", "pw", 1, 1400);
+        double miss = watch.elapsedMs();
+        TEST_CHECK("sig-alice-1" == first);
+        TEST_CHECK(1 == g_requests);
+
+        watch.restart();
+        TEST_CHECK(first == api.getUserSigFromServer("alice", "pw", 1, 1400));
+        double hit = watch.elapsedMs();
+        TEST_CHECK(1 == g_requests);
+        TEST_CHECK("sig-alice-2" == api.getUserSigFromServer("alice", "pw", 2, 1400));     // һһ
+        ::printf("  miss %.2f ms, hit %.3f ms\n", miss, hit);
+
+        // ʱ첽ӿֱڵ߳ϻص
+        std::string got;
+        api.getUserSigFromServerAsync("alice", "pw", 1, 1400, [&got](const std::string& userSig) { got = userSig; });
+        TEST_CHECK(first == got);
+        TEST_CHECK(2 == g_requests);
+    }
+
+    void testRefresh(TRTCGetUserIDAndUserSig& api)
+    {
+        // TTL 3 롢ǰ 2 ˢ£ 1 ˢ
+        std::string before = api.getUserSigFromServer("alice", "pw", 1, 1400);
+        sleepMs(1500);
+        TEST_CHECK(4 == g_requests);
+        std::string after = api.getUserSigFromServer("alice", "pw", 1, 1400);
+        TEST_CHECK(after != before && 0 == after.compare(0, 10, "sig-alice-"));
+        TEST_CHECK(4 == g_requests);
+        UserSigCache::Stats stats = api.getUserSigCacheStats();
+        TEST_CHECK(2 == stats.refreshed);
+
+        //  2 ˢºûٱȡˢ£ں
+        sleepMs(3200);
+        stats = api.getUserSigCacheStats();
+        TEST_CHECK(3 == stats.refreshed);
+        int requests = g_requests;
+        api.getUserSigFromServer("alice", "pw", 2, 1400);
+        TEST_CHECK(requests + 1 == g_requests);
+
+        // ˢʧʱڵǰؾֵ
+        std::string cached = api.getUserSigFromServer("bob", "pw", 1, 1400);
+        g_fail = true;
+        sleepMs(1600);
+        TEST_CHECK(cached == api.getUserSigFromServer("bob", "pw", 1, 1400));
+        stats = api.getUserSigCacheStats();
+        TEST_CHECK(stats.refreshFailed >= 1);
+        g_fail = false;
+
+        // ʾ userSig Ч»ȡ
+        api.invalidateUserSig("bob", 1, 1400);
+        requests = g_requests;
+        TEST_CHECK(cached != api.getUserSigFromServer("bob", "pw", 1, 1400));
+        TEST_CHECK(requests + 1 == g_requests);
+    }
+
+    void testBatch(TRTCGetUserIDAndUserSig& api)
+    {
+        api.setUserSigCacheTtl(3600, 600);
+        std::vector<UserLogin> users(1000);
+        for (size_t i = 0; i < users.size(); ++i)
+        {
+            users[i].userId = "user" + std::to_string(i);
+            users[i].pwd = "pwd";
+        }
+
+        int requests = g_requests;
+        TestStopwatch watch;
+        std::vector<UserSigResult> cold = api.getUserSigsFromServer(users, 7, 1400, 6);
+        double coldMs = watch.elapsedMs();
+        int coldRequests = g_requests - requests;
+        TEST_CHECK(coldRequests >= 1000);     // ǰĿǡں̨ˢ
+
+        requests = g_requests;
+        watch.restart();
+        std::vector<UserSigResult> warm = api.getUserSigsFromServer(users, 7, 1400, 6);
+        double warmMs = watch.elapsedMs();
+        TEST_CHECK(requests == g_requests);
+        for (size_t i = 0; i < users.size(); ++i)
+        {
+            TEST_CHECK(ERROR_SUCCESS == cold[i].error && false == cold[i].userSig.empty());
+            TEST_CHECK(cold[i].userSig == warm[i].userSig);
+        }
+        ::printf("  batch of %zu: cold %.0f ms (%d requests), warm %.1f ms (0 requests)\n", users.size(), coldMs, coldRequests, warmMs);
+    }
+
+    void testPassword(TRTCGetUserIDAndUserSig& api)
+    {
+        int requests = g_requests;
+        std::string first = api.getUserSigFromServer("dave", "old", 1, 1400);
+        TEST_CHECK(first == api.getUserSigFromServer("dave", "old", 1, 1400));
+        TEST_CHECK(requests + 1 == g_requests);
+
+        // Ҫµ¼µ userSig Ǿɵ
+        std::string changed = api.getUserSigFromServer("dave", "new", 1, 1400);
+        TEST_CHECK(first != changed && requests + 2 == g_requests);
+        TEST_CHECK(changed == api.getUserSigFromServer("dave", "new", 1, 1400));
+        TEST_CHECK(requests + 2 == g_requests);
+        TEST_CHECK(first != api.getUserSigFromServer("dave", "old", 1, 1400));
+        TEST_CHECK(requests + 3 == g_requests);
+    }
+
+    void testPersistence()
+    {
+        std::remove("UserSigCacheTest.json");
+        UserSigKey key = { 1, "carol", 3 };
+        {
+            UserSigCache cache;
+            cache.setFilePath("UserSigCacheTest.json");
+            cache.setTtl(60, 10);
+            cache.store(key, "carol-secret-pwd", "sig-carol", UserSigCache::Fetcher());
+        }
+        TEST_CHECK(false == fileExists("UserSigCacheTest.json.tmp"));
+        TEST_CHECK(std::string::npos == readFile("UserSigCacheTest.json").find("carol-secret-pwd"));
+        struct stat info;
+        TEST_CHECK(0 == ::stat("UserSigCacheTest.json", &info) && 0600 == (info.st_mode & 0777));
+        {
+            UserSigCache cache;
+            cache.setFilePath("UserSigCacheTest.json");
+            std::string userSig;
+            TEST_CHECK(cache.lookup(key, "carol-secret-pwd", UserSigCache::Fetcher(), userSig) && "sig-carol" == userSig);
+            UserSigKey other = { 1, "carol", 4 };
+            TEST_CHECK(false == cache.lookup(other, "carol-secret-pwd", UserSigCache::Fetcher(), userSig));
+            TEST_CHECK(false == cache.lookup(key, "wrong", UserSigCache::Fetcher(), userSig));
+            UserSigCache::Stats stats = cache.stats();
+            TEST_CHECK(1 == stats.hits && 2 == stats.misses);
+        }
+
+        // ɰ汾дĿûժҪ
+        {
+            std::ofstream file("UserSigCacheTest.json", std::ios::binary | std::ios::trunc);
+            file << "{\"entries\":[{\"sdkAppId\":1,\"userId\":\"carol\",\"roomId\":3,\"userSig\":\"sig-old\",\"expires\":4000000000}]}";
+        }
+        {
+            UserSigCache cache;
+            cache.setFilePath("UserSigCacheTest.json");
+            std::string userSig;
+            TEST_CHECK(false == cache.lookup(key, "carol-secret-pwd", UserSigCache::Fetcher(), userSig));
+        }
+
+        // ضϵĻļʲôأҲӰ֮д
+        {
+            std::ofstream file("UserSigCacheTest.json", std::ios::binary | std::ios::trunc);
+            file << "{\"entries\":[{\"sdkAppId\":1,\"userId\":\"ca";
+        }
+        {
+            UserSigCache cache;
+            cache.setFilePath("UserSigCacheTest.json");
+            std::string userSig;
+            TEST_CHECK(false == cache.lookup(key, "pw", UserSigCache::Fetcher(), userSig));
+            cache.store(key, "pw", "sig-carol-2", UserSigCache::Fetcher());
+        }
+        {
+            UserSigCache cache;
+            cache.setFilePath("UserSigCacheTest.json");
+            std::string userSig;
+            TEST_CHECK(cache.lookup(key, "pw", UserSigCache::Fetcher(), userSig) && "sig-carol-2" == userSig);
+        }
+    }
+}
+
+int main()
+{
+    std::remove("UserSigCache.json");   // ϴ̵Ŀֱ
+
+    TestHttpServer server(handle);
+    TEST_CHECK(server.start());
+
+    TRTCGetUserIDAndUserSig& api = TRTCGetUserIDAndUserSig::instance();
+    api.setServerUrl(server.url("/login"));
+    api.setUserSigCacheTtl(3, 2);
+
+    testLookup(api);
+    testRefresh(api);
+    testBatch(api);
+    testPassword(api);
+    testPersistence();
+
+    UserSigCache::Stats stats = api.getUserSigCacheStats();
+    ::printf("  hits %llu, misses %llu, refreshed %llu, refresh failed %llu\n", stats.hits, stats.misses, stats.refreshed, stats.refreshFailed);
+    return testResult("usersig_cache_test");
+}
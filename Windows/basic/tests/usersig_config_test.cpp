@@ -0,0 +1,175 @@
+#include "TestUtil.h"
+#include "TRTCGetUserIDAndUserSig.h"
+#include "json.h"
+#include <fstream>
+#include <string>
+#include <vector>
+/**************************************************************************/
+
+/*
+* Config.json ĶȡSaxReader ʵԭȻ Json::Reader ʵֽһ£
+* Ƕ׹users ԪزǶȱֶκͲļ falseұѼصûб
+*/
+
+namespace
+{
+    const char kSample[] =
+        "{\r\n"
+        "  \"sdkappid\": 1400188366,\r\n"
+        "  \"users\": [\r\n"
+        "    { \"userId\": \"user_1001\", \"userToken\": \"eJyrVgrxCdYrSy1SslIy0jNQ0gHzM1PySvKTMvMA\" },\r\n"
+        "    { \"userToken\": \"eJwtjMEKgjAQRH9l2bN\\/Q\\u003d\\u003d\", \"userId\": \"user_\\u4e2d\\u6587\", \"nick\": \"x\" },\r\n"
+        "    { \"userId\": \"user_1003\", \"extra\": { \"userId\": \"ignored\", \"list\": [1, 2, [3]] }, \"userToken\": \"sig3\" }\r\n"
+        "  ],\r\n"
+        "  \"servers\": { \"users\": [\"not\", \"a\", \"roster\"] },\r\n"
+        "  \"comment\": \"\\\"quoted\\\" \\\\ backslash\"\r\n"
+        "}\r\n";
+
+    void writeConfig(const std::string& text)
+    {
+        std::ofstream file("Config.json", std::ios::binary | std::ios::trunc);
+        file << text;
+    }
+
+    // Ϊ SaxReader ֮ǰʵ֣Ϊ
+    bool loadWithReader(const std::string& text, uint32_t& sdkAppId, std::vector<UserInfo>& userInfos)
+    {
+        Json::Reader reader;
+        Json::Value root;
+        if (!reader.parse(text, root))
+        {
+            return false;
+        }
+        if (!root.isMember("sdkappid") || !root.isMember("users"))
+        {
+            return false;
+        }
+        sdkAppId = root["sdkappid"].asUInt();
+
+        const Json::Value& users = root["users"];
+        for (Json::ArrayIndex i = 0; i < users.size(); ++i)
+        {
+            const Json::Value& item = users[i];
+            if (!item.isObject() || !item.isMember("userId") || !item.isMember("userToken"))
+            {
+                return false;
+            }
+            UserInfo info;
+            info.userId = item["userId"].asString();
+            info.userSig = item["userToken"].asString();
+            userInfos.push_back(info);
+        }
+        return true;
+    }
+
+    bool sameUsers(const std::vector<UserInfo>& a, const std::vector<UserInfo>& b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (a[i].userId != b[i].userId || a[i].userSig != b[i].userSig)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void testMatchesReader(TRTCGetUserIDAndUserSig& api)
+    {
+        uint32_t sdkAppId = 0;
+        std::vector<UserInfo> expected;
+        TEST_CHECK(loadWithReader(kSample, sdkAppId, expected));
+        TEST_CHECK(3 == expected.size());
+
+        writeConfig(kSample);
+        TEST_CHECK(api.loadFromConfig());
+        TEST_CHECK(sdkAppId == api.getConfigSdkAppId());
+        TEST_CHECK(sameUsers(expected, api.getConfigUserIdArray()));
+        TEST_CHECK("user_\xe4\xb8\xad\xe6\x96\x87" == api.getConfigUserIdArray()[1].userId);
+        TEST_CHECK("eJwtjMEKgjAQRH9l2bN/Q==" == api.getConfigUserIdArray()[1].userSig);
+
+        // SaxReader  ValueBuilder õҲ Json::Reader ͬ
+        Json::Value fromReader;
+        Json::Value fromSax;
+        Json::Reader reader;
+        TEST_CHECK(reader.parse(kSample, fromReader));
+        Json::SaxReader saxReader;
+        Json::ValueBuilder builder(fromSax);
+        TEST_CHECK(saxReader.parse(kSample, kSample + sizeof(kSample) - 1, builder));
+        TEST_CHECK(fromReader == fromSax);
+    }
+
+    // text ʵֶܾѼصûб
+    void checkRejected(TRTCGetUserIDAndUserSig& api, const std::string& text)
+    {
+        uint32_t sdkAppId = 0;
+        std::vector<UserInfo> userInfos;
+        bool readerOk = true;
+        try
+        {
+            readerOk = loadWithReader(text, sdkAppId, userInfos);
+        }
+        catch (const Json::Exception&)
+        {
+            readerOk = false;   // Json::Reader Ƕ׹ʱ쳣
+        }
+        TEST_CHECK(false == readerOk);
+
+        std::vector<UserInfo> before = api.getConfigUserIdArray();
+        uint32_t sdkAppIdBefore = api.getConfigSdkAppId();
+        writeConfig(text);
+        bool loaded = true;
+        try
+        {
+            loaded = api.loadFromConfig();
+        }
+        catch (const std::exception&)
+        {
+            TEST_CHECK(false && "loadFromConfig must not throw");
+        }
+        TEST_CHECK(false == loaded);
+        TEST_CHECK(sdkAppIdBefore == api.getConfigSdkAppId());
+        TEST_CHECK(sameUsers(before, api.getConfigUserIdArray()));
+    }
+
+    void testRejected(TRTCGetUserIDAndUserSig& api)
+    {
+        std::string sample(kSample);
+
+        // ޹ֶǶ׹
+        std::string deep = "{\"sdkappid\":1,\"users\":[],\"extra\":" + std::string(5000, '[') + std::string(5000, ']') + "}";
+        checkRejected(api, deep);
+
+        // users ԪزǶ
+        checkRejected(api, "{\"sdkappid\":1,\"users\":[{\"userId\":\"a\",\"userToken\":\"b\"},\"user_1002\"]}");
+        checkRejected(api, "{\"sdkappid\":1,\"users\":[42]}");
+        checkRejected(api, "{\"sdkappid\":1,\"users\":[null]}");
+        checkRejected(api, "{\"sdkappid\":1,\"users\":[[{\"userId\":\"a\",\"userToken\":\"b\"}]]}");
+
+        // ȱֶ
+        checkRejected(api, "{\"sdkappid\":1,\"users\":[{\"userId\":\"a\"}]}");
+        checkRejected(api, "{\"users\":[]}");
+        checkRejected(api, "{\"sdkappid\":1}");
+
+        // дһļ﷨
+        for (size_t length = 1; length < sample.size() - 3; length += 7)
+        {
+            checkRejected(api, sample.substr(0, length));
+        }
+        checkRejected(api, "{\"sdkappid\":1,\"users\":[{\"userId\":\"a\",\"userToken\":\"b\"},]}");
+        checkRejected(api, "{\"sdkappid\":1 \"users\":[]}");
+        checkRejected(api, "");
+    }
+}
+
+int main()
+{
+    TRTCGetUserIDAndUserSig& api = TRTCGetUserIDAndUserSig::instance();
+    testMatchesReader(api);
+    testRejected(api);
+    return testResult("usersig_config_test");
+}
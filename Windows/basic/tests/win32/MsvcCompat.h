@@ -0,0 +1,18 @@
+#ifndef __MSVCCOMPAT_H__
+#define __MSVCCOMPAT_H__
+
+#include <errno.h>
+#include <stdio.h>
+/**************************************************************************/
+
+/*
+*  POSIX ϱ Windows Ŀ¼µҵʱǿư-includeõ MSVC ȫ
+*/
+
+inline int fopen_s(FILE** file, const char* name, const char* mode)
+{
+    *file = fopen(name, mode);
+    return (NULL != *file) ? 0 : errno;
+}
+
+#endif /* __MSVCCOMPAT_H__ */
@@ -0,0 +1,48 @@
+#ifndef __TEST_WIN32_TRTCCLOUDDEF_H__
+#define __TEST_WIN32_TRTCCLOUDDEF_H__
+
+#include <stdint.h>
+/**************************************************************************/
+
+/*
+* SDK ͷļ TRTCCloudDef.h ֻ StorageConfigMgr õͣȡֵ SDK һ
+*/
+
+enum TRTCVideoResolution
+{
+    TRTCVideoResolution_320_240 = 56,
+    TRTCVideoResolution_640_360 = 108,
+    TRTCVideoResolution_960_540 = 110,
+    TRTCVideoResolution_1280_720 = 112,
+};
+
+enum TRTCVideoQosPreference
+{
+    TRTCVideoQosPreferenceSmooth = 1,
+    TRTCVideoQosPreferenceClear = 2,
+};
+
+enum TRTCQosControlMode
+{
+    TRTCQosControlModeClient,
+    TRTCQosControlModeServer,
+};
+
+struct TRTCVideoEncParam
+{
+    TRTCVideoResolution videoResolution;
+    uint32_t videoFps;
+    uint32_t videoBitrate;
+
+    TRTCVideoEncParam() : videoResolution(TRTCVideoResolution_640_360), videoFps(15), videoBitrate(550) {}
+};
+
+struct TRTCNetworkQosParam
+{
+    TRTCVideoQosPreference preference;
+    TRTCQosControlMode controlMode;
+
+    TRTCNetworkQosParam() : preference(TRTCVideoQosPreferenceClear), controlMode(TRTCQosControlModeServer) {}
+};
+
+#endif /* __TEST_WIN32_TRTCCLOUDDEF_H__ */
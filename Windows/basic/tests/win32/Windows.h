@@ -0,0 +1,224 @@
+#ifndef __TEST_WIN32_WINDOWS_H__
+#define __TEST_WIN32_WINDOWS_H__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <wchar.h>
+#include <atomic>
+#include <fstream>
+#include <string>
+/**************************************************************************/
+
+/*
+*  POSIX ϱ StorageConfigMgr.cpp Base.hС Win32 Ӽ͡UTF-8 ת
+* ģ·ļд룻ֻʵЩԴļõĲϣ
+*
+* ·е '\\'  '/'GetModuleFileNameW صǰĿ¼µ TRTCDemo.exeļڵǰĿ¼
+*/
+
+typedef unsigned long DWORD;
+typedef int BOOL;
+typedef unsigned int UINT;
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef const char* LPCCH;
+typedef char* LPSTR;
+typedef const wchar_t* LPCWSTR;
+typedef wchar_t* LPWSTR;
+
+#define TRUE 1
+#define FALSE 0
+#define ERROR_SUCCESS 0L
+#define MAX_PATH 260
+#define CP_ACP 0
+#define CP_UTF8 65001
+#define INVALID_HANDLE_VALUE (reinterpret_cast<HANDLE>(static_cast<intptr_t>(-1)))
+#define GENERIC_WRITE 0x40000000
+#define CREATE_ALWAYS 2
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define MOVEFILE_REPLACE_EXISTING 0x1
+#define MOVEFILE_WRITE_THROUGH 0x8
+#define _countof(array) (sizeof(array) / sizeof((array)[0]))
+
+// ҳһɰ UTF-8 
+inline int MultiByteToWideChar(UINT, DWORD, LPCCH source, int size, LPWSTR out, int capacity)
+{
+    const unsigned char* itr = reinterpret_cast<const unsigned char*>(source);
+    const unsigned char* end = itr + (size < 0 ? strlen(source) + 1 : static_cast<size_t>(size));
+    int count = 0;
+    while (itr < end)
+    {
+        unsigned long code = *itr;
+        int length = 1;
+        if (code >= 0xF0) { code &= 0x07; length = 4; }
+        else if (code >= 0xE0) { code &= 0x0F; length = 3; }
+        else if (code >= 0xC0) { code &= 0x1F; length = 2; }
+        for (int i = 1; i < length && itr + i < end; ++i)
+        {
+            code = (code << 6) | (itr[i] & 0x3F);
+        }
+        itr += length;
+        if (NULL != out)
+        {
+            if (count >= capacity)
+            {
+                return 0;
+            }
+            out[count] = static_cast<wchar_t>(code);
+        }
+        ++count;
+    }
+    return count;
+}
+
+inline int WideCharToMultiByte(UINT, DWORD, LPCWSTR source, int size, LPSTR out, int capacity, LPCCH, BOOL*)
+{
+    std::string text;
+    size_t length = (size < 0) ? wcslen(source) + 1 : static_cast<size_t>(size);
+    for (size_t i = 0; i < length; ++i)
+    {
+        unsigned long code = static_cast<unsigned long>(source[i]);
+        if (code < 0x80)
+        {
+            text += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            text += static_cast<char>(0xC0 | (code >> 6));
+            text += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            text += static_cast<char>(0xE0 | (code >> 12));
+            text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            text += static_cast<char>(0xF0 | (code >> 18));
+            text += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+    if (NULL != out)
+    {
+        if (static_cast<int>(text.size()) > capacity)
+        {
+            return 0;
+        }
+        memcpy(out, text.data(), text.size());
+    }
+    return static_cast<int>(text.size());
+}
+
+inline int vswprintf_s(wchar_t* buffer, size_t size, const wchar_t* format, va_list args)
+{
+    return vswprintf(buffer, size, format, args);
+}
+
+inline int vsprintf_s(char* buffer, size_t size, const char* format, va_list args)
+{
+    return vsnprintf(buffer, size, format, args);
+}
+
+inline std::string win32PosixPath(LPCWSTR path)
+{
+    std::wstring wide(path);
+    for (size_t i = 0; i < wide.size(); ++i)
+    {
+        if (L'\\' == wide[i])
+        {
+            wide[i] = L'/';
+        }
+    }
+    std::string narrow(WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), static_cast<int>(wide.size()), NULL, 0, NULL, NULL), '\0');
+    if (false == narrow.empty())
+    {
+        WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), static_cast<int>(wide.size()), &narrow[0], static_cast<int>(narrow.size()), NULL, NULL);
+    }
+    return narrow;
+}
+
+inline DWORD GetModuleFileNameW(HMODULE, LPWSTR buffer, DWORD size)
+{
+    char directory[MAX_PATH] = { 0 };
+    if (NULL == getcwd(directory, sizeof(directory)))
+    {
+        return 0;
+    }
+    std::string path = std::string(directory) + "\\TRTCDemo.exe";
+    int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), static_cast<int>(path.size()), buffer, static_cast<int>(size) - 1);
+    buffer[length] = L'\0';
+    return static_cast<DWORD>(length);
+}
+
+inline HANDLE CreateFileW(LPCWSTR path, DWORD, DWORD, void*, DWORD, DWORD, HANDLE)
+{
+    int fd = open(win32PosixPath(path).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    return fd < 0 ? INVALID_HANDLE_VALUE : reinterpret_cast<HANDLE>(static_cast<intptr_t>(fd));
+}
+
+inline BOOL WriteFile(HANDLE file, const void* data, DWORD size, DWORD* written, void*)
+{
+    ssize_t ret = write(static_cast<int>(reinterpret_cast<intptr_t>(file)), data, size);
+    if (ret < 0)
+    {
+        return FALSE;
+    }
+    *written = static_cast<DWORD>(ret);
+    return TRUE;
+}
+
+inline BOOL FlushFileBuffers(HANDLE file)
+{
+    return 0 == fsync(static_cast<int>(reinterpret_cast<intptr_t>(file)));
+}
+
+inline BOOL CloseHandle(HANDLE file)
+{
+    return 0 == close(static_cast<int>(reinterpret_cast<intptr_t>(file)));
+}
+
+// ãɹ MoveFileExW CConfigMgr ÿдһļһ
+inline std::atomic<int>& win32MoveFileCount()
+{
+    static std::atomic<int> count(0);
+    return count;
+}
+
+inline BOOL MoveFileExW(LPCWSTR from, LPCWSTR to, DWORD)
+{
+    if (0 != rename(win32PosixPath(from).c_str(), win32PosixPath(to).c_str()))
+    {
+        return FALSE;
+    }
+    ++win32MoveFileCount();
+    return TRUE;
+}
+
+inline BOOL DeleteFileW(LPCWSTR path)
+{
+    return 0 == unlink(win32PosixPath(path).c_str());
+}
+
+// MSVC  std::ifstream ֱÿַ·
+namespace std
+{
+    class win32_ifstream : public ifstream
+    {
+    public:
+        explicit win32_ifstream(const wchar_t* path, ios_base::openmode mode = ios_base::in)
+            : ifstream(win32PosixPath(path).c_str(), mode) {}
+        explicit win32_ifstream(const char* path, ios_base::openmode mode = ios_base::in)
+            : ifstream(path, mode) {}
+    };
+}
+#define ifstream win32_ifstream
+
+#endif /* __TEST_WIN32_WINDOWS_H__ */
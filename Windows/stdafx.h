@@ -49,4 +49,6 @@
 
 #define WM_CUSTOM_CLOSE_MAINVIEW (WM_USER + 1)
 #define WM_CUSTOM_CLOSE_SETTINGVIEW (WM_USER + 1)
+#define WM_CUSTOM_STORAGE_CONFIG_CHANGED (WM_USER + 2)  //wParam Ϊб仯 Config::SettingKey λ
+#define WM_CUSTOM_USER_CONFIG_CHANGED (WM_USER + 3)
 